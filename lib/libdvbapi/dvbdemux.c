@@ -225,6 +225,34 @@ int dvbdemux_set_pid_filter(int fd, int pid,
 	return ioctl(fd, DMX_SET_PES_FILTER, &filter);
 }
 
+int dvbdemux_add_pid(int fd, int pid)
+{
+#ifdef DMX_ADD_PID
+	uint16_t kpid = pid;
+
+	return ioctl(fd, DMX_ADD_PID, &kpid);
+#else
+	(void) fd;
+	(void) pid;
+	errno = ENOTTY;
+	return -1;
+#endif
+}
+
+int dvbdemux_remove_pid(int fd, int pid)
+{
+#ifdef DMX_REMOVE_PID
+	uint16_t kpid = pid;
+
+	return ioctl(fd, DMX_REMOVE_PID, &kpid);
+#else
+	(void) fd;
+	(void) pid;
+	errno = ENOTTY;
+	return -1;
+#endif
+}
+
 int dvbdemux_start(int fd)
 {
 	return ioctl(fd, DMX_START);
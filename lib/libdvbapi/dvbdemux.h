@@ -161,6 +161,26 @@ extern int dvbdemux_set_pid_filter(int fd, int pid,
                                    int input, int output,
                                    int start);
 
+/**
+ * Add another PID to a pid filter set up with dvbdemux_set_pid_filter(). The
+ * kernel only allows this for filters with DVBDEMUX_OUTPUT_TS_DEMUX output.
+ *
+ * @param fd FD as opened with dvbdemux_open_demux() above.
+ * @param pid PID to add.
+ * @return 0 on success, nonzero on failure (errno is ENOTTY if the kernel does
+ * not support multiple PIDs per filter).
+ */
+extern int dvbdemux_add_pid(int fd, int pid);
+
+/**
+ * Remove a PID from a pid filter.
+ *
+ * @param fd FD as opened with dvbdemux_open_demux() above.
+ * @param pid PID to remove.
+ * @return 0 on success, nonzero on failure.
+ */
+extern int dvbdemux_remove_pid(int fd, int pid);
+
 /**
  * Start a demux going.
  *
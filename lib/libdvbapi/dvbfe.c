@@ -28,6 +28,7 @@
 #include <sys/ioctl.h>
 #include <sys/time.h>
 #include <sys/poll.h>
+#include <time.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <ctype.h>
@@ -58,6 +59,35 @@ static int dvbfe_code_rate_to_kapi[][2] =
 	{ DVBFE_FEC_7_8, FEC_7_8 },
 	{ DVBFE_FEC_8_9, FEC_8_9 },
 	{ DVBFE_FEC_AUTO, FEC_AUTO },
+	{ DVBFE_FEC_3_5, FEC_3_5 },
+	{ DVBFE_FEC_9_10, FEC_9_10 },
+	{ -1, -1 }
+};
+
+static int dvbfe_dvbs_mod_to_kapi[][2] =
+{
+	{ DVBFE_DVBS_MOD_QPSK, QPSK },
+	{ DVBFE_DVBS_MOD_8PSK, PSK_8 },
+	{ DVBFE_DVBS_MOD_16APSK, APSK_16 },
+	{ DVBFE_DVBS_MOD_32APSK, APSK_32 },
+	{ DVBFE_DVBS_MOD_AUTO, QAM_AUTO },
+	{ -1, -1 }
+};
+
+static int dvbfe_dvbs_rolloff_to_kapi[][2] =
+{
+	{ DVBFE_DVBS_ROLLOFF_35, ROLLOFF_35 },
+	{ DVBFE_DVBS_ROLLOFF_25, ROLLOFF_25 },
+	{ DVBFE_DVBS_ROLLOFF_20, ROLLOFF_20 },
+	{ DVBFE_DVBS_ROLLOFF_AUTO, ROLLOFF_AUTO },
+	{ -1, -1 }
+};
+
+static int dvbfe_dvbs_pilot_to_kapi[][2] =
+{
+	{ DVBFE_DVBS_PILOT_AUTO, PILOT_AUTO },
+	{ DVBFE_DVBS_PILOT_ON, PILOT_ON },
+	{ DVBFE_DVBS_PILOT_OFF, PILOT_OFF },
 	{ -1, -1 }
 };
 
@@ -111,6 +141,15 @@ static int dvbfe_dvbt_bandwidth_to_kapi[][2] =
 	{ -1, -1 }
 };
 
+static int dvbfe_dvbt_bandwidth_to_hz[][2] =
+{
+	{ DVBFE_DVBT_BANDWIDTH_8_MHZ, 8000000 },
+	{ DVBFE_DVBT_BANDWIDTH_7_MHZ, 7000000 },
+	{ DVBFE_DVBT_BANDWIDTH_6_MHZ, 6000000 },
+	{ DVBFE_DVBT_BANDWIDTH_AUTO, 0 },
+	{ -1, -1 }
+};
+
 static int dvbfe_dvbt_guard_interval_to_kapi[][2] =
 {
 	{ DVBFE_DVBT_GUARD_INTERVAL_1_32, GUARD_INTERVAL_1_32},
@@ -153,18 +192,45 @@ static int lookupval(int val, int reverse, int table[][2])
 }
 
 
+/* DVB API versions, as reported by DTV_API_VERSION */
+#define DVBFE_API_V5		0x0500	/* property based tuning */
+#define DVBFE_API_V5_STATS	0x050a	/* DTV_STAT_* statistics */
+
+/* most properties sent or fetched in one call */
+#define DVBFE_MAX_PROPS		16
+
 struct dvbfe_handle {
 	int fd;
 	enum dvbfe_type type;
 	char *name;
+	int api_version;		/* 0 if only the legacy API is available */
+
+	/* the tune in progress */
+	int tune_status;
+	uint64_t tune_start;		/* us */
+	uint64_t tune_deadline;		/* us, or 0 for none */
+	dvbfe_tune_callback tune_callback;
+	void *tune_arg;
+
+	struct dvbfe_tune_stats tune_stats;
 };
 
+static int dvbfe_tune_start(struct dvbfe_handle *fehandle, struct dvbfe_parameters *params);
+static int dvbfe_set_frontend(struct dvbfe_handle *fehandle, struct dvbfe_parameters *params);
+static int dvbfe_set_properties(struct dvbfe_handle *fehandle, struct dvbfe_parameters *params);
+static int dvbfe_get_properties(struct dvbfe_handle *fehandle, struct dvbfe_parameters *params);
+static uint64_t dvbfe_now(void);
+static int dvbfe_read_events(struct dvbfe_handle *fehandle, fe_status_t *status);
+static void dvbfe_tune_done(struct dvbfe_handle *fehandle, int status);
+
 struct dvbfe_handle *dvbfe_open(int adapter, int frontend, int readonly)
 {
 	char filename[PATH_MAX+1];
 	struct dvbfe_handle *fehandle;
 	int fd;
 	struct dvb_frontend_info info;
+	struct dtv_property prop;
+	struct dtv_properties cmdseq;
 
 	//  flags
 	int flags = O_RDWR;
@@ -211,6 +277,14 @@ struct dvbfe_handle *dvbfe_open(int adapter, int frontend, int readonly)
 	}
 	fehandle->name = strndup(info.name, sizeof(info.name));
 
+	// find out if the property based API is available
+	memset(&prop, 0, sizeof(prop));
+	prop.cmd = DTV_API_VERSION;
+	cmdseq.num = 1;
+	cmdseq.props = &prop;
+	if (!ioctl(fd, FE_GET_PROPERTY, &cmdseq))
+		fehandle->api_version = prop.u.data;
+
 	// done
 	return fehandle;
 }
@@ -231,6 +305,7 @@ extern int dvbfe_get_info(struct dvbfe_handle *fehandle,
 	int returnval = 0;
 	struct dvb_frontend_event kevent;
 	int ok = 0;
+	int v5params = 0;
 
 	result->name = fehandle->name;
 	result->type = fehandle->type;
@@ -243,7 +318,12 @@ extern int dvbfe_get_info(struct dvbfe_handle *fehandle,
 			}
 		}
 		if (querymask & DVBFE_INFO_FEPARAMS) {
-			if (!ioctl(fehandle->fd, FE_GET_FRONTEND, &kevent.parameters)) {
+			if (fehandle->api_version >= DVBFE_API_V5) {
+				if (!dvbfe_get_properties(fehandle, &result->feparams)) {
+					returnval |= DVBFE_INFO_FEPARAMS;
+					v5params = 1;
+				}
+			} else if (!ioctl(fehandle->fd, FE_GET_FRONTEND, &kevent.parameters)) {
 				returnval |= DVBFE_INFO_FEPARAMS;
 			}
 		}
@@ -285,7 +365,7 @@ extern int dvbfe_get_info(struct dvbfe_handle *fehandle,
 		result->lock = kevent.status & FE_HAS_LOCK ? 1 : 0;
 	}
 
-	if (returnval & DVBFE_INFO_FEPARAMS) {
+	if ((returnval & DVBFE_INFO_FEPARAMS) && !v5params) {
 		result->feparams.frequency = kevent.parameters.frequency;
 		result->feparams.inversion = lookupval(kevent.parameters.inversion, 1, dvbfe_spectral_inversion_to_kapi);
 		switch(fehandle->type) {
@@ -293,6 +373,10 @@ extern int dvbfe_get_info(struct dvbfe_handle *fehandle,
 			result->feparams.u.dvbs.symbol_rate = kevent.parameters.u.qpsk.symbol_rate;
 			result->feparams.u.dvbs.fec_inner =
 				lookupval(kevent.parameters.u.qpsk.fec_inner, 1, dvbfe_code_rate_to_kapi);
+			result->feparams.u.dvbs.system = DVBFE_DVBS_SYSTEM_DVBS;
+			result->feparams.u.dvbs.modulation = DVBFE_DVBS_MOD_QPSK;
+			result->feparams.u.dvbs.rolloff = DVBFE_DVBS_ROLLOFF_35;
+			result->feparams.u.dvbs.pilot = DVBFE_DVBS_PILOT_AUTO;
 			break;
 
 		case FE_QAM:
@@ -352,91 +436,175 @@ int dvbfe_set(struct dvbfe_handle *fehandle,
 	      struct dvbfe_parameters *params,
 	      int timeout)
 {
-	struct dvb_frontend_parameters kparams;
+	struct pollfd pollfd;
+	int status;
 	int res;
-	struct timeval endtime;
-	fe_status_t status;
-
-	kparams.frequency = params->frequency;
-	kparams.inversion = lookupval(params->inversion, 0, dvbfe_spectral_inversion_to_kapi);
-	switch(fehandle->type) {
-	case FE_QPSK:
-		kparams.u.qpsk.symbol_rate = params->u.dvbs.symbol_rate;
-		kparams.u.qpsk.fec_inner = lookupval(params->u.dvbs.fec_inner, 0, dvbfe_code_rate_to_kapi);
-		break;
-
-	case FE_QAM:
-		kparams.u.qam.symbol_rate = params->u.dvbc.symbol_rate;
-		kparams.u.qam.fec_inner = lookupval(params->u.dvbc.fec_inner, 0, dvbfe_code_rate_to_kapi);
-		kparams.u.qam.modulation = lookupval(params->u.dvbc.modulation, 0, dvbfe_dvbc_mod_to_kapi);
-		break;
-
-	case FE_OFDM:
-		kparams.u.ofdm.bandwidth = lookupval(params->u.dvbt.bandwidth, 0, dvbfe_dvbt_bandwidth_to_kapi);
-		kparams.u.ofdm.code_rate_HP = lookupval(params->u.dvbt.code_rate_HP, 0, dvbfe_code_rate_to_kapi);
-		kparams.u.ofdm.code_rate_LP = lookupval(params->u.dvbt.code_rate_LP, 0, dvbfe_code_rate_to_kapi);
-		kparams.u.ofdm.constellation = lookupval(params->u.dvbt.constellation, 0, dvbfe_dvbt_const_to_kapi);
-		kparams.u.ofdm.transmission_mode =
-			lookupval(params->u.dvbt.transmission_mode, 0, dvbfe_dvbt_transmit_mode_to_kapi);
-		kparams.u.ofdm.guard_interval =
-			lookupval(params->u.dvbt.guard_interval, 0, dvbfe_dvbt_guard_interval_to_kapi);
-		kparams.u.ofdm.hierarchy_information =
-			lookupval(params->u.dvbt.hierarchy_information, 0, dvbfe_dvbt_hierarchy_to_kapi);
-                break;
 
-	case FE_ATSC:
-		kparams.u.vsb.modulation = lookupval(params->u.atsc.modulation, 0, dvbfe_atsc_mod_to_kapi);
-		break;
-
-	default:
-		return -EINVAL;
+	// 0 => return immediately; nothing waits for the lock, so it isn't
+	// tracked as a tune
+	if (timeout == 0) {
+		fehandle->tune_status = DVBFE_TUNE_IDLE;
+		return dvbfe_tune_start(fehandle, params);
 	}
 
-	// set it and check for error
-	res = ioctl(fehandle->fd, FE_SET_FRONTEND, &kparams);
+	res = dvbfe_set_async(fehandle, params, timeout, NULL, NULL);
 	if (res)
 		return res;
 
-	// 0 => return immediately
-	if (timeout == 0) {
-		return 0;
+	/* wait for the lock to be reported */
+	pollfd.fd = fehandle->fd;
+	pollfd.events = POLLIN;
+	while((status = dvbfe_tune_check(fehandle)) == DVBFE_TUNE_PENDING) {
+		if ((poll(&pollfd, 1, dvbfe_tune_poll_timeout(fehandle)) < 0) && (errno != EINTR))
+			break;
 	}
 
-	/* calculate timeout */
-	if (timeout > 0) {
-		gettimeofday(&endtime, NULL);
-		timeout *= 1000;
-		endtime.tv_sec += timeout / 1000000;
-		endtime.tv_usec += timeout % 1000000;
+	/* exit */
+	if (status == DVBFE_TUNE_LOCKED)
+		return 0;
+	return -ETIMEDOUT;
+}
+
+int dvbfe_set_async(struct dvbfe_handle *fehandle,
+		    struct dvbfe_parameters *params,
+		    int timeout,
+		    dvbfe_tune_callback callback,
+		    void *arg)
+{
+	int res;
+
+	// set it and check for error; this also flushes the old events
+	if ((res = dvbfe_tune_start(fehandle, params)) != 0) {
+		fehandle->tune_status = DVBFE_TUNE_IDLE;
+		return res;
 	}
 
-	/* wait for a lock */
-	while(1) {
-		/* has it locked? */
-		if (!ioctl(fehandle->fd, FE_READ_STATUS, &status)) {
-			if (status & FE_HAS_LOCK) {
-				break;
-			}
-		}
+	fehandle->tune_status = DVBFE_TUNE_PENDING;
+	fehandle->tune_start = dvbfe_now();
+	fehandle->tune_deadline = 0;
+	if (timeout >= 0)
+		fehandle->tune_deadline = fehandle->tune_start + (timeout * 1000ULL);
+	fehandle->tune_callback = callback;
+	fehandle->tune_arg = arg;
+	fehandle->tune_stats.tunes++;
 
-		/* check for timeout */
-		if (timeout > 0) {
-			struct timeval curtime;
-			gettimeofday(&curtime, NULL);
-			if ((curtime.tv_sec > endtime.tv_sec) ||
-			    ((curtime.tv_sec == endtime.tv_sec) && (curtime.tv_usec >= endtime.tv_usec))) {
-				break;
-			}
-		}
+	return 0;
+}
 
-		/* delay for a bit */
-		usleep(100000);
+int dvbfe_tune_check(struct dvbfe_handle *fehandle)
+{
+	fe_status_t status = 0;
+
+	if (fehandle->tune_status != DVBFE_TUNE_PENDING)
+		return fehandle->tune_status;
+
+	if (dvbfe_read_events(fehandle, &status) && (status & FE_HAS_LOCK)) {
+		dvbfe_tune_done(fehandle, DVBFE_TUNE_LOCKED);
+	} else if (fehandle->tune_deadline && (dvbfe_now() >= fehandle->tune_deadline)) {
+		/* make sure no event was missed before giving up */
+		if (!ioctl(fehandle->fd, FE_READ_STATUS, &status) && (status & FE_HAS_LOCK))
+			dvbfe_tune_done(fehandle, DVBFE_TUNE_LOCKED);
+		else
+			dvbfe_tune_done(fehandle, DVBFE_TUNE_TIMEOUT);
 	}
 
-	/* exit */
-	if (status & FE_HAS_LOCK)
+	return fehandle->tune_status;
+}
+
+int dvbfe_tune_poll_timeout(struct dvbfe_handle *fehandle)
+{
+	uint64_t now;
+
+	if ((fehandle->tune_status != DVBFE_TUNE_PENDING) || (fehandle->tune_deadline == 0))
+		return -1;
+
+	now = dvbfe_now();
+	if (now >= fehandle->tune_deadline)
 		return 0;
-	return -ETIMEDOUT;
+	return (fehandle->tune_deadline - now + 999) / 1000;
+}
+
+void dvbfe_get_tune_stats(struct dvbfe_handle *fehandle,
+			  struct dvbfe_tune_stats *stats)
+{
+	memcpy(stats, &fehandle->tune_stats, sizeof(struct dvbfe_tune_stats));
+}
+
+void dvbfe_reset_tune_stats(struct dvbfe_handle *fehandle)
+{
+	memset(&fehandle->tune_stats, 0, sizeof(struct dvbfe_tune_stats));
+}
+
+int dvbfe_get_stats(struct dvbfe_handle *fehandle,
+		    struct dvbfe_stats *stats)
+{
+#ifdef DTV_STAT_SIGNAL_STRENGTH
+	static const uint32_t cmds[] = {
+		DTV_STAT_SIGNAL_STRENGTH,
+		DTV_STAT_CNR,
+		DTV_STAT_PRE_ERROR_BIT_COUNT,
+		DTV_STAT_PRE_TOTAL_BIT_COUNT,
+		DTV_STAT_POST_ERROR_BIT_COUNT,
+		DTV_STAT_POST_TOTAL_BIT_COUNT,
+		DTV_STAT_ERROR_BLOCK_COUNT,
+		DTV_STAT_TOTAL_BLOCK_COUNT,
+	};
+	struct dvbfe_stat *out[] = {
+		&stats->signal_strength,
+		&stats->cnr,
+		&stats->pre_error_bits,
+		&stats->pre_total_bits,
+		&stats->post_error_bits,
+		&stats->post_total_bits,
+		&stats->error_blocks,
+		&stats->total_blocks,
+	};
+	struct dtv_property props[sizeof(cmds) / sizeof(cmds[0])];
+	struct dtv_properties cmdseq;
+	unsigned int i;
+
+	if (fehandle->api_version < DVBFE_API_V5_STATS)
+		return -EOPNOTSUPP;
+
+	memset(props, 0, sizeof(props));
+	for(i=0; i < sizeof(cmds) / sizeof(cmds[0]); i++)
+		props[i].cmd = cmds[i];
+	cmdseq.num = i;
+	cmdseq.props = props;
+	if (ioctl(fehandle->fd, FE_GET_PROPERTY, &cmdseq))
+		return -errno;
+
+	// only the global values are returned, not those of each layer
+	for(i=0; i < sizeof(cmds) / sizeof(cmds[0]); i++) {
+		struct dtv_stats *st = &props[i].u.st.stat[0];
+
+		out[i]->scale = DVBFE_STAT_SCALE_NONE;
+		out[i]->value = 0;
+		if (props[i].u.st.len == 0)
+			continue;
+
+		switch(st->scale) {
+		case FE_SCALE_DECIBEL:
+			out[i]->scale = DVBFE_STAT_SCALE_DECIBEL;
+			out[i]->value = st->svalue;
+			break;
+		case FE_SCALE_RELATIVE:
+			out[i]->scale = DVBFE_STAT_SCALE_RELATIVE;
+			out[i]->value = st->uvalue;
+			break;
+		case FE_SCALE_COUNTER:
+			out[i]->scale = DVBFE_STAT_SCALE_COUNTER;
+			out[i]->value = st->uvalue;
+			break;
+		}
+	}
+
+	return 0;
+#else
+	(void) fehandle;
+	(void) stats;
+	return -EOPNOTSUPP;
+#endif
 }
 
 int dvbfe_get_pollfd(struct dvbfe_handle *handle)
@@ -572,3 +740,275 @@ int dvbfe_diseqc_read(struct dvbfe_handle *fehandle, int timeout, unsigned char
 
 	return len;
 }
+
+static int dvbfe_tune_start(struct dvbfe_handle *fehandle, struct dvbfe_parameters *params)
+{
+	if (fehandle->api_version >= DVBFE_API_V5)
+		return dvbfe_set_properties(fehandle, params);
+	return dvbfe_set_frontend(fehandle, params);
+}
+
+static int dvbfe_set_frontend(struct dvbfe_handle *fehandle, struct dvbfe_parameters *params)
+{
+	struct dvb_frontend_parameters kparams;
+
+	kparams.frequency = params->frequency;
+	kparams.inversion = lookupval(params->inversion, 0, dvbfe_spectral_inversion_to_kapi);
+	switch(fehandle->type) {
+	case FE_QPSK:
+		// the legacy API has no way to ask for DVB-S2
+		if (params->u.dvbs.system == DVBFE_DVBS_SYSTEM_DVBS2)
+			return -EOPNOTSUPP;
+		kparams.u.qpsk.symbol_rate = params->u.dvbs.symbol_rate;
+		kparams.u.qpsk.fec_inner = lookupval(params->u.dvbs.fec_inner, 0, dvbfe_code_rate_to_kapi);
+		break;
+
+	case FE_QAM:
+		kparams.u.qam.symbol_rate = params->u.dvbc.symbol_rate;
+		kparams.u.qam.fec_inner = lookupval(params->u.dvbc.fec_inner, 0, dvbfe_code_rate_to_kapi);
+		kparams.u.qam.modulation = lookupval(params->u.dvbc.modulation, 0, dvbfe_dvbc_mod_to_kapi);
+		break;
+
+	case FE_OFDM:
+		kparams.u.ofdm.bandwidth = lookupval(params->u.dvbt.bandwidth, 0, dvbfe_dvbt_bandwidth_to_kapi);
+		kparams.u.ofdm.code_rate_HP = lookupval(params->u.dvbt.code_rate_HP, 0, dvbfe_code_rate_to_kapi);
+		kparams.u.ofdm.code_rate_LP = lookupval(params->u.dvbt.code_rate_LP, 0, dvbfe_code_rate_to_kapi);
+		kparams.u.ofdm.constellation = lookupval(params->u.dvbt.constellation, 0, dvbfe_dvbt_const_to_kapi);
+		kparams.u.ofdm.transmission_mode =
+			lookupval(params->u.dvbt.transmission_mode, 0, dvbfe_dvbt_transmit_mode_to_kapi);
+		kparams.u.ofdm.guard_interval =
+			lookupval(params->u.dvbt.guard_interval, 0, dvbfe_dvbt_guard_interval_to_kapi);
+		kparams.u.ofdm.hierarchy_information =
+			lookupval(params->u.dvbt.hierarchy_information, 0, dvbfe_dvbt_hierarchy_to_kapi);
+                break;
+
+	case FE_ATSC:
+		kparams.u.vsb.modulation = lookupval(params->u.atsc.modulation, 0, dvbfe_atsc_mod_to_kapi);
+		break;
+
+	default:
+		return -EINVAL;
+	}
+
+	return ioctl(fehandle->fd, FE_SET_FRONTEND, &kparams);
+}
+
+static int dvbfe_add_prop(struct dtv_property *props, int count, uint32_t cmd, uint32_t data)
+{
+	memset(&props[count], 0, sizeof(struct dtv_property));
+	props[count].cmd = cmd;
+	props[count].u.data = data;
+	return count + 1;
+}
+
+static int dvbfe_set_properties(struct dvbfe_handle *fehandle, struct dvbfe_parameters *params)
+{
+	struct dtv_property props[DVBFE_MAX_PROPS];
+	struct dtv_properties cmdseq;
+	int n = 0;
+
+	n = dvbfe_add_prop(props, n, DTV_CLEAR, 0);
+	switch(fehandle->type) {
+	case DVBFE_TYPE_DVBS:
+		if (params->u.dvbs.system == DVBFE_DVBS_SYSTEM_DVBS2) {
+			n = dvbfe_add_prop(props, n, DTV_DELIVERY_SYSTEM, SYS_DVBS2);
+			n = dvbfe_add_prop(props, n, DTV_MODULATION,
+					   lookupval(params->u.dvbs.modulation, 0, dvbfe_dvbs_mod_to_kapi));
+			n = dvbfe_add_prop(props, n, DTV_ROLLOFF,
+					   lookupval(params->u.dvbs.rolloff, 0, dvbfe_dvbs_rolloff_to_kapi));
+			n = dvbfe_add_prop(props, n, DTV_PILOT,
+					   lookupval(params->u.dvbs.pilot, 0, dvbfe_dvbs_pilot_to_kapi));
+		} else {
+			n = dvbfe_add_prop(props, n, DTV_DELIVERY_SYSTEM, SYS_DVBS);
+			n = dvbfe_add_prop(props, n, DTV_MODULATION, QPSK);
+			n = dvbfe_add_prop(props, n, DTV_ROLLOFF, ROLLOFF_35);
+		}
+		n = dvbfe_add_prop(props, n, DTV_SYMBOL_RATE, params->u.dvbs.symbol_rate);
+		n = dvbfe_add_prop(props, n, DTV_INNER_FEC,
+				   lookupval(params->u.dvbs.fec_inner, 0, dvbfe_code_rate_to_kapi));
+		break;
+
+	case DVBFE_TYPE_DVBC:
+		n = dvbfe_add_prop(props, n, DTV_DELIVERY_SYSTEM, SYS_DVBC_ANNEX_AC);
+		n = dvbfe_add_prop(props, n, DTV_SYMBOL_RATE, params->u.dvbc.symbol_rate);
+		n = dvbfe_add_prop(props, n, DTV_INNER_FEC,
+				   lookupval(params->u.dvbc.fec_inner, 0, dvbfe_code_rate_to_kapi));
+		n = dvbfe_add_prop(props, n, DTV_MODULATION,
+				   lookupval(params->u.dvbc.modulation, 0, dvbfe_dvbc_mod_to_kapi));
+		break;
+
+	case DVBFE_TYPE_DVBT:
+		n = dvbfe_add_prop(props, n, DTV_DELIVERY_SYSTEM, SYS_DVBT);
+		n = dvbfe_add_prop(props, n, DTV_BANDWIDTH_HZ,
+				   lookupval(params->u.dvbt.bandwidth, 0, dvbfe_dvbt_bandwidth_to_hz));
+		n = dvbfe_add_prop(props, n, DTV_CODE_RATE_HP,
+				   lookupval(params->u.dvbt.code_rate_HP, 0, dvbfe_code_rate_to_kapi));
+		n = dvbfe_add_prop(props, n, DTV_CODE_RATE_LP,
+				   lookupval(params->u.dvbt.code_rate_LP, 0, dvbfe_code_rate_to_kapi));
+		n = dvbfe_add_prop(props, n, DTV_MODULATION,
+				   lookupval(params->u.dvbt.constellation, 0, dvbfe_dvbt_const_to_kapi));
+		n = dvbfe_add_prop(props, n, DTV_TRANSMISSION_MODE,
+				   lookupval(params->u.dvbt.transmission_mode, 0, dvbfe_dvbt_transmit_mode_to_kapi));
+		n = dvbfe_add_prop(props, n, DTV_GUARD_INTERVAL,
+				   lookupval(params->u.dvbt.guard_interval, 0, dvbfe_dvbt_guard_interval_to_kapi));
+		n = dvbfe_add_prop(props, n, DTV_HIERARCHY,
+				   lookupval(params->u.dvbt.hierarchy_information, 0, dvbfe_dvbt_hierarchy_to_kapi));
+		break;
+
+	case DVBFE_TYPE_ATSC:
+		switch(params->u.atsc.modulation) {
+		case DVBFE_ATSC_MOD_QAM_64:
+		case DVBFE_ATSC_MOD_QAM_256:
+			n = dvbfe_add_prop(props, n, DTV_DELIVERY_SYSTEM, SYS_DVBC_ANNEX_B);
+			break;
+		default:
+			n = dvbfe_add_prop(props, n, DTV_DELIVERY_SYSTEM, SYS_ATSC);
+			break;
+		}
+		n = dvbfe_add_prop(props, n, DTV_MODULATION,
+				   lookupval(params->u.atsc.modulation, 0, dvbfe_atsc_mod_to_kapi));
+		break;
+
+	default:
+		return -EINVAL;
+	}
+	n = dvbfe_add_prop(props, n, DTV_FREQUENCY, params->frequency);
+	n = dvbfe_add_prop(props, n, DTV_INVERSION,
+			   lookupval(params->inversion, 0, dvbfe_spectral_inversion_to_kapi));
+	n = dvbfe_add_prop(props, n, DTV_TUNE, 0);
+
+	cmdseq.num = n;
+	cmdseq.props = props;
+	return ioctl(fehandle->fd, FE_SET_PROPERTY, &cmdseq);
+}
+
+static int dvbfe_get_properties(struct dvbfe_handle *fehandle, struct dvbfe_parameters *params)
+{
+	static const uint32_t cmds[] = {
+		DTV_DELIVERY_SYSTEM,
+		DTV_FREQUENCY,
+		DTV_INVERSION,
+		DTV_SYMBOL_RATE,
+		DTV_INNER_FEC,
+		DTV_MODULATION,
+		DTV_ROLLOFF,
+		DTV_PILOT,
+		DTV_BANDWIDTH_HZ,
+		DTV_CODE_RATE_HP,
+		DTV_CODE_RATE_LP,
+		DTV_TRANSMISSION_MODE,
+		DTV_GUARD_INTERVAL,
+		DTV_HIERARCHY,
+	};
+	struct dtv_property props[sizeof(cmds) / sizeof(cmds[0])];
+	struct dtv_properties cmdseq;
+	uint32_t val[sizeof(cmds) / sizeof(cmds[0])];
+	unsigned int i;
+	int res;
+
+	memset(props, 0, sizeof(props));
+	for(i=0; i < sizeof(cmds) / sizeof(cmds[0]); i++)
+		props[i].cmd = cmds[i];
+	cmdseq.num = i;
+	cmdseq.props = props;
+	if ((res = ioctl(fehandle->fd, FE_GET_PROPERTY, &cmdseq)) != 0)
+		return res;
+	for(i=0; i < sizeof(cmds) / sizeof(cmds[0]); i++)
+		val[i] = props[i].u.data;
+
+	params->frequency = val[1];
+	params->inversion = lookupval(val[2], 1, dvbfe_spectral_inversion_to_kapi);
+	switch(fehandle->type) {
+	case DVBFE_TYPE_DVBS:
+		params->u.dvbs.symbol_rate = val[3];
+		params->u.dvbs.fec_inner = lookupval(val[4], 1, dvbfe_code_rate_to_kapi);
+		params->u.dvbs.system = DVBFE_DVBS_SYSTEM_DVBS;
+		if (val[0] == SYS_DVBS2)
+			params->u.dvbs.system = DVBFE_DVBS_SYSTEM_DVBS2;
+		params->u.dvbs.modulation = lookupval(val[5], 1, dvbfe_dvbs_mod_to_kapi);
+		params->u.dvbs.rolloff = lookupval(val[6], 1, dvbfe_dvbs_rolloff_to_kapi);
+		params->u.dvbs.pilot = lookupval(val[7], 1, dvbfe_dvbs_pilot_to_kapi);
+		break;
+
+	case DVBFE_TYPE_DVBC:
+		params->u.dvbc.symbol_rate = val[3];
+		params->u.dvbc.fec_inner = lookupval(val[4], 1, dvbfe_code_rate_to_kapi);
+		params->u.dvbc.modulation = lookupval(val[5], 1, dvbfe_dvbc_mod_to_kapi);
+		break;
+
+	case DVBFE_TYPE_DVBT:
+		params->u.dvbt.constellation = lookupval(val[5], 1, dvbfe_dvbt_const_to_kapi);
+		params->u.dvbt.bandwidth = lookupval(val[8], 1, dvbfe_dvbt_bandwidth_to_hz);
+		params->u.dvbt.code_rate_HP = lookupval(val[9], 1, dvbfe_code_rate_to_kapi);
+		params->u.dvbt.code_rate_LP = lookupval(val[10], 1, dvbfe_code_rate_to_kapi);
+		params->u.dvbt.transmission_mode = lookupval(val[11], 1, dvbfe_dvbt_transmit_mode_to_kapi);
+		params->u.dvbt.guard_interval = lookupval(val[12], 1, dvbfe_dvbt_guard_interval_to_kapi);
+		params->u.dvbt.hierarchy_information = lookupval(val[13], 1, dvbfe_dvbt_hierarchy_to_kapi);
+		break;
+
+	case DVBFE_TYPE_ATSC:
+		params->u.atsc.modulation = lookupval(val[5], 1, dvbfe_atsc_mod_to_kapi);
+		break;
+	}
+
+	return 0;
+}
+
+static uint64_t dvbfe_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (ts.tv_sec * 1000000ULL) + (ts.tv_nsec / 1000);
+}
+
+static int dvbfe_read_events(struct dvbfe_handle *fehandle, fe_status_t *status)
+{
+	struct dvb_frontend_event kevent;
+	struct pollfd pollfd;
+	int got = 0;
+
+	/* FE_GET_EVENT blocks if the queue is empty, so poll before each one */
+	pollfd.fd = fehandle->fd;
+	pollfd.events = POLLIN;
+	while((poll(&pollfd, 1, 0) > 0) && (pollfd.revents & POLLIN)) {
+		if (ioctl(fehandle->fd, FE_GET_EVENT, &kevent)) {
+			if (errno != EOVERFLOW)
+				break;
+
+			/* events were lost: ask for the status instead */
+			if (!ioctl(fehandle->fd, FE_READ_STATUS, status))
+				got = 1;
+			continue;
+		}
+		*status = kevent.status;
+		got = 1;
+	}
+
+	return got;
+}
+
+static void dvbfe_tune_done(struct dvbfe_handle *fehandle, int status)
+{
+	struct dvbfe_tune_stats *stats = &fehandle->tune_stats;
+	uint32_t latency_ms = (dvbfe_now() - fehandle->tune_start) / 1000;
+	int bucket = 0;
+
+	fehandle->tune_status = status;
+	if (status == DVBFE_TUNE_LOCKED) {
+		while((bucket < (DVBFE_TUNE_HISTOGRAM_BUCKETS - 1)) && (latency_ms >> bucket))
+			bucket++;
+		stats->histogram[bucket]++;
+		if ((stats->locks == 0) || (latency_ms < stats->min_ms))
+			stats->min_ms = latency_ms;
+		if (latency_ms > stats->max_ms)
+			stats->max_ms = latency_ms;
+		stats->total_ms += latency_ms;
+		stats->locks++;
+	} else {
+		stats->timeouts++;
+	}
+
+	if (fehandle->tune_callback)
+		fehandle->tune_callback(fehandle, status, latency_ms, fehandle->tune_arg);
+}
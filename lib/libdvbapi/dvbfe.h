@@ -56,7 +56,39 @@ enum dvbfe_code_rate {
 	DVBFE_FEC_6_7,
 	DVBFE_FEC_7_8,
 	DVBFE_FEC_8_9,
-	DVBFE_FEC_AUTO
+	DVBFE_FEC_AUTO,
+	DVBFE_FEC_3_5,
+	DVBFE_FEC_9_10
+};
+
+/**
+ * Delivery systems carried by a DVBFE_TYPE_DVBS frontend. DVB-S2 can only
+ * be tuned through the property based (DVBv5) kernel API.
+ */
+enum dvbfe_dvbs_system {
+	DVBFE_DVBS_SYSTEM_DVBS,
+	DVBFE_DVBS_SYSTEM_DVBS2
+};
+
+enum dvbfe_dvbs_mod {
+	DVBFE_DVBS_MOD_QPSK,
+	DVBFE_DVBS_MOD_8PSK,
+	DVBFE_DVBS_MOD_16APSK,
+	DVBFE_DVBS_MOD_32APSK,
+	DVBFE_DVBS_MOD_AUTO
+};
+
+enum dvbfe_dvbs_rolloff {
+	DVBFE_DVBS_ROLLOFF_35,
+	DVBFE_DVBS_ROLLOFF_25,
+	DVBFE_DVBS_ROLLOFF_20,
+	DVBFE_DVBS_ROLLOFF_AUTO
+};
+
+enum dvbfe_dvbs_pilot {
+	DVBFE_DVBS_PILOT_AUTO,
+	DVBFE_DVBS_PILOT_ON,
+	DVBFE_DVBS_PILOT_OFF
 };
 
 enum dvbfe_dvbt_const {
@@ -117,6 +149,10 @@ enum dvbfe_dvbt_hierarchy {
 
 /**
  * Structure used to store and communicate frontend parameters.
+ *
+ * For DVB-S, the modulation, rolloff and pilot fields are only used when
+ * system is DVBFE_DVBS_SYSTEM_DVBS2; plain DVB-S is always QPSK with a
+ * 0.35 rolloff. Zeroing the structure before filling it in selects DVB-S.
  */
 struct dvbfe_parameters {
 	uint32_t frequency;
@@ -125,6 +161,10 @@ struct dvbfe_parameters {
 		struct {
 			uint32_t			symbol_rate;
 			enum dvbfe_code_rate		fec_inner;
+			enum dvbfe_dvbs_system		system;
+			enum dvbfe_dvbs_mod		modulation;
+			enum dvbfe_dvbs_rolloff		rolloff;
+			enum dvbfe_dvbs_pilot		pilot;
 		} dvbs;
 
 		struct {
@@ -208,6 +248,68 @@ enum dvbfe_info_querytype {
 	DVBFE_INFO_QUERYTYPE_LOCKCHANGE,
 };
 
+/**
+ * Scale of a value in struct dvbfe_stats.
+ */
+enum dvbfe_stat_scale {
+	DVBFE_STAT_SCALE_NONE,			/* not supported by the frontend */
+	DVBFE_STAT_SCALE_DECIBEL,		/* 0.001 dB (signal: 0.001 dBm) */
+	DVBFE_STAT_SCALE_RELATIVE,		/* 0 to 65535 */
+	DVBFE_STAT_SCALE_COUNTER,		/* running count */
+};
+
+struct dvbfe_stat {
+	enum dvbfe_stat_scale scale;
+	int64_t value;
+};
+
+/**
+ * Frontend statistics, retrieved with dvbfe_get_stats(). The bit and block
+ * counters run continuously; the error rates are the differences between
+ * two samples, e.g. BER = delta(post_error_bits) / delta(post_total_bits).
+ */
+struct dvbfe_stats {
+	struct dvbfe_stat signal_strength;
+	struct dvbfe_stat cnr;			/* carrier to noise ratio */
+	struct dvbfe_stat pre_error_bits;	/* bit errors before the outer FEC */
+	struct dvbfe_stat pre_total_bits;
+	struct dvbfe_stat post_error_bits;	/* bit errors after the outer FEC */
+	struct dvbfe_stat post_total_bits;
+	struct dvbfe_stat error_blocks;		/* uncorrectable blocks */
+	struct dvbfe_stat total_blocks;
+};
+
+/**
+ * State of a tune started with dvbfe_set_async().
+ */
+enum dvbfe_tune_status {
+	DVBFE_TUNE_IDLE,			/* no tune has been started */
+	DVBFE_TUNE_PENDING,			/* waiting for lock */
+	DVBFE_TUNE_LOCKED,			/* the frontend locked */
+	DVBFE_TUNE_TIMEOUT,			/* it did not lock in time */
+};
+
+/**
+ * Number of buckets in the tune latency histogram. Bucket 0 counts locks
+ * taken in under 1ms, bucket n those in [2^(n-1), 2^n) ms, and the last
+ * bucket everything longer.
+ */
+#define DVBFE_TUNE_HISTOGRAM_BUCKETS 16
+
+/**
+ * Tune latency statistics of a frontend, retrieved with dvbfe_get_tune_stats().
+ * Latency is measured from FE_SET_FRONTEND to the lock being reported.
+ */
+struct dvbfe_tune_stats {
+	uint32_t tunes;				/* tunes started */
+	uint32_t locks;				/* tunes which locked */
+	uint32_t timeouts;			/* tunes which timed out */
+	uint32_t min_ms;			/* quickest lock */
+	uint32_t max_ms;			/* slowest lock */
+	uint64_t total_ms;			/* sum of the lock latencies */
+	uint32_t histogram[DVBFE_TUNE_HISTOGRAM_BUCKETS];
+};
+
 
 /**
  * Frontend handle datatype.
@@ -237,6 +339,11 @@ extern void dvbfe_close(struct dvbfe_handle *handle);
  * Note: this function provides only the basic tuning operation; you might want to
  * investigate dvbfe_set_sec() in sec.h for a unified device tuning operation.
  *
+ * On kernels with the DVBv5 API all the parameters are sent in a single
+ * FE_SET_PROPERTY call; older kernels get FE_SET_FRONTEND, which cannot
+ * tune DVB-S2. The lock is waited for by polling the frontend for status
+ * change events, so it is noticed as soon as the driver reports it.
+ *
  * @param fehandle Handle opened with dvbfe_open().
  * @param params Params to set.
  * @param timeout <0 => wait forever for lock. 0=>return immediately, >0=>
@@ -264,6 +371,19 @@ extern int dvbfe_get_info(struct dvbfe_handle *fehandle,
 			  enum dvbfe_info_querytype querytype,
 			  int timeout);
 
+/**
+ * Retrieve the statistics of the frontend. All of them are read in a single
+ * FE_GET_PROPERTY call, so this is the cheap way to sample a frontend
+ * periodically. Requires a kernel with DVB API 5.10 or later.
+ *
+ * @param fehandle Handle opened with dvbfe_open().
+ * @param stats Where to put the statistics.
+ * @return 0 on success, -EOPNOTSUPP if the kernel is too old, or another
+ * nonzero value on failure.
+ */
+extern int dvbfe_get_stats(struct dvbfe_handle *fehandle,
+			   struct dvbfe_stats *stats);
+
 /**
  * Get a file descriptor for polling for lock status changes.
  *
@@ -272,6 +392,77 @@ extern int dvbfe_get_info(struct dvbfe_handle *fehandle,
  */
 extern int dvbfe_get_pollfd(struct dvbfe_handle *handle);
 
+/**
+ * Callback reporting the end of a tune started with dvbfe_set_async().
+ *
+ * @param fehandle The frontend.
+ * @param status DVBFE_TUNE_LOCKED or DVBFE_TUNE_TIMEOUT.
+ * @param latency_ms Milliseconds since the tune was started.
+ * @param arg The arg passed to dvbfe_set_async().
+ */
+typedef void (*dvbfe_tune_callback)(struct dvbfe_handle *fehandle,
+				    enum dvbfe_tune_status status,
+				    int latency_ms, void *arg);
+
+/**
+ * Start tuning the frontend, returning immediately. The end of the tune
+ * is found with dvbfe_tune_check(), which should be called whenever the
+ * fd from dvbfe_get_pollfd() polls readable (POLLIN), and when
+ * dvbfe_tune_poll_timeout() expires. Any tune already pending is abandoned.
+ *
+ * While a tune is pending, the frontend's events belong to it, so
+ * dvbfe_get_info() should not be used with DVBFE_INFO_QUERYTYPE_LOCKCHANGE.
+ *
+ * @param fehandle Handle opened with dvbfe_open().
+ * @param params Params to set.
+ * @param timeout Milliseconds to wait for a lock, or <0 to wait forever.
+ * @param callback Function to call when the tune locks or times out, or NULL.
+ * @param arg Argument to pass to the callback.
+ * @return 0 on success, or nonzero on failure.
+ */
+extern int dvbfe_set_async(struct dvbfe_handle *fehandle,
+			   struct dvbfe_parameters *params,
+			   int timeout,
+			   dvbfe_tune_callback callback,
+			   void *arg);
+
+/**
+ * Process the frontend's pending events, and see whether a tune started
+ * with dvbfe_set_async() has finished. Never blocks. When it does finish,
+ * its callback is called (once) and the latency statistics are updated.
+ *
+ * @param fehandle Handle opened with dvbfe_open().
+ * @return The state of the tune (enum dvbfe_tune_status).
+ */
+extern int dvbfe_tune_check(struct dvbfe_handle *fehandle);
+
+/**
+ * Determine how long to poll() the frontend fd for while a tune is pending.
+ *
+ * @param fehandle Handle opened with dvbfe_open().
+ * @return Milliseconds until the pending tune times out, or -1 if it never
+ * does or no tune is pending.
+ */
+extern int dvbfe_tune_poll_timeout(struct dvbfe_handle *fehandle);
+
+/**
+ * Retrieve the tune latency statistics of a frontend. Tunes made with
+ * dvbfe_set() are included, except those with a timeout of 0, whose lock is
+ * not waited for.
+ *
+ * @param fehandle Handle opened with dvbfe_open().
+ * @param stats Where to put the statistics.
+ */
+extern void dvbfe_get_tune_stats(struct dvbfe_handle *fehandle,
+				 struct dvbfe_tune_stats *stats);
+
+/**
+ * Reset the tune latency statistics of a frontend.
+ *
+ * @param fehandle Handle opened with dvbfe_open().
+ */
+extern void dvbfe_reset_tune_stats(struct dvbfe_handle *fehandle);
+
 /**
  *	Tone/Data Burst control
  * 	@param fehandle Handle opened with dvbfe_open().
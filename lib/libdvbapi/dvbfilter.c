@@ -0,0 +1,402 @@
+/*
+ * libdvbfilter - a pooled DVB demux filter manager
+ *
+ * Copyright (C) 2026 agent (agent@local)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/epoll.h>
+#include "dvbdemux.h"
+#include "dvbfilter.h"
+
+#define DVBFILTER_TYPE_SECTION	0
+#define DVBFILTER_TYPE_DECODER	1
+#define DVBFILTER_TYPE_PID	2
+#define DVBFILTER_TYPE_SHARED	3	/* a PID on the shared fd */
+
+#define DVBFILTER_MAX_PIDS	0x2000
+#define DVBFILTER_MAX_EVENTS	32
+
+struct dvbfilter {
+	int used;
+	int type;
+	int pid;
+	int fd;				/* -1 for DVBFILTER_TYPE_SHARED */
+	uint32_t generation;		/* tells stale epoll events apart */
+	dvbfilter_callback callback;
+	void *arg;
+};
+
+struct dvbfilter_pool {
+	int adapter;
+	int demuxdevice;
+	int epfd;
+
+	struct dvbfilter *filters;
+	int filters_size;
+
+	/* stopped fds, ready to be reprogrammed */
+	int *idle_fds;
+	int idle_count;
+	int idle_size;
+
+	/* the fd shared by the TS demux PID filters */
+	int shared_fd;
+	int shared_pids;		/* distinct PIDs on it */
+	int no_add_pid;			/* the kernel cannot add PIDs to a filter */
+	uint16_t shared_refs[DVBFILTER_MAX_PIDS];
+
+	struct dvbfilter_pool_stats stats;
+};
+
+static int dvbfilter_take_fd(struct dvbfilter_pool *pool);
+static void dvbfilter_release_fd(struct dvbfilter_pool *pool, int fd);
+static int dvbfilter_new(struct dvbfilter_pool *pool, int type, int pid, int fd,
+			 dvbfilter_callback callback, void *arg);
+static int dvbfilter_add_shared(struct dvbfilter_pool *pool, int pid);
+static void dvbfilter_unref_shared(struct dvbfilter_pool *pool, int pid);
+
+struct dvbfilter_pool *dvbfilter_pool_create(int adapter, int demuxdevice)
+{
+	struct dvbfilter_pool *pool;
+
+	pool = (struct dvbfilter_pool *) malloc(sizeof(struct dvbfilter_pool));
+	if (pool == NULL)
+		return NULL;
+	memset(pool, 0, sizeof(struct dvbfilter_pool));
+	pool->adapter = adapter;
+	pool->demuxdevice = demuxdevice;
+	pool->shared_fd = -1;
+
+	if ((pool->epfd = epoll_create1(EPOLL_CLOEXEC)) < 0) {
+		free(pool);
+		return NULL;
+	}
+
+	return pool;
+}
+
+void dvbfilter_pool_destroy(struct dvbfilter_pool *pool)
+{
+	int i;
+
+	dvbfilter_remove_all(pool);
+	for(i=0; i < pool->idle_count; i++)
+		close(pool->idle_fds[i]);
+	if (pool->shared_fd != -1)
+		close(pool->shared_fd);
+	close(pool->epfd);
+	free(pool->idle_fds);
+	free(pool->filters);
+	free(pool);
+}
+
+int dvbfilter_add_section(struct dvbfilter_pool *pool, int pid,
+			  uint8_t filter[18], uint8_t mask[18], int checkcrc,
+			  dvbfilter_callback callback, void *arg)
+{
+	int fd;
+	int res;
+
+	if ((fd = dvbfilter_take_fd(pool)) < 0)
+		return fd;
+
+	if ((res = dvbdemux_set_section_filter(fd, pid, filter, mask, 1, checkcrc)) != 0) {
+		if (res == -1)
+			res = -errno;
+		dvbfilter_release_fd(pool, fd);
+		return res;
+	}
+
+	return dvbfilter_new(pool, DVBFILTER_TYPE_SECTION, pid, fd, callback, arg);
+}
+
+int dvbfilter_add_decoder(struct dvbfilter_pool *pool, int pid, int pestype)
+{
+	int fd;
+	int res;
+
+	if ((fd = dvbfilter_take_fd(pool)) < 0)
+		return fd;
+
+	res = dvbdemux_set_pes_filter(fd, pid, DVBDEMUX_INPUT_FRONTEND, DVBDEMUX_OUTPUT_DECODER,
+				      pestype, 1);
+	if (res) {
+		if (res == -1)
+			res = -errno;
+		dvbfilter_release_fd(pool, fd);
+		return res;
+	}
+
+	return dvbfilter_new(pool, DVBFILTER_TYPE_DECODER, pid, fd, NULL, NULL);
+}
+
+int dvbfilter_add_pid(struct dvbfilter_pool *pool, int pid, int output,
+		      dvbfilter_callback callback, void *arg)
+{
+	int fd;
+	int res;
+
+	// nothing is read from a DVR filter's fd
+	if ((output == DVBDEMUX_OUTPUT_DVR) && callback)
+		return -EINVAL;
+
+	if ((output == DVBDEMUX_OUTPUT_TS_DEMUX) && (callback == NULL) &&
+	    (pid >= 0) && (pid < DVBFILTER_MAX_PIDS) && !pool->no_add_pid) {
+		res = dvbfilter_add_shared(pool, pid);
+		if (res != -EOPNOTSUPP)
+			return res;
+	}
+
+	if ((fd = dvbfilter_take_fd(pool)) < 0)
+		return fd;
+
+	if ((res = dvbdemux_set_pid_filter(fd, pid, DVBDEMUX_INPUT_FRONTEND, output, 1)) != 0) {
+		if (res == -1)
+			res = -errno;
+		dvbfilter_release_fd(pool, fd);
+		return res;
+	}
+
+	return dvbfilter_new(pool, DVBFILTER_TYPE_PID, pid, fd, callback, arg);
+}
+
+int dvbfilter_remove(struct dvbfilter_pool *pool, int filter)
+{
+	struct dvbfilter *f;
+
+	if ((filter < 0) || (filter >= pool->filters_size) || !pool->filters[filter].used)
+		return -EINVAL;
+	f = &pool->filters[filter];
+
+	if (f->type == DVBFILTER_TYPE_SHARED) {
+		dvbfilter_unref_shared(pool, f->pid);
+	} else {
+		if (f->callback)
+			epoll_ctl(pool->epfd, EPOLL_CTL_DEL, f->fd, NULL);
+		dvbfilter_release_fd(pool, f->fd);
+	}
+
+	f->used = 0;
+	f->generation++;
+	pool->stats.filters--;
+
+	return 0;
+}
+
+void dvbfilter_remove_all(struct dvbfilter_pool *pool)
+{
+	int i;
+
+	for(i=0; i < pool->filters_size; i++) {
+		if (pool->filters[i].used)
+			dvbfilter_remove(pool, i);
+	}
+}
+
+int dvbfilter_get_fd(struct dvbfilter_pool *pool, int filter)
+{
+	if ((filter < 0) || (filter >= pool->filters_size) || !pool->filters[filter].used)
+		return -EINVAL;
+
+	if (pool->filters[filter].type == DVBFILTER_TYPE_SHARED)
+		return pool->shared_fd;
+	return pool->filters[filter].fd;
+}
+
+int dvbfilter_pool_get_shared_fd(struct dvbfilter_pool *pool)
+{
+	int fd;
+
+	if (pool->shared_fd == -1) {
+		if ((fd = dvbfilter_take_fd(pool)) < 0)
+			return fd;
+		pool->shared_fd = fd;
+	}
+
+	return pool->shared_fd;
+}
+
+int dvbfilter_pool_get_pollfd(struct dvbfilter_pool *pool)
+{
+	return pool->epfd;
+}
+
+int dvbfilter_pool_dispatch(struct dvbfilter_pool *pool, int timeout)
+{
+	struct epoll_event events[DVBFILTER_MAX_EVENTS];
+	int count;
+	int calls = 0;
+	int i;
+
+	count = epoll_wait(pool->epfd, events, DVBFILTER_MAX_EVENTS, timeout);
+	if (count < 0)
+		return (errno == EINTR) ? 0 : -errno;
+
+	for(i=0; i < count; i++) {
+		int filter = events[i].data.u64 & 0xffffffff;
+		uint32_t generation = events[i].data.u64 >> 32;
+		struct dvbfilter *f;
+
+		// an earlier callback may have removed or replaced this filter
+		if (filter >= pool->filters_size)
+			continue;
+		f = &pool->filters[filter];
+		if (!f->used || (f->generation != generation) || !f->callback)
+			continue;
+
+		f->callback(pool, filter, f->fd, f->arg);
+		calls++;
+	}
+
+	return calls;
+}
+
+void dvbfilter_pool_get_stats(struct dvbfilter_pool *pool,
+			      struct dvbfilter_pool_stats *stats)
+{
+	memcpy(stats, &pool->stats, sizeof(struct dvbfilter_pool_stats));
+}
+
+static int dvbfilter_take_fd(struct dvbfilter_pool *pool)
+{
+	int fd;
+
+	if (pool->idle_count) {
+		pool->stats.fds_reused++;
+		return pool->idle_fds[--pool->idle_count];
+	}
+
+	if ((fd = dvbdemux_open_demux(pool->adapter, pool->demuxdevice, 1)) < 0)
+		return -errno;
+	pool->stats.fds_opened++;
+	pool->stats.fds++;
+
+	return fd;
+}
+
+static void dvbfilter_release_fd(struct dvbfilter_pool *pool, int fd)
+{
+	int *tmp;
+
+	dvbdemux_stop(fd);
+
+	if (pool->idle_count == pool->idle_size) {
+		int size = pool->idle_size ? pool->idle_size * 2 : 16;
+
+		if ((tmp = realloc(pool->idle_fds, size * sizeof(int))) == NULL) {
+			close(fd);
+			pool->stats.fds--;
+			return;
+		}
+		pool->idle_fds = tmp;
+		pool->idle_size = size;
+	}
+	pool->idle_fds[pool->idle_count++] = fd;
+}
+
+static int dvbfilter_new(struct dvbfilter_pool *pool, int type, int pid, int fd,
+			 dvbfilter_callback callback, void *arg)
+{
+	struct dvbfilter *tmp;
+	struct epoll_event event;
+	int filter;
+
+	for(filter=0; filter < pool->filters_size; filter++) {
+		if (!pool->filters[filter].used)
+			break;
+	}
+	if (filter == pool->filters_size) {
+		int size = pool->filters_size ? pool->filters_size * 2 : 16;
+
+		if ((tmp = realloc(pool->filters, size * sizeof(struct dvbfilter))) == NULL)
+			goto fail;
+		memset(tmp + pool->filters_size, 0,
+		       (size - pool->filters_size) * sizeof(struct dvbfilter));
+		pool->filters = tmp;
+		pool->filters_size = size;
+	}
+
+	if (callback) {
+		memset(&event, 0, sizeof(event));
+		event.events = EPOLLIN | EPOLLPRI;
+		event.data.u64 = ((uint64_t) pool->filters[filter].generation << 32) | filter;
+		if (epoll_ctl(pool->epfd, EPOLL_CTL_ADD, fd, &event))
+			goto fail;
+	}
+
+	pool->filters[filter].used = 1;
+	pool->filters[filter].type = type;
+	pool->filters[filter].pid = pid;
+	pool->filters[filter].fd = fd;
+	pool->filters[filter].callback = callback;
+	pool->filters[filter].arg = arg;
+	pool->stats.filters++;
+
+	return filter;
+
+fail:
+	if (fd != -1)
+		dvbfilter_release_fd(pool, fd);
+	return -ENOMEM;
+}
+
+static int dvbfilter_add_shared(struct dvbfilter_pool *pool, int pid)
+{
+	int fd;
+	int res;
+
+	if (pool->shared_refs[pid] == 0) {
+		if ((fd = dvbfilter_pool_get_shared_fd(pool)) < 0)
+			return fd;
+
+		if (pool->shared_pids == 0) {
+			res = dvbdemux_set_pid_filter(fd, pid, DVBDEMUX_INPUT_FRONTEND,
+						      DVBDEMUX_OUTPUT_TS_DEMUX, 1);
+			if (res)
+				return (res == -1) ? -errno : res;
+		} else if (dvbdemux_add_pid(fd, pid)) {
+			if ((errno != ENOTTY) && (errno != EINVAL))
+				return -errno;
+			pool->no_add_pid = 1;
+			return -EOPNOTSUPP;
+		}
+		pool->shared_pids++;
+		pool->stats.pids_shared++;
+	}
+	pool->shared_refs[pid]++;
+
+	if ((res = dvbfilter_new(pool, DVBFILTER_TYPE_SHARED, pid, -1, NULL, NULL)) < 0)
+		dvbfilter_unref_shared(pool, pid);
+	return res;
+}
+
+static void dvbfilter_unref_shared(struct dvbfilter_pool *pool, int pid)
+{
+	if (--pool->shared_refs[pid])
+		return;
+	pool->stats.pids_shared--;
+
+	// the last PID stops the fd, which stays the shared fd for the next one
+	if (--pool->shared_pids == 0)
+		dvbdemux_stop(pool->shared_fd);
+	else
+		dvbdemux_remove_pid(pool->shared_fd, pid);
+}
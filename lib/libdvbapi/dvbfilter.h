@@ -0,0 +1,215 @@
+/*
+ * libdvbfilter - a pooled DVB demux filter manager
+ *
+ * Copyright (C) 2026 agent (agent@local)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef LIBDVBFILTER_H
+#define LIBDVBFILTER_H 1
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+
+/**
+ * A pool of demux file descriptors for one demux device.
+ *
+ * Every filter in dvbdemux.h needs its own demux fd, so an application
+ * which changes channel often ends up opening and closing the demux device
+ * over and over. The pool keeps the fds of removed filters open (stopped)
+ * and reprograms them for the next filter. PID filters with
+ * DVBDEMUX_OUTPUT_TS_DEMUX output and no callback are all put on one shared
+ * fd with DMX_ADD_PID, so a whole program can be read from a single fd.
+ *
+ * Filters which are read from (section filters, and PID filters with
+ * DVBDEMUX_OUTPUT_DEMUX or DVBDEMUX_OUTPUT_TS_DEMUX output) can be given a
+ * callback. They are then all watched by a single epoll instance, and the
+ * callbacks are run from dvbfilter_pool_dispatch().
+ *
+ * The demux fds are opened in nonblocking mode. A pool is not thread safe.
+ */
+struct dvbfilter_pool;
+
+/**
+ * Statistics of a pool, retrieved with dvbfilter_pool_get_stats().
+ */
+struct dvbfilter_pool_stats {
+	uint32_t filters;			/* filters currently set */
+	uint32_t fds;				/* demux fds currently open */
+	uint32_t fds_opened;			/* demux device opens */
+	uint32_t fds_reused;			/* filters set on an idle fd */
+	uint32_t pids_shared;			/* distinct PIDs on the shared fd */
+};
+
+/**
+ * Callback run by dvbfilter_pool_dispatch() when a filter's fd is readable.
+ * The callback should read() the fd until it would block. It may remove
+ * any filter, including its own.
+ *
+ * @param pool The pool.
+ * @param filter ID of the filter.
+ * @param fd The filter's demux fd.
+ * @param arg The arg given when the filter was added.
+ */
+typedef void (*dvbfilter_callback)(struct dvbfilter_pool *pool, int filter, int fd, void *arg);
+
+/**
+ * Create a filter pool.
+ *
+ * @param adapter Index of the DVB adapter.
+ * @param demuxdevice Index of the demux device on that adapter (usually 0).
+ * @return The pool, or NULL on failure.
+ */
+extern struct dvbfilter_pool *dvbfilter_pool_create(int adapter, int demuxdevice);
+
+/**
+ * Destroy a pool, removing its filters and closing all its fds.
+ *
+ * @param pool The pool.
+ */
+extern void dvbfilter_pool_destroy(struct dvbfilter_pool *pool);
+
+/**
+ * Add a section filter. The parameters are as for
+ * dvbdemux_set_section_filter(); the filter is started immediately.
+ *
+ * @param pool The pool.
+ * @param pid PID of the stream.
+ * @param filter The filter values of the first 18 bytes of the desired sections.
+ * @param mask Bitmask indicating which bits in the filter array should be tested.
+ * @param checkcrc If 1, the driver will check the CRC on the table sections.
+ * @param callback Function to call when sections can be read, or NULL to
+ * read the fd from dvbfilter_get_fd() yourself.
+ * @param arg Argument to pass to the callback.
+ * @return The filter ID (>= 0), or a negative value on failure.
+ */
+extern int dvbfilter_add_section(struct dvbfilter_pool *pool, int pid,
+				 uint8_t filter[18], uint8_t mask[18], int checkcrc,
+				 dvbfilter_callback callback, void *arg);
+
+/**
+ * Add a filter sending a PES stream to the hardware decoder. The
+ * parameters are as for dvbdemux_set_pes_filter(), with input
+ * DVBDEMUX_INPUT_FRONTEND and output DVBDEMUX_OUTPUT_DECODER.
+ *
+ * @param pool The pool.
+ * @param pid PID of the stream.
+ * @param pestype One of DVBDEMUX_PESTYPE_*.
+ * @return The filter ID (>= 0), or a negative value on failure.
+ */
+extern int dvbfilter_add_decoder(struct dvbfilter_pool *pool, int pid, int pestype);
+
+/**
+ * Add a PID filter reading from the frontend. The parameters are as for
+ * dvbdemux_set_pid_filter().
+ *
+ * A DVBDEMUX_OUTPUT_TS_DEMUX filter without a callback goes on the shared fd
+ * (see dvbfilter_pool_get_shared_fd()). Its PIDs are reference counted, so
+ * adding the same PID twice does not duplicate its packets. If the kernel
+ * cannot add PIDs to a filter, such filters get an fd of their own instead;
+ * compare dvbfilter_get_fd() with the shared fd to tell. Every other filter
+ * has its own fd, so the same PID added twice with DVBDEMUX_OUTPUT_DVR is
+ * output twice.
+ *
+ * @param pool The pool.
+ * @param pid PID to retrieve, or -1 as a wildcard for ALL PIDs.
+ * @param output One of DVBDEMUX_OUTPUT_DEMUX, DVBDEMUX_OUTPUT_DVR or
+ * DVBDEMUX_OUTPUT_TS_DEMUX.
+ * @param callback Function to call when data can be read from the demux
+ * fd, or NULL. Must be NULL for DVBDEMUX_OUTPUT_DVR.
+ * @param arg Argument to pass to the callback.
+ * @return The filter ID (>= 0), or a negative value on failure.
+ */
+extern int dvbfilter_add_pid(struct dvbfilter_pool *pool, int pid, int output,
+			     dvbfilter_callback callback, void *arg);
+
+/**
+ * Remove a filter. Its fd is stopped and kept for the next filter.
+ *
+ * @param pool The pool.
+ * @param filter ID of the filter.
+ * @return 0 on success, or -EINVAL if there is no such filter.
+ */
+extern int dvbfilter_remove(struct dvbfilter_pool *pool, int filter);
+
+/**
+ * Remove all the filters, for example before retuning. The fds stay open
+ * for the filters of the next channel.
+ *
+ * @param pool The pool.
+ */
+extern void dvbfilter_remove_all(struct dvbfilter_pool *pool);
+
+/**
+ * Get the demux fd of a filter, for read()ing sections or PES data.
+ * Filters on the shared fd return that fd.
+ *
+ * @param pool The pool.
+ * @param filter ID of the filter.
+ * @return The fd, or -EINVAL if there is no such filter.
+ */
+extern int dvbfilter_get_fd(struct dvbfilter_pool *pool, int filter);
+
+/**
+ * Get the fd shared by the DVBDEMUX_OUTPUT_TS_DEMUX PID filters, opening it
+ * if need be. It stays the same for the life of the pool, so it can be
+ * polled and read() before any PIDs are added; it is stopped while it has
+ * none. Its buffer size can be set with dvbdemux_set_buffer() before the
+ * first PID is added.
+ *
+ * @param pool The pool.
+ * @return The fd, or a negative value on failure.
+ */
+extern int dvbfilter_pool_get_shared_fd(struct dvbfilter_pool *pool);
+
+/**
+ * Get a file descriptor which polls readable (POLLIN) when one of the
+ * filters with a callback has data; dvbfilter_pool_dispatch() should then
+ * be called. This lets the pool be part of a bigger poll() loop.
+ *
+ * @param pool The pool.
+ * @return The epoll fd.
+ */
+extern int dvbfilter_pool_get_pollfd(struct dvbfilter_pool *pool);
+
+/**
+ * Wait for filters to become readable and run their callbacks.
+ *
+ * @param pool The pool.
+ * @param timeout Milliseconds to wait; 0 to return immediately, <0 to wait
+ * forever.
+ * @return Number of callbacks run, or a negative value on failure.
+ */
+extern int dvbfilter_pool_dispatch(struct dvbfilter_pool *pool, int timeout);
+
+/**
+ * Retrieve the statistics of a pool.
+ *
+ * @param pool The pool.
+ * @param stats Where to put the statistics.
+ */
+extern void dvbfilter_pool_get_stats(struct dvbfilter_pool *pool,
+				     struct dvbfilter_pool_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LIBDVBFILTER_H
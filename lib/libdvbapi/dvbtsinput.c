@@ -0,0 +1,405 @@
+/*
+ * libdvbtsinput - transport stream input
+ *
+ * Copyright (C) 2026 agent (agent@local)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include "dvbdemux.h"
+#include "dvbtsinput.h"
+
+#define SYNC_BYTE 0x47
+
+struct dvbtsinput {
+	int type;
+	int fd;
+	int own_fd;
+
+	// DVBTSINPUT_TYPE_MMAP
+	uint8_t *map;
+	size_t map_len;
+	size_t start;		/* offset of the first packet */
+	size_t pos;		/* offset of the next packet */
+
+	// DVBTSINPUT_TYPE_STREAM/DVR
+	uint8_t *buf;
+	size_t bufsize;
+	size_t carry;		/* offset of the bytes to keep for the next read */
+	size_t carry_len;	/* number of them */
+	off_t offset;		/* file offset read up to */
+	int synced;
+	int eof;
+
+	uint32_t sync_losses;
+};
+
+static struct dvbtsinput *dvbtsinput_alloc(int fd, int type, int own_fd);
+static int dvbtsinput_map(struct dvbtsinput *input);
+static int dvbtsinput_read_fd(struct dvbtsinput *input, uint8_t **packets, int timeout);
+static int dvbtsinput_next_packets(struct dvbtsinput *input, size_t *len, uint8_t **packets);
+static size_t dvbtsinput_count_synced(uint8_t *buf, size_t len, size_t max);
+static ssize_t dvbtsinput_find_sync(uint8_t *buf, size_t len, int final);
+
+struct dvbtsinput *dvbtsinput_open_file(const char *filename, int type)
+{
+	struct dvbtsinput *input;
+	int fd;
+
+	if ((type != DVBTSINPUT_TYPE_MMAP) && (type != DVBTSINPUT_TYPE_STREAM))
+		return NULL;
+
+	if ((fd = open(filename, O_RDONLY)) < 0)
+		return NULL;
+	if ((input = dvbtsinput_alloc(fd, type, 1)) == NULL) {
+		close(fd);
+		return NULL;
+	}
+
+	if (type == DVBTSINPUT_TYPE_MMAP) {
+		if (dvbtsinput_map(input) == 0)
+			return input;
+
+		// fall back to streaming it
+		dvbtsinput_close(input);
+		if ((fd = open(filename, O_RDONLY)) < 0)
+			return NULL;
+		if ((input = dvbtsinput_alloc(fd, DVBTSINPUT_TYPE_STREAM, 1)) == NULL) {
+			close(fd);
+			return NULL;
+		}
+	}
+
+	posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+	return input;
+}
+
+struct dvbtsinput *dvbtsinput_open_dvr(int adapter, int dvrdevice, size_t bufsize)
+{
+	struct dvbtsinput *input;
+	int fd;
+
+	if ((fd = dvbdemux_open_dvr(adapter, dvrdevice, 1, 1)) < 0)
+		return NULL;
+	if (bufsize)
+		dvbdemux_set_buffer(fd, bufsize);
+
+	if ((input = dvbtsinput_alloc(fd, DVBTSINPUT_TYPE_DVR, 1)) == NULL) {
+		close(fd);
+		return NULL;
+	}
+
+	return input;
+}
+
+struct dvbtsinput *dvbtsinput_open_fd(int fd, int type)
+{
+	if ((type != DVBTSINPUT_TYPE_STREAM) && (type != DVBTSINPUT_TYPE_DVR))
+		return NULL;
+
+	return dvbtsinput_alloc(fd, type, 0);
+}
+
+void dvbtsinput_close(struct dvbtsinput *input)
+{
+	if (input->map)
+		munmap(input->map, input->map_len);
+	if (input->own_fd)
+		close(input->fd);
+	free(input->buf);
+	free(input);
+}
+
+int dvbtsinput_read(struct dvbtsinput *input, uint8_t **packets, int timeout)
+{
+	size_t count;
+	ssize_t sync;
+
+	if (input->type != DVBTSINPUT_TYPE_MMAP)
+		return dvbtsinput_read_fd(input, packets, timeout);
+
+	while(1) {
+		count = dvbtsinput_count_synced(input->map + input->pos,
+						input->map_len - input->pos,
+						DVBTSINPUT_DEFAULT_PACKETS);
+		if (count || ((input->map_len - input->pos) < DVBTSINPUT_PACKET_LENGTH))
+			break;
+
+		// lost sync; the whole of the rest of the file is here to find it in
+		input->sync_losses++;
+		sync = dvbtsinput_find_sync(input->map + input->pos,
+					    input->map_len - input->pos, 1);
+		input->pos = (sync < 0) ? input->map_len : input->pos + sync;
+	}
+
+	*packets = input->map + input->pos;
+	input->pos += count * DVBTSINPUT_PACKET_LENGTH;
+
+	return count;
+}
+
+int dvbtsinput_rewind(struct dvbtsinput *input)
+{
+	switch(input->type) {
+	case DVBTSINPUT_TYPE_MMAP:
+		input->pos = input->start;
+		return 0;
+
+	case DVBTSINPUT_TYPE_STREAM:
+		if (lseek(input->fd, 0, SEEK_SET) < 0)
+			return -1;
+		input->offset = 0;
+		input->carry_len = 0;
+		input->synced = 0;
+		input->eof = 0;
+		return 0;
+	}
+
+	return -1;
+}
+
+int dvbtsinput_fd(struct dvbtsinput *input)
+{
+	if (input->type == DVBTSINPUT_TYPE_MMAP)
+		return -1;
+	return input->fd;
+}
+
+int dvbtsinput_type(struct dvbtsinput *input)
+{
+	return input->type;
+}
+
+uint32_t dvbtsinput_sync_losses(struct dvbtsinput *input)
+{
+	return input->sync_losses;
+}
+
+static struct dvbtsinput *dvbtsinput_alloc(int fd, int type, int own_fd)
+{
+	struct dvbtsinput *input;
+
+	input = (struct dvbtsinput *) malloc(sizeof(struct dvbtsinput));
+	if (input == NULL)
+		return NULL;
+	memset(input, 0, sizeof(struct dvbtsinput));
+	input->type = type;
+	input->fd = fd;
+	input->own_fd = own_fd;
+
+	if (type != DVBTSINPUT_TYPE_MMAP) {
+		input->bufsize = DVBTSINPUT_DEFAULT_PACKETS * DVBTSINPUT_PACKET_LENGTH;
+		if ((input->buf = (uint8_t *) malloc(input->bufsize)) == NULL) {
+			free(input);
+			return NULL;
+		}
+	}
+
+	return input;
+}
+
+static int dvbtsinput_map(struct dvbtsinput *input)
+{
+	struct stat st;
+	ssize_t sync;
+	void *map;
+
+	if ((fstat(input->fd, &st) < 0) || (!S_ISREG(st.st_mode)) || (st.st_size == 0))
+		return -1;
+	if ((off_t) (size_t) st.st_size != st.st_size)
+		return -1;
+
+	// private, so modifying packets in place never writes back to the file
+	map = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, input->fd, 0);
+	if (map == MAP_FAILED)
+		return -1;
+	madvise(map, st.st_size, MADV_SEQUENTIAL);
+
+	input->map = (uint8_t *) map;
+	input->map_len = st.st_size;
+	if ((sync = dvbtsinput_find_sync(input->map, input->map_len, 1)) < 0)
+		sync = input->map_len;
+	input->start = input->pos = sync;
+
+	return 0;
+}
+
+static int dvbtsinput_read_fd(struct dvbtsinput *input, uint8_t **packets, int timeout)
+{
+	struct pollfd pollfd;
+	size_t len;
+	ssize_t sz;
+	int ret;
+
+	// keep any partial packet from last time
+	if (input->carry_len)
+		memmove(input->buf, input->buf + input->carry, input->carry_len);
+	len = input->carry_len;
+	input->carry_len = 0;
+
+	while (1) {
+		if (!input->eof) {
+			if (input->type == DVBTSINPUT_TYPE_DVR) {
+				pollfd.fd = input->fd;
+				pollfd.events = POLLIN | POLLPRI;
+				if ((ret = poll(&pollfd, 1, timeout)) < 0) {
+					if (errno == EINTR)
+						continue;
+					return -errno;
+				}
+				if (ret == 0) {
+					input->carry = 0;
+					input->carry_len = len;
+					return -ETIMEDOUT;
+				}
+			}
+
+			if ((sz = read(input->fd, input->buf + len, input->bufsize - len)) < 0) {
+				if ((errno == EINTR) || (errno == EAGAIN))
+					continue;
+				if (errno == EOVERFLOW) {
+					// the data is discontinuous, so we'll need to resync
+					input->synced = 0;
+					return -EOVERFLOW;
+				}
+				return -errno;
+			}
+			if (sz == 0) {
+				input->eof = 1;
+			} else {
+				len += sz;
+			}
+
+			if ((sz > 0) && (input->type == DVBTSINPUT_TYPE_STREAM)) {
+				// read the next chunk in while this one is processed, and
+				// drop the one before from the cache
+				posix_fadvise(input->fd, input->offset + sz, input->bufsize,
+					      POSIX_FADV_WILLNEED);
+				if (input->offset > (off_t) input->bufsize)
+					posix_fadvise(input->fd, 0, input->offset - input->bufsize,
+						      POSIX_FADV_DONTNEED);
+				input->offset += sz;
+			}
+		}
+
+		// any trailing partial packet is dropped at the end
+		if ((ret = dvbtsinput_next_packets(input, &len, packets)) || input->eof)
+			return ret;
+	}
+}
+
+/*
+ * Return the run of packets at the start of the buffer which begin with a
+ * sync byte, finding sync first if need be. If none are complete yet, the
+ * buffer is trimmed to what must be kept and 0 is returned.
+ */
+static int dvbtsinput_next_packets(struct dvbtsinput *input, size_t *len, uint8_t **packets)
+{
+	ssize_t sync;
+	size_t count;
+
+	while(1) {
+		sync = 0;
+		if (!input->synced) {
+			if ((sync = dvbtsinput_find_sync(input->buf, *len, input->eof)) < 0) {
+				// keep enough to find it next time
+				if (*len >= (2 * DVBTSINPUT_PACKET_LENGTH)) {
+					memmove(input->buf,
+						input->buf + *len - (2 * DVBTSINPUT_PACKET_LENGTH),
+						2 * DVBTSINPUT_PACKET_LENGTH);
+					*len = 2 * DVBTSINPUT_PACKET_LENGTH;
+				}
+				return 0;
+			}
+			input->synced = 1;
+		}
+
+		count = dvbtsinput_count_synced(input->buf + sync, *len - sync, (size_t) -1);
+		if (count)
+			break;
+
+		if ((*len - sync) >= DVBTSINPUT_PACKET_LENGTH) {
+			// a whole packet without a sync byte: find it again
+			input->sync_losses++;
+			input->synced = 0;
+			continue;
+		}
+
+		// wait for the rest of the packet
+		if (sync) {
+			memmove(input->buf, input->buf + sync, *len - sync);
+			*len -= sync;
+		}
+		return 0;
+	}
+
+	*packets = input->buf + sync;
+	input->carry = sync + (count * DVBTSINPUT_PACKET_LENGTH);
+	input->carry_len = *len - input->carry;
+
+	// the run ended at a packet without a sync byte, which is carried over
+	// and resynced from next time
+	if (input->carry_len >= DVBTSINPUT_PACKET_LENGTH) {
+		input->sync_losses++;
+		input->synced = 0;
+	}
+
+	return count;
+}
+
+static size_t dvbtsinput_count_synced(uint8_t *buf, size_t len, size_t max)
+{
+	size_t count = 0;
+
+	while((count < max) && (len >= DVBTSINPUT_PACKET_LENGTH) && (buf[0] == SYNC_BYTE)) {
+		buf += DVBTSINPUT_PACKET_LENGTH;
+		len -= DVBTSINPUT_PACKET_LENGTH;
+		count++;
+	}
+
+	return count;
+}
+
+static ssize_t dvbtsinput_find_sync(uint8_t *buf, size_t len, int final)
+{
+	size_t i;
+
+	// a sync byte followed by two more a packet apart, or as many as fit
+	for(i=0; i < len; i++) {
+		if (buf[i] != SYNC_BYTE)
+			continue;
+		if (((i + DVBTSINPUT_PACKET_LENGTH) < len) &&
+		    (buf[i + DVBTSINPUT_PACKET_LENGTH] != SYNC_BYTE))
+			continue;
+		if (((i + (2 * DVBTSINPUT_PACKET_LENGTH)) < len) &&
+		    (buf[i + (2 * DVBTSINPUT_PACKET_LENGTH)] != SYNC_BYTE))
+			continue;
+		// can't confirm it until more data arrives, unless there is no more
+		if (((i + (2 * DVBTSINPUT_PACKET_LENGTH)) >= len) && !final)
+			return -1;
+		return i;
+	}
+
+	return -1;
+}
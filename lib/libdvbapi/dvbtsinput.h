@@ -0,0 +1,163 @@
+/*
+ * libdvbtsinput - transport stream input
+ *
+ * Copyright (C) 2026 agent (agent@local)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef LIBDVBTSINPUT_H
+#define LIBDVBTSINPUT_H 1
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * Length of a transport stream packet.
+ */
+#define DVBTSINPUT_PACKET_LENGTH 188
+
+/**
+ * Default number of packets returned by each dvbtsinput_read() for files,
+ * and the default buffer size for live sources.
+ */
+#define DVBTSINPUT_DEFAULT_PACKETS 4096
+
+/**
+ * Types of transport stream input.
+ *
+ * MMAP. A recording is mapped into memory in one go, and packets are
+ * returned directly from the mapping with nothing copied. Best for whole
+ * file analysis of recordings which fit in the address space.
+ *
+ * STREAM. A recording is read in large chunks, with readahead requested
+ * for the next chunk, and the pages already processed dropped from the
+ * page cache, so multi-GB captures can be processed at disk speed without
+ * evicting everything else.
+ *
+ * DVR. Packets are read from a live DVR device (or any other fd, e.g. a
+ * pipe), waiting for them to arrive.
+ */
+enum dvbtsinput_type {
+	DVBTSINPUT_TYPE_MMAP,
+	DVBTSINPUT_TYPE_STREAM,
+	DVBTSINPUT_TYPE_DVR,
+};
+
+/**
+ * Opaque type representing a transport stream input.
+ */
+struct dvbtsinput;
+
+/**
+ * Open a recorded transport stream. If the file does not start on a packet
+ * boundary, the data before the first sync byte is skipped.
+ *
+ * @param filename Name of the file.
+ * @param type DVBTSINPUT_TYPE_MMAP or DVBTSINPUT_TYPE_STREAM. If mapping the
+ * file fails, DVBTSINPUT_TYPE_MMAP falls back to DVBTSINPUT_TYPE_STREAM.
+ * @return The new instance, or NULL on error.
+ */
+extern struct dvbtsinput *dvbtsinput_open_file(const char *filename, int type);
+
+/**
+ * Open the DVR device of an adapter for live input.
+ *
+ * @param adapter Index of the DVB adapter.
+ * @param dvrdevice Index of the dvr device on that adapter (usually 0).
+ * @param bufsize Size of the kernel DVR buffer to request, or 0 to leave it alone.
+ * @return The new instance, or NULL on error.
+ */
+extern struct dvbtsinput *dvbtsinput_open_dvr(int adapter, int dvrdevice, size_t bufsize);
+
+/**
+ * Use an already open file descriptor. It is not closed by
+ * dvbtsinput_close().
+ *
+ * @param fd The file descriptor.
+ * @param type DVBTSINPUT_TYPE_STREAM for a file, or DVBTSINPUT_TYPE_DVR for a
+ * device or pipe.
+ * @return The new instance, or NULL on error.
+ */
+extern struct dvbtsinput *dvbtsinput_open_fd(int fd, int type);
+
+/**
+ * Close a transport stream input.
+ *
+ * @param input The instance to close.
+ */
+extern void dvbtsinput_close(struct dvbtsinput *input);
+
+/**
+ * Retrieve the next batch of packets. The packets remain valid until the
+ * next call, and may be modified in place (an mmapped recording is mapped
+ * privately, so it is never written back). Every packet returned starts
+ * with a sync byte: if the stream loses sync, the batch ends before the
+ * packet without one, and sync is found again for the next batch.
+ *
+ * @param input The transport stream input.
+ * @param packets Set to point to the first packet.
+ * @param timeout For DVR inputs, milliseconds to wait for data, or -1 to
+ * wait forever. Ignored for files.
+ * @return Number of packets (> 0), 0 at the end of the stream, -ETIMEDOUT if
+ * nothing arrived in time, -EOVERFLOW if a live input overflowed (data was
+ * lost; reading may continue), or another negative error code.
+ */
+extern int dvbtsinput_read(struct dvbtsinput *input, uint8_t **packets, int timeout);
+
+/**
+ * Go back to the start of a recording.
+ *
+ * @param input The transport stream input.
+ * @return 0 on success, or -1 if the input is live.
+ */
+extern int dvbtsinput_rewind(struct dvbtsinput *input);
+
+/**
+ * Get the file descriptor of an input (e.g. to poll() on it).
+ *
+ * @param input The transport stream input.
+ * @return The file descriptor, or -1 for an mmapped recording.
+ */
+extern int dvbtsinput_fd(struct dvbtsinput *input);
+
+/**
+ * Get the type of an input (which may differ from the one requested, if
+ * mmap failed).
+ *
+ * @param input The transport stream input.
+ * @return One of enum dvbtsinput_type.
+ */
+extern int dvbtsinput_type(struct dvbtsinput *input);
+
+/**
+ * Get the number of times an input has lost sync, i.e. found a packet not
+ * starting with a sync byte and had to look for it again.
+ *
+ * @param input The transport stream input.
+ * @return The count.
+ */
+extern uint32_t dvbtsinput_sync_losses(struct dvbtsinput *input);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LIBDVBTSINPUT_H
@@ -0,0 +1,98 @@
+/*
+ * libdvbtun - TUN device output for userspace IP reception
+ *
+ * Copyright (C) 2026 agent (agent@local)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/ioctl.h>
+#include <sys/uio.h>
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <linux/if_tun.h>
+#include "dvbtun.h"
+
+#ifndef IFF_MULTI_QUEUE
+#define IFF_MULTI_QUEUE 0x0100
+#endif
+
+int dvbtun_open(char *name, int flags)
+{
+	struct ifreq ifr;
+	int fd;
+
+	if ((fd = open("/dev/net/tun", O_RDWR)) < 0)
+		return -1;
+
+	memset(&ifr, 0, sizeof(ifr));
+	ifr.ifr_flags = IFF_TUN;
+	if (flags & DVBTUN_FLAG_MULTI_QUEUE)
+		ifr.ifr_flags |= IFF_MULTI_QUEUE;
+	strncpy(ifr.ifr_name, name, IFNAMSIZ - 1);
+
+	if (ioctl(fd, TUNSETIFF, &ifr) < 0) {
+		close(fd);
+		return -1;
+	}
+
+	strncpy(name, ifr.ifr_name, DVBTUN_NAME_LENGTH - 1);
+	name[DVBTUN_NAME_LENGTH - 1] = 0;
+	return fd;
+}
+
+int dvbtun_write_batch(int fd, struct dvbtun_packet *packets, int count)
+{
+	struct tun_pi pi;
+	struct iovec iov[2];
+	int written = 0;
+	int i;
+
+	pi.flags = 0;
+	iov[0].iov_base = &pi;
+	iov[0].iov_len = sizeof(pi);
+
+	for(i=0; i < count; i++) {
+		pi.proto = htons(packets[i].protocol);
+		iov[1].iov_base = packets[i].data;
+		iov[1].iov_len = packets[i].len;
+
+		if (writev(fd, iov, 2) >= 0) {
+			written++;
+			continue;
+		}
+
+		switch(errno) {
+		case EINTR:
+			i--;
+			break;
+
+		case EINVAL:
+		case ENOMEM:
+		case ENOBUFS:
+			// this datagram was refused: drop it
+			break;
+
+		default:
+			return written ? written : -1;
+		}
+	}
+
+	return written;
+}
@@ -0,0 +1,90 @@
+/*
+ * libdvbtun - TUN device output for userspace IP reception
+ *
+ * Copyright (C) 2026 agent (agent@local)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef LIBDVBTUN_H
+#define LIBDVBTUN_H 1
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * Size of the buffer to pass to dvbtun_open() for the interface name.
+ */
+#define DVBTUN_NAME_LENGTH 16
+
+/**
+ * Flags for dvbtun_open().
+ */
+enum dvbtun_flags {
+	/*
+	 * Open one queue of a multiqueue device: several processes or threads
+	 * may each open the same interface name with this flag, and write to it
+	 * independently, without contending on one file descriptor.
+	 */
+	DVBTUN_FLAG_MULTI_QUEUE		= 0x01,
+};
+
+/**
+ * An IP datagram to write to a TUN device.
+ */
+struct dvbtun_packet {
+	uint8_t *data;		/* the datagram */
+	size_t len;		/* its length */
+	uint16_t protocol;	/* ethertype, e.g. 0x0800 for IPv4 or 0x86dd for IPv6 */
+};
+
+/**
+ * Open (creating if necessary) a TUN network interface. The interface must
+ * still be configured and brought up in the usual way (e.g. with ip(8)).
+ *
+ * @param name On entry, the name of the interface to open, or an empty
+ * string to let the kernel choose one (e.g. "tun0"); on return, the name of
+ * the interface. Must be DVBTUN_NAME_LENGTH bytes long.
+ * @param flags Orred enum dvbtun_flags.
+ * @return A unix file descriptor on success, or -1 on failure.
+ */
+extern int dvbtun_open(char *name, int flags);
+
+/**
+ * Write a batch of IP datagrams to a TUN device. The kernel accepts exactly
+ * one datagram per write, so each one is passed with a single writev() of the
+ * packet information header and the datagram in place, without copying it.
+ * A datagram the kernel refuses (e.g. as malformed, or for lack of memory)
+ * is dropped and the rest are still written, but if the device itself fails
+ * (or would block) writing stops there.
+ *
+ * @param fd FD opened with dvbtun_open().
+ * @param packets The datagrams.
+ * @param count Number of datagrams.
+ * @return Number of datagrams written, or -1 if writing stopped before any
+ * were (errno is set).
+ */
+extern int dvbtun_write_batch(int fd, struct dvbtun_packet *packets, int count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LIBDVBTUN_H
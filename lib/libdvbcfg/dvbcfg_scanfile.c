@@ -23,6 +23,7 @@
 #define _GNU_SOURCE
 
 #include <malloc.h>
+#include <string.h>
 #include <ctype.h>
 
 #include "dvbcfg_scanfile.h"
@@ -37,11 +38,30 @@ static const struct dvbcfg_setting dvbcfg_fec_list[] = {
 	{ "6/7",  DVBFE_FEC_6_7  },
 	{ "7/8",  DVBFE_FEC_7_8  },
 	{ "8/9",  DVBFE_FEC_8_9  },
+	{ "3/5",  DVBFE_FEC_3_5  },
+	{ "9/10", DVBFE_FEC_9_10 },
 	{ "AUTO", DVBFE_FEC_AUTO },
 	{ "NONE", DVBFE_FEC_NONE },
 	{ NULL, 0 }
 };
 
+static const struct dvbcfg_setting dvbcfg_dvbs_rolloff_list[] = {
+	{ "35",   DVBFE_DVBS_ROLLOFF_35   },
+	{ "25",   DVBFE_DVBS_ROLLOFF_25   },
+	{ "20",   DVBFE_DVBS_ROLLOFF_20   },
+	{ "AUTO", DVBFE_DVBS_ROLLOFF_AUTO },
+	{ NULL, 0 }
+};
+
+static const struct dvbcfg_setting dvbcfg_dvbs_modulation_list[] = {
+	{ "QPSK",   DVBFE_DVBS_MOD_QPSK   },
+	{ "8PSK",   DVBFE_DVBS_MOD_8PSK   },
+	{ "16APSK", DVBFE_DVBS_MOD_16APSK },
+	{ "32APSK", DVBFE_DVBS_MOD_32APSK },
+	{ "AUTO",   DVBFE_DVBS_MOD_AUTO   },
+	{ NULL, 0 }
+};
+
 static const struct dvbcfg_setting dvbcfg_dvbc_modulation_list[] = {
 	{ "QAM16",   DVBFE_DVBC_MOD_QAM_16  },
 	{ "QAM32",   DVBFE_DVBC_MOD_QAM_32  },
@@ -115,15 +135,21 @@ int dvbcfg_scanfile_parse(FILE *file, dvbcfg_scancallback callback, void *privat
 		char *line_tmp = line_buf;
 		char *line_pos = line_buf;
 		struct dvbcfg_scanfile tmp;
+		int dvbs2;
 
 		/* remove newline and comments (started with hashes) */
 		while ((*line_tmp != '\0') && (*line_tmp != '\n') && (*line_tmp != '#'))
 			line_tmp++;
 		*line_tmp = '\0';
 
+		memset(&tmp.fe_params, 0, sizeof(tmp.fe_params));
+
 		/* always use inversion auto */
 		tmp.fe_params.inversion = DVBFE_INVERSION_AUTO;
 
+		/* DVB-S2 entries are marked "S2" */
+		dvbs2 = (line_pos[0] == 'S') && (line_pos[1] == '2');
+
 		/* parse frontend type */
 		switch(dvbcfg_parse_char(&line_pos, " ")) {
 		case 'T':
@@ -213,6 +239,22 @@ int dvbcfg_scanfile_parse(FILE *file, dvbcfg_scancallback callback, void *privat
 			if (!line_pos)
 				continue;
 
+			if (!dvbs2)
+				break;
+			tmp.fe_params.u.dvbs.system = DVBFE_DVBS_SYSTEM_DVBS2;
+
+			/* rolloff */
+			tmp.fe_params.u.dvbs.rolloff =
+				dvbcfg_parse_setting(&line_pos, " ", dvbcfg_dvbs_rolloff_list);
+			if (!line_pos)
+				continue;
+
+			/* modulation */
+			tmp.fe_params.u.dvbs.modulation =
+				dvbcfg_parse_setting(&line_pos, " ", dvbcfg_dvbs_modulation_list);
+			if (!line_pos)
+				continue;
+
 			break;
 
 		case DVBFE_TYPE_DVBT:
@@ -45,6 +45,8 @@ static const struct dvbcfg_setting dvbcfg_fec_list[] = {
 	{ "FEC_6_7",  DVBFE_FEC_6_7  },
 	{ "FEC_7_8",  DVBFE_FEC_7_8  },
 	{ "FEC_8_9",  DVBFE_FEC_8_9  },
+	{ "FEC_3_5",  DVBFE_FEC_3_5  },
+	{ "FEC_9_10", DVBFE_FEC_9_10 },
 	{ "FEC_AUTO", DVBFE_FEC_AUTO },
 	{ "FEC_NONE", DVBFE_FEC_NONE },
 	{ NULL, 0 }
@@ -128,6 +130,7 @@ int dvbcfg_zapchannel_parse(FILE *file, dvbcfg_zapcallback callback, void *priva
 		while ((*line_tmp != '\0') && (*line_tmp != '\n') && (*line_tmp != '#'))
 			line_tmp++;
 		*line_tmp = '\0';
+		memset(&tmp.fe_params, 0, sizeof(tmp.fe_params));
 
 		/* parse name */
 		dvbcfg_parse_string(&line_pos, ":", tmp.name, sizeof(tmp.name));
@@ -30,6 +30,15 @@
 // uncomment this to make dvbsec_command print out debug instead of talking to a frontend
 // #define TEST_SEC_COMMAND 1
 
+static int dvbsec_prepare(struct dvbfe_handle *fe,
+			  struct dvbsec_config *sec_config,
+			  enum dvbsec_diseqc_polarization polarization,
+			  enum dvbsec_diseqc_switch sat_pos,
+			  enum dvbsec_diseqc_switch switch_option,
+			  struct dvbfe_parameters *params,
+			  struct dvbfe_parameters *localparams,
+			  struct dvbfe_parameters **topass);
+
 int dvbsec_set(struct dvbfe_handle *fe,
 		   struct dvbsec_config *sec_config,
 		   enum dvbsec_diseqc_polarization polarization,
@@ -40,7 +49,49 @@ int dvbsec_set(struct dvbfe_handle *fe,
 {
 	int tmp;
 	struct dvbfe_parameters localparams;
-	struct dvbfe_parameters *topass = params;
+	struct dvbfe_parameters *topass;
+
+	if ((tmp = dvbsec_prepare(fe, sec_config, polarization, sat_pos, switch_option,
+				  params, &localparams, &topass)) < 0)
+		return tmp;
+
+	// set the frontend!
+	return dvbfe_set(fe, topass, timeout);
+}
+
+int dvbsec_set_async(struct dvbfe_handle *fe,
+		     struct dvbsec_config *sec_config,
+		     enum dvbsec_diseqc_polarization polarization,
+		     enum dvbsec_diseqc_switch sat_pos,
+		     enum dvbsec_diseqc_switch switch_option,
+		     struct dvbfe_parameters *params,
+		     int timeout,
+		     dvbfe_tune_callback callback,
+		     void *arg)
+{
+	int tmp;
+	struct dvbfe_parameters localparams;
+	struct dvbfe_parameters *topass;
+
+	if ((tmp = dvbsec_prepare(fe, sec_config, polarization, sat_pos, switch_option,
+				  params, &localparams, &topass)) < 0)
+		return tmp;
+
+	return dvbfe_set_async(fe, topass, timeout, callback, arg);
+}
+
+static int dvbsec_prepare(struct dvbfe_handle *fe,
+			  struct dvbsec_config *sec_config,
+			  enum dvbsec_diseqc_polarization polarization,
+			  enum dvbsec_diseqc_switch sat_pos,
+			  enum dvbsec_diseqc_switch switch_option,
+			  struct dvbfe_parameters *params,
+			  struct dvbfe_parameters *localparams,
+			  struct dvbfe_parameters **topass)
+{
+	int tmp;
+
+	*topass = params;
 
 	// perform SEC
 	if (sec_config != NULL) {
@@ -156,18 +207,17 @@ int dvbsec_set(struct dvbfe_handle *fe,
 
 		// do frequency adjustment
 		if (lof) {
-			memcpy(&localparams, params, sizeof(struct dvbfe_parameters));
-			int tmpfreq = localparams.frequency - lof;
+			memcpy(localparams, params, sizeof(struct dvbfe_parameters));
+			int tmpfreq = localparams->frequency - lof;
 
 			if (tmpfreq < 0)
 				tmpfreq *= -1;
-			localparams.frequency = (uint32_t) tmpfreq;
-			topass = &localparams;
+			localparams->frequency = (uint32_t) tmpfreq;
+			*topass = localparams;
 		}
 	}
 
-	// set the frontend!
-	return dvbfe_set(fe, topass, timeout);
+	return 0;
 }
 
 int dvbsec_std_sequence(struct dvbfe_handle *fe,
@@ -21,9 +21,7 @@
 #define DVBSEC_API_H 1
 
 #include <stdint.h>
-
-struct dvbfe_handle;
-struct dvbfe_parameters;
+#include <libdvbapi/dvbfe.h>
 
 enum dvbsec_diseqc_framing {
 	DISEQC_FRAMING_MASTER_NOREPLY		= 0xE0,
@@ -192,6 +190,32 @@ extern int dvbsec_set(struct dvbfe_handle *fe,
 			  struct dvbfe_parameters *params,
 			  int timeout);
 
+/**
+ * As dvbsec_set(), but the frontend is tuned with dvbfe_set_async(), so this
+ * returns as soon as the SEC commands have been sent. The end of the tune is
+ * found with dvbfe_tune_check().
+ *
+ * @param fe Frontend concerned.
+ * @param sec_config SEC configuration structure. May be NULL to disable SEC/frequency adjustment.
+ * @param polarization Polarization of signal.
+ * @param sat_pos Satellite position - only used if type == DISEQC_SEC_CONFIG_STANDARD.
+ * @param switch_option Switch option - only used if type == DISEQC_SEC_CONFIG_STANDARD.
+ * @param params Tuning parameters.
+ * @param timeout Milliseconds to wait for a lock, or <0 to wait forever.
+ * @param callback Function to call when the tune locks or times out, or NULL.
+ * @param arg Argument to pass to the callback.
+ * @return 0 if the tune was started, or nonzero on failure.
+ */
+extern int dvbsec_set_async(struct dvbfe_handle *fe,
+			    struct dvbsec_config *sec_config,
+			    enum dvbsec_diseqc_polarization polarization,
+			    enum dvbsec_diseqc_switch sat_pos,
+			    enum dvbsec_diseqc_switch switch_option,
+			    struct dvbfe_parameters *params,
+			    int timeout,
+			    dvbfe_tune_callback callback,
+			    void *arg);
+
 /**
  * This will issue the standardised back-compatable DISEQC/SEC command
  * sequence as defined in the DISEQC spec:
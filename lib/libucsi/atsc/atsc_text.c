@@ -22,6 +22,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <pthread.h>
 #include "libucsi/endianops.h"
 #include "libucsi/atsc/types.h"
 
@@ -31,11 +32,31 @@
 
 #define DEST_ALLOC_DELTA 20
 
+#define HUFFTREE_CONTEXTS 128
+#define HUFFLUT_BITS 8
+
 struct hufftree_entry {
 	uint8_t left_idx;
 	uint8_t right_idx;
 } __ucsi_packed;
 
+/*
+ * One entry per context and per value of the next HUFFLUT_BITS bits of the
+ * string: if bits is nonzero, the code is bits long and value is the leaf
+ * (i.e. a literal). Otherwise the code is longer than HUFFLUT_BITS, and
+ * value is the tree node reached after them.
+ */
+struct hufflut_entry {
+	uint8_t value;
+	uint8_t bits;
+};
+
+struct hufflut {
+	struct hufftree_entry (*hufftree)[128];
+	int contexts;
+	struct hufflut_entry entries[HUFFTREE_CONTEXTS][1 << HUFFLUT_BITS];
+};
+
 struct huffbuff {
 	uint8_t *buf;
 	uint32_t buf_len;
@@ -534,6 +555,18 @@ static struct hufftree_entry program_title_hufftree[][128] = {
 
 
 
+static struct hufflut program_description_hufflut = {
+	.hufftree = program_description_hufftree,
+	.contexts = sizeof(program_description_hufftree) / sizeof(program_description_hufftree[0]),
+};
+
+static struct hufflut program_title_hufflut = {
+	.hufftree = program_title_hufftree,
+	.contexts = sizeof(program_title_hufftree) / sizeof(program_title_hufftree[0]),
+};
+
+static pthread_once_t hufflut_once = PTHREAD_ONCE_INIT;
+
 static inline void huffbuff_init(struct huffbuff *hbuf, uint8_t *buf, uint32_t buf_len)
 {
 	memset(hbuf, 0, sizeof(struct huffbuff));
@@ -541,27 +574,38 @@ static inline void huffbuff_init(struct huffbuff *hbuf, uint8_t *buf, uint32_t b
 	hbuf->buf_len = buf_len;
 }
 
-static inline int huffbuff_bits(struct huffbuff *hbuf, uint8_t nbits)
+static inline uint32_t huffbuff_remaining(struct huffbuff *hbuf)
 {
-	uint8_t result = 0;
+	return ((hbuf->buf_len - hbuf->cur_byte) * 8) - hbuf->cur_bit;
+}
 
-	if (nbits > 8)
-		return -1;
+// must not be called at the end of the buffer; missing bits read as 0
+static inline int huffbuff_peek8(struct huffbuff *hbuf)
+{
+	uint32_t bits = hbuf->buf[hbuf->cur_byte] << 8;
 
-	while(nbits--) {
-		if (hbuf->cur_byte >= hbuf->buf_len) {
-			return -1;
-		}
+	if ((hbuf->cur_byte + 1) < hbuf->buf_len)
+		bits |= hbuf->buf[hbuf->cur_byte + 1];
 
-		result <<= 1;
-		if (hbuf->buf[hbuf->cur_byte] & (0x80 >> hbuf->cur_bit))
-			result |= 1;
+	return (bits >> (8 - hbuf->cur_bit)) & 0xff;
+}
 
-		if (++hbuf->cur_bit > 7) {
-			hbuf->cur_byte++;
-			hbuf->cur_bit = 0;
-		}
-	}
+static inline void huffbuff_skip(struct huffbuff *hbuf, uint8_t nbits)
+{
+	hbuf->cur_bit += nbits;
+	hbuf->cur_byte += hbuf->cur_bit >> 3;
+	hbuf->cur_bit &= 7;
+}
+
+static inline int huffbuff_bits(struct huffbuff *hbuf, uint8_t nbits)
+{
+	int result;
+
+	if ((nbits > 8) || (huffbuff_remaining(hbuf) < nbits))
+		return -1;
+
+	result = huffbuff_peek8(hbuf) >> (8 - nbits);
+	huffbuff_skip(hbuf, nbits);
 
 	return result;
 }
@@ -653,58 +697,126 @@ static int huffman_decode_uncompressed(struct huffbuff *hbuf,
 	return HUFFSTRING_END;
 }
 
+static void hufflut_build(struct hufflut *lut)
+{
+	struct hufflut_entry *entry;
+	struct hufftree_entry *tree;
+	uint8_t treeidx;
+	uint8_t treeval;
+	int context;
+	int bits;
+	int i;
+
+	for(context=0; context < HUFFTREE_CONTEXTS; context++) {
+		for(i=0; i < (1 << HUFFLUT_BITS); i++) {
+			entry = &lut->entries[context][i];
+
+			// no tree for this context: treat it like the unused ones,
+			// which only contain an escape
+			if (context >= lut->contexts) {
+				entry->value = HUFFTREE_LITERAL_MASK | HUFFSTRING_ESCAPE;
+				entry->bits = 1;
+				continue;
+			}
+
+			tree = lut->hufftree[context];
+			treeidx = 0;
+			treeval = 0;
+			for(bits=1; bits <= HUFFLUT_BITS; bits++) {
+				if ((i >> (HUFFLUT_BITS - bits)) & 1)
+					treeval = tree[treeidx].right_idx;
+				else
+					treeval = tree[treeidx].left_idx;
+				if (treeval & HUFFTREE_LITERAL_MASK)
+					break;
+				treeidx = treeval;
+			}
+
+			if (bits <= HUFFLUT_BITS) {
+				entry->value = treeval;
+				entry->bits = bits;
+			} else {
+				entry->value = treeidx;
+				entry->bits = 0;
+			}
+		}
+	}
+}
+
+static void hufflut_build_all(void)
+{
+	hufflut_build(&program_title_hufflut);
+	hufflut_build(&program_description_hufflut);
+}
+
 static int huffman_decode(uint8_t *src, size_t srclen,
 			  uint8_t **destbuf, size_t *destbuflen, size_t *destbufpos,
-			  struct hufftree_entry hufftree[][128])
+			  struct hufflut *lut)
 {
 	struct huffbuff hbuf;
-	int bit;
-	struct hufftree_entry *tree = hufftree[0];
-	uint8_t treeidx = 0;
+	struct hufflut_entry *entry;
+	struct hufftree_entry *tree;
+	uint8_t context = 0;
+	uint8_t treeidx;
 	uint8_t treeval;
+	int bit;
 	int tmp;
 
+	pthread_once(&hufflut_once, hufflut_build_all);
+
 	huffbuff_init(&hbuf, src, srclen);
 
 	while(hbuf.cur_byte < hbuf.buf_len) {
-		// get the next bit
-		if ((bit = huffbuff_bits(&hbuf, 1)) < 0)
-			return *destbufpos;
-
-		if (!bit) {
-			treeval = tree[treeidx].left_idx;
+		// decode the next code using the next HUFFLUT_BITS bits
+		entry = &lut->entries[context][huffbuff_peek8(&hbuf)];
+		if (entry->bits) {
+			if (huffbuff_remaining(&hbuf) < entry->bits)
+				return *destbufpos;
+			huffbuff_skip(&hbuf, entry->bits);
+			treeval = entry->value;
 		} else {
-			treeval = tree[treeidx].right_idx;
+			// longer codes carry on down the tree a bit at a time
+			if (huffbuff_remaining(&hbuf) < HUFFLUT_BITS)
+				return *destbufpos;
+			huffbuff_skip(&hbuf, HUFFLUT_BITS);
+
+			tree = lut->hufftree[context];
+			treeidx = entry->value;
+			do {
+				if ((bit = huffbuff_bits(&hbuf, 1)) < 0)
+					return *destbufpos;
+
+				if (!bit) {
+					treeval = tree[treeidx].left_idx;
+				} else {
+					treeval = tree[treeidx].right_idx;
+				}
+				treeidx = treeval;
+			} while(!(treeval & HUFFTREE_LITERAL_MASK));
 		}
 
-		if (treeval & HUFFTREE_LITERAL_MASK) {
-			switch(treeval & ~HUFFTREE_LITERAL_MASK) {
-			case HUFFSTRING_END:
-				return 0;
-
-			case HUFFSTRING_ESCAPE:
-				if ((tmp =
-					huffman_decode_uncompressed(&hbuf,
-							destbuf, destbuflen, destbufpos)) < 0)
-					return tmp;
-				if (tmp == 0)
-					return *destbufpos;
+		switch(treeval & ~HUFFTREE_LITERAL_MASK) {
+		case HUFFSTRING_END:
+			return 0;
 
-				tree = hufftree[tmp];
-				treeidx = 0;
-				break;
-
-			default:
-				// stash it
-				if (append_unicode_char(destbuf, destbuflen, destbufpos,
-				    			treeval & ~HUFFTREE_LITERAL_MASK))
-					return -1;
-				tree = hufftree[treeval & ~HUFFTREE_LITERAL_MASK];
-				treeidx = 0;
-				break;
-			}
-		} else {
-			treeidx = treeval;
+		case HUFFSTRING_ESCAPE:
+			if ((tmp =
+				huffman_decode_uncompressed(&hbuf,
+						destbuf, destbuflen, destbufpos)) < 0)
+				return tmp;
+			if (tmp == 0)
+				return *destbufpos;
+
+			context = tmp;
+			break;
+
+		default:
+			// stash it
+			if (append_unicode_char(destbuf, destbuflen, destbufpos,
+						treeval & ~HUFFTREE_LITERAL_MASK))
+				return -1;
+			context = treeval & ~HUFFTREE_LITERAL_MASK;
+			break;
 		}
 	}
 
@@ -731,12 +843,12 @@ int atsc_text_segment_decode(struct atsc_text_string_segment *segment,
 	case ATSC_TEXT_COMPRESS_PROGRAM_TITLE:
 		return huffman_decode(buf, segment->number_bytes,
 				      destbuf, destbufsize, destbufpos,
-				      program_title_hufftree);
+				      &program_title_hufflut);
 
 	case ATSC_TEXT_COMPRESS_PROGRAM_DESCRIPTION:
 		return huffman_decode(buf, segment->number_bytes,
 				      destbuf, destbufsize, destbufpos,
-				      program_description_hufftree);
+				      &program_description_hufflut);
 	}
 
 	return -1;
@@ -0,0 +1,53 @@
+/*
+ * ATSC descriptor decoder registrations
+ *
+ * Copyright (C) 2026 agent (agent@local)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <libucsi/descriptor_registry.h>
+#include <libucsi/atsc/descriptor.h>
+
+DESCRIPTOR_REGISTRY_CODEC(atsc_stuffing_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(atsc_ac3_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(atsc_caption_service_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(atsc_content_advisory_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(atsc_extended_channel_name_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(atsc_service_location_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(atsc_time_shifted_service_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(atsc_component_name_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(atsc_dcc_departing_request_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(atsc_dcc_arriving_request_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(atsc_rc_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(atsc_genre_descriptor)
+
+const struct descriptor_registry atsc_descriptor_registry = {
+	.name = "ATSC",
+	.codecs = {
+		[dtag_atsc_stuffing] = atsc_stuffing_descriptor_registry_codec,
+		[dtag_atsc_ac3_audio] = atsc_ac3_descriptor_registry_codec,
+		[dtag_atsc_caption_service] = atsc_caption_service_descriptor_registry_codec,
+		[dtag_atsc_content_advisory] = atsc_content_advisory_descriptor_registry_codec,
+		[dtag_atsc_extended_channel_name] = atsc_extended_channel_name_descriptor_registry_codec,
+		[dtag_atsc_service_location] = atsc_service_location_descriptor_registry_codec,
+		[dtag_atsc_time_shifted_service] = atsc_time_shifted_service_descriptor_registry_codec,
+		[dtag_atsc_component_name] = atsc_component_name_descriptor_registry_codec,
+		[dtag_atsc_dcc_departing_request] = atsc_dcc_departing_request_descriptor_registry_codec,
+		[dtag_atsc_dcc_arriving_request] = atsc_dcc_arriving_request_descriptor_registry_codec,
+		[dtag_atsc_redistribution_control] = atsc_rc_descriptor_registry_codec,
+		[dtag_atsc_genre] = atsc_genre_descriptor_registry_codec,
+	},
+};
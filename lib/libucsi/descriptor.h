@@ -38,6 +38,26 @@ struct descriptor {
 	uint8_t len;
 } __ucsi_packed;
 
+/**
+ * Retreive pointer to the first descriptor structure.
+ *
+ * Descriptor loops which were not checked by verify_descriptors() (see the
+ * *_section_codec_lazy() functions) are validated as they are iterated: the
+ * iteration stops at the first descriptor that does not fit within the loop.
+ *
+ * @param buf The buffer of descriptors.
+ * @param len Size of the buffer.
+ * @return Pointer to first descriptor, or NULL if there are none.
+ */
+static inline struct descriptor *
+	first_descriptor(uint8_t * buf, size_t len)
+{
+	if ((len < 2) || ((size_t) (2 + buf[1]) > len))
+		return NULL;
+
+	return (struct descriptor *) buf;
+}
+
 /**
  * Retreive pointer to the next descriptor structure.
  *
@@ -58,6 +78,10 @@ static inline struct descriptor *
 	if (next >= buf + len)
 		return NULL;
 
+	/* can only fail if the loop was not verified up front */
+	if (((next + 2) > (buf + len)) || ((next + 2 + next[1]) > (buf + len)))
+		return NULL;
+
 	return (struct descriptor *) next;
 }
 
@@ -0,0 +1,69 @@
+/*
+ * descriptor decoder registry
+ *
+ * Copyright (C) 2026 agent (agent@local)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <string.h>
+#include "descriptor_registry.h"
+
+void descriptor_visitor_init(struct descriptor_visitor *visitor, void *arg)
+{
+	memset(visitor, 0, sizeof(struct descriptor_visitor));
+	visitor->arg = arg;
+}
+
+int descriptor_visitor_register(struct descriptor_visitor *visitor,
+				const struct descriptor_registry *registry,
+				uint8_t tag, descriptor_visitor_callback callback)
+{
+	struct descriptor_visitor_entry *entry = &visitor->entries[tag];
+
+	if ((registry != NULL) && (registry->codecs[tag] == NULL))
+		return -1;
+
+	entry->codec = registry ? registry->codecs[tag] : NULL;
+	entry->callback = callback;
+	return 0;
+}
+
+int descriptor_visitor_visit(struct descriptor_visitor *visitor,
+			     uint8_t *buf, size_t len, uint32_t *invalid)
+{
+	struct descriptor_visitor_entry *entry;
+	struct descriptor *d;
+	void *decoded;
+	int ret;
+
+	for (d = first_descriptor(buf, len); d; d = next_descriptor(buf, len, d)) {
+		entry = &visitor->entries[d->tag];
+		if (entry->callback == NULL)
+			continue;
+
+		decoded = d;
+		if (entry->codec && ((decoded = entry->codec(d)) == NULL)) {
+			if (invalid)
+				(*invalid)++;
+			continue;
+		}
+
+		if ((ret = entry->callback(visitor->arg, d, decoded)) != 0)
+			return ret;
+	}
+
+	return 0;
+}
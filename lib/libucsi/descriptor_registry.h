@@ -0,0 +1,166 @@
+/*
+ * descriptor decoder registry
+ *
+ * Copyright (C) 2026 agent (agent@local)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef _UCSI_DESCRIPTOR_REGISTRY_H
+#define _UCSI_DESCRIPTOR_REGISTRY_H 1
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <libucsi/descriptor.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * Generic form of a *_descriptor_codec() function. It returns a pointer to
+ * the decoded descriptor (e.g. a struct dvb_short_event_descriptor *), or
+ * NULL if the descriptor is invalid.
+ */
+typedef void *(*descriptor_codec)(struct descriptor *d);
+
+/**
+ * A constant table mapping descriptor tags to their codecs for one standard.
+ * Tags with no codec are NULL.
+ */
+struct descriptor_registry {
+	const char *name;
+	descriptor_codec codecs[256];
+};
+
+/**
+ * Registries for the descriptors defined by ISO 13818-1 (tags 0x02->0x27),
+ * EN 300 468 (tags 0x40->0x7f, in SI tables), and ATSC A/65 (tags 0x80+).
+ * The tag ranges do not overlap, so registries may be mixed freely in one
+ * visitor; e.g. a DVB PMT uses both the MPEG and DVB registries.
+ *
+ * Descriptors whose meaning depends on the table they are found in (those
+ * in AIT, INT, UNT and RNT descriptor loops) are not included.
+ */
+extern const struct descriptor_registry mpeg_descriptor_registry;
+extern const struct descriptor_registry dvb_descriptor_registry;
+extern const struct descriptor_registry atsc_descriptor_registry;
+
+/**
+ * Decode a descriptor using a registry.
+ *
+ * @param registry The registry.
+ * @param d The raw descriptor. It is decoded in place, so this may only be
+ * called once for each descriptor.
+ * @return Pointer to the decoded descriptor, or NULL if it is invalid or
+ * the registry has no codec for it.
+ */
+static inline void *descriptor_registry_codec(const struct descriptor_registry *registry,
+					      struct descriptor *d)
+{
+	if (registry->codecs[d->tag] == NULL)
+		return NULL;
+
+	return registry->codecs[d->tag](d);
+}
+
+/**
+ * Callback invoked by a descriptor_visitor for a decoded descriptor.
+ *
+ * @param arg Private argument supplied to descriptor_visitor_init().
+ * @param d The raw descriptor header.
+ * @param decoded The decoded descriptor: a pointer to the type returned by
+ * the tag's codec (e.g. struct dvb_short_event_descriptor * for
+ * dtag_dvb_short_event), or the same as d if the tag was registered with
+ * no codec.
+ * @return 0 to continue visiting, or nonzero to stop.
+ */
+typedef int (*descriptor_visitor_callback)(void *arg, struct descriptor *d, void *decoded);
+
+struct descriptor_visitor_entry {
+	descriptor_codec codec;
+	descriptor_visitor_callback callback;
+};
+
+/**
+ * A descriptor visitor. It walks a descriptor loop, and only decodes the
+ * descriptors whose tags have a registered callback: all the rest are
+ * skipped without being touched. It holds no dynamic state, so it may be
+ * declared on the stack or embedded in another structure, and shared by
+ * several threads once set up.
+ */
+struct descriptor_visitor {
+	void *arg;
+	struct descriptor_visitor_entry entries[256];
+};
+
+/**
+ * Initialise a descriptor_visitor with no callbacks registered.
+ *
+ * @param visitor The visitor.
+ * @param arg Private argument passed to the callbacks.
+ */
+extern void descriptor_visitor_init(struct descriptor_visitor *visitor, void *arg);
+
+/**
+ * Register a callback for a descriptor tag.
+ *
+ * @param visitor The visitor.
+ * @param registry Registry to take the tag's codec from, or NULL to receive
+ * the raw descriptor.
+ * @param tag The descriptor tag.
+ * @param callback The callback, or NULL to unregister the tag.
+ * @return 0 on success, or -1 if the registry has no codec for the tag.
+ */
+extern int descriptor_visitor_register(struct descriptor_visitor *visitor,
+				       const struct descriptor_registry *registry,
+				       uint8_t tag, descriptor_visitor_callback callback);
+
+/**
+ * Visit a descriptor loop, invoking the registered callbacks in order.
+ * Descriptors which fail to decode are skipped. Registered descriptors are
+ * decoded in place, so a loop may only be visited once.
+ *
+ * @param visitor The visitor.
+ * @param buf Pointer to the start of the descriptor loop.
+ * @param len Length of the descriptor loop.
+ * @param invalid If not NULL, incremented for each descriptor rejected by its
+ * codec. It belongs to the caller, so threads sharing a visitor should each
+ * pass their own.
+ * @return 0 if the whole loop was visited, or the nonzero value returned by
+ * a callback which stopped it.
+ */
+extern int descriptor_visitor_visit(struct descriptor_visitor *visitor,
+				    uint8_t *buf, size_t len, uint32_t *invalid);
+
+
+
+
+
+
+
+/******************************** PRIVATE CODE ********************************/
+#define DESCRIPTOR_REGISTRY_CODEC(name) \
+	static void *name##_registry_codec(struct descriptor *d) \
+	{ \
+		return name##_codec(d); \
+	}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -21,7 +21,7 @@
 
 #include <libucsi/dvb/bat_section.h>
 
-struct dvb_bat_section * dvb_bat_section_codec(struct section_ext * ext)
+static inline struct dvb_bat_section *dvb_bat_section_do_codec(struct section_ext * ext, int lazy)
 {
 	uint8_t * buf = (uint8_t *) ext;
 	size_t pos = sizeof(struct section_ext);
@@ -37,7 +37,7 @@ struct dvb_bat_section * dvb_bat_section_codec(struct section_ext * ext)
 	if ((pos + ret->bouquet_descriptors_length) > len)
 		return NULL;
 
-	if (verify_descriptors(buf + pos, ret->bouquet_descriptors_length))
+	if ((!lazy) && verify_descriptors(buf + pos, ret->bouquet_descriptors_length))
 		return NULL;
 	pos += ret->bouquet_descriptors_length;
 
@@ -63,7 +63,7 @@ struct dvb_bat_section * dvb_bat_section_codec(struct section_ext * ext)
 		if ((pos + transport->transport_descriptors_length) > len)
 			return NULL;
 
-		if (verify_descriptors(buf + pos,
+		if ((!lazy) && verify_descriptors(buf + pos,
 					transport->transport_descriptors_length))
 			return NULL;
 
@@ -75,3 +75,13 @@ struct dvb_bat_section * dvb_bat_section_codec(struct section_ext * ext)
 
 	return ret;
 }
+
+struct dvb_bat_section *dvb_bat_section_codec(struct section_ext * ext)
+{
+	return dvb_bat_section_do_codec(ext, 0);
+}
+
+struct dvb_bat_section *dvb_bat_section_codec_lazy(struct section_ext * ext)
+{
+	return dvb_bat_section_do_codec(ext, 1);
+}
@@ -69,6 +69,17 @@ struct dvb_bat_transport {
  */
 struct dvb_bat_section *dvb_bat_section_codec(struct section_ext *section);
 
+/**
+ * Process a dvb_bat_section, but leave the bouquet and transport descriptor loops to be
+ * validated when they are first iterated (see first_descriptor()) rather
+ * than checking them all up front. Use this when most descriptors will not
+ * be looked at.
+ *
+ * @param section Generic section pointer.
+ * @return dvb_bat_section pointer, or NULL on error.
+ */
+struct dvb_bat_section *dvb_bat_section_codec_lazy(struct section_ext *section);
+
 /**
  * Accessor for the bouquet_id field of a BAT.
  *
@@ -144,11 +155,8 @@ static inline struct dvb_bat_section_part2 *
 static inline struct descriptor *
 	dvb_bat_section_descriptors_first(struct dvb_bat_section *bat)
 {
-	if (bat->bouquet_descriptors_length == 0)
-		return NULL;
-
-	return (struct descriptor *)
-		((uint8_t *) bat + sizeof(struct dvb_bat_section));
+	return first_descriptor((uint8_t *) bat + sizeof(struct dvb_bat_section),
+				bat->bouquet_descriptors_length);
 }
 
 static inline struct descriptor *
@@ -188,11 +196,8 @@ static inline struct dvb_bat_transport *
 static inline struct descriptor *
 	dvb_bat_transport_descriptors_first(struct dvb_bat_transport *t)
 {
-	if (t->transport_descriptors_length == 0)
-		return NULL;
-
-	return (struct descriptor *)
-		((uint8_t*)t + sizeof(struct dvb_bat_transport));
+	return first_descriptor((uint8_t *) t + sizeof(struct dvb_bat_transport),
+				t->transport_descriptors_length);
 }
 
 static inline struct descriptor *
@@ -0,0 +1,143 @@
+/*
+ * DVB descriptor decoder registrations
+ *
+ * Copyright (C) 2026 agent (agent@local)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <libucsi/descriptor_registry.h>
+#include <libucsi/dvb/descriptor.h>
+
+DESCRIPTOR_REGISTRY_CODEC(dvb_network_name_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(dvb_service_list_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(dvb_stuffing_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(dvb_satellite_delivery_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(dvb_cable_delivery_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(dvb_vbi_data_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(dvb_vbi_teletext_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(dvb_bouquet_name_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(dvb_service_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(dvb_country_availability_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(dvb_linkage_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(dvb_nvod_reference_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(dvb_time_shifted_service_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(dvb_short_event_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(dvb_extended_event_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(dvb_time_shifted_event_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(dvb_component_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(dvb_mosaic_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(dvb_stream_identifier_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(dvb_ca_identifier_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(dvb_content_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(dvb_parental_rating_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(dvb_teletext_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(dvb_telephone_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(dvb_local_time_offset_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(dvb_subtitling_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(dvb_terrestrial_delivery_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(dvb_multilingual_network_name_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(dvb_multilingual_bouquet_name_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(dvb_multilingual_service_name_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(dvb_multilingual_component_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(dvb_private_data_specifier_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(dvb_service_move_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(dvb_short_smoothing_buffer_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(dvb_frequency_list_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(dvb_partial_transport_stream_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(dvb_data_broadcast_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(dvb_scrambling_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(dvb_data_broadcast_id_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(dvb_transport_stream_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(dvb_dsng_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(dvb_pdc_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(dvb_ac3_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(dvb_ancillary_data_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(dvb_cell_list_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(dvb_cell_frequency_link_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(dvb_announcement_support_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(dvb_application_signalling_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(dvb_adaptation_field_data_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(dvb_service_identifier_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(dvb_service_availability_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(dvb_default_authority_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(dvb_related_content_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(dvb_tva_id_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(dvb_content_identifier_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(dvb_time_slice_fec_identifier_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(dvb_s2_satellite_delivery_descriptor)
+
+const struct descriptor_registry dvb_descriptor_registry = {
+	.name = "DVB",
+	.codecs = {
+		[dtag_dvb_network_name] = dvb_network_name_descriptor_registry_codec,
+		[dtag_dvb_service_list] = dvb_service_list_descriptor_registry_codec,
+		[dtag_dvb_stuffing] = dvb_stuffing_descriptor_registry_codec,
+		[dtag_dvb_satellite_delivery_system] = dvb_satellite_delivery_descriptor_registry_codec,
+		[dtag_dvb_cable_delivery_system] = dvb_cable_delivery_descriptor_registry_codec,
+		[dtag_dvb_vbi_data] = dvb_vbi_data_descriptor_registry_codec,
+		[dtag_dvb_vbi_teletext] = dvb_vbi_teletext_descriptor_registry_codec,
+		[dtag_dvb_bouquet_name] = dvb_bouquet_name_descriptor_registry_codec,
+		[dtag_dvb_service] = dvb_service_descriptor_registry_codec,
+		[dtag_dvb_country_availability] = dvb_country_availability_descriptor_registry_codec,
+		[dtag_dvb_linkage] = dvb_linkage_descriptor_registry_codec,
+		[dtag_dvb_nvod_reference] = dvb_nvod_reference_descriptor_registry_codec,
+		[dtag_dvb_time_shifted_service] = dvb_time_shifted_service_descriptor_registry_codec,
+		[dtag_dvb_short_event] = dvb_short_event_descriptor_registry_codec,
+		[dtag_dvb_extended_event] = dvb_extended_event_descriptor_registry_codec,
+		[dtag_dvb_time_shifted_event] = dvb_time_shifted_event_descriptor_registry_codec,
+		[dtag_dvb_component] = dvb_component_descriptor_registry_codec,
+		[dtag_dvb_mosaic] = dvb_mosaic_descriptor_registry_codec,
+		[dtag_dvb_stream_identifier] = dvb_stream_identifier_descriptor_registry_codec,
+		[dtag_dvb_ca_identifier] = dvb_ca_identifier_descriptor_registry_codec,
+		[dtag_dvb_content] = dvb_content_descriptor_registry_codec,
+		[dtag_dvb_parental_rating] = dvb_parental_rating_descriptor_registry_codec,
+		[dtag_dvb_teletext] = dvb_teletext_descriptor_registry_codec,
+		[dtag_dvb_telephone] = dvb_telephone_descriptor_registry_codec,
+		[dtag_dvb_local_time_offset] = dvb_local_time_offset_descriptor_registry_codec,
+		[dtag_dvb_subtitling] = dvb_subtitling_descriptor_registry_codec,
+		[dtag_dvb_terrestial_delivery_system] = dvb_terrestrial_delivery_descriptor_registry_codec,
+		[dtag_dvb_multilingual_network_name] = dvb_multilingual_network_name_descriptor_registry_codec,
+		[dtag_dvb_multilingual_bouquet_name] = dvb_multilingual_bouquet_name_descriptor_registry_codec,
+		[dtag_dvb_multilingual_service_name] = dvb_multilingual_service_name_descriptor_registry_codec,
+		[dtag_dvb_multilingual_component] = dvb_multilingual_component_descriptor_registry_codec,
+		[dtag_dvb_private_data_specifier] = dvb_private_data_specifier_descriptor_registry_codec,
+		[dtag_dvb_service_move] = dvb_service_move_descriptor_registry_codec,
+		[dtag_dvb_short_smoothing_buffer] = dvb_short_smoothing_buffer_descriptor_registry_codec,
+		[dtag_dvb_frequency_list] = dvb_frequency_list_descriptor_registry_codec,
+		[dtag_dvb_partial_transport_stream] = dvb_partial_transport_stream_descriptor_registry_codec,
+		[dtag_dvb_data_broadcast] = dvb_data_broadcast_descriptor_registry_codec,
+		[dtag_dvb_scrambling] = dvb_scrambling_descriptor_registry_codec,
+		[dtag_dvb_data_broadcast_id] = dvb_data_broadcast_id_descriptor_registry_codec,
+		[dtag_dvb_transport_stream] = dvb_transport_stream_descriptor_registry_codec,
+		[dtag_dvb_dsng] = dvb_dsng_descriptor_registry_codec,
+		[dtag_dvb_pdc] = dvb_pdc_descriptor_registry_codec,
+		[dtag_dvb_ac3] = dvb_ac3_descriptor_registry_codec,
+		[dtag_dvb_ancillary_data] = dvb_ancillary_data_descriptor_registry_codec,
+		[dtag_dvb_cell_list] = dvb_cell_list_descriptor_registry_codec,
+		[dtag_dvb_cell_frequency_link] = dvb_cell_frequency_link_descriptor_registry_codec,
+		[dtag_dvb_announcement_support] = dvb_announcement_support_descriptor_registry_codec,
+		[dtag_dvb_application_signalling] = dvb_application_signalling_descriptor_registry_codec,
+		[dtag_dvb_adaptation_field_data] = dvb_adaptation_field_data_descriptor_registry_codec,
+		[dtag_dvb_service_identifier] = dvb_service_identifier_descriptor_registry_codec,
+		[dtag_dvb_service_availability] = dvb_service_availability_descriptor_registry_codec,
+		[dtag_dvb_default_authority] = dvb_default_authority_descriptor_registry_codec,
+		[dtag_dvb_related_content] = dvb_related_content_descriptor_registry_codec,
+		[dtag_dvb_tva_id] = dvb_tva_id_descriptor_registry_codec,
+		[dtag_dvb_content_identifier] = dvb_content_identifier_descriptor_registry_codec,
+		[dtag_dvb_time_slice_fec_identifier] = dvb_time_slice_fec_identifier_descriptor_registry_codec,
+		[dtag_dvb_s2_satellite_delivery_descriptor] = dvb_s2_satellite_delivery_descriptor_registry_codec,
+	},
+};
@@ -21,7 +21,7 @@
 
 #include <libucsi/dvb/eit_section.h>
 
-struct dvb_eit_section *dvb_eit_section_codec(struct section_ext * ext)
+static inline struct dvb_eit_section *dvb_eit_section_do_codec(struct section_ext * ext, int lazy)
 {
 	uint8_t * buf = (uint8_t *) ext;
 	size_t pos = sizeof(struct section_ext);
@@ -50,7 +50,7 @@ struct dvb_eit_section *dvb_eit_section_codec(struct section_ext * ext)
 		if ((pos + event->descriptors_loop_length) > len)
 			return NULL;
 
-		if (verify_descriptors(buf + pos, event->descriptors_loop_length))
+		if ((!lazy) && verify_descriptors(buf + pos, event->descriptors_loop_length))
 			return NULL;
 
 		pos += event->descriptors_loop_length;
@@ -61,3 +61,41 @@ struct dvb_eit_section *dvb_eit_section_codec(struct section_ext * ext)
 
 	return (struct dvb_eit_section *) ext;
 }
+
+struct dvb_eit_section *dvb_eit_section_codec(struct section_ext * ext)
+{
+	return dvb_eit_section_do_codec(ext, 0);
+}
+
+struct dvb_eit_section *dvb_eit_section_codec_lazy(struct section_ext * ext)
+{
+	return dvb_eit_section_do_codec(ext, 1);
+}
+
+int dvb_eit_view_check(const uint8_t *buf, size_t len)
+{
+	size_t pos = sizeof(struct dvb_eit_section);
+	size_t dlen;
+
+	if (section_view_check(buf, len) || section_view_ext_check(buf, 0))
+		return -1;
+	len = section_view_ext_length(buf);
+	if (len < sizeof(struct dvb_eit_section))
+		return -1;
+
+	while (pos < len) {
+		if ((pos + sizeof(struct dvb_eit_event)) > len)
+			return -1;
+
+		dlen = dvb_eit_view_event_descriptors_loop_length(buf + pos);
+		pos += sizeof(struct dvb_eit_event);
+
+		if ((pos + dlen) > len)
+			return -1;
+		if (verify_descriptors((uint8_t *) buf + pos, dlen))
+			return -1;
+		pos += dlen;
+	}
+
+	return 0;
+}
@@ -28,6 +28,7 @@ extern "C"
 #endif
 
 #include <libucsi/section.h>
+#include <libucsi/section_view.h>
 #include <libucsi/dvb/types.h>
 
 
@@ -65,6 +66,17 @@ struct dvb_eit_event {
  */
 struct dvb_eit_section *dvb_eit_section_codec(struct section_ext *section);
 
+/**
+ * Process a dvb_eit_section, but leave the event descriptor loops to be
+ * validated when they are first iterated (see first_descriptor()) rather
+ * than checking them all up front. Use this when most descriptors will not
+ * be looked at.
+ *
+ * @param section Pointer to a generic section_ext structure.
+ * @return Pointer to a dvb_eit_section, or NULL on error.
+ */
+struct dvb_eit_section *dvb_eit_section_codec_lazy(struct section_ext *section);
+
 /**
  * Accessor for the service_id field of an EIT.
  *
@@ -98,6 +110,129 @@ static inline uint16_t dvb_eit_section_service_id(struct dvb_eit_section *eit)
 	     (pos); \
 	     (pos) = dvb_eit_event_descriptors_next(event, pos))
 
+/**
+ * Check a raw EIT section before using the read-only dvb_eit_view_*()
+ * functions (see libucsi/section_view.h). The buffer is not modified.
+ *
+ * @param buf Pointer to the raw section.
+ * @param len Length of the buffer.
+ * @return 0 if it is valid, nonzero if not.
+ */
+extern int dvb_eit_view_check(const uint8_t *buf, size_t len);
+
+/**
+ * Accessor for the service_id field of a raw EIT.
+ */
+static inline uint16_t dvb_eit_view_service_id(const uint8_t *buf)
+{
+	return section_view_table_id_ext(buf);
+}
+
+/**
+ * Accessor for the transport_stream_id field of a raw EIT.
+ */
+static inline uint16_t dvb_eit_view_transport_stream_id(const uint8_t *buf)
+{
+	return ucsi_get_be16(buf + 8);
+}
+
+/**
+ * Accessor for the original_network_id field of a raw EIT.
+ */
+static inline uint16_t dvb_eit_view_original_network_id(const uint8_t *buf)
+{
+	return ucsi_get_be16(buf + 10);
+}
+
+/**
+ * Accessor for the segment_last_section_number field of a raw EIT.
+ */
+static inline uint8_t dvb_eit_view_segment_last_section_number(const uint8_t *buf)
+{
+	return buf[12];
+}
+
+/**
+ * Accessor for the last_table_id field of a raw EIT.
+ */
+static inline uint8_t dvb_eit_view_last_table_id(const uint8_t *buf)
+{
+	return buf[13];
+}
+
+/**
+ * Iterator for the events field of a raw EIT.
+ *
+ * @param buf Pointer to the raw section.
+ * @param pos Variable holding a const uint8_t pointer to the current event.
+ */
+#define dvb_eit_view_events_for_each(buf, pos) \
+	for ((pos) = dvb_eit_view_events_first(buf); \
+	     (pos); \
+	     (pos) = dvb_eit_view_events_next(buf, pos))
+
+/**
+ * Accessor for the event_id field of an event in a raw EIT.
+ */
+static inline uint16_t dvb_eit_view_event_id(const uint8_t *event)
+{
+	return ucsi_get_be16(event);
+}
+
+/**
+ * Accessor for the start_time field of an event in a raw EIT. The value is
+ * in the same format as dvbdate_t.
+ */
+static inline const uint8_t *dvb_eit_view_event_start_time(const uint8_t *event)
+{
+	return event + 2;
+}
+
+/**
+ * Accessor for the duration field of an event in a raw EIT. The value is
+ * in the same format as dvbduration_t.
+ */
+static inline const uint8_t *dvb_eit_view_event_duration(const uint8_t *event)
+{
+	return event + 7;
+}
+
+/**
+ * Accessor for the running_status field of an event in a raw EIT.
+ */
+static inline int dvb_eit_view_event_running_status(const uint8_t *event)
+{
+	return event[10] >> 5;
+}
+
+/**
+ * Accessor for the free_ca_mode field of an event in a raw EIT.
+ */
+static inline int dvb_eit_view_event_free_ca_mode(const uint8_t *event)
+{
+	return (event[10] >> 4) & 1;
+}
+
+/**
+ * Accessor for the descriptors_loop_length field of an event in a raw EIT.
+ */
+static inline uint16_t dvb_eit_view_event_descriptors_loop_length(const uint8_t *event)
+{
+	return ucsi_get_be16(event + 10) & 0x0fff;
+}
+
+/**
+ * Iterator for the descriptors field of an event in a raw EIT.
+ *
+ * @param event Pointer to the event.
+ * @param pos Variable holding a const pointer to the current descriptor.
+ */
+#define dvb_eit_view_event_descriptors_for_each(event, pos) \
+	section_view_descriptors_for_each((event) + sizeof(struct dvb_eit_event), \
+					  dvb_eit_view_event_descriptors_loop_length(event), \
+					  pos)
+
+
 
 
 
@@ -137,11 +272,8 @@ static inline struct dvb_eit_event *
 static inline struct descriptor *
 	dvb_eit_event_descriptors_first(struct dvb_eit_event * t)
 {
-	if (t->descriptors_loop_length == 0)
-		return NULL;
-
-	return (struct descriptor *)
-		((uint8_t *) t + sizeof(struct dvb_eit_event));
+	return first_descriptor((uint8_t *) t + sizeof(struct dvb_eit_event),
+				t->descriptors_loop_length);
 }
 
 static inline struct descriptor *
@@ -153,6 +285,27 @@ static inline struct descriptor *
 			       pos);
 }
 
+static inline const uint8_t *
+	dvb_eit_view_events_first(const uint8_t *buf)
+{
+	if (sizeof(struct dvb_eit_section) >= section_view_ext_length(buf))
+		return NULL;
+
+	return buf + sizeof(struct dvb_eit_section);
+}
+
+static inline const uint8_t *
+	dvb_eit_view_events_next(const uint8_t *buf, const uint8_t *pos)
+{
+	const uint8_t *next = pos + sizeof(struct dvb_eit_event) +
+			      dvb_eit_view_event_descriptors_loop_length(pos);
+
+	if (next >= buf + section_view_ext_length(buf))
+		return NULL;
+
+	return next;
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,739 @@
+/**
+ * MPE-FEC frame decoder.
+ *
+ * Copyright (c) 2026 by agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <libucsi/crc32.h>
+#include <libucsi/mpeg/section.h>
+#include <libucsi/dvb/section.h>
+#include "mpe_fec.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define GF_X86 1
+#endif
+
+/* datagram and MPE-FEC sections have headers of the same size */
+#define MPE_HDR_SIZE 12
+#define MPE_LLC_SNAP_SIZE 8
+
+/* field generator polynomial x^8 + x^4 + x^3 + x^2 + 1 */
+#define GF_POLY 0x11d
+
+typedef void (*gf_region_fn)(uint8_t *dst, const uint8_t *src, uint8_t c, int len);
+
+struct gf_tables {
+	uint8_t exp[2 * 255];
+	uint8_t log[256];
+	uint8_t mul[256][256];
+	/* products with each low nibble, then with each high nibble */
+	uint8_t nibble[256][2][16];
+	/* contribution of each ADT column to each RS column */
+	uint8_t parity[MPE_FEC_RS_COLUMNS][MPE_FEC_ADT_COLUMNS];
+	gf_region_fn region;
+};
+
+static struct gf_tables gf;
+static pthread_once_t gf_once = PTHREAD_ONCE_INIT;
+
+struct mpe_fec_range {
+	uint32_t start;
+	uint32_t end;
+	uint16_t mac;			/* MAC_address_5 and _6 of its section */
+};
+
+struct mpe_fec {
+	int rows;
+	uint8_t *frame;			/* MPE_FEC_COLUMNS columns of rows bytes */
+	uint8_t *known;			/* per ADT byte: nonzero if it was received */
+	uint8_t *row_ok;		/* per row: nonzero if nothing in it is missing */
+	uint8_t *syndromes;		/* MPE_FEC_RS_COLUMNS runs of rows bytes */
+
+	/* the frame in progress */
+	struct mpe_fec_range *ranges;	/* where the datagrams received went */
+	int ranges_count;
+	int ranges_alloc;
+	uint64_t rs_received;		/* bitmap of the RS columns received */
+	int padding_columns;		/* or -1 if no MPE-FEC section has arrived */
+	int data_end;			/* end of the datagrams in the ADT, or -1 if unknown */
+	int fec_started;		/* an MPE-FEC section of this frame has arrived */
+
+	/* set up by mpe_fec_decode() */
+	int end;			/* end of the ADT data to deliver */
+	int complete;			/* nothing was missing */
+
+	mpe_fec_callback callback;
+	void *arg;
+
+	struct mpe_fec_stats stats;
+};
+
+static void gf_init(void);
+static void gf_build(void);
+static void gf_region_scalar(uint8_t *dst, const uint8_t *src, uint8_t c, int len);
+#ifdef GF_X86
+static void gf_region_ssse3(uint8_t *dst, const uint8_t *src, uint8_t c, int len);
+static void gf_region_avx2(uint8_t *dst, const uint8_t *src, uint8_t c, int len);
+#endif
+static int gf_invert(uint8_t m[][MPE_FEC_RS_COLUMNS], uint8_t inv[][MPE_FEC_RS_COLUMNS], int n);
+static int mpe_fec_add_datagram(struct mpe_fec *fec, uint8_t *section, int len);
+static int mpe_fec_add_rs(struct mpe_fec *fec, uint8_t *section, int len);
+static void mpe_fec_reset(struct mpe_fec *fec);
+static void mpe_fec_decode(struct mpe_fec *fec);
+static void mpe_fec_syndromes(struct mpe_fec *fec, int n);
+static int mpe_fec_decode_rows(struct mpe_fec *fec, int r0, int r1, int *cols, int m);
+static void mpe_fec_deliver(struct mpe_fec *fec);
+static int mpe_fec_available(struct mpe_fec *fec, int pos, int len, int *recovered);
+static int mpe_fec_ip_length(uint8_t *data, int len);
+
+struct mpe_fec *mpe_fec_create(int rows, mpe_fec_callback callback, void *arg)
+{
+	struct mpe_fec *fec;
+
+	if ((rows < MPE_FEC_MIN_ROWS) || (rows > MPE_FEC_MAX_ROWS) || (rows % 256))
+		return NULL;
+	gf_init();
+
+	fec = (struct mpe_fec *) malloc(sizeof(struct mpe_fec));
+	if (fec == NULL)
+		return NULL;
+	memset(fec, 0, sizeof(struct mpe_fec));
+	fec->rows = rows;
+	fec->callback = callback;
+	fec->arg = arg;
+
+	fec->frame = (uint8_t *) malloc(MPE_FEC_COLUMNS * rows);
+	fec->known = (uint8_t *) malloc(MPE_FEC_ADT_COLUMNS * rows);
+	fec->row_ok = (uint8_t *) malloc(rows);
+	fec->syndromes = (uint8_t *) malloc(MPE_FEC_RS_COLUMNS * rows);
+	if ((fec->frame == NULL) || (fec->known == NULL) ||
+	    (fec->row_ok == NULL) || (fec->syndromes == NULL)) {
+		mpe_fec_destroy(fec);
+		return NULL;
+	}
+	mpe_fec_reset(fec);
+
+	return fec;
+}
+
+void mpe_fec_destroy(struct mpe_fec *fec)
+{
+	free(fec->frame);
+	free(fec->known);
+	free(fec->row_ok);
+	free(fec->syndromes);
+	free(fec->ranges);
+	free(fec);
+}
+
+int mpe_fec_add_section(struct mpe_fec *fec, uint8_t *section, int len)
+{
+	if (len >= MPE_HDR_SIZE + CRC_SIZE) {
+		if (section[0] == stag_mpeg_datagram)
+			return mpe_fec_add_datagram(fec, section, len);
+		if (section[0] == stag_dvb_mpe_fec)
+			return mpe_fec_add_rs(fec, section, len);
+	}
+
+	fec->stats.invalid++;
+	return -EINVAL;
+}
+
+void mpe_fec_flush(struct mpe_fec *fec)
+{
+	if ((fec->ranges_count == 0) && (fec->rs_received == 0))
+		return;
+
+	mpe_fec_decode(fec);
+	mpe_fec_deliver(fec);
+	fec->stats.frames++;
+	mpe_fec_reset(fec);
+}
+
+void mpe_fec_get_stats(struct mpe_fec *fec, struct mpe_fec_stats *stats)
+{
+	memcpy(stats, &fec->stats, sizeof(struct mpe_fec_stats));
+}
+
+void mpe_fec_encode(uint8_t *frame, int rows)
+{
+	uint8_t *dst;
+	int j;
+	int k;
+
+	gf_init();
+
+	for(j=0; j < MPE_FEC_RS_COLUMNS; j++) {
+		dst = frame + ((MPE_FEC_ADT_COLUMNS + j) * rows);
+		memset(dst, 0, rows);
+		for(k=0; k < MPE_FEC_ADT_COLUMNS; k++)
+			gf.region(dst, frame + (k * rows), gf.parity[j][k], rows);
+	}
+}
+
+static int mpe_fec_add_datagram(struct mpe_fec *fec, uint8_t *section, int len)
+{
+	struct real_time_parameters rt;
+	struct mpe_fec_range *range;
+	uint8_t *data;
+	int datalen;
+	int iplen;
+
+	/* unscrambled, unfragmented, and intact */
+	if ((section[5] & 0x3c) || section[6] || section[7] ||
+	    ((section[1] & 0x80) && crc32(CRC32_INIT, section, len))) {
+		fec->stats.invalid++;
+		return -EINVAL;
+	}
+
+	real_time_parameters_extract(section + 8, &rt);
+	data = section + MPE_HDR_SIZE;
+	datalen = len - MPE_HDR_SIZE - CRC_SIZE;
+	if ((section[5] & 0x02) && (datalen >= MPE_LLC_SNAP_SIZE)) {
+		data += MPE_LLC_SNAP_SIZE;
+		datalen -= MPE_LLC_SNAP_SIZE;
+	}
+	iplen = mpe_fec_ip_length(data, datalen);
+	if ((iplen <= 0) || ((int) rt.address + iplen > MPE_FEC_ADT_COLUMNS * fec->rows)) {
+		fec->stats.invalid++;
+		return -EINVAL;
+	}
+
+	/* a datagram after the RS data, or earlier in the table, is in the next frame */
+	if (fec->fec_started ||
+	    (fec->ranges_count && (rt.address < fec->ranges[fec->ranges_count - 1].start)))
+		mpe_fec_flush(fec);
+
+	if (fec->ranges_count == fec->ranges_alloc) {
+		int newalloc = fec->ranges_alloc ? fec->ranges_alloc * 2 : 256;
+
+		range = (struct mpe_fec_range *)
+			realloc(fec->ranges, newalloc * sizeof(struct mpe_fec_range));
+		if (range == NULL)
+			return -ENOMEM;
+		fec->ranges = range;
+		fec->ranges_alloc = newalloc;
+	}
+	range = &fec->ranges[fec->ranges_count++];
+	range->start = rt.address;
+	range->end = rt.address + iplen;
+	range->mac = (section[4] << 8) | section[3];
+	memcpy(fec->frame + rt.address, data, iplen);
+	fec->stats.sections++;
+
+	if (rt.table_boundary)
+		fec->data_end = range->end;
+	if (rt.frame_boundary)
+		mpe_fec_flush(fec);
+	return 0;
+}
+
+static int mpe_fec_add_rs(struct mpe_fec *fec, uint8_t *section, int len)
+{
+	struct real_time_parameters rt;
+	int column = section[6];
+
+	if ((len - MPE_HDR_SIZE - CRC_SIZE != fec->rows) ||
+	    (column >= MPE_FEC_RS_COLUMNS) || (section[3] >= MPE_FEC_ADT_COLUMNS) ||
+	    crc32(CRC32_INIT, section, len)) {
+		fec->stats.invalid++;
+		return -EINVAL;
+	}
+
+	real_time_parameters_extract(section + 8, &rt);
+	memcpy(fec->frame + ((MPE_FEC_ADT_COLUMNS + column) * fec->rows),
+	       section + MPE_HDR_SIZE, fec->rows);
+	fec->rs_received |= 1ULL << column;
+	fec->padding_columns = section[3];
+	fec->fec_started = 1;
+	fec->stats.fec_sections++;
+
+	/* anything after the last RS column is punctured */
+	if (rt.frame_boundary || (column == section[7]))
+		mpe_fec_flush(fec);
+	return 0;
+}
+
+static void mpe_fec_reset(struct mpe_fec *fec)
+{
+	fec->ranges_count = 0;
+	fec->rs_received = 0;
+	fec->padding_columns = -1;
+	fec->data_end = -1;
+	fec->fec_started = 0;
+}
+
+static int mpe_fec_range_cmp(const void *a, const void *b)
+{
+	const struct mpe_fec_range *ra = (const struct mpe_fec_range *) a;
+	const struct mpe_fec_range *rb = (const struct mpe_fec_range *) b;
+
+	if (ra->start != rb->start)
+		return (ra->start < rb->start) ? -1 : 1;
+	return 0;
+}
+
+static void mpe_fec_decode(struct mpe_fec *fec)
+{
+	int rows = fec->rows;
+	int adt_size = MPE_FEC_ADT_COLUMNS * rows;
+	uint8_t gap_column[MPE_FEC_ADT_COLUMNS];
+	int gap_columns[MPE_FEC_ADT_COLUMNS];
+	int cols[MPE_FEC_ADT_COLUMNS + MPE_FEC_RS_COLUMNS];
+	int rs_missing = 0;
+	int ngap = 0;
+	int gaps = 0;
+	int nsyndromes;
+	int pos;
+	int r0;
+	int r1;
+	int m;
+	int i;
+	int j;
+
+	for(i=1; i < fec->ranges_count; i++) {
+		if (fec->ranges[i].start < fec->ranges[i-1].start) {
+			qsort(fec->ranges, fec->ranges_count, sizeof(struct mpe_fec_range),
+			      mpe_fec_range_cmp);
+			break;
+		}
+	}
+
+	/* work out how much of the ADT holds datagrams; the rest is zero padding */
+	if (fec->data_end >= 0) {
+		fec->end = fec->data_end;
+	} else if (fec->padding_columns >= 0) {
+		fec->end = (MPE_FEC_ADT_COLUMNS - fec->padding_columns) * rows;
+	} else {
+		fec->end = 0;
+		for(i=0; i < fec->ranges_count; i++) {
+			if ((int) fec->ranges[i].end > fec->end)
+				fec->end = fec->ranges[i].end;
+		}
+	}
+	memset(fec->frame + fec->end, 0, adt_size - fec->end);
+
+	/* find the gaps */
+	memset(gap_column, 0, sizeof(gap_column));
+	memset(fec->known, 1, adt_size);
+	pos = 0;
+	for(i=0; i <= fec->ranges_count; i++) {
+		int start = (i < fec->ranges_count) ? (int) fec->ranges[i].start : fec->end;
+
+		if (start > fec->end)
+			start = fec->end;
+		if (start > pos) {
+			memset(fec->known + pos, 0, start - pos);
+			memset(fec->frame + pos, 0, start - pos);
+			for(j=pos / rows; j <= (start - 1) / rows; j++)
+				gap_column[j] = 1;
+			gaps++;
+		}
+		if ((i < fec->ranges_count) && ((int) fec->ranges[i].end > pos))
+			pos = fec->ranges[i].end;
+	}
+	fec->complete = (gaps == 0);
+	memset(fec->row_ok, 1, rows);
+	if (fec->complete)
+		return;
+
+	for(j=0; j < MPE_FEC_ADT_COLUMNS; j++) {
+		if (gap_column[j])
+			gap_columns[ngap++] = j;
+	}
+	for(j=0; j < MPE_FEC_RS_COLUMNS; j++) {
+		if (!(fec->rs_received & (1ULL << j))) {
+			memset(fec->frame + ((MPE_FEC_ADT_COLUMNS + j) * rows), 0, rows);
+			rs_missing++;
+		}
+	}
+
+	/*
+	 * With the erasures zeroed, the syndromes of every row can be worked out
+	 * in one pass down whole columns, whatever its erasures are.
+	 */
+	nsyndromes = ngap + rs_missing;
+	if (nsyndromes > MPE_FEC_RS_COLUMNS)
+		nsyndromes = MPE_FEC_RS_COLUMNS;
+	mpe_fec_syndromes(fec, nsyndromes);
+
+	/* decode runs of rows with the same erasures together */
+	for(r0=0; r0 < rows; r0 = r1) {
+		m = 0;
+		for(i=0; i < ngap; i++) {
+			if (!fec->known[(gap_columns[i] * rows) + r0])
+				cols[m++] = gap_columns[i];
+		}
+		for(r1=r0+1; r1 < rows; r1++) {
+			for(i=0; i < ngap; i++) {
+				uint8_t *k = fec->known + (gap_columns[i] * rows);
+
+				if (k[r1] != k[r0])
+					break;
+			}
+			if (i < ngap)
+				break;
+		}
+
+		if (m == 0)
+			continue;
+		if (m + rs_missing > nsyndromes) {
+			memset(fec->row_ok + r0, 0, r1 - r0);
+			fec->stats.rows_failed += r1 - r0;
+			continue;
+		}
+
+		for(j=0; j < MPE_FEC_RS_COLUMNS; j++) {
+			if (!(fec->rs_received & (1ULL << j)))
+				cols[m++] = MPE_FEC_ADT_COLUMNS + j;
+		}
+		if (mpe_fec_decode_rows(fec, r0, r1, cols, m)) {
+			memset(fec->row_ok + r0, 0, r1 - r0);
+			fec->stats.rows_failed += r1 - r0;
+			continue;
+		}
+		fec->stats.rows_corrected += r1 - r0;
+	}
+}
+
+/*
+ * Each row is a codeword c with the byte in column j as the coefficient of
+ * x^(254-j), and c(x) has roots 1, a, ... a^63. So for i < m,
+ *	sum over the erased columns e of c_e X_e^i = sum over the others of c_j X_j^i
+ * where X_j = a^(254-j). The right hand sides are the syndromes, and the
+ * erased bytes are their product with the inverse of the m x m Vandermonde
+ * matrix on the left.
+ */
+static void mpe_fec_syndromes(struct mpe_fec *fec, int n)
+{
+	int rows = fec->rows;
+	int power;
+	int log;
+	int i;
+	int j;
+
+	memset(fec->syndromes, 0, n * rows);
+	for(j=0; j < MPE_FEC_COLUMNS; j++) {
+		/* the padding and missing RS columns are all zero, so contribute nothing */
+		if ((j < MPE_FEC_ADT_COLUMNS) && (j * rows >= fec->end))
+			continue;
+		if ((j >= MPE_FEC_ADT_COLUMNS) &&
+		    !(fec->rs_received & (1ULL << (j - MPE_FEC_ADT_COLUMNS))))
+			continue;
+
+		log = 254 - j;
+		power = 0;
+		for(i=0; i < n; i++) {
+			gf.region(fec->syndromes + (i * rows), fec->frame + (j * rows),
+				  gf.exp[power], rows);
+			power = (power + log) % 255;
+		}
+	}
+}
+
+static int mpe_fec_decode_rows(struct mpe_fec *fec, int r0, int r1, int *cols, int m)
+{
+	uint8_t vandermonde[MPE_FEC_RS_COLUMNS][MPE_FEC_RS_COLUMNS];
+	uint8_t inverse[MPE_FEC_RS_COLUMNS][MPE_FEC_RS_COLUMNS];
+	int rows = fec->rows;
+	int len = r1 - r0;
+	uint8_t *dst;
+	int power;
+	int log;
+	int i;
+	int t;
+
+	for(t=0; t < m; t++) {
+		log = 254 - cols[t];
+		power = 0;
+		for(i=0; i < m; i++) {
+			vandermonde[i][t] = gf.exp[power];
+			power = (power + log) % 255;
+		}
+	}
+	if (gf_invert(vandermonde, inverse, m))
+		return -1;
+
+	/* the erasures are zero, so are just the inverse applied to the syndromes */
+	for(t=0; t < m; t++) {
+		dst = fec->frame + (cols[t] * rows) + r0;
+		for(i=0; i < m; i++) {
+			if (inverse[t][i])
+				gf.region(dst, fec->syndromes + (i * rows) + r0, inverse[t][i], len);
+		}
+	}
+
+	return 0;
+}
+
+static void mpe_fec_deliver(struct mpe_fec *fec)
+{
+	int recovered;
+	int next;
+	int pos = 0;
+	int ri = 0;
+	int len;
+
+	while(pos < fec->end) {
+		while((ri < fec->ranges_count) && ((int) fec->ranges[ri].start < pos))
+			ri++;
+
+		/* datagrams which arrived are delivered as they were */
+		if ((ri < fec->ranges_count) && ((int) fec->ranges[ri].start == pos)) {
+			len = fec->ranges[ri].end - pos;
+			fec->callback(fec->arg, fec->frame + pos, len, 0, fec->ranges[ri].mac);
+			fec->stats.datagrams++;
+			pos += len;
+			ri++;
+			continue;
+		}
+
+		/* in a gap, the datagrams have to be found from their own headers */
+		next = (ri < fec->ranges_count) ? (int) fec->ranges[ri].start : fec->end;
+		if (next > fec->end)
+			next = fec->end;
+		len = 0;
+		if (mpe_fec_available(fec, pos, (next - pos < 6) ? next - pos : 6, &recovered)) {
+			/* zeros at the end of the table are padding */
+			if ((fec->frame[pos] == 0) && (next == fec->end))
+				break;
+			len = mpe_fec_ip_length(fec->frame + pos, next - pos);
+		}
+		if ((len > 0) && mpe_fec_available(fec, pos, len, &recovered)) {
+			fec->callback(fec->arg, fec->frame + pos, len, recovered, -1);
+			fec->stats.datagrams++;
+			if (recovered)
+				fec->stats.recovered++;
+			pos += len;
+			continue;
+		}
+
+		fec->stats.lost++;
+		pos = next;
+	}
+}
+
+static int mpe_fec_available(struct mpe_fec *fec, int pos, int len, int *recovered)
+{
+	int i;
+
+	*recovered = 0;
+	if (fec->complete)
+		return 1;
+
+	for(i=pos; i < pos + len; i++) {
+		if (fec->known[i])
+			continue;
+		if (!fec->row_ok[i % fec->rows])
+			return 0;
+		*recovered = 1;
+	}
+	return 1;
+}
+
+static int mpe_fec_ip_length(uint8_t *data, int len)
+{
+	int iplen;
+
+	if ((len >= 20) && ((data[0] >> 4) == 4)) {
+		iplen = (data[2] << 8) | data[3];
+		if (iplen < 20)
+			return -1;
+	} else if ((len >= 40) && ((data[0] >> 4) == 6)) {
+		iplen = ((data[4] << 8) | data[5]) + 40;
+	} else {
+		return -1;
+	}
+
+	return (iplen <= len) ? iplen : -1;
+}
+
+static void gf_init(void)
+{
+	// gf.region must not change under a decoder running in another thread
+	pthread_once(&gf_once, gf_build);
+}
+
+static void gf_build(void)
+{
+	uint8_t generator[MPE_FEC_RS_COLUMNS + 1];
+	uint8_t rem[MPE_FEC_RS_COLUMNS];
+	uint8_t top;
+	int x;
+	int a;
+	int b;
+	int i;
+	int j;
+
+	x = 1;
+	for(i=0; i < 255; i++) {
+		gf.exp[i] = gf.exp[i + 255] = x;
+		gf.log[x] = i;
+		x <<= 1;
+		if (x & 0x100)
+			x ^= GF_POLY;
+	}
+	for(a=0; a < 256; a++) {
+		for(b=0; b < 256; b++)
+			gf.mul[a][b] = (a && b) ? gf.exp[gf.log[a] + gf.log[b]] : 0;
+		for(i=0; i < 16; i++) {
+			gf.nibble[a][0][i] = gf.mul[a][i];
+			gf.nibble[a][1][i] = gf.mul[a][i << 4];
+		}
+	}
+
+	/* g(x) = (x + 1)(x + a)...(x + a^63), lowest order coefficient first */
+	memset(generator, 0, sizeof(generator));
+	generator[0] = 1;
+	for(i=0; i < MPE_FEC_RS_COLUMNS; i++) {
+		for(j=i+1; j > 0; j--)
+			generator[j] = generator[j-1] ^ gf.mul[gf.exp[i]][generator[j]];
+		generator[0] = gf.mul[gf.exp[i]][generator[0]];
+	}
+
+	/*
+	 * ADT column k is the coefficient of x^(254-k), and RS column j of
+	 * x^(63-j), so RS column j gets the x^(63-j) coefficient of
+	 * x^(254-k) mod g(x) times column k. Work up from x^64 mod g(x).
+	 */
+	memcpy(rem, generator, MPE_FEC_RS_COLUMNS);
+	for(i=64; i <= 254; i++) {
+		for(j=0; j < MPE_FEC_RS_COLUMNS; j++)
+			gf.parity[j][254 - i] = rem[63 - j];
+
+		top = rem[MPE_FEC_RS_COLUMNS - 1];
+		for(j=MPE_FEC_RS_COLUMNS - 1; j > 0; j--)
+			rem[j] = rem[j-1] ^ gf.mul[top][generator[j]];
+		rem[0] = gf.mul[top][generator[0]];
+	}
+
+	gf.region = gf_region_scalar;
+#ifdef GF_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		gf.region = gf_region_avx2;
+	else if (__builtin_cpu_supports("ssse3"))
+		gf.region = gf_region_ssse3;
+#endif
+}
+
+/* dst ^= c * src, over GF(256) */
+static void gf_region_scalar(uint8_t *dst, const uint8_t *src, uint8_t c, int len)
+{
+	const uint8_t *mul = gf.mul[c];
+	int i;
+
+	for(i=0; i < len; i++)
+		dst[i] ^= mul[src[i]];
+}
+
+#ifdef GF_X86
+/*
+ * The product of a constant and a byte is the xor of its products with the
+ * byte's two nibbles, which pshufb looks up 16 or 32 at a time.
+ */
+__attribute__((target("ssse3")))
+static void gf_region_ssse3(uint8_t *dst, const uint8_t *src, uint8_t c, int len)
+{
+	__m128i lo = _mm_loadu_si128((const __m128i *) gf.nibble[c][0]);
+	__m128i hi = _mm_loadu_si128((const __m128i *) gf.nibble[c][1]);
+	__m128i mask = _mm_set1_epi8(0x0f);
+	__m128i s;
+	__m128i p;
+	int i;
+
+	for(i=0; i + 16 <= len; i += 16) {
+		s = _mm_loadu_si128((const __m128i *) (src + i));
+		p = _mm_xor_si128(_mm_shuffle_epi8(lo, _mm_and_si128(s, mask)),
+				  _mm_shuffle_epi8(hi, _mm_and_si128(_mm_srli_epi64(s, 4), mask)));
+		p = _mm_xor_si128(p, _mm_loadu_si128((const __m128i *) (dst + i)));
+		_mm_storeu_si128((__m128i *) (dst + i), p);
+	}
+	gf_region_scalar(dst + i, src + i, c, len - i);
+}
+
+__attribute__((target("avx2")))
+static void gf_region_avx2(uint8_t *dst, const uint8_t *src, uint8_t c, int len)
+{
+	__m256i lo = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *) gf.nibble[c][0]));
+	__m256i hi = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *) gf.nibble[c][1]));
+	__m256i mask = _mm256_set1_epi8(0x0f);
+	__m256i s;
+	__m256i p;
+	int i;
+
+	for(i=0; i + 32 <= len; i += 32) {
+		s = _mm256_loadu_si256((const __m256i *) (src + i));
+		p = _mm256_xor_si256(_mm256_shuffle_epi8(lo, _mm256_and_si256(s, mask)),
+				     _mm256_shuffle_epi8(hi, _mm256_and_si256(_mm256_srli_epi64(s, 4), mask)));
+		p = _mm256_xor_si256(p, _mm256_loadu_si256((const __m256i *) (dst + i)));
+		_mm256_storeu_si256((__m256i *) (dst + i), p);
+	}
+	gf_region_scalar(dst + i, src + i, c, len - i);
+}
+#endif
+
+/* Gauss-Jordan elimination over GF(256). Returns nonzero if m is singular. */
+static int gf_invert(uint8_t m[][MPE_FEC_RS_COLUMNS], uint8_t inv[][MPE_FEC_RS_COLUMNS], int n)
+{
+	uint8_t tmp[MPE_FEC_RS_COLUMNS];
+	uint8_t f;
+	int col;
+	int row;
+	int i;
+
+	for(row=0; row < n; row++) {
+		memset(inv[row], 0, n);
+		inv[row][row] = 1;
+	}
+
+	for(col=0; col < n; col++) {
+		for(row=col; (row < n) && (m[row][col] == 0); row++)
+			;
+		if (row == n)
+			return -1;
+		if (row != col) {
+			memcpy(tmp, m[row], n);
+			memcpy(m[row], m[col], n);
+			memcpy(m[col], tmp, n);
+			memcpy(tmp, inv[row], n);
+			memcpy(inv[row], inv[col], n);
+			memcpy(inv[col], tmp, n);
+		}
+
+		f = gf.exp[255 - gf.log[m[col][col]]];
+		for(i=0; i < n; i++) {
+			m[col][i] = gf.mul[f][m[col][i]];
+			inv[col][i] = gf.mul[f][inv[col][i]];
+		}
+
+		for(row=0; row < n; row++) {
+			if ((row == col) || (m[row][col] == 0))
+				continue;
+			f = m[row][col];
+			gf.region(m[row], m[col], f, n);
+			gf.region(inv[row], inv[col], f, n);
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,154 @@
+/**
+ * MPE-FEC frame decoder.
+ *
+ * Copyright (c) 2026 by agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef _UCSI_DVB_MPE_FEC_H
+#define _UCSI_DVB_MPE_FEC_H 1
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+
+/**
+ * Number of columns in an MPE-FEC frame, and how they are divided between
+ * the application data table (ADT) and the RS data table.
+ */
+#define MPE_FEC_COLUMNS 255
+#define MPE_FEC_ADT_COLUMNS 191
+#define MPE_FEC_RS_COLUMNS 64
+
+/**
+ * Permitted numbers of rows in an MPE-FEC frame (frame_size of the
+ * time_slice_fec_identifier_descriptor).
+ */
+#define MPE_FEC_MIN_ROWS 256
+#define MPE_FEC_MAX_ROWS 1024
+
+/**
+ * Statistics maintained by an mpe_fec.
+ */
+struct mpe_fec_stats {
+	uint64_t frames;		/* frames completed */
+	uint64_t sections;		/* datagram sections added */
+	uint64_t fec_sections;		/* MPE-FEC sections added */
+	uint64_t invalid;		/* sections discarded as invalid */
+	uint64_t datagrams;		/* datagrams delivered */
+	uint64_t recovered;		/* of those, the ones rebuilt by the decoder */
+	uint64_t lost;			/* runs of data which could not be recovered */
+	uint64_t rows_corrected;	/* rows with erasures which were decoded */
+	uint64_t rows_failed;		/* rows with erasures which could not be decoded */
+};
+
+/**
+ * Callback receiving a datagram from a completed frame, in frame order. The
+ * data is only valid for the duration of the call.
+ *
+ * @param arg Private argument supplied to mpe_fec_create().
+ * @param datagram The IP datagram.
+ * @param len Its length.
+ * @param recovered Nonzero if part of the datagram was lost, and rebuilt by
+ * the decoder.
+ * @param mac The part of the destination MAC address left in the datagram
+ * section when the real_time_parameters replace MAC_address_1 to _4, i.e.
+ * (MAC_address_5 << 8) | MAC_address_6. It is -1 if the section was lost and
+ * the datagram found in the rebuilt frame, since its address is then unknown.
+ */
+typedef void (*mpe_fec_callback)(void *arg, uint8_t *datagram, int len, int recovered,
+				 int mac);
+
+/**
+ * Opaque type representing an MPE-FEC frame assembler (EN 301 192 clause 9).
+ *
+ * The datagram sections of an elementary stream are written into the
+ * application data table of a frame at the addresses given in their
+ * real_time_parameters, and the MPE-FEC sections into the RS data table.
+ * When the frame is complete, each row is erasure decoded as an RS(255,191)
+ * codeword, the erasures being the bytes of any sections which went
+ * missing, and the datagrams are then read back out of the frame.
+ *
+ * Rows sharing the same erasure pattern are decoded together, a column at
+ * a time, so the work is mostly multiplying runs of bytes by constants over
+ * GF(256); this uses SSSE3 or AVX2 where the CPU has them.
+ */
+struct mpe_fec;
+
+/**
+ * Create a new mpe_fec.
+ *
+ * @param rows Number of rows in the frame (256, 512, 768 or 1024).
+ * @param callback Callback to receive the datagrams.
+ * @param arg Private argument to pass to the callback.
+ * @return The new instance, or NULL on error.
+ */
+extern struct mpe_fec *mpe_fec_create(int rows, mpe_fec_callback callback, void *arg);
+
+/**
+ * Destroy an mpe_fec. Any frame in progress is discarded.
+ *
+ * @param fec The instance to destroy.
+ */
+extern void mpe_fec_destroy(struct mpe_fec *fec);
+
+/**
+ * Add a section to the frame. A frame is decoded and delivered when its
+ * last section (the one with frame_boundary set) arrives, or when a section
+ * belonging to the next frame does.
+ *
+ * @param fec The mpe_fec.
+ * @param section A complete datagram section or MPE-FEC section. Its CRC
+ * is checked here.
+ * @param len Length of the section.
+ * @return 0 on success, or a negative error code if the section was invalid.
+ */
+extern int mpe_fec_add_section(struct mpe_fec *fec, uint8_t *section, int len);
+
+/**
+ * Decode and deliver the frame in progress now, e.g. at the end of a
+ * recording, or if the end of a burst was lost.
+ *
+ * @param fec The mpe_fec.
+ */
+extern void mpe_fec_flush(struct mpe_fec *fec);
+
+/**
+ * Retrieve the statistics of an mpe_fec.
+ *
+ * @param fec The mpe_fec.
+ * @param stats Where to put the statistics.
+ */
+extern void mpe_fec_get_stats(struct mpe_fec *fec, struct mpe_fec_stats *stats);
+
+/**
+ * Compute the RS data table of a frame from its application data table.
+ *
+ * @param frame The frame, stored a column at a time: MPE_FEC_COLUMNS columns
+ * of rows bytes each, with the application data table (padding included)
+ * already filled in.
+ * @param rows Number of rows in the frame.
+ */
+extern void mpe_fec_encode(uint8_t *frame, int rows);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
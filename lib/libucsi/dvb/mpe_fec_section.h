@@ -31,11 +31,61 @@ extern "C"
 #include <libucsi/mpeg/section.h>
 
 /**
- * mpe_fec_section structure. TODO
+ * mpe_fec_section structure. Each section carries one column of the RS data
+ * table of an MPE-FEC frame: section_number is the column, and the column
+ * is as many bytes long as the frame has rows.
  */
 struct mpe_fec_section {
 	struct section head;
-};
+
+	uint8_t padding_columns;
+	uint8_t reserved_for_future_use;
+  EBIT3(uint8_t reserved                  : 2; ,
+	uint8_t reserved_for_future_use_2 : 5; ,
+	uint8_t current_next_indicator    : 1; );
+	uint8_t section_number;
+	uint8_t last_section_number;
+	uint8_t real_time_parameters[4];
+	/* uint8_t rs_data[] */
+	/* crc */
+} __ucsi_packed;
+
+/**
+ * Process an mpe_fec_section.
+ *
+ * @param section Generic section header.
+ * @return mpe_fec_section pointer, or NULL on error.
+ */
+static inline struct mpe_fec_section *mpe_fec_section_codec(struct section *section)
+{
+	if (section_length(section) < sizeof(struct mpe_fec_section) + CRC_SIZE)
+		return NULL;
+
+	return (struct mpe_fec_section *) section;
+}
+
+/**
+ * Accessor for the RS data carried in an mpe_fec_section.
+ *
+ * @param s mpe_fec_section pointer.
+ * @return Pointer to the RS data.
+ */
+static inline uint8_t *mpe_fec_section_rs_data(struct mpe_fec_section *s)
+{
+	return (uint8_t *) s + sizeof(struct mpe_fec_section);
+}
+
+/**
+ * Determine the length of the RS data carried in an mpe_fec_section, which
+ * is the number of rows in the frame.
+ *
+ * @param s mpe_fec_section pointer.
+ * @return Length of the RS data in bytes.
+ */
+static inline size_t mpe_fec_section_rs_data_length(struct mpe_fec_section *s)
+{
+	return section_length(&s->head) - sizeof(struct mpe_fec_section) - CRC_SIZE;
+}
 
 
 /**
@@ -49,6 +99,21 @@ struct real_time_parameters {
 };
 
 
+/**
+ * Decode real_time_parameters without modifying the section they came from.
+ *
+ * @param buf Pointer to the four bytes of real_time_parameters (MAC_address_4
+ * of a datagram_section, or real_time_parameters of an mpe_fec_section).
+ * @param rt Where to put the decoded values.
+ */
+static inline void real_time_parameters_extract(const uint8_t *buf, struct real_time_parameters *rt)
+{
+	rt->delta_t = (buf[0] << 4) | ((buf[1] >> 4) & 0x0f);
+	rt->table_boundary = (buf[1] >> 3) & 0x1;
+	rt->frame_boundary = (buf[1] >> 2) & 0x1;
+	rt->address        = ((buf[1] & 0x3) << 16) | (buf[2] << 8) | buf[3];
+}
+
 static inline struct real_time_parameters * datagram_section_real_time_parameters_codec(struct datagram_section *d)
 {
 	struct real_time_parameters *rt = (struct real_time_parameters *) &d->MAC_address_4;
@@ -21,7 +21,7 @@
 
 #include <libucsi/dvb/nit_section.h>
 
-struct dvb_nit_section *dvb_nit_section_codec(struct section_ext * ext)
+static inline struct dvb_nit_section *dvb_nit_section_do_codec(struct section_ext * ext, int lazy)
 {
 	uint8_t * buf = (uint8_t *) ext;
 	struct dvb_nit_section * ret = (struct dvb_nit_section *) ext;
@@ -37,7 +37,7 @@ struct dvb_nit_section *dvb_nit_section_codec(struct section_ext * ext)
 	if ((pos + ret->network_descriptors_length) > len)
 		return NULL;
 
-	if (verify_descriptors(buf + pos, ret->network_descriptors_length))
+	if ((!lazy) && verify_descriptors(buf + pos, ret->network_descriptors_length))
 		return NULL;
 
 	pos += ret->network_descriptors_length;
@@ -64,7 +64,7 @@ struct dvb_nit_section *dvb_nit_section_codec(struct section_ext * ext)
 		if ((pos + transport->transport_descriptors_length) > len)
 			return NULL;
 
-		if (verify_descriptors(buf + pos,
+		if ((!lazy) && verify_descriptors(buf + pos,
 					transport->transport_descriptors_length))
 			return NULL;
 
@@ -76,3 +76,13 @@ struct dvb_nit_section *dvb_nit_section_codec(struct section_ext * ext)
 
 	return ret;
 }
+
+struct dvb_nit_section *dvb_nit_section_codec(struct section_ext * ext)
+{
+	return dvb_nit_section_do_codec(ext, 0);
+}
+
+struct dvb_nit_section *dvb_nit_section_codec_lazy(struct section_ext * ext)
+{
+	return dvb_nit_section_do_codec(ext, 1);
+}
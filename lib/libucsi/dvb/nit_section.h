@@ -69,6 +69,17 @@ struct dvb_nit_transport {
  */
 struct dvb_nit_section * dvb_nit_section_codec(struct section_ext *section);
 
+/**
+ * Process a dvb_nit_section, but leave the network and transport descriptor loops to be
+ * validated when they are first iterated (see first_descriptor()) rather
+ * than checking them all up front. Use this when most descriptors will not
+ * be looked at.
+ *
+ * @param section Generic section_ext pointer.
+ * @return dvb_nit_section pointer, or NULL on error.
+ */
+struct dvb_nit_section *dvb_nit_section_codec_lazy(struct section_ext *section);
+
 /**
  * Accessor for the network_id field of a NIT.
  *
@@ -140,11 +151,8 @@ static inline struct dvb_nit_section_part2 *dvb_nit_section_part2(struct dvb_nit
 static inline struct descriptor *
 	dvb_nit_section_descriptors_first(struct dvb_nit_section * nit)
 {
-	if (nit->network_descriptors_length == 0)
-		return NULL;
-
-	return (struct descriptor *)
-		((uint8_t *) nit + sizeof(struct dvb_nit_section));
+	return first_descriptor((uint8_t *) nit + sizeof(struct dvb_nit_section),
+				nit->network_descriptors_length);
 }
 
 static inline struct descriptor *
@@ -184,11 +192,8 @@ static inline struct dvb_nit_transport *
 static inline struct descriptor *
 	dvb_nit_transport_descriptors_first(struct dvb_nit_transport *t)
 {
-	if (t->transport_descriptors_length == 0)
-		return NULL;
-
-	return (struct descriptor *)
-		((uint8_t*) t + sizeof(struct dvb_nit_transport));
+	return first_descriptor((uint8_t *) t + sizeof(struct dvb_nit_transport),
+				t->transport_descriptors_length);
 }
 
 static inline struct descriptor *
@@ -21,7 +21,7 @@
 
 #include <libucsi/dvb/sdt_section.h>
 
-struct dvb_sdt_section * dvb_sdt_section_codec(struct section_ext * ext)
+static inline struct dvb_sdt_section *dvb_sdt_section_do_codec(struct section_ext * ext, int lazy)
 {
 	uint8_t * buf = (uint8_t *) ext;
 	size_t pos = sizeof(struct section_ext);
@@ -47,7 +47,7 @@ struct dvb_sdt_section * dvb_sdt_section_codec(struct section_ext * ext)
 		if ((pos + service->descriptors_loop_length) > len)
 			return NULL;
 
-		if (verify_descriptors(buf + pos, service->descriptors_loop_length))
+		if ((!lazy) && verify_descriptors(buf + pos, service->descriptors_loop_length))
 			return NULL;
 
 		pos += service->descriptors_loop_length;
@@ -58,3 +58,41 @@ struct dvb_sdt_section * dvb_sdt_section_codec(struct section_ext * ext)
 
 	return (struct dvb_sdt_section *) ext;
 }
+
+struct dvb_sdt_section *dvb_sdt_section_codec(struct section_ext * ext)
+{
+	return dvb_sdt_section_do_codec(ext, 0);
+}
+
+struct dvb_sdt_section *dvb_sdt_section_codec_lazy(struct section_ext * ext)
+{
+	return dvb_sdt_section_do_codec(ext, 1);
+}
+
+int dvb_sdt_view_check(const uint8_t *buf, size_t len)
+{
+	size_t pos = sizeof(struct dvb_sdt_section);
+	size_t dlen;
+
+	if (section_view_check(buf, len) || section_view_ext_check(buf, 0))
+		return -1;
+	len = section_view_ext_length(buf);
+	if (len < sizeof(struct dvb_sdt_section))
+		return -1;
+
+	while (pos < len) {
+		if ((pos + sizeof(struct dvb_sdt_service)) > len)
+			return -1;
+
+		dlen = dvb_sdt_view_service_descriptors_loop_length(buf + pos);
+		pos += sizeof(struct dvb_sdt_service);
+
+		if ((pos + dlen) > len)
+			return -1;
+		if (verify_descriptors((uint8_t *) buf + pos, dlen))
+			return -1;
+		pos += dlen;
+	}
+
+	return 0;
+}
@@ -28,6 +28,7 @@ extern "C"
 #endif
 
 #include <libucsi/section.h>
+#include <libucsi/section_view.h>
 
 /**
  * dvb_sdt_section structure.
@@ -62,6 +63,17 @@ struct dvb_sdt_service {
  */
 struct dvb_sdt_section * dvb_sdt_section_codec(struct section_ext *section);
 
+/**
+ * Process a dvb_sdt_section, but leave the service descriptor loops to be
+ * validated when they are first iterated (see first_descriptor()) rather
+ * than checking them all up front. Use this when most descriptors will not
+ * be looked at.
+ *
+ * @param section Pointer to a generic section_ext structure.
+ * @return dvb_sdt_section pointer, or NULL on error.
+ */
+struct dvb_sdt_section *dvb_sdt_section_codec_lazy(struct section_ext *section);
+
 /**
  * Accessor for the transport_stream_id field of an SDT.
  *
@@ -95,6 +107,109 @@ static inline uint16_t dvb_sdt_section_transport_stream_id(struct dvb_sdt_sectio
 	     (pos); \
 	     (pos) = dvb_sdt_service_descriptors_next(service, pos))
 
+/**
+ * Check a raw SDT section before using the read-only dvb_sdt_view_*()
+ * functions (see libucsi/section_view.h). The buffer is not modified.
+ *
+ * @param buf Pointer to the raw section.
+ * @param len Length of the buffer.
+ * @return 0 if it is valid, nonzero if not.
+ */
+extern int dvb_sdt_view_check(const uint8_t *buf, size_t len);
+
+/**
+ * Accessor for the transport_stream_id field of a raw SDT.
+ *
+ * @param buf Pointer to the raw section.
+ * @return The transport_stream_id.
+ */
+static inline uint16_t dvb_sdt_view_transport_stream_id(const uint8_t *buf)
+{
+	return section_view_table_id_ext(buf);
+}
+
+/**
+ * Accessor for the original_network_id field of a raw SDT.
+ *
+ * @param buf Pointer to the raw section.
+ * @return The original_network_id.
+ */
+static inline uint16_t dvb_sdt_view_original_network_id(const uint8_t *buf)
+{
+	return ucsi_get_be16(buf + 8);
+}
+
+/**
+ * Iterator for the services field of a raw SDT.
+ *
+ * @param buf Pointer to the raw section.
+ * @param pos Variable holding a const uint8_t pointer to the current service.
+ */
+#define dvb_sdt_view_services_for_each(buf, pos) \
+	for ((pos) = dvb_sdt_view_services_first(buf); \
+	     (pos); \
+	     (pos) = dvb_sdt_view_services_next(buf, pos))
+
+/**
+ * Accessor for the service_id field of a service in a raw SDT.
+ */
+static inline uint16_t dvb_sdt_view_service_id(const uint8_t *svc)
+{
+	return ucsi_get_be16(svc);
+}
+
+/**
+ * Accessor for the eit_schedule_flag field of a service in a raw SDT.
+ */
+static inline int dvb_sdt_view_service_eit_schedule_flag(const uint8_t *svc)
+{
+	return (svc[2] >> 1) & 1;
+}
+
+/**
+ * Accessor for the eit_present_following_flag field of a service in a raw SDT.
+ */
+static inline int dvb_sdt_view_service_eit_present_following_flag(const uint8_t *svc)
+{
+	return svc[2] & 1;
+}
+
+/**
+ * Accessor for the running_status field of a service in a raw SDT.
+ */
+static inline int dvb_sdt_view_service_running_status(const uint8_t *svc)
+{
+	return svc[3] >> 5;
+}
+
+/**
+ * Accessor for the free_ca_mode field of a service in a raw SDT.
+ */
+static inline int dvb_sdt_view_service_free_ca_mode(const uint8_t *svc)
+{
+	return (svc[3] >> 4) & 1;
+}
+
+/**
+ * Accessor for the descriptors_loop_length field of a service in a raw SDT.
+ */
+static inline uint16_t dvb_sdt_view_service_descriptors_loop_length(const uint8_t *svc)
+{
+	return ucsi_get_be16(svc + 3) & 0x0fff;
+}
+
+/**
+ * Iterator for the descriptors field of a service in a raw SDT.
+ *
+ * @param svc Pointer to the service.
+ * @param pos Variable holding a const pointer to the current descriptor.
+ */
+#define dvb_sdt_view_service_descriptors_for_each(svc, pos) \
+	section_view_descriptors_for_each((svc) + sizeof(struct dvb_sdt_service), \
+					  dvb_sdt_view_service_descriptors_loop_length(svc), \
+					  pos)
+
+
 
 
 
@@ -134,11 +249,8 @@ static inline struct dvb_sdt_service *
 static inline struct descriptor *
 	dvb_sdt_service_descriptors_first(struct dvb_sdt_service *svc)
 {
-	if (svc->descriptors_loop_length == 0)
-		return NULL;
-
-	return (struct descriptor *)
-		((uint8_t*) svc + sizeof(struct dvb_sdt_service));
+	return first_descriptor((uint8_t *) svc + sizeof(struct dvb_sdt_service),
+				svc->descriptors_loop_length);
 }
 
 static inline struct descriptor *
@@ -150,6 +262,27 @@ static inline struct descriptor *
 			       pos);
 }
 
+static inline const uint8_t *
+	dvb_sdt_view_services_first(const uint8_t *buf)
+{
+	if (sizeof(struct dvb_sdt_section) >= section_view_ext_length(buf))
+		return NULL;
+
+	return buf + sizeof(struct dvb_sdt_section);
+}
+
+static inline const uint8_t *
+	dvb_sdt_view_services_next(const uint8_t *buf, const uint8_t *pos)
+{
+	const uint8_t *next = pos + sizeof(struct dvb_sdt_service) +
+			      dvb_sdt_view_service_descriptors_loop_length(pos);
+
+	if (next >= buf + section_view_ext_length(buf))
+		return NULL;
+
+	return next;
+}
+
 #ifdef __cplusplus
 }
 #endif
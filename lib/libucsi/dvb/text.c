@@ -0,0 +1,931 @@
+/**
+ * DVB text string to UTF-8 conversion.
+ *
+ * Copyright (c) 2026 by agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <iconv.h>
+#include "text.h"
+
+/* how the text is encoded, once the character set selection is removed */
+enum dvb_text_encoding {
+	ENCODING_LATIN_00,		/* figure A.1 */
+	ENCODING_ISO8859,		/* one of iso8859_tables */
+	ENCODING_UCS2,			/* ISO/IEC 10646 basic multilingual plane */
+	ENCODING_UTF8,
+	ENCODING_ICONV,			/* anything else */
+};
+
+/* the iconv conversions a converter may need */
+enum dvb_text_iconv {
+	ICONV_DEFAULT,			/* default_charset to output */
+	ICONV_KSX1001,			/* KS X 1001 to output */
+	ICONV_GB2312,			/* GB-2312 to output */
+	ICONV_BIG5,			/* Big5 to output */
+	ICONV_UTF8,			/* UTF-8 to output */
+	ICONV_COUNT,
+};
+
+static const char *iconv_names[ICONV_COUNT] = {
+	NULL, "EUC-KR", "GB2312", "BIG5", "UTF-8",
+};
+
+struct dvb_text_conv {
+	int flags;
+	int utf8_output;
+	char *output_charset;
+
+	enum dvb_text_encoding default_encoding;
+	int default_table;
+	char *default_charset;
+
+	iconv_t cds[ICONV_COUNT];
+	uint8_t failed[ICONV_COUNT];
+
+	char *scratch;
+	size_t scratch_len;
+};
+
+/* substituted for invalid UTF-8 input */
+#define UTF8_REPLACEMENT 0xfffd
+
+/* output of a conversion to UTF-8 */
+struct utf8_out {
+	char *buf;
+	size_t pos;
+	size_t len;			/* excluding the space for the nul */
+	int truncated;
+	int emphasis;
+};
+
+/* character set selection values of table A.3, 0x01-0x0b */
+static const uint8_t iso8859_selection[12] = {
+	0, 5, 6, 7, 8, 9, 10, 11, 0, 13, 14, 15,
+};
+
+/* EN 300 468 figure A.1 (ISO/IEC 6937 plus the euro sign), 0xa0-0xff */
+static const uint16_t latin_00_table[96] = {
+	0x00a0, 0x00a1, 0x00a2, 0x00a3, 0x20ac, 0x00a5, 0x0023, 0x00a7,
+	0x00a4, 0x2018, 0x201c, 0x00ab, 0x2190, 0x2191, 0x2192, 0x2193,
+	0x00b0, 0x00b1, 0x00b2, 0x00b3, 0x00d7, 0x00b5, 0x00b6, 0x00b7,
+	0x00f7, 0x2019, 0x201d, 0x00bb, 0x00bc, 0x00bd, 0x00be, 0x00bf,
+	0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+	0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+	0x2014, 0x00b9, 0x00ae, 0x00a9, 0x2122, 0x266a, 0x00ac, 0x00a6,
+	0x0000, 0x0000, 0x0000, 0x0000, 0x215b, 0x215c, 0x215d, 0x215e,
+	0x2126, 0x00c6, 0x00d0, 0x00aa, 0x0126, 0x0000, 0x0132, 0x013f,
+	0x0141, 0x00d8, 0x0152, 0x00ba, 0x00de, 0x0166, 0x014a, 0x0149,
+	0x0138, 0x00e6, 0x0111, 0x00f0, 0x0127, 0x0131, 0x0133, 0x0140,
+	0x0142, 0x00f8, 0x0153, 0x00df, 0x00fe, 0x0167, 0x014b, 0x00ad,
+};
+
+/* ISO/IEC 8859-1 to 15, 0xa0-0xff (there is no 8859-12) */
+static const uint16_t iso8859_tables[16][96] = {
+	[1] = {
+		0x00a0, 0x00a1, 0x00a2, 0x00a3, 0x00a4, 0x00a5, 0x00a6, 0x00a7,
+		0x00a8, 0x00a9, 0x00aa, 0x00ab, 0x00ac, 0x00ad, 0x00ae, 0x00af,
+		0x00b0, 0x00b1, 0x00b2, 0x00b3, 0x00b4, 0x00b5, 0x00b6, 0x00b7,
+		0x00b8, 0x00b9, 0x00ba, 0x00bb, 0x00bc, 0x00bd, 0x00be, 0x00bf,
+		0x00c0, 0x00c1, 0x00c2, 0x00c3, 0x00c4, 0x00c5, 0x00c6, 0x00c7,
+		0x00c8, 0x00c9, 0x00ca, 0x00cb, 0x00cc, 0x00cd, 0x00ce, 0x00cf,
+		0x00d0, 0x00d1, 0x00d2, 0x00d3, 0x00d4, 0x00d5, 0x00d6, 0x00d7,
+		0x00d8, 0x00d9, 0x00da, 0x00db, 0x00dc, 0x00dd, 0x00de, 0x00df,
+		0x00e0, 0x00e1, 0x00e2, 0x00e3, 0x00e4, 0x00e5, 0x00e6, 0x00e7,
+		0x00e8, 0x00e9, 0x00ea, 0x00eb, 0x00ec, 0x00ed, 0x00ee, 0x00ef,
+		0x00f0, 0x00f1, 0x00f2, 0x00f3, 0x00f4, 0x00f5, 0x00f6, 0x00f7,
+		0x00f8, 0x00f9, 0x00fa, 0x00fb, 0x00fc, 0x00fd, 0x00fe, 0x00ff,
+	},
+	[2] = {
+		0x00a0, 0x0104, 0x02d8, 0x0141, 0x00a4, 0x013d, 0x015a, 0x00a7,
+		0x00a8, 0x0160, 0x015e, 0x0164, 0x0179, 0x00ad, 0x017d, 0x017b,
+		0x00b0, 0x0105, 0x02db, 0x0142, 0x00b4, 0x013e, 0x015b, 0x02c7,
+		0x00b8, 0x0161, 0x015f, 0x0165, 0x017a, 0x02dd, 0x017e, 0x017c,
+		0x0154, 0x00c1, 0x00c2, 0x0102, 0x00c4, 0x0139, 0x0106, 0x00c7,
+		0x010c, 0x00c9, 0x0118, 0x00cb, 0x011a, 0x00cd, 0x00ce, 0x010e,
+		0x0110, 0x0143, 0x0147, 0x00d3, 0x00d4, 0x0150, 0x00d6, 0x00d7,
+		0x0158, 0x016e, 0x00da, 0x0170, 0x00dc, 0x00dd, 0x0162, 0x00df,
+		0x0155, 0x00e1, 0x00e2, 0x0103, 0x00e4, 0x013a, 0x0107, 0x00e7,
+		0x010d, 0x00e9, 0x0119, 0x00eb, 0x011b, 0x00ed, 0x00ee, 0x010f,
+		0x0111, 0x0144, 0x0148, 0x00f3, 0x00f4, 0x0151, 0x00f6, 0x00f7,
+		0x0159, 0x016f, 0x00fa, 0x0171, 0x00fc, 0x00fd, 0x0163, 0x02d9,
+	},
+	[3] = {
+		0x00a0, 0x0126, 0x02d8, 0x00a3, 0x00a4, 0x0000, 0x0124, 0x00a7,
+		0x00a8, 0x0130, 0x015e, 0x011e, 0x0134, 0x00ad, 0x0000, 0x017b,
+		0x00b0, 0x0127, 0x00b2, 0x00b3, 0x00b4, 0x00b5, 0x0125, 0x00b7,
+		0x00b8, 0x0131, 0x015f, 0x011f, 0x0135, 0x00bd, 0x0000, 0x017c,
+		0x00c0, 0x00c1, 0x00c2, 0x0000, 0x00c4, 0x010a, 0x0108, 0x00c7,
+		0x00c8, 0x00c9, 0x00ca, 0x00cb, 0x00cc, 0x00cd, 0x00ce, 0x00cf,
+		0x0000, 0x00d1, 0x00d2, 0x00d3, 0x00d4, 0x0120, 0x00d6, 0x00d7,
+		0x011c, 0x00d9, 0x00da, 0x00db, 0x00dc, 0x016c, 0x015c, 0x00df,
+		0x00e0, 0x00e1, 0x00e2, 0x0000, 0x00e4, 0x010b, 0x0109, 0x00e7,
+		0x00e8, 0x00e9, 0x00ea, 0x00eb, 0x00ec, 0x00ed, 0x00ee, 0x00ef,
+		0x0000, 0x00f1, 0x00f2, 0x00f3, 0x00f4, 0x0121, 0x00f6, 0x00f7,
+		0x011d, 0x00f9, 0x00fa, 0x00fb, 0x00fc, 0x016d, 0x015d, 0x02d9,
+	},
+	[4] = {
+		0x00a0, 0x0104, 0x0138, 0x0156, 0x00a4, 0x0128, 0x013b, 0x00a7,
+		0x00a8, 0x0160, 0x0112, 0x0122, 0x0166, 0x00ad, 0x017d, 0x00af,
+		0x00b0, 0x0105, 0x02db, 0x0157, 0x00b4, 0x0129, 0x013c, 0x02c7,
+		0x00b8, 0x0161, 0x0113, 0x0123, 0x0167, 0x014a, 0x017e, 0x014b,
+		0x0100, 0x00c1, 0x00c2, 0x00c3, 0x00c4, 0x00c5, 0x00c6, 0x012e,
+		0x010c, 0x00c9, 0x0118, 0x00cb, 0x0116, 0x00cd, 0x00ce, 0x012a,
+		0x0110, 0x0145, 0x014c, 0x0136, 0x00d4, 0x00d5, 0x00d6, 0x00d7,
+		0x00d8, 0x0172, 0x00da, 0x00db, 0x00dc, 0x0168, 0x016a, 0x00df,
+		0x0101, 0x00e1, 0x00e2, 0x00e3, 0x00e4, 0x00e5, 0x00e6, 0x012f,
+		0x010d, 0x00e9, 0x0119, 0x00eb, 0x0117, 0x00ed, 0x00ee, 0x012b,
+		0x0111, 0x0146, 0x014d, 0x0137, 0x00f4, 0x00f5, 0x00f6, 0x00f7,
+		0x00f8, 0x0173, 0x00fa, 0x00fb, 0x00fc, 0x0169, 0x016b, 0x02d9,
+	},
+	[5] = {
+		0x00a0, 0x0401, 0x0402, 0x0403, 0x0404, 0x0405, 0x0406, 0x0407,
+		0x0408, 0x0409, 0x040a, 0x040b, 0x040c, 0x00ad, 0x040e, 0x040f,
+		0x0410, 0x0411, 0x0412, 0x0413, 0x0414, 0x0415, 0x0416, 0x0417,
+		0x0418, 0x0419, 0x041a, 0x041b, 0x041c, 0x041d, 0x041e, 0x041f,
+		0x0420, 0x0421, 0x0422, 0x0423, 0x0424, 0x0425, 0x0426, 0x0427,
+		0x0428, 0x0429, 0x042a, 0x042b, 0x042c, 0x042d, 0x042e, 0x042f,
+		0x0430, 0x0431, 0x0432, 0x0433, 0x0434, 0x0435, 0x0436, 0x0437,
+		0x0438, 0x0439, 0x043a, 0x043b, 0x043c, 0x043d, 0x043e, 0x043f,
+		0x0440, 0x0441, 0x0442, 0x0443, 0x0444, 0x0445, 0x0446, 0x0447,
+		0x0448, 0x0449, 0x044a, 0x044b, 0x044c, 0x044d, 0x044e, 0x044f,
+		0x2116, 0x0451, 0x0452, 0x0453, 0x0454, 0x0455, 0x0456, 0x0457,
+		0x0458, 0x0459, 0x045a, 0x045b, 0x045c, 0x00a7, 0x045e, 0x045f,
+	},
+	[6] = {
+		0x00a0, 0x0000, 0x0000, 0x0000, 0x00a4, 0x0000, 0x0000, 0x0000,
+		0x0000, 0x0000, 0x0000, 0x0000, 0x060c, 0x00ad, 0x0000, 0x0000,
+		0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+		0x0000, 0x0000, 0x0000, 0x061b, 0x0000, 0x0000, 0x0000, 0x061f,
+		0x0000, 0x0621, 0x0622, 0x0623, 0x0624, 0x0625, 0x0626, 0x0627,
+		0x0628, 0x0629, 0x062a, 0x062b, 0x062c, 0x062d, 0x062e, 0x062f,
+		0x0630, 0x0631, 0x0632, 0x0633, 0x0634, 0x0635, 0x0636, 0x0637,
+		0x0638, 0x0639, 0x063a, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+		0x0640, 0x0641, 0x0642, 0x0643, 0x0644, 0x0645, 0x0646, 0x0647,
+		0x0648, 0x0649, 0x064a, 0x064b, 0x064c, 0x064d, 0x064e, 0x064f,
+		0x0650, 0x0651, 0x0652, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+		0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+	},
+	[7] = {
+		0x00a0, 0x2018, 0x2019, 0x00a3, 0x20ac, 0x20af, 0x00a6, 0x00a7,
+		0x00a8, 0x00a9, 0x037a, 0x00ab, 0x00ac, 0x00ad, 0x0000, 0x2015,
+		0x00b0, 0x00b1, 0x00b2, 0x00b3, 0x0384, 0x0385, 0x0386, 0x00b7,
+		0x0388, 0x0389, 0x038a, 0x00bb, 0x038c, 0x00bd, 0x038e, 0x038f,
+		0x0390, 0x0391, 0x0392, 0x0393, 0x0394, 0x0395, 0x0396, 0x0397,
+		0x0398, 0x0399, 0x039a, 0x039b, 0x039c, 0x039d, 0x039e, 0x039f,
+		0x03a0, 0x03a1, 0x0000, 0x03a3, 0x03a4, 0x03a5, 0x03a6, 0x03a7,
+		0x03a8, 0x03a9, 0x03aa, 0x03ab, 0x03ac, 0x03ad, 0x03ae, 0x03af,
+		0x03b0, 0x03b1, 0x03b2, 0x03b3, 0x03b4, 0x03b5, 0x03b6, 0x03b7,
+		0x03b8, 0x03b9, 0x03ba, 0x03bb, 0x03bc, 0x03bd, 0x03be, 0x03bf,
+		0x03c0, 0x03c1, 0x03c2, 0x03c3, 0x03c4, 0x03c5, 0x03c6, 0x03c7,
+		0x03c8, 0x03c9, 0x03ca, 0x03cb, 0x03cc, 0x03cd, 0x03ce, 0x0000,
+	},
+	[8] = {
+		0x00a0, 0x0000, 0x00a2, 0x00a3, 0x00a4, 0x00a5, 0x00a6, 0x00a7,
+		0x00a8, 0x00a9, 0x00d7, 0x00ab, 0x00ac, 0x00ad, 0x00ae, 0x00af,
+		0x00b0, 0x00b1, 0x00b2, 0x00b3, 0x00b4, 0x00b5, 0x00b6, 0x00b7,
+		0x00b8, 0x00b9, 0x00f7, 0x00bb, 0x00bc, 0x00bd, 0x00be, 0x0000,
+		0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+		0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+		0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+		0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x2017,
+		0x05d0, 0x05d1, 0x05d2, 0x05d3, 0x05d4, 0x05d5, 0x05d6, 0x05d7,
+		0x05d8, 0x05d9, 0x05da, 0x05db, 0x05dc, 0x05dd, 0x05de, 0x05df,
+		0x05e0, 0x05e1, 0x05e2, 0x05e3, 0x05e4, 0x05e5, 0x05e6, 0x05e7,
+		0x05e8, 0x05e9, 0x05ea, 0x0000, 0x0000, 0x200e, 0x200f, 0x0000,
+	},
+	[9] = {
+		0x00a0, 0x00a1, 0x00a2, 0x00a3, 0x00a4, 0x00a5, 0x00a6, 0x00a7,
+		0x00a8, 0x00a9, 0x00aa, 0x00ab, 0x00ac, 0x00ad, 0x00ae, 0x00af,
+		0x00b0, 0x00b1, 0x00b2, 0x00b3, 0x00b4, 0x00b5, 0x00b6, 0x00b7,
+		0x00b8, 0x00b9, 0x00ba, 0x00bb, 0x00bc, 0x00bd, 0x00be, 0x00bf,
+		0x00c0, 0x00c1, 0x00c2, 0x00c3, 0x00c4, 0x00c5, 0x00c6, 0x00c7,
+		0x00c8, 0x00c9, 0x00ca, 0x00cb, 0x00cc, 0x00cd, 0x00ce, 0x00cf,
+		0x011e, 0x00d1, 0x00d2, 0x00d3, 0x00d4, 0x00d5, 0x00d6, 0x00d7,
+		0x00d8, 0x00d9, 0x00da, 0x00db, 0x00dc, 0x0130, 0x015e, 0x00df,
+		0x00e0, 0x00e1, 0x00e2, 0x00e3, 0x00e4, 0x00e5, 0x00e6, 0x00e7,
+		0x00e8, 0x00e9, 0x00ea, 0x00eb, 0x00ec, 0x00ed, 0x00ee, 0x00ef,
+		0x011f, 0x00f1, 0x00f2, 0x00f3, 0x00f4, 0x00f5, 0x00f6, 0x00f7,
+		0x00f8, 0x00f9, 0x00fa, 0x00fb, 0x00fc, 0x0131, 0x015f, 0x00ff,
+	},
+	[10] = {
+		0x00a0, 0x0104, 0x0112, 0x0122, 0x012a, 0x0128, 0x0136, 0x00a7,
+		0x013b, 0x0110, 0x0160, 0x0166, 0x017d, 0x00ad, 0x016a, 0x014a,
+		0x00b0, 0x0105, 0x0113, 0x0123, 0x012b, 0x0129, 0x0137, 0x00b7,
+		0x013c, 0x0111, 0x0161, 0x0167, 0x017e, 0x2015, 0x016b, 0x014b,
+		0x0100, 0x00c1, 0x00c2, 0x00c3, 0x00c4, 0x00c5, 0x00c6, 0x012e,
+		0x010c, 0x00c9, 0x0118, 0x00cb, 0x0116, 0x00cd, 0x00ce, 0x00cf,
+		0x00d0, 0x0145, 0x014c, 0x00d3, 0x00d4, 0x00d5, 0x00d6, 0x0168,
+		0x00d8, 0x0172, 0x00da, 0x00db, 0x00dc, 0x00dd, 0x00de, 0x00df,
+		0x0101, 0x00e1, 0x00e2, 0x00e3, 0x00e4, 0x00e5, 0x00e6, 0x012f,
+		0x010d, 0x00e9, 0x0119, 0x00eb, 0x0117, 0x00ed, 0x00ee, 0x00ef,
+		0x00f0, 0x0146, 0x014d, 0x00f3, 0x00f4, 0x00f5, 0x00f6, 0x0169,
+		0x00f8, 0x0173, 0x00fa, 0x00fb, 0x00fc, 0x00fd, 0x00fe, 0x0138,
+	},
+	[11] = {
+		0x00a0, 0x0e01, 0x0e02, 0x0e03, 0x0e04, 0x0e05, 0x0e06, 0x0e07,
+		0x0e08, 0x0e09, 0x0e0a, 0x0e0b, 0x0e0c, 0x0e0d, 0x0e0e, 0x0e0f,
+		0x0e10, 0x0e11, 0x0e12, 0x0e13, 0x0e14, 0x0e15, 0x0e16, 0x0e17,
+		0x0e18, 0x0e19, 0x0e1a, 0x0e1b, 0x0e1c, 0x0e1d, 0x0e1e, 0x0e1f,
+		0x0e20, 0x0e21, 0x0e22, 0x0e23, 0x0e24, 0x0e25, 0x0e26, 0x0e27,
+		0x0e28, 0x0e29, 0x0e2a, 0x0e2b, 0x0e2c, 0x0e2d, 0x0e2e, 0x0e2f,
+		0x0e30, 0x0e31, 0x0e32, 0x0e33, 0x0e34, 0x0e35, 0x0e36, 0x0e37,
+		0x0e38, 0x0e39, 0x0e3a, 0x0000, 0x0000, 0x0000, 0x0000, 0x0e3f,
+		0x0e40, 0x0e41, 0x0e42, 0x0e43, 0x0e44, 0x0e45, 0x0e46, 0x0e47,
+		0x0e48, 0x0e49, 0x0e4a, 0x0e4b, 0x0e4c, 0x0e4d, 0x0e4e, 0x0e4f,
+		0x0e50, 0x0e51, 0x0e52, 0x0e53, 0x0e54, 0x0e55, 0x0e56, 0x0e57,
+		0x0e58, 0x0e59, 0x0e5a, 0x0e5b, 0x0000, 0x0000, 0x0000, 0x0000,
+	},
+	[13] = {
+		0x00a0, 0x201d, 0x00a2, 0x00a3, 0x00a4, 0x201e, 0x00a6, 0x00a7,
+		0x00d8, 0x00a9, 0x0156, 0x00ab, 0x00ac, 0x00ad, 0x00ae, 0x00c6,
+		0x00b0, 0x00b1, 0x00b2, 0x00b3, 0x201c, 0x00b5, 0x00b6, 0x00b7,
+		0x00f8, 0x00b9, 0x0157, 0x00bb, 0x00bc, 0x00bd, 0x00be, 0x00e6,
+		0x0104, 0x012e, 0x0100, 0x0106, 0x00c4, 0x00c5, 0x0118, 0x0112,
+		0x010c, 0x00c9, 0x0179, 0x0116, 0x0122, 0x0136, 0x012a, 0x013b,
+		0x0160, 0x0143, 0x0145, 0x00d3, 0x014c, 0x00d5, 0x00d6, 0x00d7,
+		0x0172, 0x0141, 0x015a, 0x016a, 0x00dc, 0x017b, 0x017d, 0x00df,
+		0x0105, 0x012f, 0x0101, 0x0107, 0x00e4, 0x00e5, 0x0119, 0x0113,
+		0x010d, 0x00e9, 0x017a, 0x0117, 0x0123, 0x0137, 0x012b, 0x013c,
+		0x0161, 0x0144, 0x0146, 0x00f3, 0x014d, 0x00f5, 0x00f6, 0x00f7,
+		0x0173, 0x0142, 0x015b, 0x016b, 0x00fc, 0x017c, 0x017e, 0x2019,
+	},
+	[14] = {
+		0x00a0, 0x1e02, 0x1e03, 0x00a3, 0x010a, 0x010b, 0x1e0a, 0x00a7,
+		0x1e80, 0x00a9, 0x1e82, 0x1e0b, 0x1ef2, 0x00ad, 0x00ae, 0x0178,
+		0x1e1e, 0x1e1f, 0x0120, 0x0121, 0x1e40, 0x1e41, 0x00b6, 0x1e56,
+		0x1e81, 0x1e57, 0x1e83, 0x1e60, 0x1ef3, 0x1e84, 0x1e85, 0x1e61,
+		0x00c0, 0x00c1, 0x00c2, 0x00c3, 0x00c4, 0x00c5, 0x00c6, 0x00c7,
+		0x00c8, 0x00c9, 0x00ca, 0x00cb, 0x00cc, 0x00cd, 0x00ce, 0x00cf,
+		0x0174, 0x00d1, 0x00d2, 0x00d3, 0x00d4, 0x00d5, 0x00d6, 0x1e6a,
+		0x00d8, 0x00d9, 0x00da, 0x00db, 0x00dc, 0x00dd, 0x0176, 0x00df,
+		0x00e0, 0x00e1, 0x00e2, 0x00e3, 0x00e4, 0x00e5, 0x00e6, 0x00e7,
+		0x00e8, 0x00e9, 0x00ea, 0x00eb, 0x00ec, 0x00ed, 0x00ee, 0x00ef,
+		0x0175, 0x00f1, 0x00f2, 0x00f3, 0x00f4, 0x00f5, 0x00f6, 0x1e6b,
+		0x00f8, 0x00f9, 0x00fa, 0x00fb, 0x00fc, 0x00fd, 0x0177, 0x00ff,
+	},
+	[15] = {
+		0x00a0, 0x00a1, 0x00a2, 0x00a3, 0x20ac, 0x00a5, 0x0160, 0x00a7,
+		0x0161, 0x00a9, 0x00aa, 0x00ab, 0x00ac, 0x00ad, 0x00ae, 0x00af,
+		0x00b0, 0x00b1, 0x00b2, 0x00b3, 0x017d, 0x00b5, 0x00b6, 0x00b7,
+		0x017e, 0x00b9, 0x00ba, 0x00bb, 0x0152, 0x0153, 0x0178, 0x00bf,
+		0x00c0, 0x00c1, 0x00c2, 0x00c3, 0x00c4, 0x00c5, 0x00c6, 0x00c7,
+		0x00c8, 0x00c9, 0x00ca, 0x00cb, 0x00cc, 0x00cd, 0x00ce, 0x00cf,
+		0x00d0, 0x00d1, 0x00d2, 0x00d3, 0x00d4, 0x00d5, 0x00d6, 0x00d7,
+		0x00d8, 0x00d9, 0x00da, 0x00db, 0x00dc, 0x00dd, 0x00de, 0x00df,
+		0x00e0, 0x00e1, 0x00e2, 0x00e3, 0x00e4, 0x00e5, 0x00e6, 0x00e7,
+		0x00e8, 0x00e9, 0x00ea, 0x00eb, 0x00ec, 0x00ed, 0x00ee, 0x00ef,
+		0x00f0, 0x00f1, 0x00f2, 0x00f3, 0x00f4, 0x00f5, 0x00f6, 0x00f7,
+		0x00f8, 0x00f9, 0x00fa, 0x00fb, 0x00fc, 0x00fd, 0x00fe, 0x00ff,
+	},
+};
+
+/* the non-spacing diacritical marks 0xc1-0xcf of figure A.1 */
+static const uint16_t latin_00_marks[15] = {
+	0x0300, 0x0301, 0x0302, 0x0303, 0x0304, 0x0306, 0x0307, 0x0308,
+	0x0308, 0x030a, 0x0327, 0x0000, 0x030b, 0x0328, 0x030c,
+};
+
+/* precomposed forms of A-Z, a-z with each of those marks, or 0 */
+static const uint16_t latin_00_composed[15][52] = {
+	{
+		0x00c0, 0x0000, 0x0000, 0x0000, 0x00c8, 0x0000, 0x0000, 0x0000,
+		0x00cc, 0x0000, 0x0000, 0x0000, 0x0000, 0x01f8, 0x00d2, 0x0000,
+		0x0000, 0x0000, 0x0000, 0x0000, 0x00d9, 0x0000, 0x1e80, 0x0000,
+		0x1ef2, 0x0000, 0x00e0, 0x0000, 0x0000, 0x0000, 0x00e8, 0x0000,
+		0x0000, 0x0000, 0x00ec, 0x0000, 0x0000, 0x0000, 0x0000, 0x01f9,
+		0x00f2, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x00f9, 0x0000,
+		0x1e81, 0x0000, 0x1ef3, 0x0000,
+	},
+	{
+		0x00c1, 0x0000, 0x0106, 0x0000, 0x00c9, 0x0000, 0x01f4, 0x0000,
+		0x00cd, 0x0000, 0x1e30, 0x0139, 0x1e3e, 0x0143, 0x00d3, 0x1e54,
+		0x0000, 0x0154, 0x015a, 0x0000, 0x00da, 0x0000, 0x1e82, 0x0000,
+		0x00dd, 0x0179, 0x00e1, 0x0000, 0x0107, 0x0000, 0x00e9, 0x0000,
+		0x01f5, 0x0000, 0x00ed, 0x0000, 0x1e31, 0x013a, 0x1e3f, 0x0144,
+		0x00f3, 0x1e55, 0x0000, 0x0155, 0x015b, 0x0000, 0x00fa, 0x0000,
+		0x1e83, 0x0000, 0x00fd, 0x017a,
+	},
+	{
+		0x00c2, 0x0000, 0x0108, 0x0000, 0x00ca, 0x0000, 0x011c, 0x0124,
+		0x00ce, 0x0134, 0x0000, 0x0000, 0x0000, 0x0000, 0x00d4, 0x0000,
+		0x0000, 0x0000, 0x015c, 0x0000, 0x00db, 0x0000, 0x0174, 0x0000,
+		0x0176, 0x1e90, 0x00e2, 0x0000, 0x0109, 0x0000, 0x00ea, 0x0000,
+		0x011d, 0x0125, 0x00ee, 0x0135, 0x0000, 0x0000, 0x0000, 0x0000,
+		0x00f4, 0x0000, 0x0000, 0x0000, 0x015d, 0x0000, 0x00fb, 0x0000,
+		0x0175, 0x0000, 0x0177, 0x1e91,
+	},
+	{
+		0x00c3, 0x0000, 0x0000, 0x0000, 0x1ebc, 0x0000, 0x0000, 0x0000,
+		0x0128, 0x0000, 0x0000, 0x0000, 0x0000, 0x00d1, 0x00d5, 0x0000,
+		0x0000, 0x0000, 0x0000, 0x0000, 0x0168, 0x1e7c, 0x0000, 0x0000,
+		0x1ef8, 0x0000, 0x00e3, 0x0000, 0x0000, 0x0000, 0x1ebd, 0x0000,
+		0x0000, 0x0000, 0x0129, 0x0000, 0x0000, 0x0000, 0x0000, 0x00f1,
+		0x00f5, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0169, 0x1e7d,
+		0x0000, 0x0000, 0x1ef9, 0x0000,
+	},
+	{
+		0x0100, 0x0000, 0x0000, 0x0000, 0x0112, 0x0000, 0x1e20, 0x0000,
+		0x012a, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x014c, 0x0000,
+		0x0000, 0x0000, 0x0000, 0x0000, 0x016a, 0x0000, 0x0000, 0x0000,
+		0x0232, 0x0000, 0x0101, 0x0000, 0x0000, 0x0000, 0x0113, 0x0000,
+		0x1e21, 0x0000, 0x012b, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+		0x014d, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x016b, 0x0000,
+		0x0000, 0x0000, 0x0233, 0x0000,
+	},
+	{
+		0x0102, 0x0000, 0x0000, 0x0000, 0x0114, 0x0000, 0x011e, 0x0000,
+		0x012c, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x014e, 0x0000,
+		0x0000, 0x0000, 0x0000, 0x0000, 0x016c, 0x0000, 0x0000, 0x0000,
+		0x0000, 0x0000, 0x0103, 0x0000, 0x0000, 0x0000, 0x0115, 0x0000,
+		0x011f, 0x0000, 0x012d, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+		0x014f, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x016d, 0x0000,
+		0x0000, 0x0000, 0x0000, 0x0000,
+	},
+	{
+		0x0226, 0x1e02, 0x010a, 0x1e0a, 0x0116, 0x1e1e, 0x0120, 0x1e22,
+		0x0130, 0x0000, 0x0000, 0x0000, 0x1e40, 0x1e44, 0x022e, 0x1e56,
+		0x0000, 0x1e58, 0x1e60, 0x1e6a, 0x0000, 0x0000, 0x1e86, 0x1e8a,
+		0x1e8e, 0x017b, 0x0227, 0x1e03, 0x010b, 0x1e0b, 0x0117, 0x1e1f,
+		0x0121, 0x1e23, 0x0000, 0x0000, 0x0000, 0x0000, 0x1e41, 0x1e45,
+		0x022f, 0x1e57, 0x0000, 0x1e59, 0x1e61, 0x1e6b, 0x0000, 0x0000,
+		0x1e87, 0x1e8b, 0x1e8f, 0x017c,
+	},
+	{
+		0x00c4, 0x0000, 0x0000, 0x0000, 0x00cb, 0x0000, 0x0000, 0x1e26,
+		0x00cf, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x00d6, 0x0000,
+		0x0000, 0x0000, 0x0000, 0x0000, 0x00dc, 0x0000, 0x1e84, 0x1e8c,
+		0x0178, 0x0000, 0x00e4, 0x0000, 0x0000, 0x0000, 0x00eb, 0x0000,
+		0x0000, 0x1e27, 0x00ef, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+		0x00f6, 0x0000, 0x0000, 0x0000, 0x0000, 0x1e97, 0x00fc, 0x0000,
+		0x1e85, 0x1e8d, 0x00ff, 0x0000,
+	},
+	{
+		0x00c4, 0x0000, 0x0000, 0x0000, 0x00cb, 0x0000, 0x0000, 0x1e26,
+		0x00cf, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x00d6, 0x0000,
+		0x0000, 0x0000, 0x0000, 0x0000, 0x00dc, 0x0000, 0x1e84, 0x1e8c,
+		0x0178, 0x0000, 0x00e4, 0x0000, 0x0000, 0x0000, 0x00eb, 0x0000,
+		0x0000, 0x1e27, 0x00ef, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+		0x00f6, 0x0000, 0x0000, 0x0000, 0x0000, 0x1e97, 0x00fc, 0x0000,
+		0x1e85, 0x1e8d, 0x00ff, 0x0000,
+	},
+	{
+		0x00c5, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+		0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+		0x0000, 0x0000, 0x0000, 0x0000, 0x016e, 0x0000, 0x0000, 0x0000,
+		0x0000, 0x0000, 0x00e5, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+		0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+		0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x016f, 0x0000,
+		0x1e98, 0x0000, 0x1e99, 0x0000,
+	},
+	{
+		0x0000, 0x0000, 0x00c7, 0x1e10, 0x0228, 0x0000, 0x0122, 0x1e28,
+		0x0000, 0x0000, 0x0136, 0x013b, 0x0000, 0x0145, 0x0000, 0x0000,
+		0x0000, 0x0156, 0x015e, 0x0162, 0x0000, 0x0000, 0x0000, 0x0000,
+		0x0000, 0x0000, 0x0000, 0x0000, 0x00e7, 0x1e11, 0x0229, 0x0000,
+		0x0123, 0x1e29, 0x0000, 0x0000, 0x0137, 0x013c, 0x0000, 0x0146,
+		0x0000, 0x0000, 0x0000, 0x0157, 0x015f, 0x0163, 0x0000, 0x0000,
+		0x0000, 0x0000, 0x0000, 0x0000,
+	},
+	{
+		0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+		0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+		0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+		0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+		0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+		0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+		0x0000, 0x0000, 0x0000, 0x0000,
+	},
+	{
+		0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+		0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0150, 0x0000,
+		0x0000, 0x0000, 0x0000, 0x0000, 0x0170, 0x0000, 0x0000, 0x0000,
+		0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+		0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+		0x0151, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0171, 0x0000,
+		0x0000, 0x0000, 0x0000, 0x0000,
+	},
+	{
+		0x0104, 0x0000, 0x0000, 0x0000, 0x0118, 0x0000, 0x0000, 0x0000,
+		0x012e, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x01ea, 0x0000,
+		0x0000, 0x0000, 0x0000, 0x0000, 0x0172, 0x0000, 0x0000, 0x0000,
+		0x0000, 0x0000, 0x0105, 0x0000, 0x0000, 0x0000, 0x0119, 0x0000,
+		0x0000, 0x0000, 0x012f, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+		0x01eb, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0173, 0x0000,
+		0x0000, 0x0000, 0x0000, 0x0000,
+	},
+	{
+		0x01cd, 0x0000, 0x010c, 0x010e, 0x011a, 0x0000, 0x01e6, 0x021e,
+		0x01cf, 0x0000, 0x01e8, 0x013d, 0x0000, 0x0147, 0x01d1, 0x0000,
+		0x0000, 0x0158, 0x0160, 0x0164, 0x01d3, 0x0000, 0x0000, 0x0000,
+		0x0000, 0x017d, 0x01ce, 0x0000, 0x010d, 0x010f, 0x011b, 0x0000,
+		0x01e7, 0x021f, 0x01d0, 0x01f0, 0x01e9, 0x013e, 0x0000, 0x0148,
+		0x01d2, 0x0000, 0x0000, 0x0159, 0x0161, 0x0165, 0x01d4, 0x0000,
+		0x0000, 0x0000, 0x0000, 0x017e,
+	},
+};
+
+static int dvb_text_charset_parse(const char *name, enum dvb_text_encoding *encoding,
+				  int *table);
+static iconv_t dvb_text_iconv(struct dvb_text_conv *tc, enum dvb_text_iconv which);
+static int dvb_text_iconv_decode(struct dvb_text_conv *tc, enum dvb_text_iconv which,
+				 const char *src, size_t srclen, char *dest, size_t destlen);
+static void dvb_text_decode_8bit(struct dvb_text_conv *tc, struct utf8_out *out,
+				 const uint16_t *table, int latin_00,
+				 const uint8_t *src, size_t srclen);
+static void dvb_text_decode_ucs2(struct dvb_text_conv *tc, struct utf8_out *out,
+				 const uint8_t *src, size_t srclen);
+static void dvb_text_decode_utf8(struct dvb_text_conv *tc, struct utf8_out *out,
+				 const uint8_t *src, size_t srclen);
+
+static inline void utf8_put(struct utf8_out *out, uint32_t c)
+{
+	char *p = out->buf + out->pos;
+	size_t need = (c < 0x80) ? 1 : (c < 0x800) ? 2 : (c < 0x10000) ? 3 : 4;
+
+	if (out->truncated || ((out->pos + need) > out->len)) {
+		out->truncated = 1;
+		return;
+	}
+
+	switch(need) {
+	case 1:
+		p[0] = c;
+		break;
+	case 2:
+		p[0] = 0xc0 | (c >> 6);
+		p[1] = 0x80 | (c & 0x3f);
+		break;
+	case 3:
+		p[0] = 0xe0 | (c >> 12);
+		p[1] = 0x80 | ((c >> 6) & 0x3f);
+		p[2] = 0x80 | (c & 0x3f);
+		break;
+	case 4:
+		p[0] = 0xf0 | (c >> 18);
+		p[1] = 0x80 | ((c >> 12) & 0x3f);
+		p[2] = 0x80 | ((c >> 6) & 0x3f);
+		p[3] = 0x80 | (c & 0x3f);
+		break;
+	}
+	out->pos += need;
+}
+
+/* the control codes of tables A.1 (0x80-0x9f) and A.2 (0xe080-0xe09f) */
+static inline void utf8_put_control(struct dvb_text_conv *tc, struct utf8_out *out,
+				    uint8_t code)
+{
+	switch(code) {
+	case 0x86:
+		if ((tc->flags & DVB_TEXT_CONV_EMPHASIS) && !out->emphasis) {
+			utf8_put(out, '*');
+			out->emphasis = 1;
+		}
+		break;
+
+	case 0x87:
+		if (out->emphasis) {
+			utf8_put(out, '*');
+			out->emphasis = 0;
+		}
+		break;
+
+	case 0x8a:
+		utf8_put(out, (tc->flags & DVB_TEXT_CONV_NEWLINE) ? '\n' : ' ');
+		break;
+	}
+}
+
+struct dvb_text_conv *dvb_text_conv_create(const char *output_charset,
+					   const char *default_charset,
+					   int flags)
+{
+	struct dvb_text_conv *tc;
+	enum dvb_text_encoding encoding;
+	int i;
+
+	tc = (struct dvb_text_conv *) malloc(sizeof(struct dvb_text_conv));
+	if (tc == NULL)
+		return NULL;
+	memset(tc, 0, sizeof(struct dvb_text_conv));
+	tc->flags = flags;
+	for(i=0; i < ICONV_COUNT; i++)
+		tc->cds[i] = (iconv_t) -1;
+
+	tc->utf8_output = 1;
+	if (output_charset != NULL) {
+		if ((tc->output_charset = strdup(output_charset)) == NULL)
+			goto error;
+		if ((dvb_text_charset_parse(output_charset, &encoding, NULL) < 0) ||
+		    (encoding != ENCODING_UTF8))
+			tc->utf8_output = 0;
+	}
+
+	tc->default_encoding = ENCODING_LATIN_00;
+	if (default_charset != NULL) {
+		if (dvb_text_charset_parse(default_charset, &tc->default_encoding,
+					   &tc->default_table) < 0) {
+			tc->default_encoding = ENCODING_ICONV;
+			if ((tc->default_charset = strdup(default_charset)) == NULL)
+				goto error;
+		}
+	}
+
+	return tc;
+
+error:
+	dvb_text_conv_destroy(tc);
+	return NULL;
+}
+
+void dvb_text_conv_destroy(struct dvb_text_conv *tc)
+{
+	int i;
+
+	for(i=0; i < ICONV_COUNT; i++) {
+		if (tc->cds[i] != (iconv_t) -1)
+			iconv_close(tc->cds[i]);
+	}
+	free(tc->output_charset);
+	free(tc->default_charset);
+	free(tc->scratch);
+	free(tc);
+}
+
+int dvb_text_conv_decode(struct dvb_text_conv *tc,
+			 const uint8_t *src, size_t srclen,
+			 char *dest, size_t destlen)
+{
+	enum dvb_text_encoding encoding = tc->default_encoding;
+	enum dvb_text_iconv which = ICONV_DEFAULT;
+	int table = tc->default_table;
+	struct utf8_out out;
+	size_t used = 0;
+
+	if (destlen == 0)
+		return -E2BIG;
+	dest[0] = 0;
+	if (srclen == 0)
+		return 0;
+
+	// the character set selection (table A.3)
+	if (src[0] < 0x20) {
+		used = 1;
+		switch(src[0]) {
+		case 0x01:
+		case 0x02:
+		case 0x03:
+		case 0x04:
+		case 0x05:
+		case 0x06:
+		case 0x07:
+		case 0x09:
+		case 0x0a:
+		case 0x0b:
+			encoding = ENCODING_ISO8859;
+			table = iso8859_selection[src[0]];
+			break;
+
+		case 0x10:
+			used = (srclen < 3) ? srclen : 3;
+			if (used < 3)
+				break;
+			table = (src[1] << 8) | src[2];
+			if ((table >= 1) && (table <= 15) && (table != 12))
+				encoding = ENCODING_ISO8859;
+			else
+				table = tc->default_table;
+			break;
+
+		case 0x11:
+			encoding = ENCODING_UCS2;
+			break;
+		case 0x12:
+			encoding = ENCODING_ICONV;
+			which = ICONV_KSX1001;
+			break;
+		case 0x13:
+			encoding = ENCODING_ICONV;
+			which = ICONV_GB2312;
+			break;
+		case 0x14:
+			encoding = ENCODING_ICONV;
+			which = ICONV_BIG5;
+			break;
+		case 0x15:
+			encoding = ENCODING_UTF8;
+			break;
+
+		case 0x1f:
+			// encoding_type_id: not supported, so use the default
+			used = (srclen < 2) ? srclen : 2;
+			break;
+		}
+		src += used;
+		srclen -= used;
+	}
+
+	if (encoding == ENCODING_ICONV)
+		return dvb_text_iconv_decode(tc, which, (const char *) src, srclen, dest, destlen);
+
+	// decode to UTF-8, directly into dest if that's what is wanted
+	if (tc->utf8_output) {
+		out.buf = dest;
+		out.len = destlen - 1;
+	} else {
+		if (tc->scratch_len < DVB_TEXT_UTF8_MAX(srclen)) {
+			char *tmp = (char *) realloc(tc->scratch, DVB_TEXT_UTF8_MAX(srclen));
+			if (tmp == NULL)
+				return -ENOMEM;
+			tc->scratch = tmp;
+			tc->scratch_len = DVB_TEXT_UTF8_MAX(srclen);
+		}
+		out.buf = tc->scratch;
+		out.len = tc->scratch_len - 1;
+	}
+	out.pos = 0;
+	out.truncated = 0;
+	out.emphasis = 0;
+
+	switch(encoding) {
+	case ENCODING_LATIN_00:
+		dvb_text_decode_8bit(tc, &out, latin_00_table, 1, src, srclen);
+		break;
+	case ENCODING_ISO8859:
+		dvb_text_decode_8bit(tc, &out, iso8859_tables[table], 0, src, srclen);
+		break;
+	case ENCODING_UCS2:
+		dvb_text_decode_ucs2(tc, &out, src, srclen);
+		break;
+	case ENCODING_UTF8:
+		dvb_text_decode_utf8(tc, &out, src, srclen);
+		break;
+	case ENCODING_ICONV:
+		break;
+	}
+	if (out.emphasis)
+		utf8_put(&out, '*');
+	out.buf[out.pos] = 0;
+
+	if (!tc->utf8_output)
+		return dvb_text_iconv_decode(tc, ICONV_UTF8, out.buf, out.pos, dest, destlen);
+	if (out.truncated)
+		return -E2BIG;
+	return out.pos;
+}
+
+/*
+ * Identify the character sets with a direct conversion from their iconv
+ * name, ignoring case, '-' and '_', and any "//" options.
+ */
+static int dvb_text_charset_parse(const char *name, enum dvb_text_encoding *encoding,
+				  int *table)
+{
+	char tmp[16];
+	size_t len = 0;
+	int n;
+
+	for(; *name && strncmp(name, "//", 2); name++) {
+		if ((*name == '-') || (*name == '_'))
+			continue;
+		if (len == (sizeof(tmp) - 1))
+			return -1;
+		tmp[len++] = (*name >= 'a' && *name <= 'z') ? (*name - 'a' + 'A') : *name;
+	}
+	tmp[len] = 0;
+
+	if (!strcmp(tmp, "UTF8")) {
+		*encoding = ENCODING_UTF8;
+		return 0;
+	}
+	if (!strcmp(tmp, "ISO6937")) {
+		*encoding = ENCODING_LATIN_00;
+		return 0;
+	}
+	if (!strncmp(tmp, "ISO8859", 7)) {
+		n = atoi(tmp + 7);
+		if ((n < 1) || (n > 15) || (n == 12))
+			return -1;
+		*encoding = ENCODING_ISO8859;
+		if (table)
+			*table = n;
+		return 0;
+	}
+
+	return -1;
+}
+
+static iconv_t dvb_text_iconv(struct dvb_text_conv *tc, enum dvb_text_iconv which)
+{
+	const char *from = iconv_names[which];
+
+	if ((tc->cds[which] != (iconv_t) -1) || tc->failed[which])
+		return tc->cds[which];
+
+	if (which == ICONV_DEFAULT)
+		from = tc->default_charset;
+	tc->cds[which] = iconv_open(tc->output_charset ? tc->output_charset : "UTF-8", from);
+	if (tc->cds[which] == (iconv_t) -1)
+		tc->failed[which] = 1;
+
+	return tc->cds[which];
+}
+
+static int dvb_text_iconv_decode(struct dvb_text_conv *tc, enum dvb_text_iconv which,
+				 const char *src, size_t srclen, char *dest, size_t destlen)
+{
+	iconv_t cd;
+	char *in = (char *) src;
+	char *out = dest;
+	size_t outleft = destlen - 1;
+	int ret = 0;
+
+	if ((cd = dvb_text_iconv(tc, which)) == (iconv_t) -1)
+		return -EINVAL;
+
+	iconv(cd, NULL, NULL, NULL, NULL);
+	while(srclen) {
+		if (iconv(cd, &in, &srclen, &out, &outleft) != (size_t) -1)
+			break;
+
+		if (errno == E2BIG) {
+			ret = -E2BIG;
+			break;
+		}
+		if (errno != EILSEQ)
+			break;
+
+		// skip invalid input
+		in++;
+		srclen--;
+	}
+	if (ret == 0)
+		iconv(cd, NULL, NULL, &out, &outleft);
+	*out = 0;
+
+	return ret ? ret : (int) (out - dest);
+}
+
+static void dvb_text_decode_8bit(struct dvb_text_conv *tc, struct utf8_out *out,
+				 const uint16_t *table, int latin_00,
+				 const uint8_t *src, size_t srclen)
+{
+	size_t i;
+	uint8_t c;
+	uint8_t base;
+	uint16_t mark;
+	uint16_t composed;
+
+	for(i=0; i < srclen; i++) {
+		c = src[i];
+
+		if (c < 0x20)
+			continue;
+		if (c < 0x80) {
+			utf8_put(out, c);
+			continue;
+		}
+		if (c < 0xa0) {
+			utf8_put_control(tc, out, c);
+			continue;
+		}
+
+		// the non-spacing diacritical marks precede the letter
+		if (latin_00 && (c >= 0xc1) && (c <= 0xcf)) {
+			if ((i + 1) == srclen)
+				break;
+			base = src[i+1];
+			if ((base < 0x20) || (base > 0x7e))
+				continue;
+			i++;
+
+			mark = latin_00_marks[c - 0xc1];
+			composed = 0;
+			if ((base >= 'A') && (base <= 'Z'))
+				composed = latin_00_composed[c - 0xc1][base - 'A'];
+			else if ((base >= 'a') && (base <= 'z'))
+				composed = latin_00_composed[c - 0xc1][base - 'a' + 26];
+
+			if (composed) {
+				utf8_put(out, composed);
+			} else {
+				utf8_put(out, base);
+				if (mark)
+					utf8_put(out, mark);
+			}
+			continue;
+		}
+
+		if (table[c - 0xa0])
+			utf8_put(out, table[c - 0xa0]);
+	}
+}
+
+static void dvb_text_decode_ucs2(struct dvb_text_conv *tc, struct utf8_out *out,
+				 const uint8_t *src, size_t srclen)
+{
+	size_t i;
+	uint32_t c;
+	uint32_t low;
+
+	for(i=0; (i + 1) < srclen; i += 2) {
+		c = (src[i] << 8) | src[i+1];
+
+		if (c < 0x20)
+			continue;
+		if ((c >= 0xe080) && (c <= 0xe09f)) {
+			utf8_put_control(tc, out, c & 0xff);
+			continue;
+		}
+
+		// strictly UCS-2 has none, but accept surrogate pairs
+		if ((c >= 0xd800) && (c <= 0xdfff)) {
+			if ((c >= 0xdc00) || ((i + 3) >= srclen))
+				continue;
+			low = (src[i+2] << 8) | src[i+3];
+			if ((low < 0xdc00) || (low > 0xdfff))
+				continue;
+			c = 0x10000 + ((c - 0xd800) << 10) + (low - 0xdc00);
+			i += 2;
+		}
+
+		utf8_put(out, c);
+	}
+}
+
+static void dvb_text_decode_utf8(struct dvb_text_conv *tc, struct utf8_out *out,
+				 const uint8_t *src, size_t srclen)
+{
+	size_t i;
+	size_t len;
+	size_t k;
+	uint32_t c;
+
+	for(i=0; i < srclen; i += len) {
+		c = src[i];
+		len = 1;
+
+		if (c < 0x20)
+			continue;
+		if (c < 0x80) {
+			utf8_put(out, c);
+			continue;
+		}
+
+		// the length of the sequence from its lead byte
+		if ((c >= 0xc2) && (c <= 0xdf)) {
+			len = 2;
+			c &= 0x1f;
+		} else if ((c >= 0xe0) && (c <= 0xef)) {
+			len = 3;
+			c &= 0x0f;
+		} else if ((c >= 0xf0) && (c <= 0xf4)) {
+			len = 4;
+			c &= 0x07;
+		} else {
+			// a stray continuation byte, or a lead byte which can't be valid
+			utf8_put(out, UTF8_REPLACEMENT);
+			continue;
+		}
+
+		// replace a truncated sequence, up to the byte which ended it
+		for(k=1; (k < len) && ((i + k) < srclen) && ((src[i+k] & 0xc0) == 0x80); k++)
+			c = (c << 6) | (src[i+k] & 0x3f);
+		if (k < len) {
+			utf8_put(out, UTF8_REPLACEMENT);
+			len = k;
+			continue;
+		}
+
+		// and overlong forms, surrogates, and anything beyond U+10FFFF
+		if (((len == 3) && (c < 0x800)) || ((len == 4) && (c < 0x10000)) ||
+		    ((c >= 0xd800) && (c <= 0xdfff)) || (c > 0x10ffff)) {
+			utf8_put(out, UTF8_REPLACEMENT);
+			continue;
+		}
+
+		// U+E080 to U+E09F are the control codes
+		if ((c >= 0xe080) && (c <= 0xe09f)) {
+			utf8_put_control(tc, out, c & 0xff);
+			continue;
+		}
+
+		utf8_put(out, c);
+	}
+}
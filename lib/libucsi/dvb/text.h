@@ -0,0 +1,107 @@
+/**
+ * DVB text string to UTF-8 conversion.
+ *
+ * Copyright (c) 2026 by agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef _UCSI_DVB_TEXT_H
+#define _UCSI_DVB_TEXT_H 1
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * Size of a destination buffer which is always big enough to hold the UTF-8
+ * conversion of a DVB string of len bytes, including the terminating nul.
+ */
+#define DVB_TEXT_UTF8_MAX(len) (((len) * 3) + 1)
+
+/**
+ * Flags for dvb_text_conv_create().
+ */
+enum dvb_text_conv_flags {
+	DVB_TEXT_CONV_EMPHASIS		= 0x01, /* mark emphasised text as *text* */
+	DVB_TEXT_CONV_NEWLINE		= 0x02, /* CR/LF control code to '\n' rather than ' ' */
+};
+
+/**
+ * Opaque type representing a DVB text converter.
+ *
+ * This converts DVB strings (EN 300 468 annex A) from the character set
+ * selected by their first bytes into an output character set. ISO/IEC 6937
+ * (figure A.1) and ISO/IEC 8859-1 to 15 text, UCS-2 and UTF-8 are converted
+ * directly to UTF-8. The other character sets, and output character sets
+ * other than UTF-8, go through iconv. The iconv descriptors are opened on
+ * first use and kept for the life of the converter.
+ *
+ * The control codes of tables A.1 and A.2 are removed, or replaced according
+ * to the flags. Malformed sequences in UTF-8 strings are replaced with U+FFFD,
+ * so the output is always valid. A converter must only be used by one thread
+ * at a time.
+ */
+struct dvb_text_conv;
+
+/**
+ * Create a new dvb_text_conv.
+ *
+ * @param output_charset iconv name of the character set to produce, or NULL
+ * for UTF-8. iconv suffixes such as "//TRANSLIT" may be used.
+ * @param default_charset iconv name of the character set to assume for
+ * strings which do not select one, or NULL for the standard figure A.1
+ * (ISO/IEC 6937) table.
+ * @param flags Combination of enum dvb_text_conv_flags.
+ * @return The new instance, or NULL on error.
+ */
+extern struct dvb_text_conv *dvb_text_conv_create(const char *output_charset,
+						  const char *default_charset,
+						  int flags);
+
+/**
+ * Destroy a dvb_text_conv, closing its iconv descriptors.
+ *
+ * @param tc The instance to destroy.
+ */
+extern void dvb_text_conv_destroy(struct dvb_text_conv *tc);
+
+/**
+ * Convert a DVB string (e.g. a service name or event text) into a caller
+ * provided buffer. The result is always nul terminated.
+ *
+ * @param tc The dvb_text_conv.
+ * @param src The DVB string, including any character set selection bytes.
+ * @param srclen Length of the DVB string.
+ * @param dest Where to put the converted string.
+ * @param destlen Size of dest. For UTF-8 output, DVB_TEXT_UTF8_MAX(srclen)
+ * is always enough.
+ * @return Length of the converted string excluding the nul, -E2BIG if dest
+ * was too small (it then contains as many whole characters as fit), or
+ * -EINVAL if iconv does not support the character sets concerned.
+ */
+extern int dvb_text_conv_decode(struct dvb_text_conv *tc,
+				const uint8_t *src, size_t srclen,
+				char *dest, size_t destlen);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
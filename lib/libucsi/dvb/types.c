@@ -21,11 +21,19 @@
 #include <string.h>
 #include "types.h"
 
+/* MJD of the unix epoch, 1970-01-01 */
+#define MJD_UNIX_EPOCH 40587
+
+#define SECONDS_PER_DAY (24 * 60 * 60)
+
+/*
+ * The MJD counts days in UTC, and unix time counts seconds in UTC ignoring
+ * leap seconds, so the conversion is exact with integers and involves no
+ * calendar (or timezone) at all.
+ */
 time_t dvbdate_to_unixtime(dvbdate_t dvbdate)
 {
-	int k = 0;
-	struct tm tm;
-	double mjd;
+	int mjd;
 
 	/* check for the undefined value */
 	if ((dvbdate[0] == 0xff) &&
@@ -36,26 +44,29 @@ time_t dvbdate_to_unixtime(dvbdate_t dvbdate)
 		return -1;
 	}
 
-	memset(&tm, 0, sizeof(tm));
 	mjd = (dvbdate[0] << 8) | dvbdate[1];
 
-	tm.tm_year = (int) ((mjd - 15078.2) / 365.25);
-	tm.tm_mon = (int) (((mjd - 14956.1) - (int) (tm.tm_year * 365.25)) / 30.6001);
-	tm.tm_mday = (int) mjd - 14956 - (int) (tm.tm_year * 365.25) - (int) (tm.tm_mon * 30.6001);
-	if ((tm.tm_mon == 14) || (tm.tm_mon == 15)) k = 1;
-	tm.tm_year += k;
-	tm.tm_mon = tm.tm_mon - 2 - k * 12;
-	tm.tm_sec = bcd_to_integer(dvbdate[4]);
-	tm.tm_min = bcd_to_integer(dvbdate[3]);
-	tm.tm_hour = bcd_to_integer(dvbdate[2]);
-
-	return mktime(&tm);
+	return ((time_t) (mjd - MJD_UNIX_EPOCH) * SECONDS_PER_DAY) +
+		(bcd_to_integer(dvbdate[2]) * 60 * 60) +
+		(bcd_to_integer(dvbdate[3]) * 60) +
+		bcd_to_integer(dvbdate[4]);
+}
+
+void dvbdate_to_unixtime_batch(const uint8_t *dvbdates, size_t stride, int count,
+			       time_t *unixtimes)
+{
+	int i;
+
+	for(i=0; i < count; i++) {
+		unixtimes[i] = dvbdate_to_unixtime((uint8_t *) dvbdates);
+		dvbdates += stride;
+	}
 }
 
 void unixtime_to_dvbdate(time_t unixtime, dvbdate_t dvbdate)
 {
-	struct tm tm;
-	double l = 0;
+	time_t days;
+	int secs;
 	int mjd;
 
 	/* the undefined value */
@@ -64,16 +75,19 @@ void unixtime_to_dvbdate(time_t unixtime, dvbdate_t dvbdate)
 		return;
 	}
 
-	gmtime_r(&unixtime, &tm);
-	tm.tm_mon++;
-	if ((tm.tm_mon == 1) || (tm.tm_mon == 2)) l = 1;
-	mjd = 14956 + tm.tm_mday + (int) ((tm.tm_year - l) * 365.25) + (int) ((tm.tm_mon + 1 + l * 12) * 30.6001);
+	days = unixtime / SECONDS_PER_DAY;
+	secs = unixtime % SECONDS_PER_DAY;
+	if (secs < 0) {
+		days--;
+		secs += SECONDS_PER_DAY;
+	}
+	mjd = days + MJD_UNIX_EPOCH;
 
 	dvbdate[0] = (mjd & 0xff00) >> 8;
 	dvbdate[1] = mjd & 0xff;
-	dvbdate[2] = integer_to_bcd(tm.tm_hour);
-	dvbdate[3] = integer_to_bcd(tm.tm_min);
-	dvbdate[4] = integer_to_bcd(tm.tm_sec);
+	dvbdate[2] = integer_to_bcd(secs / (60 * 60));
+	dvbdate[3] = integer_to_bcd((secs / 60) % 60);
+	dvbdate[4] = integer_to_bcd(secs % 60);
 }
 
 int dvbduration_to_seconds(dvbduration_t dvbduration)
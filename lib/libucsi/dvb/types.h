@@ -27,6 +27,7 @@ extern "C"
 #endif
 
 #include <stdint.h>
+#include <stddef.h>
 #include <time.h>
 
 typedef uint8_t dvbdate_t[5];
@@ -47,11 +48,27 @@ enum {
  * Convert from a 5 byte DVB UTC date to unix time.
  * Note: this functions expects the DVB date in network byte order.
  *
+ * This is pure integer arithmetic: it makes no libc time calls, and the
+ * result does not depend on the local timezone.
+ *
  * @param d Pointer to DVB date.
  * @return The unix timestamp, or -1 if the dvbdate was set to the 'undefined' value
  */
 extern time_t dvbdate_to_unixtime(dvbdate_t dvbdate);
 
+/**
+ * Convert an array of 5 byte DVB UTC dates to unix time, e.g. the start
+ * times of a batch of EIT events copied into an array of structures.
+ *
+ * @param dvbdates Pointer to the first DVB date.
+ * @param stride Distance in bytes between successive DVB dates (5 for a
+ * plain array of dvbdate_t).
+ * @param count Number of dates to convert.
+ * @param unixtimes Where to put the unix timestamps (-1 for 'undefined' dates).
+ */
+extern void dvbdate_to_unixtime_batch(const uint8_t *dvbdates, size_t stride, int count,
+				      time_t *unixtimes);
+
 /**
  * Convert from a unix timestemp to a 5 byte DVB UTC date.
  * Note: this function will always output the DVB date in
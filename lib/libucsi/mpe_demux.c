@@ -0,0 +1,485 @@
+/**
+ * MPE datagram section demultiplexer.
+ *
+ * Copyright (c) 2026 by agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <libucsi/crc32.h>
+#include <libucsi/section_buf.h>
+#include <libucsi/section_demux.h>
+#include <libucsi/mpeg/section.h>
+#include <libucsi/dvb/section.h>
+#include <libucsi/dvb/mpe_fec.h>
+#include "mpe_demux.h"
+
+#define MPE_HDR_SIZE 12
+#define MPE_LLC_SNAP_SIZE 8
+
+#define ETHERTYPE_IPV4 0x0800
+#define ETHERTYPE_IPV6 0x86dd
+
+struct mpe_demux_pid {
+	struct mpe_demux_pid_stats stats;
+	struct mpe_fec *fec;		/* MPE-FEC frame assembler, or NULL */
+	uint16_t pid;
+};
+
+struct mpe_demux {
+	struct section_demux *sdemux;
+
+	/* index+1 into pids for each PID, 0 if not added */
+	uint16_t pid_index[TRANSPORT_MAX_PIDS];
+	struct mpe_demux_pid *pids;
+	int pids_count;
+	int pids_alloc;
+
+	/* wanted MAC addresses, as 48 bit integers */
+	uint64_t *macs;
+	int macs_count;
+	int flags;
+
+	/* the packet pool: packets[0..used) are waiting to be delivered */
+	uint8_t *pool;
+	struct mpe_demux_packet *packets;
+	int pool_size;
+	int used;
+
+	mpe_demux_callback callback;
+	void *arg;
+
+	/* the PID whose MPE-FEC frame is being delivered */
+	struct mpe_demux_pid *fec_pid;
+
+	uint64_t batches;
+};
+
+static void mpe_demux_section(void *arg, int pid, uint8_t *section, int len);
+static void mpe_demux_datagram(struct mpe_demux *mdemux, struct mpe_demux_pid *p,
+			       uint8_t *section, int len);
+static void mpe_demux_fec_section(struct mpe_demux *mdemux, struct mpe_demux_pid *p,
+				  uint8_t *section, int len);
+static void mpe_demux_fec_datagram(void *arg, uint8_t *datagram, int len, int recovered,
+				   int mac);
+static void mpe_demux_deliver(struct mpe_demux *mdemux, struct mpe_demux_pid *p,
+			      uint8_t *data, int len, uint16_t protocol, uint64_t mac);
+static int mpe_demux_mac_wanted(struct mpe_demux *mdemux, uint64_t mac);
+static int mpe_demux_fec_mac_wanted(struct mpe_demux *mdemux, uint8_t *datagram, int mac);
+
+struct mpe_demux *mpe_demux_create(int pool_size, int flags,
+				   mpe_demux_callback callback, void *arg)
+{
+	struct mpe_demux *mdemux;
+	int i;
+
+	if ((pool_size <= 0) || (callback == NULL))
+		return NULL;
+
+	mdemux = (struct mpe_demux *) malloc(sizeof(struct mpe_demux));
+	if (mdemux == NULL)
+		return NULL;
+	memset(mdemux, 0, sizeof(struct mpe_demux));
+	mdemux->flags = flags;
+	mdemux->pool_size = pool_size;
+	mdemux->callback = callback;
+	mdemux->arg = arg;
+
+	mdemux->sdemux = section_demux_create(DVB_MAX_SECTION_BYTES, mpe_demux_section, mdemux);
+	mdemux->pool = (uint8_t *) malloc((size_t) pool_size * MPE_DEMUX_PACKET_SIZE);
+	mdemux->packets = (struct mpe_demux_packet *)
+		malloc(pool_size * sizeof(struct mpe_demux_packet));
+	if ((mdemux->sdemux == NULL) || (mdemux->pool == NULL) || (mdemux->packets == NULL)) {
+		mpe_demux_destroy(mdemux);
+		return NULL;
+	}
+
+	for(i=0; i < pool_size; i++)
+		mdemux->packets[i].data = mdemux->pool + ((size_t) i * MPE_DEMUX_PACKET_SIZE);
+
+	return mdemux;
+}
+
+void mpe_demux_destroy(struct mpe_demux *mdemux)
+{
+	int i;
+
+	for(i=0; i < mdemux->pids_count; i++) {
+		if (mdemux->pids[i].fec)
+			mpe_fec_destroy(mdemux->pids[i].fec);
+	}
+	if (mdemux->sdemux)
+		section_demux_destroy(mdemux->sdemux);
+	free(mdemux->packets);
+	free(mdemux->pool);
+	free(mdemux->macs);
+	free(mdemux->pids);
+	free(mdemux);
+}
+
+int mpe_demux_add_pid(struct mpe_demux *mdemux, int pid)
+{
+	struct mpe_demux_pid *p;
+
+	if ((pid < 0) || (pid >= TRANSPORT_MAX_PIDS))
+		return -EINVAL;
+	if (mdemux->pid_index[pid])
+		return 0;
+
+	if (mdemux->pids_count == mdemux->pids_alloc) {
+		int newalloc = mdemux->pids_alloc ? mdemux->pids_alloc * 2 : 16;
+
+		p = (struct mpe_demux_pid *)
+			realloc(mdemux->pids, newalloc * sizeof(struct mpe_demux_pid));
+		if (p == NULL)
+			return -ENOMEM;
+		mdemux->pids = p;
+		mdemux->pids_alloc = newalloc;
+	}
+
+	p = &mdemux->pids[mdemux->pids_count++];
+	memset(p, 0, sizeof(struct mpe_demux_pid));
+	p->pid = pid;
+	mdemux->pid_index[pid] = mdemux->pids_count;
+
+	return 0;
+}
+
+int mpe_demux_set_fec(struct mpe_demux *mdemux, int pid, int rows)
+{
+	struct mpe_demux_pid *p;
+	int ret;
+
+	if ((ret = mpe_demux_add_pid(mdemux, pid)) < 0)
+		return ret;
+	p = &mdemux->pids[mdemux->pid_index[pid] - 1];
+	if (p->fec)
+		mpe_fec_destroy(p->fec);
+
+	if ((p->fec = mpe_fec_create(rows, mpe_demux_fec_datagram, mdemux)) == NULL)
+		return -EINVAL;
+	return 0;
+}
+
+int mpe_demux_add_mac(struct mpe_demux *mdemux, const uint8_t mac[6])
+{
+	uint64_t *macs;
+	uint64_t key = 0;
+	int i;
+
+	for(i=0; i < 6; i++)
+		key = (key << 8) | mac[i];
+	if (mpe_demux_mac_wanted(mdemux, key))
+		return 0;
+
+	macs = (uint64_t *) realloc(mdemux->macs, (mdemux->macs_count + 1) * sizeof(uint64_t));
+	if (macs == NULL)
+		return -ENOMEM;
+	macs[mdemux->macs_count++] = key;
+	mdemux->macs = macs;
+
+	return 0;
+}
+
+int mpe_demux_add_packet(struct mpe_demux *mdemux,
+			 struct transport_packet *pkt)
+{
+	struct mpe_demux_pid *p;
+	int pid = transport_packet_pid(pkt);
+	int ret;
+
+	if (mdemux->pid_index[pid] == 0)
+		return 0;
+	p = &mdemux->pids[mdemux->pid_index[pid] - 1];
+
+	ret = section_demux_add_packet(mdemux->sdemux, pkt);
+	if (ret == -EPROTO)
+		p->stats.continuity_errors++;
+	return ret;
+}
+
+void mpe_demux_add_packets(struct mpe_demux *mdemux, uint8_t *buf, int count)
+{
+	struct transport_packet *pkt;
+	int i;
+
+	for(i=0; i < count; i++, buf += TRANSPORT_PACKET_LENGTH) {
+		if ((pkt = transport_packet_init(buf)) == NULL)
+			continue;
+		mpe_demux_add_packet(mdemux, pkt);
+	}
+}
+
+void mpe_demux_flush(struct mpe_demux *mdemux)
+{
+	if (mdemux->used == 0)
+		return;
+
+	mdemux->callback(mdemux->arg, mdemux->packets, mdemux->used);
+	mdemux->used = 0;
+	mdemux->batches++;
+}
+
+void mpe_demux_get_stats(struct mpe_demux *mdemux,
+			 struct mpe_demux_stats *stats)
+{
+	struct mpe_demux_pid_stats *t = &stats->total;
+	int i;
+
+	memset(stats, 0, sizeof(struct mpe_demux_stats));
+	stats->pids = mdemux->pids_count;
+	stats->pool_size = mdemux->pool_size;
+	stats->batches = mdemux->batches;
+
+	for(i=0; i < mdemux->pids_count; i++) {
+		struct mpe_demux_pid_stats *s = &mdemux->pids[i].stats;
+
+		t->sections += s->sections;
+		t->datagrams += s->datagrams;
+		t->bytes += s->bytes;
+		t->mac_filtered += s->mac_filtered;
+		t->crc_errors += s->crc_errors;
+		t->scrambled += s->scrambled;
+		t->unsupported += s->unsupported;
+		t->invalid += s->invalid;
+		t->continuity_errors += s->continuity_errors;
+		t->other_tables += s->other_tables;
+		t->recovered += s->recovered;
+		t->fec_lost += s->fec_lost;
+	}
+}
+
+int mpe_demux_get_pid_stats(struct mpe_demux *mdemux, int pid,
+			    struct mpe_demux_pid_stats *stats)
+{
+	if ((pid < 0) || (pid >= TRANSPORT_MAX_PIDS) || (mdemux->pid_index[pid] == 0))
+		return -ENOENT;
+
+	memcpy(stats, &mdemux->pids[mdemux->pid_index[pid] - 1].stats,
+	       sizeof(struct mpe_demux_pid_stats));
+	return 0;
+}
+
+static void mpe_demux_section(void *arg, int pid, uint8_t *section, int len)
+{
+	struct mpe_demux *mdemux = (struct mpe_demux *) arg;
+	struct mpe_demux_pid *p = &mdemux->pids[mdemux->pid_index[pid] - 1];
+
+	if (p->fec && ((section[0] == stag_mpeg_datagram) || (section[0] == stag_dvb_mpe_fec))) {
+		mpe_demux_fec_section(mdemux, p, section, len);
+		return;
+	}
+	if (section[0] != stag_mpeg_datagram) {
+		p->stats.other_tables++;
+		return;
+	}
+	p->stats.sections++;
+
+	mpe_demux_datagram(mdemux, p, section, len);
+}
+
+static void mpe_demux_datagram(struct mpe_demux *mdemux, struct mpe_demux_pid *p,
+			       uint8_t *section, int len)
+{
+	uint8_t *data;
+	uint64_t mac;
+	uint16_t protocol;
+	int datalen;
+	int iplen;
+
+	if (len < MPE_HDR_SIZE + CRC_SIZE) {
+		p->stats.invalid++;
+		return;
+	}
+
+	/*
+	 * Only sections with section_syntax_indicator set carry a CRC32; the
+	 * others end with a checksum, which is not verified.
+	 */
+	if ((section[1] & 0x80) && crc32(CRC32_INIT, section, len)) {
+		p->stats.crc_errors++;
+		return;
+	}
+
+	/* payload_scrambling_control and address_scrambling_control */
+	if (section[5] & 0x3c) {
+		p->stats.scrambled++;
+		return;
+	}
+
+	/* MAC_address_6 and _5 come first, then _4 to _1 */
+	mac = ((uint64_t) section[11] << 40) | ((uint64_t) section[10] << 32) |
+	      ((uint64_t) section[9] << 24) | ((uint64_t) section[8] << 16) |
+	      ((uint64_t) section[4] << 8) | section[3];
+	if (!(mdemux->flags & mpe_demux_flag_promiscuous) &&
+	    !((mdemux->flags & mpe_demux_flag_multicast) && (section[11] & 0x01)) &&
+	    !mpe_demux_mac_wanted(mdemux, mac)) {
+		p->stats.mac_filtered++;
+		return;
+	}
+
+	/* datagrams split over several sections are not supported */
+	if (section[6] || section[7]) {
+		p->stats.unsupported++;
+		return;
+	}
+
+	data = section + MPE_HDR_SIZE;
+	datalen = len - MPE_HDR_SIZE - CRC_SIZE;
+
+	if (section[5] & 0x02) {
+		/* LLC_SNAP_flag: the ethertype is at the end of an LLC/SNAP header */
+		if (datalen < MPE_LLC_SNAP_SIZE) {
+			p->stats.invalid++;
+			return;
+		}
+		protocol = (data[6] << 8) | data[7];
+		data += MPE_LLC_SNAP_SIZE;
+		datalen -= MPE_LLC_SNAP_SIZE;
+		if ((protocol != ETHERTYPE_IPV4) && (protocol != ETHERTYPE_IPV6)) {
+			p->stats.unsupported++;
+			return;
+		}
+	} else if (datalen > 0) {
+		protocol = ((data[0] >> 4) == 6) ? ETHERTYPE_IPV6 : ETHERTYPE_IPV4;
+	} else {
+		p->stats.invalid++;
+		return;
+	}
+
+	/* trim any stuffing after the datagram, using its own length field */
+	if ((protocol == ETHERTYPE_IPV4) && (datalen >= 20) && ((data[0] >> 4) == 4)) {
+		iplen = (data[2] << 8) | data[3];
+	} else if ((protocol == ETHERTYPE_IPV6) && (datalen >= 40) && ((data[0] >> 4) == 6)) {
+		iplen = ((data[4] << 8) | data[5]) + 40;
+	} else {
+		p->stats.invalid++;
+		return;
+	}
+	if (((protocol == ETHERTYPE_IPV4) && (iplen < 20)) ||
+	    (iplen > datalen) || (iplen > MPE_DEMUX_PACKET_SIZE)) {
+		p->stats.invalid++;
+		return;
+	}
+
+	mpe_demux_deliver(mdemux, p, data, iplen, protocol, mac);
+}
+
+static void mpe_demux_fec_section(struct mpe_demux *mdemux, struct mpe_demux_pid *p,
+				  uint8_t *section, int len)
+{
+	struct mpe_fec_stats before;
+	struct mpe_fec_stats after;
+
+	if (section[0] == stag_mpeg_datagram)
+		p->stats.sections++;
+
+	mpe_fec_get_stats(p->fec, &before);
+	mdemux->fec_pid = p;
+	if (mpe_fec_add_section(p->fec, section, len) < 0)
+		p->stats.invalid++;
+	mdemux->fec_pid = NULL;
+	mpe_fec_get_stats(p->fec, &after);
+
+	p->stats.recovered += after.recovered - before.recovered;
+	p->stats.fec_lost += after.lost - before.lost;
+}
+
+static void mpe_demux_fec_datagram(void *arg, uint8_t *datagram, int len, int recovered,
+				   int mac)
+{
+	struct mpe_demux *mdemux = (struct mpe_demux *) arg;
+	uint16_t protocol;
+
+	(void) recovered;
+
+	/* the frame assembler has already checked the IP length */
+	if (len > MPE_DEMUX_PACKET_SIZE) {
+		mdemux->fec_pid->stats.invalid++;
+		return;
+	}
+	if (!mpe_demux_fec_mac_wanted(mdemux, datagram, mac)) {
+		mdemux->fec_pid->stats.mac_filtered++;
+		return;
+	}
+	protocol = ((datagram[0] >> 4) == 6) ? ETHERTYPE_IPV6 : ETHERTYPE_IPV4;
+	mpe_demux_deliver(mdemux, mdemux->fec_pid, datagram, len, protocol,
+			  (mac < 0) ? 0 : mac);
+}
+
+static void mpe_demux_deliver(struct mpe_demux *mdemux, struct mpe_demux_pid *p,
+			      uint8_t *data, int len, uint16_t protocol, uint64_t mac)
+{
+	struct mpe_demux_packet *out;
+
+	out = &mdemux->packets[mdemux->used++];
+	memcpy(out->data, data, len);
+	out->len = len;
+	out->pid = p->pid;
+	out->protocol = protocol;
+	out->mac[0] = mac >> 40;
+	out->mac[1] = mac >> 32;
+	out->mac[2] = mac >> 24;
+	out->mac[3] = mac >> 16;
+	out->mac[4] = mac >> 8;
+	out->mac[5] = mac;
+
+	p->stats.datagrams++;
+	p->stats.bytes += len;
+
+	/* the pool is full: hand it over, then we're guaranteed room */
+	if (mdemux->used == mdemux->pool_size)
+		mpe_demux_flush(mdemux);
+}
+
+static int mpe_demux_mac_wanted(struct mpe_demux *mdemux, uint64_t mac)
+{
+	int i;
+
+	for(i=0; i < mdemux->macs_count; i++) {
+		if (mdemux->macs[i] == mac)
+			return 1;
+	}
+	return 0;
+}
+
+/*
+ * On MPE-FEC PIDs only the bottom 16 bits of the MAC address are sent, and
+ * without the group bit multicast has to be spotted from the IP destination.
+ */
+static int mpe_demux_fec_mac_wanted(struct mpe_demux *mdemux, uint8_t *datagram, int mac)
+{
+	int i;
+
+	/* not known for datagrams rebuilt by the decoder: let them through */
+	if ((mdemux->flags & mpe_demux_flag_promiscuous) || (mac < 0))
+		return 1;
+
+	if (mdemux->flags & mpe_demux_flag_multicast) {
+		if (((datagram[0] >> 4) == 4) && ((datagram[16] & 0xf0) == 0xe0))
+			return 1;
+		if (((datagram[0] >> 4) == 6) && (datagram[24] == 0xff))
+			return 1;
+	}
+
+	for(i=0; i < mdemux->macs_count; i++) {
+		if ((mdemux->macs[i] & 0xffff) == (uint64_t) mac)
+			return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,239 @@
+/**
+ * MPE datagram section demultiplexer.
+ *
+ * Copyright (c) 2026 by agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef _UCSI_MPE_DEMUX_H
+#define _UCSI_MPE_DEMUX_H 1
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <libucsi/transport_packet.h>
+
+/**
+ * Size of each buffer in the packet pool: enough for the payload of the
+ * largest possible datagram section.
+ */
+#define MPE_DEMUX_PACKET_SIZE 4096
+
+/**
+ * Default number of packets in the pool (and so in each delivered batch).
+ */
+#define MPE_DEMUX_DEFAULT_POOL 64
+
+/**
+ * Flags for mpe_demux_create().
+ */
+enum mpe_demux_flags {
+	/* accept every MAC address, regardless of the configured list */
+	mpe_demux_flag_promiscuous	= 0x01,
+	/* also accept group (multicast and broadcast) MAC addresses */
+	mpe_demux_flag_multicast	= 0x02,
+};
+
+/**
+ * A received IP datagram. The data lives in the demux's packet pool.
+ */
+struct mpe_demux_packet {
+	uint8_t *data;		/* the IP datagram */
+	uint16_t len;		/* its length */
+	uint16_t pid;		/* PID it arrived on */
+	uint16_t protocol;	/* ethertype: 0x0800 (IPv4) or 0x86dd (IPv6) */
+	uint8_t mac[6];		/* destination MAC address, most significant byte first
+				   (only the last two bytes on PIDs using MPE-FEC,
+				   and all zero for datagrams rebuilt by the decoder) */
+};
+
+/**
+ * Per-PID statistics maintained by an mpe_demux. Without MPE-FEC, every
+ * datagram section received is counted in exactly one of datagrams or the
+ * drop counters.
+ */
+struct mpe_demux_pid_stats {
+	uint64_t sections;		/* datagram sections received */
+	uint64_t datagrams;		/* datagrams delivered */
+	uint64_t bytes;			/* bytes of IP delivered */
+	uint64_t mac_filtered;		/* dropped: MAC address not wanted */
+	uint64_t crc_errors;		/* dropped: CRC32 mismatch */
+	uint64_t scrambled;		/* dropped: payload or address scrambled */
+	uint64_t unsupported;		/* dropped: fragmented, or not IPv4/IPv6 */
+	uint64_t invalid;		/* dropped: malformed section or datagram */
+	uint64_t continuity_errors;	/* TS packets with a continuity error */
+	uint64_t other_tables;		/* sections which were not datagram sections */
+	uint64_t recovered;		/* datagrams rebuilt by MPE-FEC (included in datagrams) */
+	uint64_t fec_lost;		/* runs of data MPE-FEC could not rebuild */
+};
+
+/**
+ * Statistics maintained by an mpe_demux, totalled over all PIDs.
+ */
+struct mpe_demux_stats {
+	uint32_t pids;			/* number of PIDs added */
+	uint32_t pool_size;		/* number of packets in the pool */
+	uint64_t batches;		/* batches delivered to the callback */
+	struct mpe_demux_pid_stats total;
+};
+
+/**
+ * Callback receiving a batch of IP datagrams, in arrival order. The packet
+ * buffers go back to the pool when the callback returns, so it must have
+ * finished with them (e.g. written them out) by then. The callback must not
+ * feed more data into the mpe_demux.
+ *
+ * @param arg Private argument supplied to mpe_demux_create().
+ * @param packets The datagrams.
+ * @param count Number of datagrams (1 to the pool size).
+ */
+typedef void (*mpe_demux_callback)(void *arg, struct mpe_demux_packet *packets, int count);
+
+/**
+ * Opaque type representing a userspace Multiprotocol Encapsulation
+ * (EN 301 192) receiver.
+ *
+ * Datagram sections are reassembled from any number of PIDs, checked, and
+ * filtered on their destination MAC address. The IP datagrams they carry are
+ * copied straight into a preallocated pool of packet buffers, and handed to
+ * the callback in batches when the pool fills up, or when mpe_demux_flush()
+ * is called. Nothing is allocated per datagram.
+ *
+ * An mpe_demux is not thread safe; to spread a feed across cores, give each
+ * thread its own mpe_demux with a share of the PIDs.
+ */
+struct mpe_demux;
+
+/**
+ * Create a new mpe_demux.
+ *
+ * @param pool_size Number of packet buffers, i.e. the largest batch the
+ * callback will receive (e.g. MPE_DEMUX_DEFAULT_POOL).
+ * @param flags Orred enum mpe_demux_flags.
+ * @param callback Callback to receive the datagrams.
+ * @param arg Private argument to pass to the callback.
+ * @return The new instance, or NULL on error.
+ */
+extern struct mpe_demux *mpe_demux_create(int pool_size, int flags,
+					  mpe_demux_callback callback, void *arg);
+
+/**
+ * Destroy an mpe_demux. Any datagrams not yet delivered are discarded.
+ *
+ * @param mdemux The instance to destroy.
+ */
+extern void mpe_demux_destroy(struct mpe_demux *mdemux);
+
+/**
+ * Start receiving datagram sections on a PID. Packets for PIDs which have not
+ * been added are ignored.
+ *
+ * @param mdemux The mpe_demux.
+ * @param pid The PID.
+ * @return 0 on success, or a negative error code.
+ */
+extern int mpe_demux_add_pid(struct mpe_demux *mdemux, int pid);
+
+/**
+ * Receive a PID as MPE-FEC frames (EN 301 192 clause 9), adding it if
+ * necessary. Datagrams are then only delivered once their frame is complete,
+ * with any lost ones rebuilt from the RS data if possible. Every datagram of
+ * a frame is needed to decode it, so the MAC filter is applied on delivery.
+ *
+ * MAC_address_1 to _4 carry the real_time_parameters on such PIDs, so only
+ * the last two bytes of the MAC addresses added are compared, and
+ * mpe_demux_flag_multicast accepts datagrams with a multicast IP destination.
+ * A datagram whose section was lost has no MAC address at all: if the
+ * decoder rebuilds it, it is delivered unfiltered.
+ *
+ * @param mdemux The mpe_demux.
+ * @param pid The PID.
+ * @param rows Number of rows in the frames (frame_size of the
+ * time_slice_fec_identifier_descriptor: 256, 512, 768 or 1024).
+ * @return 0 on success, or a negative error code.
+ */
+extern int mpe_demux_set_fec(struct mpe_demux *mdemux, int pid, int rows);
+
+/**
+ * Add a MAC address to accept. Unless mpe_demux_flag_promiscuous was given,
+ * only datagrams for the MAC addresses added (and, with
+ * mpe_demux_flag_multicast, group addresses) are delivered.
+ *
+ * @param mdemux The mpe_demux.
+ * @param mac The MAC address, most significant byte first.
+ * @return 0 on success, or a negative error code.
+ */
+extern int mpe_demux_add_mac(struct mpe_demux *mdemux, const uint8_t mac[6]);
+
+/**
+ * Process a transport packet. The continuity counter is checked.
+ *
+ * @param mdemux The mpe_demux.
+ * @param pkt The transport packet.
+ * @return 0 on success (including packets for PIDs not added), -EPROTO on a
+ * continuity error, or another negative error code if the packet was invalid.
+ */
+extern int mpe_demux_add_packet(struct mpe_demux *mdemux,
+				struct transport_packet *pkt);
+
+/**
+ * Process a buffer of contiguous transport packets, e.g. as returned by
+ * dvbtsinput_read(). Errors are counted in the statistics.
+ *
+ * @param mdemux The mpe_demux.
+ * @param buf The packets.
+ * @param count Number of packets.
+ */
+extern void mpe_demux_add_packets(struct mpe_demux *mdemux, uint8_t *buf, int count);
+
+/**
+ * Deliver any datagrams waiting in the pool to the callback now. Call this
+ * after each read from a live source, so datagrams are not held back waiting
+ * for the pool to fill.
+ *
+ * @param mdemux The mpe_demux.
+ */
+extern void mpe_demux_flush(struct mpe_demux *mdemux);
+
+/**
+ * Retrieve the statistics of an mpe_demux.
+ *
+ * @param mdemux The mpe_demux.
+ * @param stats Where to put the statistics.
+ */
+extern void mpe_demux_get_stats(struct mpe_demux *mdemux,
+				struct mpe_demux_stats *stats);
+
+/**
+ * Retrieve the statistics for one PID.
+ *
+ * @param mdemux The mpe_demux.
+ * @param pid The PID.
+ * @param stats Where to put the statistics.
+ * @return 0 on success, or -ENOENT if the PID has not been added.
+ */
+extern int mpe_demux_get_pid_stats(struct mpe_demux *mdemux, int pid,
+				   struct mpe_demux_pid_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
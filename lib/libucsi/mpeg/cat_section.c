@@ -32,3 +32,15 @@ struct mpeg_cat_section * mpeg_cat_section_codec(struct section_ext * ext)
 
 	return (struct mpeg_cat_section *)ext;
 }
+
+int mpeg_cat_view_check(const uint8_t *buf, size_t len)
+{
+	if (section_view_check(buf, len) || section_view_ext_check(buf, 0))
+		return -1;
+
+	if (verify_descriptors((uint8_t *) buf + SECTION_VIEW_EXT_HDR_SIZE,
+			       section_view_ext_length(buf) - SECTION_VIEW_EXT_HDR_SIZE))
+		return -1;
+
+	return 0;
+}
@@ -28,6 +28,7 @@ extern "C"
 #endif
 
 #include <libucsi/section.h>
+#include <libucsi/section_view.h>
 
 /**
  * mpeg_cat_section structure.
@@ -57,6 +58,28 @@ extern struct mpeg_cat_section *mpeg_cat_section_codec(struct section_ext *secti
 	     (pos); \
 	     (pos) = mpeg_cat_section_descriptors_next(cat, pos))
 
+/**
+ * Check a raw CAT section before using the read-only mpeg_cat_view_*()
+ * functions (see libucsi/section_view.h). The buffer is not modified.
+ *
+ * @param buf Pointer to the raw section.
+ * @param len Length of the buffer.
+ * @return 0 if it is valid, nonzero if not.
+ */
+extern int mpeg_cat_view_check(const uint8_t *buf, size_t len);
+
+/**
+ * Iterator for the descriptors field of a raw CAT.
+ *
+ * @param buf Pointer to the raw section.
+ * @param pos Variable holding a const pointer to the current descriptor.
+ */
+#define mpeg_cat_view_descriptors_for_each(buf, pos) \
+	section_view_descriptors_for_each((buf) + SECTION_VIEW_EXT_HDR_SIZE, \
+					  section_view_ext_length(buf) - SECTION_VIEW_EXT_HDR_SIZE, \
+					  pos)
+
+
 
 
 
@@ -87,6 +110,7 @@ static inline struct descriptor *
 			       pos);
 }
 
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,89 @@
+/*
+ * MPEG descriptor decoder registrations
+ *
+ * Copyright (C) 2026 agent (agent@local)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <libucsi/descriptor_registry.h>
+#include <libucsi/mpeg/descriptor.h>
+
+DESCRIPTOR_REGISTRY_CODEC(mpeg_video_stream_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(mpeg_audio_stream_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(mpeg_hierarchy_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(mpeg_registration_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(mpeg_data_stream_alignment_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(mpeg_target_background_grid_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(mpeg_video_window_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(mpeg_ca_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(mpeg_iso_639_language_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(mpeg_system_clock_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(mpeg_multiplex_buffer_utilization_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(mpeg_copyright_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(mpeg_maximum_bitrate_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(mpeg_private_data_indicator_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(mpeg_smoothing_buffer_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(mpeg_std_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(mpeg_ibp_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(mpeg4_video_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(mpeg4_audio_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(mpeg_iod_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(mpeg_sl_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(mpeg_fmc_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(mpeg_external_es_id_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(mpeg_muxcode_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(mpeg_fmxbuffer_size_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(mpeg_multiplex_buffer_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(mpeg_content_labelling_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(mpeg_metadata_pointer_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(mpeg_metadata_descriptor)
+DESCRIPTOR_REGISTRY_CODEC(mpeg_metadata_std_descriptor)
+
+const struct descriptor_registry mpeg_descriptor_registry = {
+	.name = "MPEG",
+	.codecs = {
+		[dtag_mpeg_video_stream] = mpeg_video_stream_descriptor_registry_codec,
+		[dtag_mpeg_audio_stream] = mpeg_audio_stream_descriptor_registry_codec,
+		[dtag_mpeg_hierarchy] = mpeg_hierarchy_descriptor_registry_codec,
+		[dtag_mpeg_registration] = mpeg_registration_descriptor_registry_codec,
+		[dtag_mpeg_data_stream_alignment] = mpeg_data_stream_alignment_descriptor_registry_codec,
+		[dtag_mpeg_target_background_grid] = mpeg_target_background_grid_descriptor_registry_codec,
+		[dtag_mpeg_video_window] = mpeg_video_window_descriptor_registry_codec,
+		[dtag_mpeg_ca] = mpeg_ca_descriptor_registry_codec,
+		[dtag_mpeg_iso_639_language] = mpeg_iso_639_language_descriptor_registry_codec,
+		[dtag_mpeg_system_clock] = mpeg_system_clock_descriptor_registry_codec,
+		[dtag_mpeg_multiplex_buffer_utilization] = mpeg_multiplex_buffer_utilization_descriptor_registry_codec,
+		[dtag_mpeg_copyright] = mpeg_copyright_descriptor_registry_codec,
+		[dtag_mpeg_maximum_bitrate] = mpeg_maximum_bitrate_descriptor_registry_codec,
+		[dtag_mpeg_private_data_indicator] = mpeg_private_data_indicator_descriptor_registry_codec,
+		[dtag_mpeg_smoothing_buffer] = mpeg_smoothing_buffer_descriptor_registry_codec,
+		[dtag_mpeg_std] = mpeg_std_descriptor_registry_codec,
+		[dtag_mpeg_ibp] = mpeg_ibp_descriptor_registry_codec,
+		[dtag_mpeg_4_video] = mpeg4_video_descriptor_registry_codec,
+		[dtag_mpeg_4_audio] = mpeg4_audio_descriptor_registry_codec,
+		[dtag_mpeg_iod] = mpeg_iod_descriptor_registry_codec,
+		[dtag_mpeg_sl] = mpeg_sl_descriptor_registry_codec,
+		[dtag_mpeg_fmc] = mpeg_fmc_descriptor_registry_codec,
+		[dtag_mpeg_external_es_id] = mpeg_external_es_id_descriptor_registry_codec,
+		[dtag_mpeg_muxcode] = mpeg_muxcode_descriptor_registry_codec,
+		[dtag_mpeg_fmxbuffer_size] = mpeg_fmxbuffer_size_descriptor_registry_codec,
+		[dtag_mpeg_multiplex_buffer] = mpeg_multiplex_buffer_descriptor_registry_codec,
+		[dtag_mpeg_content_labelling] = mpeg_content_labelling_descriptor_registry_codec,
+		[dtag_mpeg_metadata_pointer] = mpeg_metadata_pointer_descriptor_registry_codec,
+		[dtag_mpeg_metadata] = mpeg_metadata_descriptor_registry_codec,
+		[dtag_mpeg_metadata_std] = mpeg_metadata_std_descriptor_registry_codec,
+	},
+};
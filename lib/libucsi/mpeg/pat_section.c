@@ -44,3 +44,15 @@ struct mpeg_pat_section *mpeg_pat_section_codec(struct section_ext * ext)
 
 	return (struct mpeg_pat_section *)ext;
 }
+
+int mpeg_pat_view_check(const uint8_t *buf, size_t len)
+{
+	if (section_view_check(buf, len) || section_view_ext_check(buf, 0))
+		return -1;
+
+	if ((section_view_ext_length(buf) - SECTION_VIEW_EXT_HDR_SIZE) %
+	    sizeof(struct mpeg_pat_program))
+		return -1;
+
+	return 0;
+}
@@ -28,6 +28,7 @@ extern "C"
 #endif
 
 #include <libucsi/section.h>
+#include <libucsi/section_view.h>
 
 /**
  * mpeg_pat_section structure.
@@ -77,6 +78,61 @@ static inline uint16_t mpeg_pat_section_transport_stream_id(struct mpeg_pat_sect
 	     (pos); \
 	     (pos) = mpeg_pat_section_programs_next(pat, pos))
 
+/**
+ * Check a raw PAT section before using the read-only mpeg_pat_view_*()
+ * functions (see libucsi/section_view.h). The buffer is not modified.
+ *
+ * @param buf Pointer to the raw section.
+ * @param len Length of the buffer.
+ * @return 0 if it is valid, nonzero if not.
+ */
+extern int mpeg_pat_view_check(const uint8_t *buf, size_t len);
+
+/**
+ * Accessor for the transport_stream_id field of a raw PAT.
+ *
+ * @param buf Pointer to the raw section.
+ * @return The transport_stream_id.
+ */
+static inline uint16_t mpeg_pat_view_transport_stream_id(const uint8_t *buf)
+{
+	return section_view_table_id_ext(buf);
+}
+
+/**
+ * Iterator for the programs field of a raw PAT.
+ *
+ * @param buf Pointer to the raw section.
+ * @param pos Variable holding a const uint8_t pointer to the current program.
+ */
+#define mpeg_pat_view_programs_for_each(buf, pos) \
+	for ((pos) = mpeg_pat_view_programs_first(buf); \
+	     (pos); \
+	     (pos) = mpeg_pat_view_programs_next(buf, pos))
+
+/**
+ * Accessor for the program_number field of a program in a raw PAT.
+ *
+ * @param program Pointer to the program.
+ * @return The program_number.
+ */
+static inline uint16_t mpeg_pat_view_program_number(const uint8_t *program)
+{
+	return ucsi_get_be16(program);
+}
+
+/**
+ * Accessor for the pid field of a program in a raw PAT.
+ *
+ * @param program Pointer to the program.
+ * @return The pid.
+ */
+static inline uint16_t mpeg_pat_view_program_pid(const uint8_t *program)
+{
+	return ucsi_get_be16(program + 2) & 0x1fff;
+}
+
+
 
 
 
@@ -111,6 +167,26 @@ static inline
 	return (struct mpeg_pat_program *) next;
 }
 
+static inline const uint8_t *
+	mpeg_pat_view_programs_first(const uint8_t *buf)
+{
+	if (SECTION_VIEW_EXT_HDR_SIZE >= section_view_ext_length(buf))
+		return NULL;
+
+	return buf + SECTION_VIEW_EXT_HDR_SIZE;
+}
+
+static inline const uint8_t *
+	mpeg_pat_view_programs_next(const uint8_t *buf, const uint8_t *pos)
+{
+	const uint8_t *next = pos + sizeof(struct mpeg_pat_program);
+
+	if (next >= buf + section_view_ext_length(buf))
+		return NULL;
+
+	return next;
+}
+
 #ifdef __cplusplus
 }
 #endif
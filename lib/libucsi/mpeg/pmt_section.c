@@ -21,7 +21,7 @@
 
 #include <libucsi/mpeg/pmt_section.h>
 
-struct mpeg_pmt_section * mpeg_pmt_section_codec(struct section_ext * ext)
+static inline struct mpeg_pmt_section *mpeg_pmt_section_do_codec(struct section_ext * ext, int lazy)
 {
 	uint8_t * buf = (uint8_t *) ext;
 	struct mpeg_pmt_section * pmt = (struct mpeg_pmt_section *) ext;
@@ -39,7 +39,7 @@ struct mpeg_pmt_section * mpeg_pmt_section_codec(struct section_ext * ext)
 	if ((pos + pmt->program_info_length) > len)
 		return NULL;
 
-	if (verify_descriptors(buf + pos, pmt->program_info_length))
+	if ((!lazy) && verify_descriptors(buf + pos, pmt->program_info_length))
 		return NULL;
 
 	pos += pmt->program_info_length;
@@ -58,7 +58,7 @@ struct mpeg_pmt_section * mpeg_pmt_section_codec(struct section_ext * ext)
 		if ((pos + stream->es_info_length) > len)
 			return NULL;
 
-		if (verify_descriptors(buf + pos, stream->es_info_length))
+		if ((!lazy) && verify_descriptors(buf + pos, stream->es_info_length))
 			return NULL;
 
 		pos += stream->es_info_length;
@@ -69,3 +69,48 @@ struct mpeg_pmt_section * mpeg_pmt_section_codec(struct section_ext * ext)
 
 	return (struct mpeg_pmt_section *) ext;
 }
+
+struct mpeg_pmt_section *mpeg_pmt_section_codec(struct section_ext * ext)
+{
+	return mpeg_pmt_section_do_codec(ext, 0);
+}
+
+struct mpeg_pmt_section *mpeg_pmt_section_codec_lazy(struct section_ext * ext)
+{
+	return mpeg_pmt_section_do_codec(ext, 1);
+}
+
+int mpeg_pmt_view_check(const uint8_t *buf, size_t len)
+{
+	size_t pos = sizeof(struct mpeg_pmt_section);
+	size_t dlen;
+
+	if (section_view_check(buf, len) || section_view_ext_check(buf, 0))
+		return -1;
+	len = section_view_ext_length(buf);
+	if (len < sizeof(struct mpeg_pmt_section))
+		return -1;
+
+	dlen = mpeg_pmt_view_program_info_length(buf);
+	if ((pos + dlen) > len)
+		return -1;
+	if (verify_descriptors((uint8_t *) buf + pos, dlen))
+		return -1;
+	pos += dlen;
+
+	while (pos < len) {
+		if ((pos + sizeof(struct mpeg_pmt_stream)) > len)
+			return -1;
+
+		dlen = mpeg_pmt_view_stream_es_info_length(buf + pos);
+		pos += sizeof(struct mpeg_pmt_stream);
+
+		if ((pos + dlen) > len)
+			return -1;
+		if (verify_descriptors((uint8_t *) buf + pos, dlen))
+			return -1;
+		pos += dlen;
+	}
+
+	return 0;
+}
@@ -28,6 +28,7 @@ extern "C"
 #endif
 
 #include <libucsi/section.h>
+#include <libucsi/section_view.h>
 
 /**
  * mpeg_pmt_section structure.
@@ -64,6 +65,17 @@ struct mpeg_pmt_stream {
  */
 extern struct mpeg_pmt_section *mpeg_pmt_section_codec(struct section_ext *section);
 
+/**
+ * Process a mpeg_pmt_section, but leave the program and stream descriptor loops to be
+ * validated when they are first iterated (see first_descriptor()) rather
+ * than checking them all up front. Use this when most descriptors will not
+ * be looked at.
+ *
+ * @param section Pointer to the generic section header.
+ * @return Pointer to the mpeg_pmt_section structure, or NULL on error.
+ */
+extern struct mpeg_pmt_section *mpeg_pmt_section_codec_lazy(struct section_ext *section);
+
 /**
  * Accessor for program_number field of a PMT.
  *
@@ -108,6 +120,116 @@ static inline uint16_t mpeg_pmt_section_program_number(struct mpeg_pmt_section *
 	     (pos); \
 	     (pos) = mpeg_pmt_stream_descriptors_next(stream, pos))
 
+/**
+ * Check a raw PMT section before using the read-only mpeg_pmt_view_*()
+ * functions (see libucsi/section_view.h). The buffer is not modified.
+ *
+ * @param buf Pointer to the raw section.
+ * @param len Length of the buffer.
+ * @return 0 if it is valid, nonzero if not.
+ */
+extern int mpeg_pmt_view_check(const uint8_t *buf, size_t len);
+
+/**
+ * Accessor for the program_number field of a raw PMT.
+ *
+ * @param buf Pointer to the raw section.
+ * @return The program_number.
+ */
+static inline uint16_t mpeg_pmt_view_program_number(const uint8_t *buf)
+{
+	return section_view_table_id_ext(buf);
+}
+
+/**
+ * Accessor for the pcr_pid field of a raw PMT.
+ *
+ * @param buf Pointer to the raw section.
+ * @return The pcr_pid.
+ */
+static inline uint16_t mpeg_pmt_view_pcr_pid(const uint8_t *buf)
+{
+	return ucsi_get_be16(buf + 8) & 0x1fff;
+}
+
+/**
+ * Accessor for the program_info_length field of a raw PMT.
+ *
+ * @param buf Pointer to the raw section.
+ * @return The program_info_length.
+ */
+static inline uint16_t mpeg_pmt_view_program_info_length(const uint8_t *buf)
+{
+	return ucsi_get_be16(buf + 10) & 0x0fff;
+}
+
+/**
+ * Iterator for the descriptors field of a raw PMT.
+ *
+ * @param buf Pointer to the raw section.
+ * @param pos Variable holding a const pointer to the current descriptor.
+ */
+#define mpeg_pmt_view_descriptors_for_each(buf, pos) \
+	section_view_descriptors_for_each((buf) + sizeof(struct mpeg_pmt_section), \
+					  mpeg_pmt_view_program_info_length(buf), \
+					  pos)
+
+/**
+ * Iterator for the streams field of a raw PMT.
+ *
+ * @param buf Pointer to the raw section.
+ * @param pos Variable holding a const uint8_t pointer to the current stream.
+ */
+#define mpeg_pmt_view_streams_for_each(buf, pos) \
+	for ((pos) = mpeg_pmt_view_streams_first(buf); \
+	     (pos); \
+	     (pos) = mpeg_pmt_view_streams_next(buf, pos))
+
+/**
+ * Accessor for the stream_type field of a stream in a raw PMT.
+ *
+ * @param stream Pointer to the stream.
+ * @return The stream_type.
+ */
+static inline uint8_t mpeg_pmt_view_stream_type(const uint8_t *stream)
+{
+	return stream[0];
+}
+
+/**
+ * Accessor for the pid field of a stream in a raw PMT.
+ *
+ * @param stream Pointer to the stream.
+ * @return The pid.
+ */
+static inline uint16_t mpeg_pmt_view_stream_pid(const uint8_t *stream)
+{
+	return ucsi_get_be16(stream + 1) & 0x1fff;
+}
+
+/**
+ * Accessor for the es_info_length field of a stream in a raw PMT.
+ *
+ * @param stream Pointer to the stream.
+ * @return The es_info_length.
+ */
+static inline uint16_t mpeg_pmt_view_stream_es_info_length(const uint8_t *stream)
+{
+	return ucsi_get_be16(stream + 3) & 0x0fff;
+}
+
+/**
+ * Iterator for the descriptors field of a stream in a raw PMT.
+ *
+ * @param stream Pointer to the stream.
+ * @param pos Variable holding a const pointer to the current descriptor.
+ */
+#define mpeg_pmt_view_stream_descriptors_for_each(stream, pos) \
+	section_view_descriptors_for_each((stream) + sizeof(struct mpeg_pmt_stream), \
+					  mpeg_pmt_view_stream_es_info_length(stream), \
+					  pos)
+
+
 
 
 
@@ -121,11 +243,8 @@ static inline uint16_t mpeg_pmt_section_program_number(struct mpeg_pmt_section *
 static inline struct descriptor *
 	mpeg_pmt_section_descriptors_first(struct mpeg_pmt_section * pmt)
 {
-	if (pmt->program_info_length == 0)
-		return NULL;
-
-	return (struct descriptor *)
-		((uint8_t *) pmt + sizeof(struct mpeg_pmt_section));
+	return first_descriptor((uint8_t *) pmt + sizeof(struct mpeg_pmt_section),
+				pmt->program_info_length);
 }
 
 static inline struct descriptor *
@@ -165,11 +284,8 @@ static inline struct mpeg_pmt_stream *
 static inline struct descriptor *
 	mpeg_pmt_stream_descriptors_first(struct mpeg_pmt_stream *stream)
 {
-	if (stream->es_info_length == 0)
-		return NULL;
-
-	return (struct descriptor *)
-		((uint8_t*) stream + sizeof(struct mpeg_pmt_stream));
+	return first_descriptor((uint8_t *) stream + sizeof(struct mpeg_pmt_stream),
+				stream->es_info_length);
 }
 
 static inline struct descriptor *
@@ -181,6 +297,29 @@ static inline struct descriptor *
 			       pos);
 }
 
+static inline const uint8_t *
+	mpeg_pmt_view_streams_first(const uint8_t *buf)
+{
+	size_t pos = sizeof(struct mpeg_pmt_section) + mpeg_pmt_view_program_info_length(buf);
+
+	if (pos >= section_view_ext_length(buf))
+		return NULL;
+
+	return buf + pos;
+}
+
+static inline const uint8_t *
+	mpeg_pmt_view_streams_next(const uint8_t *buf, const uint8_t *pos)
+{
+	const uint8_t *next = pos + sizeof(struct mpeg_pmt_stream) +
+			      mpeg_pmt_view_stream_es_info_length(pos);
+
+	if (next >= buf + section_view_ext_length(buf))
+		return NULL;
+
+	return next;
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,348 @@
+/**
+ * PCR clock recovery and bitrate estimation.
+ *
+ * Copyright (c) 2026 by agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "pcr_clock.h"
+
+#define NO_PID 0xffff
+#define PACKET_BITS (TRANSPORT_PACKET_LENGTH * 8)
+
+/* smoothed values move 1/2^SMOOTHING of the way towards each new sample */
+#define SMOOTHING 3
+
+/*
+ * Each program's PCR is tracked by a software PLL estimating its clock in
+ * 27MHz ticks per mux packet, in fixed point. On each PCR, the phase is
+ * moved 1/2^PLL_PHASE_GAIN and the frequency 1/2^PLL_FREQ_GAIN of the way
+ * towards it. Jitter is not reported until the PLL has had PLL_SETTLE PCRs,
+ * after which the error fed back is limited to PCR_CLOCK_JITTER_MAX.
+ */
+#define PLL_SHIFT 16
+#define PLL_PHASE_GAIN 3
+#define PLL_FREQ_GAIN 5
+#define PLL_SETTLE 8
+#define PLL_MAX_ERROR ((int64_t) PCR_CLOCK_JITTER_MAX << PLL_SHIFT)
+
+struct pcr_clock_pid {
+	uint64_t packets;		/* packets received */
+	uint64_t window_packets;	/* packets at the start of the window */
+	uint32_t bitrate;
+	uint32_t bitrate_smoothed;
+	uint16_t program;		/* index+1 into programs if a PCR PID */
+	uint8_t active;
+};
+
+struct pcr_clock_state {
+	struct pcr_clock_program pub;
+	uint64_t packet;		/* mux packet number of the last PCR */
+
+	uint64_t pll_pcr;		/* estimated PCR at the last PCR << PLL_SHIFT */
+	uint64_t pll_tpp;		/* estimated ticks per packet << PLL_SHIFT */
+	uint32_t pll_count;		/* PCRs since the PLL was started */
+};
+
+struct pcr_clock {
+	struct pcr_clock_pid pids[TRANSPORT_MAX_PIDS];
+	uint16_t active[TRANSPORT_MAX_PIDS];
+	int nactive;
+
+	struct pcr_clock_state *programs;
+	int programs_alloc;
+
+	/* the current per-PID bitrate window */
+	uint64_t window_pcr;
+	int window_valid;
+	int rates_valid;
+
+	struct pcr_clock_stats stats;
+};
+
+static int pcr_clock_pcr(struct pcr_clock *clk, int pid, uint64_t pcr, int discontinuity);
+static void pcr_clock_window(struct pcr_clock *clk, uint64_t pcr, int update);
+static void pcr_clock_pll_start(struct pcr_clock_state *prog, uint64_t pcr);
+
+static inline uint32_t pcr_clock_rate(uint64_t packets, uint64_t ticks)
+{
+	return (packets * PACKET_BITS * PCR_CLOCK_HZ) / ticks;
+}
+
+static inline int64_t pcr_clock_pll_error(uint64_t pcr, uint64_t predicted)
+{
+	const int64_t wrap = (int64_t) PCR_CLOCK_WRAP << PLL_SHIFT;
+	int64_t err = (int64_t) (pcr << PLL_SHIFT) - (int64_t) predicted;
+
+	if (err > (wrap / 2))
+		err -= wrap;
+	else if (err < -(wrap / 2))
+		err += wrap;
+	return err;
+}
+
+static inline void pcr_clock_smooth(uint32_t *smoothed, uint32_t sample)
+{
+	if (*smoothed == 0)
+		*smoothed = sample;
+	else
+		*smoothed += ((int64_t) sample - (int64_t) *smoothed) >> SMOOTHING;
+}
+
+struct pcr_clock *pcr_clock_create(void)
+{
+	struct pcr_clock *clk;
+
+	clk = (struct pcr_clock *) malloc(sizeof(struct pcr_clock));
+	if (clk == NULL)
+		return NULL;
+	memset(clk, 0, sizeof(struct pcr_clock));
+	clk->stats.reference_pid = NO_PID;
+
+	return clk;
+}
+
+void pcr_clock_destroy(struct pcr_clock *clk)
+{
+	free(clk->programs);
+	free(clk);
+}
+
+int pcr_clock_add_packet(struct pcr_clock *clk, struct transport_packet *pkt)
+{
+	uint8_t *buf = (uint8_t *) pkt;
+	int pid = transport_packet_pid(pkt);
+	struct pcr_clock_pid *p = &clk->pids[pid];
+	uint64_t pcr;
+
+	if (!p->active) {
+		p->active = 1;
+		clk->active[clk->nactive++] = pid;
+	}
+	p->packets++;
+	clk->stats.packets++;
+
+	/* only look further if there is an adaptation field with a PCR */
+	if (!(buf[3] & 0x20) || (buf[4] < 7) || !(buf[5] & transport_adaptation_flag_pcr))
+		return 0;
+
+	pcr = (((uint64_t) buf[6] << 25) |
+	       ((uint64_t) buf[7] << 17) |
+	       ((uint64_t) buf[8] << 9) |
+	       ((uint64_t) buf[9] << 1) |
+	       ((uint64_t) buf[10] >> 7)) * 300ULL;
+	pcr += ((buf[10] & 1) << 8) | buf[11];
+
+	return pcr_clock_pcr(clk, pid, pcr, buf[5] & transport_adaptation_flag_discontinuity);
+}
+
+void pcr_clock_set_reference(struct pcr_clock *clk, int pcr_pid)
+{
+	clk->stats.reference_pid = pcr_pid;
+	clk->stats.bitrate = 0;
+	clk->stats.bitrate_smoothed = 0;
+	clk->window_valid = 0;
+}
+
+int pcr_clock_now(struct pcr_clock *clk, uint64_t *pcr)
+{
+	struct pcr_clock_state *prog;
+	uint16_t idx;
+
+	if (clk->stats.reference_pid == NO_PID)
+		return -1;
+	if ((idx = clk->pids[clk->stats.reference_pid].program) == 0)
+		return -1;
+	prog = &clk->programs[idx - 1];
+	if (prog->pll_count < 2)
+		return -1;
+
+	*pcr = ((prog->pll_pcr + (clk->stats.packets - prog->packet) * prog->pll_tpp) >> PLL_SHIFT) %
+		PCR_CLOCK_WRAP;
+	return 0;
+}
+
+int pcr_clock_get_pid_bitrate(struct pcr_clock *clk, int pid,
+			      uint32_t *bitrate, uint32_t *bitrate_smoothed)
+{
+	if ((pid < 0) || (pid >= TRANSPORT_MAX_PIDS) || !clk->rates_valid)
+		return -1;
+
+	*bitrate = clk->pids[pid].bitrate;
+	*bitrate_smoothed = clk->pids[pid].bitrate_smoothed;
+	return 0;
+}
+
+int pcr_clock_get_program(struct pcr_clock *clk, int pcr_pid,
+			  struct pcr_clock_program *program)
+{
+	uint16_t idx;
+
+	if ((pcr_pid < 0) || (pcr_pid >= TRANSPORT_MAX_PIDS))
+		return -1;
+	if ((idx = clk->pids[pcr_pid].program) == 0)
+		return -1;
+
+	memcpy(program, &clk->programs[idx - 1].pub, sizeof(struct pcr_clock_program));
+	return 0;
+}
+
+void pcr_clock_get_stats(struct pcr_clock *clk, struct pcr_clock_stats *stats)
+{
+	memcpy(stats, &clk->stats, sizeof(struct pcr_clock_stats));
+}
+
+static int pcr_clock_pcr(struct pcr_clock *clk, int pid, uint64_t pcr, int discontinuity)
+{
+	struct pcr_clock_state *prog;
+	uint64_t packet = clk->stats.packets;
+	uint64_t delta;
+	uint64_t packets;
+	uint64_t predicted;
+	int64_t err;
+	int64_t jitter;
+	int reference;
+	int events = pcr_clock_event_pcr;
+
+	/* first PCR on this PID? */
+	if (clk->pids[pid].program == 0) {
+		if ((int) clk->stats.programs == clk->programs_alloc) {
+			int newalloc = clk->programs_alloc ? clk->programs_alloc * 2 : 8;
+
+			prog = (struct pcr_clock_state *)
+				realloc(clk->programs, newalloc * sizeof(struct pcr_clock_state));
+			if (prog == NULL)
+				return events;
+			clk->programs = prog;
+			clk->programs_alloc = newalloc;
+		}
+
+		prog = &clk->programs[clk->stats.programs++];
+		memset(prog, 0, sizeof(struct pcr_clock_state));
+		prog->pub.pcr_pid = pid;
+		clk->pids[pid].program = clk->stats.programs;
+		if (clk->stats.reference_pid == NO_PID)
+			clk->stats.reference_pid = pid;
+	} else {
+		prog = &clk->programs[clk->pids[pid].program - 1];
+	}
+	reference = (pid == clk->stats.reference_pid);
+
+	if (prog->pub.pcrs == 0) {
+		pcr_clock_pll_start(prog, pcr);
+	} else {
+		delta = pcr_clock_delta(pcr, prog->pub.pcr);
+		packets = packet - prog->packet;
+
+		if (discontinuity || (delta == 0) || (delta > PCR_CLOCK_MAX_GAP)) {
+			prog->pub.discontinuities++;
+			events |= pcr_clock_event_discontinuity;
+			pcr_clock_pll_start(prog, pcr);
+			if (reference)
+				clk->window_valid = 0;
+		} else {
+			if (delta > prog->pub.max_interval)
+				prog->pub.max_interval = delta;
+
+			if (prog->pll_count == 1) {
+				/* the first interval gives the initial frequency */
+				prog->pll_tpp = (delta << PLL_SHIFT) / packets;
+				prog->pll_pcr = pcr << PLL_SHIFT;
+			} else {
+				/* how far is it from where the PLL says it should be? */
+				predicted = (prog->pll_pcr + packets * prog->pll_tpp) %
+					(PCR_CLOCK_WRAP << PLL_SHIFT);
+				err = pcr_clock_pll_error(pcr, predicted);
+
+				if (prog->pll_count >= PLL_SETTLE) {
+					jitter = err / (1 << PLL_SHIFT);
+					prog->pub.jitter = jitter;
+					if (jitter < 0)
+						jitter = -jitter;
+					if (jitter > prog->pub.max_jitter)
+						prog->pub.max_jitter = jitter;
+					if (jitter > PCR_CLOCK_JITTER_MAX) {
+						prog->pub.jitter_errors++;
+						events |= pcr_clock_event_jitter;
+					}
+
+					/* don't let a single bad PCR drag the PLL off */
+					if (err > PLL_MAX_ERROR)
+						err = PLL_MAX_ERROR;
+					else if (err < -PLL_MAX_ERROR)
+						err = -PLL_MAX_ERROR;
+				}
+
+				prog->pll_pcr = (predicted + (err >> PLL_PHASE_GAIN)) %
+					(PCR_CLOCK_WRAP << PLL_SHIFT);
+				prog->pll_tpp += (err >> PLL_FREQ_GAIN) / (int64_t) packets;
+			}
+			prog->pll_count++;
+
+			/* the reference PID gives us the mux bitrate */
+			if (reference) {
+				clk->stats.bitrate = pcr_clock_rate(packets, delta);
+				clk->stats.bitrate_smoothed =
+					((uint64_t) PACKET_BITS * PCR_CLOCK_HZ << PLL_SHIFT) /
+					prog->pll_tpp;
+			}
+		}
+	}
+	prog->pub.pcr = pcr;
+	prog->pub.pcrs++;
+	prog->packet = packet;
+
+	/* per-PID bitrates are measured against the reference */
+	if (reference) {
+		if (!clk->window_valid) {
+			pcr_clock_window(clk, pcr, 0);
+		} else if (pcr_clock_delta(pcr, clk->window_pcr) >= PCR_CLOCK_WINDOW) {
+			pcr_clock_window(clk, pcr, 1);
+			events |= pcr_clock_event_rates;
+		}
+	}
+
+	return events;
+}
+
+static void pcr_clock_window(struct pcr_clock *clk, uint64_t pcr, int update)
+{
+	uint64_t ticks = pcr_clock_delta(pcr, clk->window_pcr);
+	struct pcr_clock_pid *p;
+	int i;
+
+	for(i=0; i < clk->nactive; i++) {
+		p = &clk->pids[clk->active[i]];
+		if (update) {
+			p->bitrate = pcr_clock_rate(p->packets - p->window_packets, ticks);
+			pcr_clock_smooth(&p->bitrate_smoothed, p->bitrate);
+		}
+		p->window_packets = p->packets;
+	}
+	if (update)
+		clk->rates_valid = 1;
+
+	clk->window_pcr = pcr;
+	clk->window_valid = 1;
+}
+
+static void pcr_clock_pll_start(struct pcr_clock_state *prog, uint64_t pcr)
+{
+	prog->pll_pcr = pcr << PLL_SHIFT;
+	prog->pll_count = 1;
+}
@@ -0,0 +1,199 @@
+/**
+ * PCR clock recovery and bitrate estimation.
+ *
+ * Copyright (c) 2026 by agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef _UCSI_PCR_CLOCK_H
+#define _UCSI_PCR_CLOCK_H 1
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <libucsi/transport_packet.h>
+
+/**
+ * Frequency of the system clock which PCRs count.
+ */
+#define PCR_CLOCK_HZ 27000000ULL
+
+/**
+ * PCR values wrap at this value.
+ */
+#define PCR_CLOCK_WRAP ((1ULL << 33) * 300ULL)
+
+/**
+ * Period over which per-PID bitrates are measured (100ms, in 27MHz ticks).
+ */
+#define PCR_CLOCK_WINDOW (PCR_CLOCK_HZ / 10)
+
+/**
+ * A PCR whose error against the value predicted by its program's recovered
+ * clock exceeds this is flagged as jitter (500ns, in 27MHz ticks, as ISO 13818-1
+ * and TR 101 290 PCR_accuracy_error).
+ */
+#define PCR_CLOCK_JITTER_MAX 14
+
+/**
+ * A gap between two PCRs on one PID longer than this is treated as a
+ * discontinuity (100ms, in 27MHz ticks, as TR 101 290 PCR_discontinuity).
+ */
+#define PCR_CLOCK_MAX_GAP (PCR_CLOCK_HZ / 10)
+
+/**
+ * Events reported by pcr_clock_add_packet().
+ */
+enum pcr_clock_event {
+	pcr_clock_event_pcr		= 0x01, /* the packet carried a PCR */
+	pcr_clock_event_discontinuity	= 0x02, /* the PCR was discontinuous */
+	pcr_clock_event_jitter		= 0x04, /* the PCR exceeded PCR_CLOCK_JITTER_MAX */
+	pcr_clock_event_rates		= 0x08, /* the per-PID bitrates were updated */
+};
+
+/**
+ * Statistics for the PCR of one program.
+ */
+struct pcr_clock_program {
+	uint16_t pcr_pid;
+	uint64_t pcr;			/* last PCR received */
+	uint64_t pcrs;			/* number of PCRs received */
+	uint64_t discontinuities;	/* number of discontinuities */
+	uint64_t jitter_errors;		/* number of PCRs exceeding PCR_CLOCK_JITTER_MAX */
+	int32_t jitter;			/* error of the last PCR, in 27MHz ticks */
+	int32_t max_jitter;		/* largest error seen (absolute), in 27MHz ticks */
+	uint32_t max_interval;		/* longest gap between PCRs, in 27MHz ticks */
+};
+
+/**
+ * Overall statistics of a pcr_clock.
+ */
+struct pcr_clock_stats {
+	uint64_t packets;		/* TS packets processed */
+	uint16_t reference_pid;		/* PCR PID used as the time base, or 0xffff */
+	uint32_t programs;		/* number of PCR PIDs seen */
+	uint32_t bitrate;		/* mux bitrate over the last PCR interval, bits/s */
+	uint32_t bitrate_smoothed;	/* mux bitrate from the recovered clock, bits/s */
+};
+
+/**
+ * Opaque type representing a PCR clock recovery context.
+ *
+ * It follows the PCRs of every program in a multiplex and uses them,
+ * rather than the time packets happen to be received at, to measure the
+ * mux and per-PID bitrates. One PCR PID (by default, the first seen) is
+ * the reference time base. Each program's clock is recovered with a small
+ * software PLL, which gives the smoothed mux bitrate and the PCR jitter.
+ * Each packet costs a couple of counter updates;
+ * per-PID rates are recalculated once per PCR_CLOCK_WINDOW of PCR time.
+ */
+struct pcr_clock;
+
+/**
+ * Create a new pcr_clock.
+ *
+ * @return The new instance, or NULL on error.
+ */
+extern struct pcr_clock *pcr_clock_create(void);
+
+/**
+ * Destroy a pcr_clock.
+ *
+ * @param clk The instance to destroy.
+ */
+extern void pcr_clock_destroy(struct pcr_clock *clk);
+
+/**
+ * Process a transport packet. Every packet of the multiplex must be passed
+ * in, in order, for the bitrates to be correct.
+ *
+ * @param clk The pcr_clock.
+ * @param pkt The transport packet (already validated by transport_packet_init()).
+ * @return Orred bitmask of enum pcr_clock_event.
+ */
+extern int pcr_clock_add_packet(struct pcr_clock *clk, struct transport_packet *pkt);
+
+/**
+ * Choose the PCR PID to use as the time base. This resets the measurements.
+ *
+ * @param clk The pcr_clock.
+ * @param pcr_pid The PCR PID.
+ */
+extern void pcr_clock_set_reference(struct pcr_clock *clk, int pcr_pid);
+
+/**
+ * Estimate the current value of the reference PCR, by extrapolating from
+ * the last one using the recovered clock.
+ *
+ * @param clk The pcr_clock.
+ * @param pcr Where to put the estimate (27MHz ticks).
+ * @return 0 on success, or -1 if there is no time base yet.
+ */
+extern int pcr_clock_now(struct pcr_clock *clk, uint64_t *pcr);
+
+/**
+ * Retrieve the bitrates of a PID.
+ *
+ * @param clk The pcr_clock.
+ * @param pid The PID.
+ * @param bitrate Where to put the bitrate over the last window, in bits/s.
+ * @param bitrate_smoothed Where to put the smoothed bitrate, in bits/s.
+ * @return 0 on success, or -1 if no bitrates have been measured yet.
+ */
+extern int pcr_clock_get_pid_bitrate(struct pcr_clock *clk, int pid,
+				     uint32_t *bitrate, uint32_t *bitrate_smoothed);
+
+/**
+ * Retrieve the statistics of one program's PCR.
+ *
+ * @param clk The pcr_clock.
+ * @param pcr_pid The PCR PID of the program.
+ * @param program Where to put the statistics.
+ * @return 0 on success, or -1 if no PCRs have been seen on the PID.
+ */
+extern int pcr_clock_get_program(struct pcr_clock *clk, int pcr_pid,
+				 struct pcr_clock_program *program);
+
+/**
+ * Retrieve the overall statistics of a pcr_clock.
+ *
+ * @param clk The pcr_clock.
+ * @param stats Where to put the statistics.
+ */
+extern void pcr_clock_get_stats(struct pcr_clock *clk, struct pcr_clock_stats *stats);
+
+/**
+ * Calculate the difference between two PCR values, allowing for wrapping.
+ *
+ * @param later The later PCR.
+ * @param earlier The earlier PCR.
+ * @return later - earlier, in 27MHz ticks.
+ */
+static inline uint64_t pcr_clock_delta(uint64_t later, uint64_t earlier)
+{
+	if (later >= earlier)
+		return later - earlier;
+	return later + PCR_CLOCK_WRAP - earlier;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
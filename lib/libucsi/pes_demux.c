@@ -0,0 +1,358 @@
+/**
+ * PES packet reassembly from transport stream packets.
+ *
+ * Copyright (c) 2026 by agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pes_demux.h"
+
+struct pes_demux_pid {
+	uint8_t *buf;			/* chunk buffer, or NULL */
+	int used;			/* bytes in buf */
+	size_t remaining;		/* bytes of a bounded packet still to come */
+	struct pes_header hdr;
+	uint16_t pid;
+	uint8_t continuity;
+	uint8_t wait_pdu;
+	uint8_t have_header;		/* hdr is valid */
+	uint8_t started;		/* a chunk of this packet has been delivered */
+};
+
+struct pes_demux {
+	/* index+1 into pids for each PID, 0 if never seen */
+	uint16_t pid_index[TRANSPORT_MAX_PIDS];
+	struct pes_demux_pid *pids;
+	int pids_alloc;
+
+	/* free list of chunk buffers, chained through their first bytes */
+	uint8_t *free;
+	int chunk_size;
+
+	pes_demux_callback callback;
+	void *arg;
+
+	struct pes_demux_stats stats;
+};
+
+static struct pes_demux_pid *pes_demux_lookup(struct pes_demux *pdemux, int pid);
+static int pes_demux_header(struct pes_demux_pid *p);
+static void pes_demux_deliver(struct pes_demux *pdemux, struct pes_demux_pid *p, int end);
+static void pes_demux_discard(struct pes_demux *pdemux, struct pes_demux_pid *p);
+static uint8_t *pes_demux_buf_get(struct pes_demux *pdemux);
+static void pes_demux_buf_put(struct pes_demux *pdemux, uint8_t *buf);
+
+struct pes_demux *pes_demux_create(int chunk_size,
+				   pes_demux_callback callback,
+				   void *arg)
+{
+	struct pes_demux *pdemux;
+
+	if (chunk_size < PES_DEMUX_MIN_CHUNK_SIZE)
+		return NULL;
+
+	pdemux = (struct pes_demux *) malloc(sizeof(struct pes_demux));
+	if (pdemux == NULL)
+		return NULL;
+	memset(pdemux, 0, sizeof(struct pes_demux));
+	pdemux->chunk_size = chunk_size;
+	pdemux->callback = callback;
+	pdemux->arg = arg;
+
+	return pdemux;
+}
+
+void pes_demux_destroy(struct pes_demux *pdemux)
+{
+	uint8_t *buf;
+	int i;
+
+	for(i=0; i < (int) pdemux->stats.pids; i++) {
+		if (pdemux->pids[i].buf)
+			free(pdemux->pids[i].buf);
+	}
+	while((buf = pdemux->free) != NULL) {
+		memcpy(&pdemux->free, buf, sizeof(uint8_t *));
+		free(buf);
+	}
+	free(pdemux->pids);
+	free(pdemux);
+}
+
+int pes_demux_add_packet(struct pes_demux *pdemux,
+			 struct transport_packet *pkt)
+{
+	struct pes_demux_pid *p;
+	struct transport_values tsvals;
+	int pid = transport_packet_pid(pkt);
+
+	if ((p = pes_demux_lookup(pdemux, pid)) == NULL)
+		return -ENOMEM;
+
+	if (transport_packet_values_extract(pkt, &tsvals, 0) < 0) {
+		pes_demux_reset_pid(pdemux, pid);
+		return -EINVAL;
+	}
+
+	if (transport_packet_continuity_check(pkt,
+					      tsvals.flags & transport_adaptation_flag_discontinuity,
+					      &p->continuity)) {
+		pdemux->stats.continuity_errors++;
+		pes_demux_reset_pid(pdemux, pid);
+		return -EPROTO;
+	}
+
+	if (tsvals.payload_length == 0)
+		return 0;
+
+	return pes_demux_add_payload(pdemux, pid, tsvals.payload, tsvals.payload_length,
+				     pkt->payload_unit_start_indicator);
+}
+
+int pes_demux_add_payload(struct pes_demux *pdemux, int pid,
+			  uint8_t *payload, int len, int pdu_start)
+{
+	struct pes_demux_pid *p;
+	size_t pktlen;
+	int ret;
+	int n;
+
+	if ((p = pes_demux_lookup(pdemux, pid)) == NULL)
+		return -ENOMEM;
+
+	if (pdu_start) {
+		/* a new packet ends an unbounded one, and truncates anything else */
+		if (p->buf || p->started) {
+			if (p->have_header && (p->hdr.packet_length == 0)) {
+				pes_demux_deliver(pdemux, p, 1);
+			} else {
+				pdemux->stats.pes_errors++;
+				pes_demux_discard(pdemux, p);
+			}
+		}
+		p->wait_pdu = 0;
+
+		/* if the whole packet is here, deliver it in place */
+		if ((len >= PES_PACKET_HDR_SIZE) && pes_packet_start_code(payload) &&
+		    ((pktlen = pes_packet_length(payload)) != 0) && (pktlen <= (size_t) len)) {
+			if (pes_header_parse(payload, pktlen, &p->hdr)) {
+				pdemux->stats.pes_errors++;
+				p->wait_pdu = 1;
+				return -EINVAL;
+			}
+			pdemux->stats.packets++;
+			pdemux->stats.direct++;
+			pdemux->callback(pdemux->arg, pid, &p->hdr, payload, pktlen,
+					 pes_demux_flag_start | pes_demux_flag_end |
+					 pes_demux_flag_direct);
+			/* anything after a bounded packet is stuffing */
+			p->wait_pdu = 1;
+			return 0;
+		}
+	} else if (p->wait_pdu) {
+		return 0;
+	}
+
+	while(len) {
+		if ((p->buf == NULL) && ((p->buf = pes_demux_buf_get(pdemux)) == NULL))
+			return -ENOMEM;
+
+		/* a full chunk is only passed on once there is more data, so
+		 * the end of an unbounded packet always comes with some */
+		if (p->used == pdemux->chunk_size)
+			pes_demux_deliver(pdemux, p, 0);
+
+		/* accumulate */
+		n = pdemux->chunk_size - p->used;
+		if (n > len)
+			n = len;
+		if (p->have_header && p->hdr.packet_length && ((size_t) n > p->remaining))
+			n = p->remaining;
+		memcpy(p->buf + p->used, payload, n);
+		p->used += n;
+		payload += n;
+		len -= n;
+		if (p->have_header && p->hdr.packet_length)
+			p->remaining -= n;
+
+		if (!p->have_header) {
+			if ((ret = pes_demux_header(p)) < 0) {
+				pdemux->stats.pes_errors++;
+				pes_demux_discard(pdemux, p);
+				p->wait_pdu = 1;
+				return ret;
+			}
+		}
+
+		if (p->have_header && p->hdr.packet_length && (p->remaining == 0)) {
+			/* anything after a bounded packet is stuffing */
+			pes_demux_deliver(pdemux, p, 1);
+			p->wait_pdu = 1;
+			return 0;
+		}
+	}
+
+	return 0;
+}
+
+void pes_demux_reset_pid(struct pes_demux *pdemux, int pid)
+{
+	struct pes_demux_pid *p;
+
+	if ((pid < 0) || (pid >= TRANSPORT_MAX_PIDS) || (pdemux->pid_index[pid] == 0))
+		return;
+	p = &pdemux->pids[pdemux->pid_index[pid] - 1];
+
+	pes_demux_discard(pdemux, p);
+	p->continuity = 0;
+	p->wait_pdu = 1;
+}
+
+void pes_demux_get_stats(struct pes_demux *pdemux,
+			 struct pes_demux_stats *stats)
+{
+	memcpy(stats, &pdemux->stats, sizeof(struct pes_demux_stats));
+}
+
+static struct pes_demux_pid *pes_demux_lookup(struct pes_demux *pdemux, int pid)
+{
+	struct pes_demux_pid *p;
+
+	if ((pid < 0) || (pid >= TRANSPORT_MAX_PIDS))
+		return NULL;
+	if (pdemux->pid_index[pid])
+		return &pdemux->pids[pdemux->pid_index[pid] - 1];
+
+	/* first time we've seen this PID */
+	if (pdemux->stats.pids == (uint32_t) pdemux->pids_alloc) {
+		int newalloc = pdemux->pids_alloc ? pdemux->pids_alloc * 2 : 16;
+
+		p = (struct pes_demux_pid *)
+			realloc(pdemux->pids, newalloc * sizeof(struct pes_demux_pid));
+		if (p == NULL)
+			return NULL;
+		pdemux->pids = p;
+		pdemux->pids_alloc = newalloc;
+	}
+
+	p = &pdemux->pids[pdemux->stats.pids++];
+	memset(p, 0, sizeof(struct pes_demux_pid));
+	p->pid = pid;
+	p->wait_pdu = 1;
+	pdemux->pid_index[pid] = pdemux->stats.pids;
+
+	return p;
+}
+
+static int pes_demux_header(struct pes_demux_pid *p)
+{
+	size_t hdrlen = PES_PACKET_HDR_SIZE;
+	size_t pktlen;
+
+	/* wait until the whole header is here */
+	if ((p->used >= 3) && !pes_packet_start_code(p->buf))
+		return -EINVAL;
+	if (p->used < PES_PACKET_HDR_SIZE)
+		return 0;
+	if (pes_stream_id_has_header(p->buf[3])) {
+		hdrlen += PES_PACKET_OPT_HDR_SIZE;
+		if ((size_t) p->used < hdrlen)
+			return 0;
+		hdrlen += p->buf[8];
+		if ((size_t) p->used < hdrlen)
+			return 0;
+	}
+
+	if (pes_header_parse(p->buf, p->used, &p->hdr))
+		return -EINVAL;
+	p->have_header = 1;
+
+	/* we may have been given more than a bounded packet before we knew its length */
+	if ((pktlen = pes_packet_length(p->buf)) != 0) {
+		if ((size_t) p->used > pktlen)
+			p->used = pktlen;
+		p->remaining = pktlen - p->used;
+	}
+
+	return 0;
+}
+
+static void pes_demux_deliver(struct pes_demux *pdemux, struct pes_demux_pid *p, int end)
+{
+	uint8_t *buf = p->buf;
+	int flags = 0;
+	int len = p->used;
+
+	if (!p->started)
+		flags |= pes_demux_flag_start;
+	if (end) {
+		flags |= pes_demux_flag_end;
+		if (p->started)
+			pdemux->stats.chunks++;
+		pdemux->stats.packets++;
+
+		/* detach it first, so the callback may reset the PID */
+		p->buf = NULL;
+		p->used = 0;
+		p->started = 0;
+		p->have_header = 0;
+	} else {
+		pdemux->stats.chunks++;
+		p->used = 0;
+		p->started = 1;
+	}
+
+	pdemux->callback(pdemux->arg, p->pid, &p->hdr, buf, len, flags);
+
+	if (end && buf)
+		pes_demux_buf_put(pdemux, buf);
+}
+
+static void pes_demux_discard(struct pes_demux *pdemux, struct pes_demux_pid *p)
+{
+	if (p->buf)
+		pes_demux_buf_put(pdemux, p->buf);
+	p->buf = NULL;
+	p->used = 0;
+	p->started = 0;
+	p->have_header = 0;
+}
+
+static uint8_t *pes_demux_buf_get(struct pes_demux *pdemux)
+{
+	uint8_t *buf;
+
+	if ((buf = pdemux->free) != NULL) {
+		memcpy(&pdemux->free, buf, sizeof(uint8_t *));
+	} else {
+		if ((buf = (uint8_t *) malloc(pdemux->chunk_size)) == NULL)
+			return NULL;
+		pdemux->stats.buffers++;
+	}
+	pdemux->stats.buffers_in_use++;
+
+	return buf;
+}
+
+static void pes_demux_buf_put(struct pes_demux *pdemux, uint8_t *buf)
+{
+	memcpy(buf, &pdemux->free, sizeof(uint8_t *));
+	pdemux->free = buf;
+	pdemux->stats.buffers_in_use--;
+}
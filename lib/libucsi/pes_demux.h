@@ -0,0 +1,171 @@
+/**
+ * PES packet reassembly from transport stream packets.
+ *
+ * Copyright (c) 2026 by agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef _UCSI_PES_DEMUX_H
+#define _UCSI_PES_DEMUX_H 1
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <libucsi/pes_packet.h>
+#include <libucsi/transport_packet.h>
+
+/**
+ * Smallest chunk size a pes_demux may be created with: enough to hold any
+ * PES header.
+ */
+#define PES_DEMUX_MIN_CHUNK_SIZE 512
+
+/**
+ * Chunk size at which any bounded PES packet is delivered whole.
+ */
+#define PES_DEMUX_MAX_PACKET_SIZE (PES_PACKET_HDR_SIZE + 0xffff)
+
+/**
+ * Flags passed to a pes_demux_callback.
+ */
+enum pes_demux_flags {
+	pes_demux_flag_start	= 0x01, /* data starts with the PES header */
+	pes_demux_flag_end	= 0x02, /* data ends the PES packet */
+	pes_demux_flag_direct	= 0x04, /* data is in place in the TS packet */
+};
+
+/**
+ * Statistics maintained by a pes_demux.
+ */
+struct pes_demux_stats {
+	uint32_t pids;			/* number of PIDs tracked */
+	uint32_t buffers;		/* number of chunk buffers allocated */
+	uint32_t buffers_in_use;	/* number of buffers holding a partial packet */
+	uint64_t packets;		/* complete PES packets delivered */
+	uint64_t direct;		/* of which were delivered in place */
+	uint64_t chunks;		/* partial chunks delivered */
+	uint64_t continuity_errors;	/* TS packets discarded due to continuity errors */
+	uint64_t pes_errors;		/* PES packets discarded as invalid or truncated */
+};
+
+/**
+ * Callback receiving PES data. A PES packet is delivered either whole (both
+ * pes_demux_flag_start and pes_demux_flag_end set) or as a series of chunks
+ * if it is larger than the chunk size or unbounded (PES_packet_length of 0,
+ * as used for video); the end of an unbounded packet is only known when the
+ * next one starts. Every call carries at least one byte of data: a chunk is
+ * held back until more data arrives, so the last one of an unbounded packet
+ * can still be flagged with pes_demux_flag_end.
+ *
+ * The data is only valid for the duration of the call. The callback may
+ * call pes_demux_reset_pid(), but must not feed more data into the
+ * pes_demux.
+ *
+ * @param arg Private argument supplied to pes_demux_create().
+ * @param pid PID the data was received on.
+ * @param hdr The decoded header of the PES packet the data belongs to. The
+ * payload starts hdr->header_length bytes into the first chunk.
+ * @param data Pointer to the data.
+ * @param len Length of the data.
+ * @param flags Combination of pes_demux_flags.
+ */
+typedef void (*pes_demux_callback)(void *arg, int pid, struct pes_header *hdr,
+				   uint8_t *data, int len, int flags);
+
+/**
+ * Opaque type representing a multi-PID PES reassembly context.
+ *
+ * As with section_demux, per-PID state is only created for PIDs which are
+ * fed in. Each PID holds one chunk buffer from a shared pool while a packet
+ * is being received. A PES packet contained within one TS packet is
+ * delivered in place without being copied.
+ */
+struct pes_demux;
+
+/**
+ * Create a new pes_demux.
+ *
+ * @param chunk_size Size of the reassembly buffers, at least
+ * PES_DEMUX_MIN_CHUNK_SIZE. Use PES_DEMUX_MAX_PACKET_SIZE to receive all
+ * bounded packets (e.g. audio, subtitles, teletext) whole.
+ * @param callback Callback to receive PES data.
+ * @param arg Private argument to pass to the callback.
+ * @return The new instance, or NULL on error.
+ */
+extern struct pes_demux *pes_demux_create(int chunk_size,
+					  pes_demux_callback callback,
+					  void *arg);
+
+/**
+ * Destroy a pes_demux, freeing all its buffers.
+ *
+ * @param pdemux The instance to destroy.
+ */
+extern void pes_demux_destroy(struct pes_demux *pdemux);
+
+/**
+ * Process a transport packet. The continuity counter is checked, and any
+ * partial PES packet is discarded on error.
+ *
+ * @param pdemux The pes_demux.
+ * @param pkt The transport packet (already validated by transport_packet_init()).
+ * @return 0 on success, -EPROTO on a continuity error, or another negative
+ * error code if the packet or PES data in it was invalid.
+ */
+extern int pes_demux_add_packet(struct pes_demux *pdemux,
+				struct transport_packet *pkt);
+
+/**
+ * Process a transport packet payload for a PID. No continuity checking
+ * is performed.
+ *
+ * @param pdemux The pes_demux.
+ * @param pid PID the payload belongs to.
+ * @param payload Pointer to the payload data.
+ * @param len Number of bytes of payload.
+ * @param pdu_start True if the payload_unit_start_indicator flag was set in the
+ * TS packet.
+ * @return 0 on success, nonzero on error.
+ */
+extern int pes_demux_add_payload(struct pes_demux *pdemux, int pid,
+				 uint8_t *payload, int len, int pdu_start);
+
+/**
+ * Discard any partial PES packet for a PID, returning its buffer to the
+ * pool. The PID will wait for the next PDU start.
+ *
+ * @param pdemux The pes_demux.
+ * @param pid The PID.
+ */
+extern void pes_demux_reset_pid(struct pes_demux *pdemux, int pid);
+
+/**
+ * Retrieve the statistics of a pes_demux.
+ *
+ * @param pdemux The pes_demux.
+ * @param stats Where to put the statistics.
+ */
+extern void pes_demux_get_stats(struct pes_demux *pdemux,
+				struct pes_demux_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
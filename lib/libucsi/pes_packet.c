@@ -0,0 +1,115 @@
+/**
+ * PES packet header parser.
+ *
+ * Copyright (c) 2026 by agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include "pes_packet.h"
+
+static inline uint64_t pes_timestamp(const uint8_t *buf)
+{
+	return (((uint64_t) (buf[0] & 0x0e)) << 29) |
+		(buf[1] << 22) |
+		((buf[2] & 0xfe) << 14) |
+		(buf[3] << 7) |
+		(buf[4] >> 1);
+}
+
+int pes_header_parse(const uint8_t *buf, size_t len, struct pes_header *hdr)
+{
+	const uint8_t *opt;
+	const uint8_t *end;
+	uint8_t opt_flags;
+
+	if (len < PES_PACKET_HDR_SIZE)
+		return -1;
+	if (!pes_packet_start_code(buf))
+		return -1;
+
+	hdr->stream_id = buf[3];
+	hdr->packet_length = (buf[4] << 8) | buf[5];
+	hdr->header_length = PES_PACKET_HDR_SIZE;
+	hdr->flags = 0;
+	hdr->scrambling_control = 0;
+	if (!pes_stream_id_has_header(hdr->stream_id))
+		return 0;
+
+	/* the optional header */
+	if (len < (PES_PACKET_HDR_SIZE + PES_PACKET_OPT_HDR_SIZE))
+		return -1;
+	opt = buf + PES_PACKET_HDR_SIZE;
+	if ((opt[0] & 0xc0) != 0x80)
+		return -1;
+	hdr->header_length = PES_PACKET_HDR_SIZE + PES_PACKET_OPT_HDR_SIZE + opt[2];
+	if ((len < hdr->header_length) ||
+	    (hdr->packet_length && ((hdr->header_length - PES_PACKET_HDR_SIZE) > hdr->packet_length)))
+		return -1;
+	end = buf + hdr->header_length;
+
+	hdr->scrambling_control = (opt[0] >> 4) & 3;
+	if (opt[0] & 0x08)
+		hdr->flags |= pes_header_flag_priority;
+	if (opt[0] & 0x04)
+		hdr->flags |= pes_header_flag_data_alignment;
+	if (opt[0] & 0x02)
+		hdr->flags |= pes_header_flag_copyright;
+	if (opt[0] & 0x01)
+		hdr->flags |= pes_header_flag_original;
+
+	/* the optional fields come in a fixed order */
+	opt_flags = opt[1];
+	opt += PES_PACKET_OPT_HDR_SIZE;
+	/* PTS_DTS_flags of 01 is forbidden */
+	if ((opt_flags & 0xc0) == 0x40)
+		return -1;
+	if (opt_flags & 0x80) {
+		if ((opt + 5) > end)
+			return -1;
+		hdr->pts = pes_timestamp(opt);
+		hdr->flags |= pes_header_flag_pts;
+		opt += 5;
+	}
+	if ((opt_flags & 0xc0) == 0xc0) {
+		if ((opt + 5) > end)
+			return -1;
+		hdr->dts = pes_timestamp(opt);
+		hdr->flags |= pes_header_flag_dts;
+		opt += 5;
+	}
+	if (opt_flags & 0x20) {
+		if ((opt + 6) > end)
+			return -1;
+		hdr->escr_base = (((uint64_t) (opt[0] & 0x38)) << 27) |
+			((opt[0] & 0x03) << 28) |
+			(opt[1] << 20) |
+			((opt[2] & 0xf8) << 12) |
+			((opt[2] & 0x03) << 13) |
+			(opt[3] << 5) |
+			(opt[4] >> 3);
+		hdr->escr_extension = ((opt[4] & 0x03) << 7) | (opt[5] >> 1);
+		hdr->flags |= pes_header_flag_escr;
+		opt += 6;
+	}
+	if (opt_flags & 0x10) {
+		if ((opt + 3) > end)
+			return -1;
+		hdr->es_rate = ((opt[0] & 0x7f) << 15) | (opt[1] << 7) | (opt[2] >> 1);
+		hdr->flags |= pes_header_flag_es_rate;
+	}
+
+	return 0;
+}
@@ -0,0 +1,160 @@
+/**
+ * PES packet header parser.
+ *
+ * Copyright (c) 2026 by agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef _UCSI_PES_PACKET_H
+#define _UCSI_PES_PACKET_H 1
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * Size of the fixed PES packet header (start code, stream_id, length).
+ */
+#define PES_PACKET_HDR_SIZE 6
+
+/**
+ * Size of the fixed part of the optional PES header.
+ */
+#define PES_PACKET_OPT_HDR_SIZE 3
+
+/**
+ * Largest possible PES header, including all optional fields and stuffing.
+ */
+#define PES_PACKET_MAX_HDR_SIZE (PES_PACKET_HDR_SIZE + PES_PACKET_OPT_HDR_SIZE + 255)
+
+/**
+ * Enumeration of special PES stream_id values.
+ */
+enum pes_stream_id {
+	pes_stream_id_program_stream_map	= 0xbc,
+	pes_stream_id_private_stream_1		= 0xbd,
+	pes_stream_id_padding			= 0xbe,
+	pes_stream_id_private_stream_2		= 0xbf,
+	pes_stream_id_audio			= 0xc0, /* 0xc0->0xdf */
+	pes_stream_id_video			= 0xe0, /* 0xe0->0xef */
+	pes_stream_id_ecm			= 0xf0,
+	pes_stream_id_emm			= 0xf1,
+	pes_stream_id_dsmcc			= 0xf2,
+	pes_stream_id_h222_1_type_e		= 0xf8,
+	pes_stream_id_program_stream_directory	= 0xff,
+};
+
+/**
+ * Flags indicating which fields of a pes_header are present.
+ */
+enum pes_header_flags {
+	pes_header_flag_pts			= 0x01,
+	pes_header_flag_dts			= 0x02,
+	pes_header_flag_escr			= 0x04,
+	pes_header_flag_es_rate			= 0x08,
+	pes_header_flag_data_alignment		= 0x10,
+	pes_header_flag_priority		= 0x20,
+	pes_header_flag_copyright		= 0x40,
+	pes_header_flag_original		= 0x80,
+};
+
+/**
+ * Decoded values from a PES packet header. The packet itself is not
+ * modified or copied; the payload begins header_length bytes into it.
+ */
+struct pes_header {
+	uint8_t stream_id;
+	uint8_t flags;			/* pes_header_flags */
+	uint8_t scrambling_control;
+	uint16_t packet_length;		/* PES_packet_length: 0 if unbounded */
+	uint16_t header_length;		/* offset of the payload in the packet */
+	uint64_t pts;			/* 90kHz */
+	uint64_t dts;			/* 90kHz */
+	uint64_t escr_base;		/* 90kHz */
+	uint16_t escr_extension;	/* 27MHz remainder */
+	uint32_t es_rate;		/* units of 50 bytes/s */
+};
+
+/**
+ * Parse the header of a PES packet.
+ *
+ * @param buf Pointer to the start of the PES packet.
+ * @param len Number of bytes available at buf; this must include the whole
+ * header, but need not include all of the payload.
+ * @param hdr Where to put the decoded values.
+ * @return 0 on success, or -1 if the header is invalid or truncated.
+ */
+extern int pes_header_parse(const uint8_t *buf, size_t len, struct pes_header *hdr);
+
+/**
+ * Determine if a PES stream_id carries the optional PES header.
+ *
+ * @param stream_id The stream_id.
+ * @return Nonzero if it does.
+ */
+static inline int pes_stream_id_has_header(uint8_t stream_id)
+{
+	switch(stream_id) {
+	case pes_stream_id_program_stream_map:
+	case pes_stream_id_padding:
+	case pes_stream_id_private_stream_2:
+	case pes_stream_id_ecm:
+	case pes_stream_id_emm:
+	case pes_stream_id_dsmcc:
+	case pes_stream_id_h222_1_type_e:
+	case pes_stream_id_program_stream_directory:
+		return 0;
+	}
+
+	return 1;
+}
+
+/**
+ * Determine the total length of a bounded PES packet from its first bytes.
+ *
+ * @param buf Pointer to the start of the PES packet (at least
+ * PES_PACKET_HDR_SIZE bytes).
+ * @return The length including the header, or 0 if the packet is unbounded.
+ */
+static inline size_t pes_packet_length(const uint8_t *buf)
+{
+	size_t len = (buf[4] << 8) | buf[5];
+
+	if (len == 0)
+		return 0;
+	return PES_PACKET_HDR_SIZE + len;
+}
+
+/**
+ * Determine if a buffer starts with a PES packet_start_code_prefix.
+ *
+ * @param buf Pointer to the data (at least 3 bytes).
+ * @return Nonzero if it does.
+ */
+static inline int pes_packet_start_code(const uint8_t *buf)
+{
+	return (buf[0] == 0x00) && (buf[1] == 0x00) && (buf[2] == 0x01);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
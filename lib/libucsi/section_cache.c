@@ -0,0 +1,256 @@
+/*
+ * duplicate section cache
+ *
+ * Copyright (C) 2026 agent (agent@local)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "section_view.h"
+#include "section_cache.h"
+
+#define NIL -1
+
+struct section_cache_entry {
+	uint64_t key;		/* pid, table_id, table_id_ext, section_number */
+	uint32_t crc;
+	int32_t hash_next;	/* next entry in hash chain, or free list */
+	int32_t lru_prev;	/* towards the most recently used */
+	int32_t lru_next;	/* towards the least recently used */
+};
+
+struct section_cache {
+	struct section_cache_entry *entries;
+	int32_t *buckets;
+	uint32_t mask;
+
+	int32_t lru_head;
+	int32_t lru_tail;
+	int32_t free;
+
+	struct section_cache_stats stats;
+};
+
+static int section_cache_key(int pid, const uint8_t *buf, size_t len,
+			     uint64_t *key, uint32_t *crc);
+static int32_t section_cache_lookup(struct section_cache *cache, uint64_t key, int32_t **link);
+static void section_cache_lru_unlink(struct section_cache *cache, int32_t idx);
+static void section_cache_lru_push(struct section_cache *cache, int32_t idx);
+
+static inline uint32_t section_cache_hash(uint64_t key)
+{
+	return (uint32_t) ((key * 0x9e3779b97f4a7c15ULL) >> 32);
+}
+
+struct section_cache *section_cache_create(int max_entries)
+{
+	struct section_cache *cache;
+	uint32_t nbuckets = 1;
+
+	if (max_entries <= 0)
+		return NULL;
+	while (nbuckets < (uint32_t) max_entries)
+		nbuckets <<= 1;
+
+	cache = (struct section_cache *) malloc(sizeof(struct section_cache));
+	if (cache == NULL)
+		return NULL;
+	memset(cache, 0, sizeof(struct section_cache));
+
+	cache->entries = (struct section_cache_entry *)
+		malloc(max_entries * sizeof(struct section_cache_entry));
+	cache->buckets = (int32_t *) malloc(nbuckets * sizeof(int32_t));
+	if ((cache->entries == NULL) || (cache->buckets == NULL)) {
+		section_cache_destroy(cache);
+		return NULL;
+	}
+	cache->mask = nbuckets - 1;
+	cache->stats.max_entries = max_entries;
+	section_cache_clear(cache);
+
+	return cache;
+}
+
+void section_cache_destroy(struct section_cache *cache)
+{
+	free(cache->entries);
+	free(cache->buckets);
+	free(cache);
+}
+
+int section_cache_check(struct section_cache *cache, int pid,
+			const uint8_t *buf, size_t len)
+{
+	struct section_cache_entry *entry;
+	uint64_t key;
+	uint32_t crc;
+	int32_t *link;
+	int32_t idx;
+
+	if (section_cache_key(pid, buf, len, &key, &crc)) {
+		cache->stats.misses++;
+		return 0;
+	}
+
+	/* seen this section before? if its CRC has changed, it is a new version */
+	idx = section_cache_lookup(cache, key, &link);
+	if (idx != NIL) {
+		section_cache_lru_unlink(cache, idx);
+		section_cache_lru_push(cache, idx);
+		entry = &cache->entries[idx];
+		if (entry->crc == crc) {
+			cache->stats.hits++;
+			return 1;
+		}
+		entry->crc = crc;
+		cache->stats.misses++;
+		cache->stats.changes++;
+		return 0;
+	}
+	cache->stats.misses++;
+
+	/* get a free entry, or evict the least recently used one */
+	if (cache->free != NIL) {
+		idx = cache->free;
+		cache->free = cache->entries[idx].hash_next;
+		cache->stats.entries++;
+	} else {
+		idx = cache->lru_tail;
+		entry = &cache->entries[idx];
+		section_cache_lookup(cache, entry->key, &link);
+		*link = entry->hash_next;
+		section_cache_lru_unlink(cache, idx);
+		cache->stats.evictions++;
+	}
+
+	/* add it */
+	entry = &cache->entries[idx];
+	entry->key = key;
+	entry->crc = crc;
+	link = &cache->buckets[section_cache_hash(key) & cache->mask];
+	entry->hash_next = *link;
+	*link = idx;
+	section_cache_lru_push(cache, idx);
+
+	return 0;
+}
+
+void section_cache_remove(struct section_cache *cache, int pid,
+			  const uint8_t *buf, size_t len)
+{
+	uint64_t key;
+	uint32_t crc;
+	int32_t *link;
+	int32_t idx;
+
+	if (section_cache_key(pid, buf, len, &key, &crc))
+		return;
+	if ((idx = section_cache_lookup(cache, key, &link)) == NIL)
+		return;
+	if (cache->entries[idx].crc != crc)
+		return;
+
+	*link = cache->entries[idx].hash_next;
+	section_cache_lru_unlink(cache, idx);
+	cache->entries[idx].hash_next = cache->free;
+	cache->free = idx;
+	cache->stats.entries--;
+}
+
+void section_cache_clear(struct section_cache *cache)
+{
+	uint32_t i;
+
+	for(i=0; i <= cache->mask; i++)
+		cache->buckets[i] = NIL;
+
+	for(i=0; i < cache->stats.max_entries; i++)
+		cache->entries[i].hash_next = i + 1;
+	cache->entries[cache->stats.max_entries - 1].hash_next = NIL;
+	cache->free = 0;
+
+	cache->lru_head = NIL;
+	cache->lru_tail = NIL;
+	cache->stats.entries = 0;
+}
+
+void section_cache_get_stats(struct section_cache *cache,
+			     struct section_cache_stats *stats)
+{
+	memcpy(stats, &cache->stats, sizeof(struct section_cache_stats));
+}
+
+static int section_cache_key(int pid, const uint8_t *buf, size_t len,
+			     uint64_t *key, uint32_t *crc)
+{
+	if (section_view_check(buf, len) || section_view_ext_check(buf, 0))
+		return -1;
+
+	*key = ((uint64_t) (pid & 0x1fff) << 32) |
+	       ((uint64_t) section_view_table_id(buf) << 24) |
+	       ((uint64_t) section_view_table_id_ext(buf) << 8) |
+	       section_view_section_number(buf);
+	*crc = section_view_crc32(buf);
+
+	return 0;
+}
+
+static int32_t section_cache_lookup(struct section_cache *cache, uint64_t key, int32_t **link)
+{
+	struct section_cache_entry *entry;
+	int32_t *pos = &cache->buckets[section_cache_hash(key) & cache->mask];
+
+	while (*pos != NIL) {
+		entry = &cache->entries[*pos];
+		if (entry->key == key) {
+			*link = pos;
+			return *pos;
+		}
+		pos = &entry->hash_next;
+	}
+
+	*link = pos;
+	return NIL;
+}
+
+static void section_cache_lru_unlink(struct section_cache *cache, int32_t idx)
+{
+	struct section_cache_entry *entry = &cache->entries[idx];
+
+	if (entry->lru_prev != NIL)
+		cache->entries[entry->lru_prev].lru_next = entry->lru_next;
+	else
+		cache->lru_head = entry->lru_next;
+
+	if (entry->lru_next != NIL)
+		cache->entries[entry->lru_next].lru_prev = entry->lru_prev;
+	else
+		cache->lru_tail = entry->lru_prev;
+}
+
+static void section_cache_lru_push(struct section_cache *cache, int32_t idx)
+{
+	struct section_cache_entry *entry = &cache->entries[idx];
+
+	entry->lru_prev = NIL;
+	entry->lru_next = cache->lru_head;
+	if (cache->lru_head != NIL)
+		cache->entries[cache->lru_head].lru_prev = idx;
+	else
+		cache->lru_tail = idx;
+	cache->lru_head = idx;
+}
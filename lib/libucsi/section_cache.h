@@ -0,0 +1,125 @@
+/*
+ * duplicate section cache
+ *
+ * Copyright (C) 2026 agent (agent@local)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef _UCSI_SECTION_CACHE_H
+#define _UCSI_SECTION_CACHE_H 1
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * Statistics maintained by a section_cache.
+ */
+struct section_cache_stats {
+	uint64_t hits;		/* sections found to be duplicates */
+	uint64_t misses;	/* sections which were new or changed */
+	uint64_t changes;	/* sections which replaced an older version */
+	uint64_t evictions;	/* entries discarded to make room */
+	uint32_t entries;	/* entries currently in the cache */
+	uint32_t max_entries;	/* maximum number of entries */
+};
+
+/**
+ * Opaque type representing a duplicate section cache.
+ *
+ * SI tables are retransmitted continuously, almost always unchanged. The
+ * cache remembers the CRC32 of the last version seen of each recent
+ * extended section, keyed on (PID, table_id, table_id_ext, section_number),
+ * so repeats can be rejected in O(1) straight from the raw section, before
+ * any parsing or CRC calculation. A section whose CRC differs replaces the
+ * remembered version, so a change back to an earlier version is seen too.
+ * Memory use is fixed at creation; the least recently seen entry is
+ * discarded when it is full.
+ */
+struct section_cache;
+
+/**
+ * Create a new section_cache.
+ *
+ * @param max_entries Maximum number of sections to remember.
+ * @return The new instance, or NULL on error.
+ */
+extern struct section_cache *section_cache_create(int max_entries);
+
+/**
+ * Destroy a section_cache.
+ *
+ * @param cache The instance to destroy.
+ */
+extern void section_cache_destroy(struct section_cache *cache);
+
+/**
+ * Check if a raw (not yet decoded) section is the same version as the last
+ * one seen with its PID, table_id, table_id_ext and section_number, and
+ * remember it if not. Note the CRC is not verified: a section that turns
+ * out to be corrupt should be removed with section_cache_remove().
+ *
+ * Sections without the syntax_indicator set carry no CRC, so they are never
+ * reported as duplicates.
+ *
+ * @param cache The section_cache.
+ * @param pid PID the section was received on.
+ * @param buf Pointer to the raw section.
+ * @param len Length of the section.
+ * @return 1 if the section is an unchanged duplicate, 0 if it is new or
+ * has changed.
+ */
+extern int section_cache_check(struct section_cache *cache, int pid,
+			       const uint8_t *buf, size_t len);
+
+/**
+ * Remove a raw section from the cache, so it will be reported as new next
+ * time it is seen. Nothing is removed if the cache holds a different version
+ * of the section.
+ *
+ * @param cache The section_cache.
+ * @param pid PID the section was received on.
+ * @param buf Pointer to the raw section.
+ * @param len Length of the section.
+ */
+extern void section_cache_remove(struct section_cache *cache, int pid,
+				 const uint8_t *buf, size_t len);
+
+/**
+ * Empty the cache (e.g. after a retune). The statistics are not reset.
+ *
+ * @param cache The section_cache.
+ */
+extern void section_cache_clear(struct section_cache *cache);
+
+/**
+ * Retrieve the statistics of a section_cache.
+ *
+ * @param cache The section_cache.
+ * @param stats Where to put the statistics.
+ */
+extern void section_cache_get_stats(struct section_cache *cache,
+				    struct section_cache_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,269 @@
+/**
+ * PSI/SI table carousel.
+ *
+ * Copyright (c) 2026 by agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "section_packetizer.h"
+#include "section_carousel.h"
+
+struct section_carousel_table {
+	uint16_t pid;
+	uint8_t in_use;
+	uint64_t interval;
+	uint64_t due;
+	uint8_t *packets;
+	int npackets;
+	int max_packets;
+};
+
+struct section_carousel {
+	struct section_carousel_table *tables;
+	int ntables;			/* slots used, including removed ones */
+	int max_tables;
+
+	int current;			/* table being output, or -1 */
+	int position;			/* next packet of the current table */
+
+	struct section_carousel_stats stats;
+	uint8_t continuity_counter[TRANSPORT_MAX_PIDS];
+};
+
+static int section_carousel_packetize(struct section_carousel_table *table,
+				      const uint8_t *sections, size_t len);
+
+struct section_carousel *section_carousel_create(void)
+{
+	struct section_carousel *sc;
+
+	sc = (struct section_carousel *) malloc(sizeof(struct section_carousel));
+	if (sc == NULL)
+		return NULL;
+	memset(sc, 0, sizeof(struct section_carousel));
+	sc->current = -1;
+
+	return sc;
+}
+
+void section_carousel_destroy(struct section_carousel *sc)
+{
+	int i;
+
+	for(i=0; i < sc->ntables; i++)
+		free(sc->tables[i].packets);
+	free(sc->tables);
+	free(sc);
+}
+
+int section_carousel_add_table(struct section_carousel *sc, int pid,
+			       const uint8_t *sections, size_t len,
+			       uint64_t interval, uint64_t now)
+{
+	struct section_carousel_table *table;
+	int id;
+	int ret;
+
+	/* reuse a free slot if there is one */
+	for(id=0; id < sc->ntables; id++) {
+		if (!sc->tables[id].in_use)
+			break;
+	}
+	if (id == sc->ntables) {
+		if (sc->ntables == sc->max_tables) {
+			int newmax = sc->max_tables ? sc->max_tables * 2 : 8;
+
+			table = (struct section_carousel_table *)
+				realloc(sc->tables, newmax * sizeof(struct section_carousel_table));
+			if (table == NULL)
+				return -ENOMEM;
+			sc->tables = table;
+			sc->max_tables = newmax;
+		}
+		memset(&sc->tables[id], 0, sizeof(struct section_carousel_table));
+		sc->ntables++;
+	}
+
+	table = &sc->tables[id];
+	table->pid = pid & 0x1fff;
+	table->interval = interval;
+	table->due = now;
+	table->npackets = 0;
+	if ((ret = section_carousel_packetize(table, sections, len)) < 0)
+		return ret;
+	table->in_use = 1;
+	sc->stats.tables++;
+
+	return id;
+}
+
+int section_carousel_update_table(struct section_carousel *sc, int id,
+				  const uint8_t *sections, size_t len)
+{
+	int ret;
+
+	if ((id < 0) || (id >= sc->ntables) || !sc->tables[id].in_use)
+		return -EINVAL;
+	if ((ret = section_carousel_packetize(&sc->tables[id], sections, len)) < 0)
+		return ret;
+
+	if (sc->current == id)
+		sc->current = -1;
+
+	return 0;
+}
+
+int section_carousel_remove_table(struct section_carousel *sc, int id)
+{
+	if ((id < 0) || (id >= sc->ntables) || !sc->tables[id].in_use)
+		return -EINVAL;
+
+	sc->tables[id].in_use = 0;
+	sc->stats.tables--;
+	if (sc->current == id)
+		sc->current = -1;
+
+	return 0;
+}
+
+int section_carousel_next_packet(struct section_carousel *sc, uint64_t now,
+				 uint8_t *pkt)
+{
+	struct section_carousel_table *table;
+	uint8_t *cc;
+	int i;
+
+	/* choose the next table if we're not part way through one */
+	if (sc->current == -1) {
+		for(i=0; i < sc->ntables; i++) {
+			table = &sc->tables[i];
+			if ((!table->in_use) || (table->due > now))
+				continue;
+			if ((sc->current == -1) || (table->due < sc->tables[sc->current].due))
+				sc->current = i;
+		}
+		if (sc->current == -1)
+			return 0;
+
+		table = &sc->tables[sc->current];
+		if (now > table->due) {
+			sc->stats.late++;
+			if ((now - table->due) > sc->stats.max_lateness)
+				sc->stats.max_lateness = now - table->due;
+		}
+
+		/* if we've fallen behind, don't try to catch up with a burst */
+		table->due += table->interval;
+		if (table->due <= now)
+			table->due = now + table->interval;
+		sc->position = 0;
+	}
+	table = &sc->tables[sc->current];
+
+	memcpy(pkt, table->packets + (sc->position * TRANSPORT_PACKET_LENGTH),
+	       TRANSPORT_PACKET_LENGTH);
+	cc = &sc->continuity_counter[table->pid];
+	section_packetizer_set_cc(pkt, *cc);
+	*cc = (*cc + 1) & 0x0f;
+	sc->stats.packets++;
+
+	if (++sc->position == table->npackets) {
+		sc->current = -1;
+		sc->stats.repetitions++;
+	}
+
+	return 1;
+}
+
+int section_carousel_next_due(struct section_carousel *sc, uint64_t now,
+			      uint64_t *due)
+{
+	int found = 0;
+	int i;
+
+	if (sc->current != -1) {
+		*due = now;
+		return 0;
+	}
+
+	for(i=0; i < sc->ntables; i++) {
+		if (!sc->tables[i].in_use)
+			continue;
+		if ((!found) || (sc->tables[i].due < *due))
+			*due = sc->tables[i].due;
+		found = 1;
+	}
+	if (found && (*due < now))
+		*due = now;
+
+	return found ? 0 : -1;
+}
+
+void section_carousel_get_stats(struct section_carousel *sc,
+				struct section_carousel_stats *stats)
+{
+	memcpy(stats, &sc->stats, sizeof(struct section_carousel_stats));
+}
+
+static int section_carousel_packetize(struct section_carousel_table *table,
+				      const uint8_t *sections, size_t len)
+{
+	struct section_packetizer sp;
+	size_t pos;
+	size_t section_len;
+	int max_packets = 1;
+	int npackets = 0;
+	int ret;
+
+	/* check the sections and work out the most packets they could need */
+	for(pos = 0; pos < len; pos += section_len) {
+		if ((len - pos) < 3)
+			return -EINVAL;
+		section_len = 3 + (((sections[pos + 1] & 0x0f) << 8) | sections[pos + 2]);
+		if ((section_len > (len - pos)) || (section_len > DVB_MAX_SECTION_BYTES))
+			return -EINVAL;
+		max_packets += SECTION_PACKETIZER_MAX_PACKETS(section_len);
+	}
+	if (len == 0)
+		return -EINVAL;
+
+	if (max_packets > table->max_packets) {
+		uint8_t *tmp = (uint8_t *) realloc(table->packets,
+						   max_packets * TRANSPORT_PACKET_LENGTH);
+		if (tmp == NULL)
+			return -ENOMEM;
+		table->packets = tmp;
+		table->max_packets = max_packets;
+	}
+
+	/* the continuity_counter is filled in as the packets are sent */
+	section_packetizer_init(&sp, table->pid, section_packetizer_flag_pack);
+	for(pos = 0; pos < len; pos += section_len) {
+		section_len = 3 + (((sections[pos + 1] & 0x0f) << 8) | sections[pos + 2]);
+		ret = section_packetizer_add(&sp, sections + pos, section_len,
+					     table->packets + (npackets * TRANSPORT_PACKET_LENGTH));
+		if (ret < 0)
+			return ret;
+		npackets += ret;
+	}
+	npackets += section_packetizer_flush(&sp, table->packets + (npackets * TRANSPORT_PACKET_LENGTH));
+	table->npackets = npackets;
+
+	return 0;
+}
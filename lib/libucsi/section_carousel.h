@@ -0,0 +1,149 @@
+/**
+ * PSI/SI table carousel.
+ *
+ * Copyright (c) 2026 by agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef _UCSI_SECTION_CAROUSEL_H
+#define _UCSI_SECTION_CAROUSEL_H 1
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * Statistics maintained by a section_carousel.
+ */
+struct section_carousel_stats {
+	uint32_t tables;		/* number of tables in the carousel */
+	uint64_t packets;		/* packets output */
+	uint64_t repetitions;		/* complete tables output */
+	uint64_t late;			/* tables started after they were due */
+	uint64_t max_lateness;		/* worst lateness, in the caller's time units */
+};
+
+/**
+ * Opaque type representing a PSI/SI carousel.
+ *
+ * Tables are packetized once when they are added or updated, and then
+ * replayed at their repetition interval. Output is pulled a packet at a
+ * time by the multiplexer with section_carousel_next_packet(), which copies
+ * a prepared packet and fixes up its continuity_counter, so nothing is
+ * allocated in the output path. Tables on the same PID share a
+ * continuity_counter.
+ *
+ * Times are in whatever monotonic unit the caller chooses (e.g. 27MHz
+ * ticks, or a count of output packets), as long as it is consistent.
+ * When several tables are due, the one which has been due longest goes
+ * first; all the packets of a table are sent before starting another.
+ */
+struct section_carousel;
+
+/**
+ * Create a new section_carousel.
+ *
+ * @return The new instance, or NULL on error.
+ */
+extern struct section_carousel *section_carousel_create(void);
+
+/**
+ * Destroy a section_carousel.
+ *
+ * @param sc The instance to destroy.
+ */
+extern void section_carousel_destroy(struct section_carousel *sc);
+
+/**
+ * Add a table to the carousel. It is first due at now.
+ *
+ * @param sc The section_carousel.
+ * @param pid PID to send the table on.
+ * @param sections The encoded sections of the table, one after the other.
+ * @param len Total length of the sections.
+ * @param interval Repetition interval.
+ * @param now The current time.
+ * @return An identifier for the table (>= 0), or < 0 on error.
+ */
+extern int section_carousel_add_table(struct section_carousel *sc, int pid,
+				      const uint8_t *sections, size_t len,
+				      uint64_t interval, uint64_t now);
+
+/**
+ * Replace the sections of a table (e.g. with a new version). If the table
+ * is being output, the rest of the old version is dropped. The repetition
+ * schedule is unchanged.
+ *
+ * @param sc The section_carousel.
+ * @param id Identifier of the table.
+ * @param sections The encoded sections of the table, one after the other.
+ * @param len Total length of the sections.
+ * @return 0 on success, or < 0 on error (the old version is kept).
+ */
+extern int section_carousel_update_table(struct section_carousel *sc, int id,
+					 const uint8_t *sections, size_t len);
+
+/**
+ * Remove a table from the carousel.
+ *
+ * @param sc The section_carousel.
+ * @param id Identifier of the table.
+ * @return 0 on success, or < 0 on error.
+ */
+extern int section_carousel_remove_table(struct section_carousel *sc, int id);
+
+/**
+ * Retrieve the next packet to output.
+ *
+ * @param sc The section_carousel.
+ * @param now The current time.
+ * @param pkt Where to put the packet (TRANSPORT_PACKET_LENGTH bytes).
+ * @return 1 if a packet was written, or 0 if nothing is due.
+ */
+extern int section_carousel_next_packet(struct section_carousel *sc, uint64_t now,
+					uint8_t *pkt);
+
+/**
+ * Find out when the next table is due.
+ *
+ * @param sc The section_carousel.
+ * @param now The current time.
+ * @param due Where to put the time the next table is due. This is now if a
+ * table is overdue or part way through being output, so (*due - now) is
+ * always the time left to wait.
+ * @return 0 on success, or -1 if the carousel is empty.
+ */
+extern int section_carousel_next_due(struct section_carousel *sc, uint64_t now,
+				     uint64_t *due);
+
+/**
+ * Retrieve the statistics of a section_carousel.
+ *
+ * @param sc The section_carousel.
+ * @param stats Where to put the statistics.
+ */
+extern void section_carousel_get_stats(struct section_carousel *sc,
+				       struct section_carousel_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
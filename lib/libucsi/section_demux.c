@@ -0,0 +1,325 @@
+/*
+ * section reassembly from transport stream packets
+ *
+ * Copyright (C) 2026 agent (agent@local)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include "section_demux.h"
+
+#define SECTION_HDR_SIZE 3
+#define SECTION_PAD 0xff
+
+/* the smallest size class holds anything which spans two packets */
+#define SECTION_DEMUX_MIN_CLASS 512
+
+struct section_demux_pid {
+	struct section_buf *buf;	/* partial section, or NULL */
+	uint16_t pid;
+	uint8_t continuity;
+	uint8_t wait_pdu;
+};
+
+struct section_demux {
+	/* index+1 into pids for each PID, 0 if never seen */
+	uint16_t pid_index[TRANSPORT_MAX_PIDS];
+	struct section_demux_pid *pids;
+	int pids_alloc;
+
+	/* free lists of section_bufs for each size class, chained through
+	 * the first bytes of their data area */
+	struct section_buf *free[SECTION_DEMUX_CLASSES];
+	int max;
+
+	section_demux_callback callback;
+	void *arg;
+
+	struct section_demux_stats stats;
+};
+
+static struct section_demux_pid *section_demux_lookup(struct section_demux *sdemux, int pid);
+static struct section_buf *section_demux_buf_get(struct section_demux *sdemux, int len);
+static void section_demux_buf_put(struct section_demux *sdemux, struct section_buf *buf);
+
+struct section_demux *section_demux_create(int max_section_size,
+					   section_demux_callback callback,
+					   void *arg)
+{
+	struct section_demux *sdemux;
+	int size;
+	int i;
+
+	if (max_section_size < SECTION_HDR_SIZE)
+		return NULL;
+
+	sdemux = (struct section_demux *) malloc(sizeof(struct section_demux));
+	if (sdemux == NULL)
+		return NULL;
+	memset(sdemux, 0, sizeof(struct section_demux));
+	sdemux->max = max_section_size;
+	sdemux->callback = callback;
+	sdemux->arg = arg;
+
+	/* size classes grow by a factor of 4 up to the maximum */
+	size = max_section_size;
+	for(i = SECTION_DEMUX_CLASSES-1; i >= 0; i--) {
+		if (size < SECTION_DEMUX_MIN_CLASS)
+			size = SECTION_DEMUX_MIN_CLASS;
+		if (size > max_section_size)
+			size = max_section_size;
+		sdemux->stats.class_size[i] = size;
+		size /= 4;
+	}
+
+	return sdemux;
+}
+
+void section_demux_destroy(struct section_demux *sdemux)
+{
+	struct section_buf *buf;
+	int i;
+
+	for(i=0; i < (int) sdemux->stats.pids; i++) {
+		if (sdemux->pids[i].buf)
+			free(sdemux->pids[i].buf);
+	}
+	for(i=0; i < SECTION_DEMUX_CLASSES; i++) {
+		while((buf = sdemux->free[i]) != NULL) {
+			memcpy(&sdemux->free[i], section_buf_data(buf), sizeof(struct section_buf *));
+			free(buf);
+		}
+	}
+	free(sdemux->pids);
+	free(sdemux);
+}
+
+int section_demux_add_packet(struct section_demux *sdemux,
+			     struct transport_packet *pkt)
+{
+	struct section_demux_pid *p;
+	struct transport_values tsvals;
+	int pid = transport_packet_pid(pkt);
+
+	if ((p = section_demux_lookup(sdemux, pid)) == NULL)
+		return -ENOMEM;
+
+	if (transport_packet_values_extract(pkt, &tsvals, 0) < 0) {
+		section_demux_reset_pid(sdemux, pid);
+		return -EINVAL;
+	}
+
+	if (transport_packet_continuity_check(pkt,
+					      tsvals.flags & transport_adaptation_flag_discontinuity,
+					      &p->continuity)) {
+		sdemux->stats.continuity_errors++;
+		section_demux_reset_pid(sdemux, pid);
+		return -EPROTO;
+	}
+
+	if (tsvals.payload_length == 0)
+		return 0;
+
+	return section_demux_add_payload(sdemux, pid, tsvals.payload, tsvals.payload_length,
+					 pkt->payload_unit_start_indicator);
+}
+
+int section_demux_add_payload(struct section_demux *sdemux, int pid,
+			      uint8_t *payload, int len, int pdu_start)
+{
+	struct section_demux_pid *p;
+	struct section_buf *buf;
+	int section_status;
+	int sectlen;
+	int used;
+	int pos;
+
+	if ((p = section_demux_lookup(sdemux, pid)) == NULL)
+		return -ENOMEM;
+
+	while(len) {
+		/* if nothing is accumulated, try to deliver in place */
+		if (p->buf == NULL) {
+			if (p->wait_pdu && !pdu_start)
+				return 0;
+
+			pos = 0;
+			if (pdu_start) {
+				if ((payload[0] + 1) > len) {
+					p->wait_pdu = 1;
+					sdemux->stats.section_errors++;
+					return -EINVAL;
+				}
+				pos = 1 + payload[0];
+				p->wait_pdu = 0;
+				pdu_start = 0;
+			}
+
+			/* skip over section padding bytes */
+			while((pos < len) && (payload[pos] == SECTION_PAD))
+				pos++;
+			if (pos == len)
+				return 0;
+
+			/* if the whole section is here, deliver it. Otherwise
+			 * get a buffer of the right size; if the header is
+			 * split, we don't know the size, so use the largest. */
+			sectlen = sdemux->max;
+			if ((pos + SECTION_HDR_SIZE) <= len) {
+				sectlen = SECTION_HDR_SIZE +
+					(((payload[pos+1] & 0x0f) << 8) | payload[pos+2]);
+				if (sectlen > sdemux->max) {
+					p->wait_pdu = 1;
+					sdemux->stats.section_errors++;
+					return -ERANGE;
+				}
+
+				if ((pos + sectlen) <= len) {
+					sdemux->stats.direct++;
+					sdemux->callback(sdemux->arg, pid, payload + pos, sectlen);
+					payload += pos + sectlen;
+					len -= pos + sectlen;
+					continue;
+				}
+			}
+
+			if ((p->buf = section_demux_buf_get(sdemux, sectlen)) == NULL)
+				return -ENOMEM;
+			payload += pos;
+			len -= pos;
+		}
+
+		/* accumulate */
+		used = section_buf_add_transport_payload(p->buf, payload, len,
+							 pdu_start, &section_status);
+		pdu_start = 0;
+		payload += used;
+		len -= used;
+
+		if (section_status == 1) {
+			/* detach it first, so the callback may reset the PID */
+			buf = p->buf;
+			p->buf = NULL;
+			sdemux->stats.copied++;
+			sdemux->callback(sdemux->arg, pid, section_buf_data(buf), buf->len);
+			section_demux_buf_put(sdemux, buf);
+		} else if (section_status < 0) {
+			sdemux->stats.section_errors++;
+			section_demux_buf_put(sdemux, p->buf);
+			p->buf = NULL;
+			p->wait_pdu = 1;
+			return section_status;
+		}
+	}
+
+	return 0;
+}
+
+void section_demux_reset_pid(struct section_demux *sdemux, int pid)
+{
+	struct section_demux_pid *p;
+
+	if ((pid < 0) || (pid >= TRANSPORT_MAX_PIDS) || (sdemux->pid_index[pid] == 0))
+		return;
+	p = &sdemux->pids[sdemux->pid_index[pid] - 1];
+
+	if (p->buf) {
+		section_demux_buf_put(sdemux, p->buf);
+		p->buf = NULL;
+	}
+	p->continuity = 0;
+	p->wait_pdu = 1;
+}
+
+void section_demux_get_stats(struct section_demux *sdemux,
+			     struct section_demux_stats *stats)
+{
+	memcpy(stats, &sdemux->stats, sizeof(struct section_demux_stats));
+}
+
+static struct section_demux_pid *section_demux_lookup(struct section_demux *sdemux, int pid)
+{
+	struct section_demux_pid *p;
+
+	if ((pid < 0) || (pid >= TRANSPORT_MAX_PIDS))
+		return NULL;
+	if (sdemux->pid_index[pid])
+		return &sdemux->pids[sdemux->pid_index[pid] - 1];
+
+	/* first time we've seen this PID */
+	if (sdemux->stats.pids == (uint32_t) sdemux->pids_alloc) {
+		int newalloc = sdemux->pids_alloc ? sdemux->pids_alloc * 2 : 16;
+
+		p = (struct section_demux_pid *)
+			realloc(sdemux->pids, newalloc * sizeof(struct section_demux_pid));
+		if (p == NULL)
+			return NULL;
+		sdemux->pids = p;
+		sdemux->pids_alloc = newalloc;
+	}
+
+	p = &sdemux->pids[sdemux->stats.pids++];
+	memset(p, 0, sizeof(struct section_demux_pid));
+	p->pid = pid;
+	p->wait_pdu = 1;
+	sdemux->pid_index[pid] = sdemux->stats.pids;
+
+	return p;
+}
+
+static struct section_buf *section_demux_buf_get(struct section_demux *sdemux, int len)
+{
+	struct section_buf *buf;
+	int i;
+
+	for(i=0; i < SECTION_DEMUX_CLASSES-1; i++) {
+		if (len <= (int) sdemux->stats.class_size[i])
+			break;
+	}
+
+	if ((buf = sdemux->free[i]) != NULL) {
+		memcpy(&sdemux->free[i], section_buf_data(buf), sizeof(struct section_buf *));
+	} else {
+		buf = (struct section_buf *)
+			malloc(sizeof(struct section_buf) + sdemux->stats.class_size[i]);
+		if (buf == NULL)
+			return NULL;
+		sdemux->stats.buffers[i]++;
+	}
+
+	/* we're already synchronised when we hand data to it */
+	section_buf_init(buf, sdemux->stats.class_size[i]);
+	buf->wait_pdu = 0;
+	sdemux->stats.buffers_in_use++;
+
+	return buf;
+}
+
+static void section_demux_buf_put(struct section_demux *sdemux, struct section_buf *buf)
+{
+	int i;
+
+	for(i=0; i < SECTION_DEMUX_CLASSES-1; i++) {
+		if (buf->max == sdemux->stats.class_size[i])
+			break;
+	}
+
+	memcpy(section_buf_data(buf), &sdemux->free[i], sizeof(struct section_buf *));
+	sdemux->free[i] = buf;
+	sdemux->stats.buffers_in_use--;
+}
@@ -0,0 +1,147 @@
+/*
+ * section reassembly from transport stream packets
+ *
+ * Copyright (C) 2026 agent (agent@local)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef _UCSI_SECTION_DEMUX_H
+#define _UCSI_SECTION_DEMUX_H 1
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <libucsi/section_buf.h>
+#include <libucsi/transport_packet.h>
+
+/**
+ * Number of buffer size classes used by a section_demux.
+ */
+#define SECTION_DEMUX_CLASSES 3
+
+/**
+ * Statistics maintained by a section_demux.
+ */
+struct section_demux_stats {
+	uint32_t pids;				/* number of PIDs tracked */
+	uint32_t buffers[SECTION_DEMUX_CLASSES];/* number of buffers allocated per size class */
+	uint32_t buffers_in_use;		/* number of buffers currently holding a partial section */
+	uint32_t class_size[SECTION_DEMUX_CLASSES];/* the size of each class */
+	uint64_t direct;			/* sections delivered in place from the packet */
+	uint64_t copied;			/* sections delivered after reassembly */
+	uint64_t continuity_errors;		/* packets discarded due to continuity errors */
+	uint64_t section_errors;		/* sections discarded as invalid */
+};
+
+/**
+ * Callback receiving a complete section. The section data is only valid for
+ * the duration of the call, but may be modified (e.g. decoded in place). The
+ * callback may call section_demux_reset_pid(), but must not feed more data
+ * into the section_demux.
+ *
+ * @param arg Private argument supplied to section_demux_create().
+ * @param pid PID the section was received on.
+ * @param section Pointer to the section data.
+ * @param len Length of the section.
+ */
+typedef void (*section_demux_callback)(void *arg, int pid, uint8_t *section, int len);
+
+/**
+ * Opaque type representing a multi-PID section reassembly context.
+ *
+ * Per-PID state is only created for PIDs which are actually fed in, and a
+ * reassembly buffer is only held by a PID while it has a section spanning
+ * packets outstanding: buffers come from a pool of size classes chosen from
+ * the section length, and go back to the pool as soon as the section is
+ * complete or discarded. Sections contained within one packet are delivered
+ * in place without being copied at all.
+ */
+struct section_demux;
+
+/**
+ * Create a new section_demux.
+ *
+ * @param max_section_size Maximum size of a section (e.g. DVB_MAX_SECTION_BYTES).
+ * @param callback Callback to receive complete sections.
+ * @param arg Private argument to pass to the callback.
+ * @return The new instance, or NULL on error.
+ */
+extern struct section_demux *section_demux_create(int max_section_size,
+						  section_demux_callback callback,
+						  void *arg);
+
+/**
+ * Destroy a section_demux, freeing all its buffers.
+ *
+ * @param sdemux The instance to destroy.
+ */
+extern void section_demux_destroy(struct section_demux *sdemux);
+
+/**
+ * Process a transport packet. The continuity counter is checked, and any
+ * partial section is discarded on error.
+ *
+ * @param sdemux The section_demux.
+ * @param pkt The transport packet (already validated by transport_packet_init()).
+ * @return 0 on success, -EPROTO on a continuity error, or another negative
+ * error code if the packet or a section in it was invalid.
+ */
+extern int section_demux_add_packet(struct section_demux *sdemux,
+				    struct transport_packet *pkt);
+
+/**
+ * Process a transport packet payload for a PID. No continuity checking
+ * is performed.
+ *
+ * @param sdemux The section_demux.
+ * @param pid PID the payload belongs to.
+ * @param payload Pointer to the payload data.
+ * @param len Number of bytes of payload.
+ * @param pdu_start True if the payload_unit_start_indicator flag was set in the
+ * TS packet.
+ * @return 0 on success, nonzero on error.
+ */
+extern int section_demux_add_payload(struct section_demux *sdemux, int pid,
+				     uint8_t *payload, int len, int pdu_start);
+
+/**
+ * Discard any partial section for a PID (e.g. if a discontinuity occurred),
+ * returning its buffer to the pool. The PID will wait for the next PDU start,
+ * and its continuity counter is picked up afresh from the next packet, so this
+ * may also be used after packets of the PID were deliberately skipped.
+ *
+ * @param sdemux The section_demux.
+ * @param pid The PID.
+ */
+extern void section_demux_reset_pid(struct section_demux *sdemux, int pid);
+
+/**
+ * Retrieve the statistics of a section_demux.
+ *
+ * @param sdemux The section_demux.
+ * @param stats Where to put the statistics.
+ */
+extern void section_demux_get_stats(struct section_demux *sdemux,
+				    struct section_demux_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,132 @@
+/**
+ * section to transport stream packetizer.
+ *
+ * Copyright (c) 2026 by agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <string.h>
+#include <errno.h>
+#include "section_packetizer.h"
+
+static void section_packetizer_start(struct section_packetizer *sp, int pusi);
+static void section_packetizer_pad(struct section_packetizer *sp);
+
+void section_packetizer_init(struct section_packetizer *sp, int pid, int flags)
+{
+	memset(sp, 0, sizeof(struct section_packetizer));
+	sp->pid = pid & 0x1fff;
+	sp->flags = flags;
+}
+
+int section_packetizer_add(struct section_packetizer *sp,
+			   const uint8_t *section, size_t len, uint8_t *out)
+{
+	size_t pos = 0;
+	size_t count;
+	int packets = 0;
+
+	if ((len < 3) || (len > DVB_MAX_SECTION_BYTES))
+		return -EINVAL;
+
+	/*
+	 * Try to start the section in the pending packet. It needs a
+	 * pointer_field if the packet doesn't already have one, which means
+	 * moving the end of the previous section up a byte.
+	 */
+	if (sp->used) {
+		if ((sp->used + (sp->pointer ? 0 : 1)) < TRANSPORT_PACKET_LENGTH) {
+			if (!sp->pointer) {
+				memmove(sp->packet + 5, sp->packet + 4, sp->used - 4);
+				sp->packet[1] |= 0x40;
+				sp->packet[4] = sp->used - 4;
+				sp->pointer = 1;
+				sp->used++;
+			}
+		} else {
+			section_packetizer_pad(sp);
+			memcpy(out, sp->packet, TRANSPORT_PACKET_LENGTH);
+			out += TRANSPORT_PACKET_LENGTH;
+			packets++;
+			sp->used = 0;
+		}
+	}
+	if (sp->used == 0)
+		section_packetizer_start(sp, 1);
+
+	while (1) {
+		count = TRANSPORT_PACKET_LENGTH - sp->used;
+		if (count > (len - pos))
+			count = len - pos;
+		memcpy(sp->packet + sp->used, section + pos, count);
+		sp->used += count;
+		pos += count;
+
+		if (pos == len)
+			break;
+
+		memcpy(out, sp->packet, TRANSPORT_PACKET_LENGTH);
+		out += TRANSPORT_PACKET_LENGTH;
+		packets++;
+		section_packetizer_start(sp, 0);
+	}
+
+	/* hold on to the last packet if something else might go in it */
+	if ((sp->flags & section_packetizer_flag_pack) &&
+	    (sp->used < TRANSPORT_PACKET_LENGTH))
+		return packets;
+
+	section_packetizer_pad(sp);
+	memcpy(out, sp->packet, TRANSPORT_PACKET_LENGTH);
+	packets++;
+	sp->used = 0;
+
+	return packets;
+}
+
+int section_packetizer_flush(struct section_packetizer *sp, uint8_t *out)
+{
+	if (sp->used == 0)
+		return 0;
+
+	section_packetizer_pad(sp);
+	memcpy(out, sp->packet, TRANSPORT_PACKET_LENGTH);
+	sp->used = 0;
+
+	return 1;
+}
+
+static void section_packetizer_start(struct section_packetizer *sp, int pusi)
+{
+	sp->packet[0] = 0x47;
+	sp->packet[1] = (pusi ? 0x40 : 0) | (sp->pid >> 8);
+	sp->packet[2] = sp->pid & 0xff;
+	sp->packet[3] = 0x10 | sp->continuity_counter;
+	sp->continuity_counter = (sp->continuity_counter + 1) & 0x0f;
+
+	if (pusi) {
+		sp->packet[4] = 0;
+		sp->used = 5;
+	} else {
+		sp->used = 4;
+	}
+	sp->pointer = pusi;
+}
+
+static void section_packetizer_pad(struct section_packetizer *sp)
+{
+	memset(sp->packet + sp->used, 0xff, TRANSPORT_PACKET_LENGTH - sp->used);
+}
@@ -0,0 +1,124 @@
+/**
+ * section to transport stream packetizer.
+ *
+ * Copyright (c) 2026 by agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef _UCSI_SECTION_PACKETIZER_H
+#define _UCSI_SECTION_PACKETIZER_H 1
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <libucsi/transport_packet.h>
+#include <libucsi/section_buf.h>
+
+/**
+ * Number of payload bytes in a TS packet without an adaptation field.
+ */
+#define SECTION_PACKETIZER_PAYLOAD (TRANSPORT_PACKET_LENGTH - 4)
+
+/**
+ * Maximum number of complete packets section_packetizer_add() can produce
+ * for a section of len bytes (a pending packet, plus the section itself).
+ */
+#define SECTION_PACKETIZER_MAX_PACKETS(len) \
+	((((len) + 1 + SECTION_PACKETIZER_PAYLOAD - 1) / SECTION_PACKETIZER_PAYLOAD) + 1)
+
+/**
+ * Flags for section_packetizer_init().
+ */
+enum section_packetizer_flags {
+	/* start sections in the remainder of the previous section's last packet */
+	section_packetizer_flag_pack	= 0x01,
+};
+
+/**
+ * Splits encoded sections into TS packets for a single PID, setting the
+ * payload_unit_start_indicator and pointer_field, and counting the
+ * continuity_counter.
+ *
+ * Without section_packetizer_flag_pack, each section starts a new packet
+ * and its last packet is padded out with 0xff stuffing. With it, the last
+ * packet is held back so the next section can start in it; call
+ * section_packetizer_flush() to pad and retrieve it when there are no more
+ * sections to come.
+ *
+ * The structure is caller allocated and never allocates anything itself.
+ */
+struct section_packetizer {
+	uint16_t pid;
+	uint8_t flags;
+	uint8_t continuity_counter;	/* for the next packet */
+	uint8_t used;			/* bytes used in the pending packet, or 0 */
+	uint8_t pointer;		/* nonzero if the pending packet has a pointer_field */
+	uint8_t packet[TRANSPORT_PACKET_LENGTH];
+};
+
+/**
+ * Initialise a section_packetizer.
+ *
+ * @param sp The section_packetizer to initialise.
+ * @param pid PID the packets will be sent on.
+ * @param flags Orred enum section_packetizer_flags.
+ */
+extern void section_packetizer_init(struct section_packetizer *sp, int pid, int flags);
+
+/**
+ * Packetize a section. The section must already be complete, i.e.
+ * section_ext_encode() must have been called on it if it has a CRC.
+ *
+ * @param sp The section_packetizer.
+ * @param section Pointer to the encoded section.
+ * @param len Length of the section (3 to DVB_MAX_SECTION_BYTES).
+ * @param out Where to put the completed packets, contiguously. There must
+ * be room for SECTION_PACKETIZER_MAX_PACKETS(len) packets.
+ * @return Number of packets written to out, or < 0 on error.
+ */
+extern int section_packetizer_add(struct section_packetizer *sp,
+				  const uint8_t *section, size_t len, uint8_t *out);
+
+/**
+ * Pad out and retrieve the pending packet, if any.
+ *
+ * @param sp The section_packetizer.
+ * @param out Where to put the packet.
+ * @return Number of packets written to out (0 or 1).
+ */
+extern int section_packetizer_flush(struct section_packetizer *sp, uint8_t *out);
+
+/**
+ * Set the continuity_counter of a complete packet (e.g. when replaying
+ * previously packetized sections).
+ *
+ * @param pkt The packet.
+ * @param continuity_counter The new continuity_counter.
+ */
+static inline void section_packetizer_set_cc(uint8_t *pkt, uint8_t continuity_counter)
+{
+	pkt[3] = (pkt[3] & 0xf0) | (continuity_counter & 0x0f);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,230 @@
+/*
+ * read-only section views
+ *
+ * Copyright (C) 2026 agent (agent@local)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef _UCSI_SECTION_VIEW_H
+#define _UCSI_SECTION_VIEW_H 1
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <libucsi/section.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * Read-only section views.
+ *
+ * The *_codec() functions convert a section to host byte order in place, so
+ * a buffer can only be decoded once. The view functions instead read the
+ * fields straight from the raw, network byte order section without modifying
+ * it, so one received section can be shared between threads and re-read at
+ * will. Table specific views (e.g. mpeg_pmt_view_*()) live alongside the
+ * normal codec for each table.
+ *
+ * Check a raw section with section_view_check() (and the table specific
+ * *_view_check() function) before using the accessors: they do no bounds
+ * checking of their own.
+ */
+
+/**
+ * Size of the generic section header.
+ */
+#define SECTION_VIEW_HDR_SIZE 3
+
+/**
+ * Size of the generic extended section header.
+ */
+#define SECTION_VIEW_EXT_HDR_SIZE 8
+
+/**
+ * Check a raw section's length field is consistent with the buffer length.
+ *
+ * @param buf Pointer to the raw section.
+ * @param len Length of the buffer.
+ * @return 0 if it is valid, nonzero if not.
+ */
+static inline int section_view_check(const uint8_t *buf, size_t len)
+{
+	if (len < SECTION_VIEW_HDR_SIZE)
+		return -1;
+	if (len != (size_t) (SECTION_VIEW_HDR_SIZE + (ucsi_get_be16(buf+1) & 0x0fff)))
+		return -1;
+	return 0;
+}
+
+/**
+ * Accessor for the table_id field of a raw section.
+ */
+static inline uint8_t section_view_table_id(const uint8_t *buf)
+{
+	return buf[0];
+}
+
+/**
+ * Accessor for the syntax_indicator field of a raw section.
+ */
+static inline int section_view_syntax_indicator(const uint8_t *buf)
+{
+	return buf[1] >> 7;
+}
+
+/**
+ * Determine the total length of a raw section, including the header.
+ */
+static inline size_t section_view_length(const uint8_t *buf)
+{
+	return SECTION_VIEW_HDR_SIZE + (ucsi_get_be16(buf+1) & 0x0fff);
+}
+
+/**
+ * Check a raw section is a valid extended section, optionally verifying
+ * the CRC. The section must already have passed section_view_check().
+ *
+ * @param buf Pointer to the raw section.
+ * @param check_crc If 1, the CRC of the section will also be checked.
+ * @return 0 if it is valid, nonzero if not.
+ */
+static inline int section_view_ext_check(const uint8_t *buf, int check_crc)
+{
+	size_t len = section_view_length(buf);
+
+	if (!section_view_syntax_indicator(buf))
+		return -1;
+	if (len < (SECTION_VIEW_EXT_HDR_SIZE + CRC_SIZE))
+		return -1;
+
+	/* the crc includes the crc value, the result should be zero */
+	if (check_crc && crc32(CRC32_INIT, (uint8_t *) buf, len))
+		return -1;
+
+	return 0;
+}
+
+/**
+ * Determine the length of a raw extended section, including the header but
+ * omitting the CRC.
+ */
+static inline size_t section_view_ext_length(const uint8_t *buf)
+{
+	return section_view_length(buf) - CRC_SIZE;
+}
+
+/**
+ * Accessor for the table_id_ext field of a raw extended section.
+ */
+static inline uint16_t section_view_table_id_ext(const uint8_t *buf)
+{
+	return ucsi_get_be16(buf+3);
+}
+
+/**
+ * Accessor for the version_number field of a raw extended section.
+ */
+static inline uint8_t section_view_version_number(const uint8_t *buf)
+{
+	return (buf[5] >> 1) & 0x1f;
+}
+
+/**
+ * Accessor for the current_next_indicator field of a raw extended section.
+ */
+static inline int section_view_current_next_indicator(const uint8_t *buf)
+{
+	return buf[5] & 1;
+}
+
+/**
+ * Accessor for the section_number field of a raw extended section.
+ */
+static inline uint8_t section_view_section_number(const uint8_t *buf)
+{
+	return buf[6];
+}
+
+/**
+ * Accessor for the last_section_number field of a raw extended section.
+ */
+static inline uint8_t section_view_last_section_number(const uint8_t *buf)
+{
+	return buf[7];
+}
+
+/**
+ * Accessor for the CRC32 field of a raw extended section.
+ */
+static inline uint32_t section_view_crc32(const uint8_t *buf)
+{
+	return ucsi_get_be32(buf + section_view_length(buf) - CRC_SIZE);
+}
+
+/**
+ * Iterator for a raw descriptor loop. Descriptors have no multi-byte header
+ * fields, so the tag and len fields of each struct descriptor can be read
+ * directly. The descriptor payload follows at ((const uint8_t *) pos + 2).
+ *
+ * Note the loop must have been verified (e.g. by a *_view_check() function).
+ *
+ * @param buf Pointer to the start of the descriptor loop.
+ * @param len Length of the descriptor loop.
+ * @param pos Variable holding a const pointer to the current descriptor.
+ */
+#define section_view_descriptors_for_each(buf, len, pos) \
+	for ((pos) = section_view_descriptors_first(buf, len); \
+	     (pos); \
+	     (pos) = section_view_descriptors_next(buf, len, pos))
+
+
+
+
+
+
+
+
+
+
+/******************************** PRIVATE CODE ********************************/
+static inline const struct descriptor *
+	section_view_descriptors_first(const uint8_t *buf, size_t len)
+{
+	if (len == 0)
+		return NULL;
+
+	return (const struct descriptor *) buf;
+}
+
+static inline const struct descriptor *
+	section_view_descriptors_next(const uint8_t *buf, size_t len,
+				      const struct descriptor *pos)
+{
+	const uint8_t *next = (const uint8_t *) pos + 2 + pos->len;
+
+	if (next >= buf + len)
+		return NULL;
+
+	return (const struct descriptor *) next;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
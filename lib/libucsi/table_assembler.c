@@ -0,0 +1,299 @@
+/*
+ * out of order PSI/SI table assembler
+ *
+ * Copyright (C) 2026 agent (agent@local)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "section_view.h"
+#include "dvb/eit_section.h"
+#include "table_assembler.h"
+
+#define NIL -1
+#define INITIAL_TABLES 64
+
+#define EIT_TABLE_ID_FIRST 0x4e
+#define EIT_TABLE_ID_LAST 0x6f
+
+struct table_assembler_entry {
+	struct table_assembler_table table;
+	uint64_t key;		/* pid, table_id, table_id_ext */
+	uint32_t key2;		/* transport_stream_id, original_network_id */
+	int32_t hash_next;
+};
+
+struct table_assembler {
+	struct table_assembler_entry *entries;
+	uint32_t max_entries;
+	int32_t *buckets;
+	uint32_t mask;
+
+	table_assembler_callback callback;
+	void *arg;
+
+	struct table_assembler_stats stats;
+};
+
+static struct table_assembler_entry *table_assembler_lookup(struct table_assembler *ta,
+							    uint64_t key, uint32_t key2);
+static void table_assembler_start(struct table_assembler *ta,
+				  struct table_assembler_table *table,
+				  uint8_t version_number, uint8_t last_section_number);
+static void table_assembler_set_bits(uint32_t *bitmap, int first, int last, int set);
+static int table_assembler_rehash(struct table_assembler *ta, uint32_t nbuckets);
+
+static inline uint32_t table_assembler_hash(uint64_t key, uint32_t key2)
+{
+	return (uint32_t) (((key ^ ((uint64_t) key2 << 29)) * 0x9e3779b97f4a7c15ULL) >> 32);
+}
+
+struct table_assembler *table_assembler_create(table_assembler_callback callback, void *arg)
+{
+	struct table_assembler *ta;
+
+	ta = (struct table_assembler *) malloc(sizeof(struct table_assembler));
+	if (ta == NULL)
+		return NULL;
+	memset(ta, 0, sizeof(struct table_assembler));
+	ta->callback = callback;
+	ta->arg = arg;
+
+	ta->entries = (struct table_assembler_entry *)
+		malloc(INITIAL_TABLES * sizeof(struct table_assembler_entry));
+	if ((ta->entries == NULL) || table_assembler_rehash(ta, INITIAL_TABLES)) {
+		table_assembler_destroy(ta);
+		return NULL;
+	}
+	ta->max_entries = INITIAL_TABLES;
+
+	return ta;
+}
+
+void table_assembler_destroy(struct table_assembler *ta)
+{
+	free(ta->entries);
+	free(ta->buckets);
+	free(ta);
+}
+
+int table_assembler_add(struct table_assembler *ta, int pid,
+			const uint8_t *buf, size_t len)
+{
+	struct table_assembler_entry *entry;
+	struct table_assembler_table *table;
+	struct table_assembler_table copy;
+	uint8_t table_id;
+	uint8_t section_number;
+	uint8_t last_section_number;
+	uint8_t version_number;
+	uint64_t key;
+	uint32_t key2 = 0;
+	int eit = 0;
+	int i;
+
+	if (section_view_check(buf, len) || section_view_ext_check(buf, 0))
+		return -EINVAL;
+	if (!section_view_current_next_indicator(buf)) {
+		ta->stats.ignored_sections++;
+		return TABLE_ASSEMBLER_IGNORED;
+	}
+
+	table_id = section_view_table_id(buf);
+	section_number = section_view_section_number(buf);
+	last_section_number = section_view_last_section_number(buf);
+	version_number = section_view_version_number(buf);
+	if (section_number > last_section_number)
+		return -EINVAL;
+
+	/* EIT sub_tables are also identified by the tsid/onid */
+	if ((table_id >= EIT_TABLE_ID_FIRST) && (table_id <= EIT_TABLE_ID_LAST)) {
+		if (dvb_eit_view_check(buf, len))
+			return -EINVAL;
+		key2 = (dvb_eit_view_transport_stream_id(buf) << 16) |
+			dvb_eit_view_original_network_id(buf);
+		eit = 1;
+	}
+	key = ((uint64_t) (pid & 0x1fff) << 24) |
+	      ((uint64_t) table_id << 16) |
+	      section_view_table_id_ext(buf);
+
+	/* find the table, creating it if necessary */
+	entry = table_assembler_lookup(ta, key, key2);
+	if (entry == NULL) {
+		if (ta->stats.tables == ta->max_entries) {
+			struct table_assembler_entry *tmp;
+
+			tmp = (struct table_assembler_entry *)
+				realloc(ta->entries, ta->max_entries * 2 *
+					sizeof(struct table_assembler_entry));
+			if (tmp == NULL)
+				return -ENOMEM;
+			ta->entries = tmp;
+			ta->max_entries *= 2;
+			if (table_assembler_rehash(ta, ta->max_entries))
+				return -ENOMEM;
+		}
+
+		entry = &ta->entries[ta->stats.tables];
+		entry->key = key;
+		entry->key2 = key2;
+		entry->hash_next = ta->buckets[table_assembler_hash(key, key2) & ta->mask];
+		ta->buckets[table_assembler_hash(key, key2) & ta->mask] = ta->stats.tables;
+		ta->stats.tables++;
+
+		table = &entry->table;
+		memset(table, 0, sizeof(struct table_assembler_table));
+		table->pid = pid & 0x1fff;
+		table->table_id = table_id;
+		table->table_id_ext = section_view_table_id_ext(buf);
+		table->transport_stream_id = key2 >> 16;
+		table->original_network_id = key2 & 0xffff;
+		table_assembler_start(ta, table, version_number, last_section_number);
+	} else {
+		table = &entry->table;
+
+		/* a new version (or a changed size) starts the table again */
+		if ((table->version_number != version_number) ||
+		    (table->last_section_number != last_section_number)) {
+			table_assembler_start(ta, table, version_number, last_section_number);
+			ta->stats.version_changes++;
+		}
+	}
+
+	/* already got it? */
+	if (table_assembler_table_has_section(table, section_number)) {
+		ta->stats.ignored_sections++;
+		return TABLE_ASSEMBLER_IGNORED;
+	}
+	table->received[section_number >> 5] |= 1U << (section_number & 31);
+	table->sections_received++;
+	ta->stats.new_sections++;
+
+	/*
+	 * EIT sub_tables are split into segments of 8 sections: the sections
+	 * after segment_last_section_number in this segment will never be sent.
+	 */
+	if (eit) {
+		int segment_last = dvb_eit_view_segment_last_section_number(buf);
+		int segment_end = (section_number | 7);
+
+		if ((segment_last >= section_number) && (segment_last < segment_end))
+			table_assembler_set_bits(table->expected, segment_last + 1, segment_end, 0);
+	}
+
+	/* complete? */
+	for(i=0; i < 8; i++) {
+		if ((table->received[i] & table->expected[i]) != table->expected[i])
+			return TABLE_ASSEMBLER_NEW_SECTION;
+	}
+	table->complete = 1;
+	ta->stats.complete++;
+
+	/* the callback may add tables, which can move ta->entries */
+	if (ta->callback) {
+		memcpy(&copy, table, sizeof(struct table_assembler_table));
+		ta->callback(ta->arg, &copy);
+	}
+
+	return TABLE_ASSEMBLER_COMPLETE;
+}
+
+void table_assembler_clear(struct table_assembler *ta)
+{
+	uint32_t i;
+
+	for(i=0; i <= ta->mask; i++)
+		ta->buckets[i] = NIL;
+	ta->stats.tables = 0;
+	ta->stats.complete = 0;
+}
+
+void table_assembler_get_stats(struct table_assembler *ta,
+			       struct table_assembler_stats *stats)
+{
+	memcpy(stats, &ta->stats, sizeof(struct table_assembler_stats));
+}
+
+static struct table_assembler_entry *table_assembler_lookup(struct table_assembler *ta,
+							    uint64_t key, uint32_t key2)
+{
+	struct table_assembler_entry *entry;
+	int32_t idx = ta->buckets[table_assembler_hash(key, key2) & ta->mask];
+
+	while (idx != NIL) {
+		entry = &ta->entries[idx];
+		if ((entry->key == key) && (entry->key2 == key2))
+			return entry;
+		idx = entry->hash_next;
+	}
+
+	return NULL;
+}
+
+static void table_assembler_start(struct table_assembler *ta,
+				  struct table_assembler_table *table,
+				  uint8_t version_number, uint8_t last_section_number)
+{
+	if (table->complete)
+		ta->stats.complete--;
+
+	table->version_number = version_number;
+	table->last_section_number = last_section_number;
+	table->complete = 0;
+	table->sections_received = 0;
+	memset(table->received, 0, sizeof(table->received));
+	memset(table->expected, 0, sizeof(table->expected));
+	table_assembler_set_bits(table->expected, 0, last_section_number, 1);
+}
+
+static void table_assembler_set_bits(uint32_t *bitmap, int first, int last, int set)
+{
+	int i;
+
+	for(i = first; i <= last; i++) {
+		if (set)
+			bitmap[i >> 5] |= 1U << (i & 31);
+		else
+			bitmap[i >> 5] &= ~(1U << (i & 31));
+	}
+}
+
+static int table_assembler_rehash(struct table_assembler *ta, uint32_t nbuckets)
+{
+	int32_t *buckets;
+	uint32_t i;
+	uint32_t h;
+
+	buckets = (int32_t *) malloc(nbuckets * sizeof(int32_t));
+	if (buckets == NULL)
+		return -ENOMEM;
+	free(ta->buckets);
+	ta->buckets = buckets;
+	ta->mask = nbuckets - 1;
+
+	for(i=0; i < nbuckets; i++)
+		ta->buckets[i] = NIL;
+	for(i=0; i < ta->stats.tables; i++) {
+		h = table_assembler_hash(ta->entries[i].key, ta->entries[i].key2) & ta->mask;
+		ta->entries[i].hash_next = ta->buckets[h];
+		ta->buckets[h] = i;
+	}
+
+	return 0;
+}
@@ -0,0 +1,159 @@
+/*
+ * out of order PSI/SI table assembler
+ *
+ * Copyright (C) 2026 agent (agent@local)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef _UCSI_TABLE_ASSEMBLER_H
+#define _UCSI_TABLE_ASSEMBLER_H 1
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * Results of table_assembler_add().
+ */
+enum table_assembler_status {
+	TABLE_ASSEMBLER_IGNORED		= 0, /* already received, or not applicable */
+	TABLE_ASSEMBLER_NEW_SECTION	= 1, /* a section we did not have */
+	TABLE_ASSEMBLER_COMPLETE	= 2, /* a new section which completed its table */
+};
+
+/**
+ * Description of a table being assembled.
+ */
+struct table_assembler_table {
+	uint16_t pid;
+	uint8_t table_id;
+	uint16_t table_id_ext;
+	uint16_t transport_stream_id;	/* EIT only, otherwise 0 */
+	uint16_t original_network_id;	/* EIT only, otherwise 0 */
+	uint8_t version_number;
+	uint8_t last_section_number;
+	uint8_t complete;
+	uint16_t sections_received;
+	uint32_t received[8];		/* bitmap of section_numbers received */
+	uint32_t expected[8];		/* bitmap of section_numbers making up the table */
+};
+
+/**
+ * Statistics maintained by a table_assembler.
+ */
+struct table_assembler_stats {
+	uint32_t tables;		/* number of tables tracked */
+	uint32_t complete;		/* number of those which are complete */
+	uint64_t new_sections;		/* sections which were new */
+	uint64_t ignored_sections;	/* sections which were already received */
+	uint64_t version_changes;	/* number of times a table changed version */
+};
+
+/**
+ * Callback invoked when a table becomes complete. The callback may add
+ * further sections to the assembler.
+ *
+ * @param arg Private argument supplied to table_assembler_create().
+ * @param table A copy of the table which is now complete, only valid for the
+ * duration of the call.
+ */
+typedef void (*table_assembler_callback)(void *arg, struct table_assembler_table *table);
+
+/**
+ * Opaque type representing a table assembler.
+ *
+ * Unlike psi_table_state/section_ext_useful(), which only accept sections in
+ * order from section 0, the assembler keeps a bitmap of the section_numbers
+ * received for each (PID, table_id, table_id_ext, version) and accepts them in
+ * any order, so a table is complete after one repetition cycle whatever
+ * section the receiver started on. For EIT, sub-tables are also keyed on
+ * transport_stream_id/original_network_id, and segment_last_section_number is
+ * used to work out which sections of each 8 section segment exist.
+ */
+struct table_assembler;
+
+/**
+ * Create a new table_assembler.
+ *
+ * @param callback Callback invoked when a table is complete, or NULL.
+ * @param arg Private argument for the callback.
+ * @return The new instance, or NULL on error.
+ */
+extern struct table_assembler *table_assembler_create(table_assembler_callback callback,
+						      void *arg);
+
+/**
+ * Destroy a table_assembler.
+ *
+ * @param ta The instance to destroy.
+ */
+extern void table_assembler_destroy(struct table_assembler *ta);
+
+/**
+ * Add a raw (not yet decoded) extended section to the assembler. Sections
+ * with current_next_indicator clear are ignored. The CRC is not checked, so
+ * the caller should do that first for new sections.
+ *
+ * If the section completes its table, the completion callback is invoked
+ * before this function returns.
+ *
+ * @param ta The table_assembler.
+ * @param pid PID the section was received on.
+ * @param buf Pointer to the raw section.
+ * @param len Length of the section.
+ * @return One of enum table_assembler_status, or < 0 if the section was invalid.
+ */
+extern int table_assembler_add(struct table_assembler *ta, int pid,
+			       const uint8_t *buf, size_t len);
+
+/**
+ * Forget all tables (e.g. after a retune). The statistics are not reset.
+ *
+ * @param ta The table_assembler.
+ */
+extern void table_assembler_clear(struct table_assembler *ta);
+
+/**
+ * Retrieve the statistics of a table_assembler.
+ *
+ * @param ta The table_assembler.
+ * @param stats Where to put the statistics.
+ */
+extern void table_assembler_get_stats(struct table_assembler *ta,
+				      struct table_assembler_stats *stats);
+
+/**
+ * Determine if a particular section_number has been received for a table.
+ *
+ * @param table The table.
+ * @param section_number The section_number.
+ * @return Nonzero if it has been received.
+ */
+static inline int table_assembler_table_has_section(struct table_assembler_table *table,
+						    uint8_t section_number)
+{
+	return (table->received[section_number >> 5] >> (section_number & 31)) & 1;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,274 @@
+/*
+ * transport stream packet demultiplexer
+ *
+ * Copyright (C) 2026 agent (agent@local)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "transport_demux.h"
+
+struct transport_demux_slot {
+	transport_demux_callback callback;
+	void *arg;
+	int pid;
+	int count;
+	struct transport_packet_info batch[TRANSPORT_DEMUX_BATCH];
+};
+
+struct transport_demux {
+	/* index+1 into slots for each PID, 0 if nothing is registered */
+	uint16_t pid_slot[TRANSPORT_MAX_PIDS];
+	struct transport_demux_slot *slots;
+	int slots_count;
+	int slots_alloc;
+
+	struct transport_demux_slot all;
+
+	uint8_t carry[TRANSPORT_PACKET_LENGTH];
+	int carry_len;
+
+	struct transport_demux_stats stats;
+};
+
+static void transport_demux_flush(struct transport_demux *demux);
+static void transport_demux_dispatch(struct transport_demux *demux, uint8_t *buf, int npackets);
+static size_t transport_demux_resync(struct transport_demux *demux, uint8_t *buf, size_t len);
+
+struct transport_demux *transport_demux_create(void)
+{
+	struct transport_demux *demux;
+
+	demux = (struct transport_demux *) malloc(sizeof(struct transport_demux));
+	if (demux == NULL)
+		return NULL;
+	memset(demux, 0, sizeof(struct transport_demux));
+	demux->all.pid = TRANSPORT_DEMUX_ALL_PIDS;
+
+	return demux;
+}
+
+void transport_demux_destroy(struct transport_demux *demux)
+{
+	free(demux->slots);
+	free(demux);
+}
+
+int transport_demux_register(struct transport_demux *demux, int pid,
+			     transport_demux_callback callback, void *arg)
+{
+	struct transport_demux_slot *slot;
+
+	if (pid == TRANSPORT_DEMUX_ALL_PIDS) {
+		demux->all.callback = callback;
+		demux->all.arg = arg;
+		demux->all.count = 0;
+		return 0;
+	}
+	if ((pid < 0) || (pid >= TRANSPORT_MAX_PIDS))
+		return -1;
+
+	/* existing slot? */
+	if (demux->pid_slot[pid]) {
+		slot = &demux->slots[demux->pid_slot[pid] - 1];
+		slot->callback = callback;
+		slot->arg = arg;
+		slot->count = 0;
+		return 0;
+	}
+	if (callback == NULL)
+		return 0;
+
+	/* allocate a new one */
+	if (demux->slots_count == demux->slots_alloc) {
+		int newalloc = demux->slots_alloc ? demux->slots_alloc * 2 : 8;
+		struct transport_demux_slot *tmp;
+
+		tmp = (struct transport_demux_slot *)
+			realloc(demux->slots, newalloc * sizeof(struct transport_demux_slot));
+		if (tmp == NULL)
+			return -1;
+		demux->slots = tmp;
+		demux->slots_alloc = newalloc;
+	}
+	slot = &demux->slots[demux->slots_count++];
+	slot->callback = callback;
+	slot->arg = arg;
+	slot->pid = pid;
+	slot->count = 0;
+	demux->pid_slot[pid] = demux->slots_count;
+
+	return 0;
+}
+
+int transport_demux_feed(struct transport_demux *demux, uint8_t *buf, size_t len)
+{
+	uint64_t start = demux->stats.packets;
+	size_t tmp;
+	int npackets;
+	int bad;
+	int i;
+
+	/* complete any packet left over from last time, resynchronising within
+	 * it if it did not start with a sync byte */
+	while (demux->carry_len) {
+		tmp = TRANSPORT_PACKET_LENGTH - demux->carry_len;
+		if (tmp > len)
+			tmp = len;
+		memcpy(demux->carry + demux->carry_len, buf, tmp);
+		demux->carry_len += tmp;
+		buf += tmp;
+		len -= tmp;
+
+		if (demux->carry_len < TRANSPORT_PACKET_LENGTH)
+			return 0;
+		if (demux->carry[0] == TRANSPORT_PACKET_SYNC) {
+			transport_demux_dispatch(demux, demux->carry, 1);
+			break;
+		}
+
+		tmp = transport_demux_resync(demux, demux->carry, demux->carry_len);
+		demux->carry_len -= tmp;
+		memmove(demux->carry, demux->carry + tmp, demux->carry_len);
+	}
+
+	while (len >= TRANSPORT_PACKET_LENGTH) {
+		npackets = len / TRANSPORT_PACKET_LENGTH;
+		if (npackets > TRANSPORT_DEMUX_BATCH)
+			npackets = TRANSPORT_DEMUX_BATCH;
+
+		/* check all the sync bytes of this run in one go */
+		bad = 0;
+		for(i=0; i < npackets; i++)
+			bad |= buf[i * TRANSPORT_PACKET_LENGTH] ^ TRANSPORT_PACKET_SYNC;
+
+		/* if any was bad, process the good ones and then resync */
+		if (bad) {
+			for(i=0; i < npackets; i++)
+				if (buf[i * TRANSPORT_PACKET_LENGTH] != TRANSPORT_PACKET_SYNC)
+					break;
+			transport_demux_dispatch(demux, buf, i);
+			buf += i * TRANSPORT_PACKET_LENGTH;
+			len -= i * TRANSPORT_PACKET_LENGTH;
+
+			tmp = transport_demux_resync(demux, buf, len);
+			buf += tmp;
+			len -= tmp;
+			continue;
+		}
+
+		transport_demux_dispatch(demux, buf, npackets);
+		buf += npackets * TRANSPORT_PACKET_LENGTH;
+		len -= npackets * TRANSPORT_PACKET_LENGTH;
+	}
+
+	/* deliver everything before the carry buffer is reused */
+	transport_demux_flush(demux);
+
+	memcpy(demux->carry, buf, len);
+	demux->carry_len = len;
+
+	return demux->stats.packets - start;
+}
+
+void transport_demux_reset(struct transport_demux *demux)
+{
+	demux->carry_len = 0;
+}
+
+void transport_demux_get_stats(struct transport_demux *demux,
+			       struct transport_demux_stats *stats)
+{
+	memcpy(stats, &demux->stats, sizeof(struct transport_demux_stats));
+}
+
+static void transport_demux_flush(struct transport_demux *demux)
+{
+	struct transport_demux_slot *slot;
+	int i;
+
+	for(i=0; i < demux->slots_count; i++) {
+		slot = &demux->slots[i];
+		if (slot->count) {
+			slot->callback(slot->arg, slot->pid, slot->batch, slot->count);
+			slot->count = 0;
+		}
+	}
+
+	if (demux->all.count) {
+		demux->all.callback(demux->all.arg, TRANSPORT_DEMUX_ALL_PIDS,
+				    demux->all.batch, demux->all.count);
+		demux->all.count = 0;
+	}
+}
+
+static void transport_demux_dispatch(struct transport_demux *demux, uint8_t *buf, int npackets)
+{
+	struct transport_demux_slot *slot;
+	struct transport_packet_info *info;
+	int pid;
+	int i;
+
+	for(i=0; i < npackets; i++, buf += TRANSPORT_PACKET_LENGTH) {
+		pid = ((buf[1] & 0x1f) << 8) | buf[2];
+
+		if (demux->pid_slot[pid]) {
+			slot = &demux->slots[demux->pid_slot[pid] - 1];
+			if (slot->callback) {
+				info = &slot->batch[slot->count++];
+				transport_packet_info_extract(buf, info);
+				if (slot->count == TRANSPORT_DEMUX_BATCH) {
+					slot->callback(slot->arg, pid, slot->batch, slot->count);
+					slot->count = 0;
+				}
+			}
+		}
+
+		if (demux->all.callback) {
+			info = &demux->all.batch[demux->all.count++];
+			transport_packet_info_extract(buf, info);
+			if (demux->all.count == TRANSPORT_DEMUX_BATCH) {
+				demux->all.callback(demux->all.arg, TRANSPORT_DEMUX_ALL_PIDS,
+						    demux->all.batch, demux->all.count);
+				demux->all.count = 0;
+			}
+		}
+	}
+
+	demux->stats.packets += npackets;
+}
+
+static size_t transport_demux_resync(struct transport_demux *demux, uint8_t *buf, size_t len)
+{
+	size_t pos;
+
+	/* look for a sync byte which is followed by another one a packet later
+	 * (or which is at the end of the data, we'll find out next time) */
+	for(pos=1; pos < len; pos++) {
+		if (buf[pos] != TRANSPORT_PACKET_SYNC)
+			continue;
+		if ((pos + TRANSPORT_PACKET_LENGTH) >= len)
+			break;
+		if (buf[pos + TRANSPORT_PACKET_LENGTH] == TRANSPORT_PACKET_SYNC)
+			break;
+	}
+
+	demux->stats.sync_losses++;
+	demux->stats.skipped_bytes += pos;
+
+	return pos;
+}
@@ -0,0 +1,167 @@
+/*
+ * transport stream packet demultiplexer
+ *
+ * Copyright (C) 2026 agent (agent@local)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef _UCSI_TRANSPORT_DEMUX_H
+#define _UCSI_TRANSPORT_DEMUX_H 1
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <libucsi/transport_packet.h>
+
+/**
+ * Maximum number of packets delivered to a callback in one call.
+ */
+#define TRANSPORT_DEMUX_BATCH 64
+
+/**
+ * PID value used to register a callback which receives every packet.
+ */
+#define TRANSPORT_DEMUX_ALL_PIDS -1
+
+/**
+ * Header fields of a transport packet, extracted by the demux.
+ */
+struct transport_packet_info {
+	struct transport_packet *pkt;			/* the raw 188 byte packet */
+	uint16_t pid;
+	uint8_t transport_error_indicator;
+	uint8_t payload_unit_start_indicator;
+	uint8_t transport_scrambling_control;
+	uint8_t adaptation_field_control;
+	uint8_t continuity_counter;
+};
+
+/**
+ * Statistics maintained by a transport_demux.
+ */
+struct transport_demux_stats {
+	uint64_t packets;	/* number of packets demuxed */
+	uint64_t sync_losses;	/* number of times the stream had to be resynchronised */
+	uint64_t skipped_bytes;	/* number of bytes discarded while resynchronising */
+};
+
+/**
+ * Callback receiving a batch of packets for one PID. The packets are in
+ * stream order, but batches for different PIDs are not delivered in stream
+ * order relative to each other. The packet data is only valid for the
+ * duration of the call.
+ *
+ * @param arg Private argument supplied at registration.
+ * @param pid The PID the callback was registered for (or TRANSPORT_DEMUX_ALL_PIDS).
+ * @param pkts Array of packet descriptions.
+ * @param count Number of packets in pkts (at most TRANSPORT_DEMUX_BATCH).
+ */
+typedef void (*transport_demux_callback)(void *arg, int pid,
+					 struct transport_packet_info *pkts, int count);
+
+/**
+ * Opaque type representing a transport stream demux.
+ */
+struct transport_demux;
+
+/**
+ * Create a new transport_demux.
+ *
+ * @return The new instance, or NULL on failure.
+ */
+extern struct transport_demux *transport_demux_create(void);
+
+/**
+ * Destroy a transport_demux.
+ *
+ * @param demux The instance to destroy.
+ */
+extern void transport_demux_destroy(struct transport_demux *demux);
+
+/**
+ * Register a callback for a PID. Any previous callback for the PID is replaced.
+ * This must not be called from within a demux callback.
+ *
+ * @param demux The transport_demux.
+ * @param pid PID to register for, or TRANSPORT_DEMUX_ALL_PIDS to receive all
+ * packets (in addition to any per-PID callback).
+ * @param callback The callback, or NULL to unregister.
+ * @param arg Private argument to pass to the callback.
+ * @return 0 on success, nonzero on error.
+ */
+extern int transport_demux_register(struct transport_demux *demux, int pid,
+				    transport_demux_callback callback, void *arg);
+
+/**
+ * Feed a buffer of transport stream data into the demux. The buffer need not
+ * start or end on a packet boundary: partial packets are carried over to the
+ * next call. Synchronisation is regained automatically if the stream is
+ * corrupt. All pending batches are delivered before this function returns.
+ *
+ * @param demux The transport_demux.
+ * @param buf The data.
+ * @param len Number of bytes of data.
+ * @return Number of complete packets processed.
+ */
+extern int transport_demux_feed(struct transport_demux *demux, uint8_t *buf, size_t len);
+
+/**
+ * Discard any partial packet held from a previous transport_demux_feed() call
+ * (e.g. after a retune).
+ *
+ * @param demux The transport_demux.
+ */
+extern void transport_demux_reset(struct transport_demux *demux);
+
+/**
+ * Retrieve the statistics of a transport_demux.
+ *
+ * @param demux The transport_demux.
+ * @param stats Where to put the statistics.
+ */
+extern void transport_demux_get_stats(struct transport_demux *demux,
+				      struct transport_demux_stats *stats);
+
+/**
+ * Decode the header fields of a single transport packet. No sync byte check
+ * is performed.
+ *
+ * @param buf Pointer to the start of the packet.
+ * @param info Where to put the fields.
+ */
+static inline void transport_packet_info_extract(uint8_t *buf,
+						 struct transport_packet_info *info)
+{
+	uint32_t hdr = ((uint32_t) buf[1] << 16) | ((uint32_t) buf[2] << 8) | buf[3];
+
+	info->pkt = (struct transport_packet *) buf;
+	info->pid = (hdr >> 8) & 0x1fff;
+	info->transport_error_indicator = hdr >> 23;
+	info->payload_unit_start_indicator = (hdr >> 22) & 1;
+	info->transport_scrambling_control = (hdr >> 6) & 3;
+	info->adaptation_field_control = (hdr >> 4) & 3;
+	info->continuity_counter = hdr & 0x0f;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
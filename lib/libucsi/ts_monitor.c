@@ -0,0 +1,850 @@
+/**
+ * transport stream monitoring and error statistics.
+ *
+ * Copyright (c) 2026 by agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <libucsi/crc32.h>
+#include <libucsi/section_demux.h>
+#include <libucsi/section_view.h>
+#include <libucsi/mpeg/section.h>
+#include <libucsi/dvb/section.h>
+#include "ts_monitor.h"
+
+#define PACKET_SIZE TRANSPORT_PACKET_LENGTH
+
+/* consecutive sync bytes needed to acquire sync, and bad ones to lose it */
+#define SYNC_ACQUIRE 5
+#define SYNC_LOSE 2
+
+/* pcr_time: PCR steps larger than this are not used to advance the time */
+#define PCR_TIME_MAX_STEP PCR_CLOCK_HZ
+
+#define NO_VERSION 0xff
+
+#define COUNTER(field) (offsetof(struct ts_monitor_counters, field) / sizeof(uint64_t))
+#define NCOUNTERS (sizeof(struct ts_monitor_counters) / sizeof(uint64_t))
+
+enum ts_monitor_pid_flags {
+	pid_flag_psi		= 0x01,	/* reassemble sections */
+	pid_flag_pmt		= 0x02,	/* a program_map_PID */
+	pid_flag_pcr		= 0x04,	/* a PCR_PID */
+	pid_flag_pts		= 0x08,	/* an audio or video stream: check PTSs */
+	pid_flag_ref		= 0x10,	/* referred to by a PMT: check it is present */
+};
+
+struct ts_monitor_pid {
+	struct ts_monitor_counters counters;
+
+	uint64_t seen;			/* time the last packet was received */
+	uint64_t reported;		/* time of the last PID_error */
+	uint64_t pts_seen;		/* time of the last PTS */
+	uint64_t pts_reported;		/* time of the last PTS_error */
+	uint64_t pcr;			/* last PCR */
+	uint8_t pcr_valid;
+	uint8_t continuity;
+	uint8_t flags;			/* enum ts_monitor_pid_flags */
+	uint8_t old_flags;		/* only used by ts_monitor_update_refs() */
+	uint16_t programs;		/* number of active programs referring to it */
+};
+
+struct ts_monitor_program {
+	/* read by other threads */
+	uint16_t program_number;
+	uint16_t pmt_pid;
+	uint16_t pcr_pid;
+	uint16_t active;
+	uint16_t npids;
+	uint16_t pids[TS_MONITOR_MAX_PROGRAM_PIDS];
+	struct ts_monitor_counters counters;
+
+	uint8_t types[TS_MONITOR_MAX_PROGRAM_PIDS];
+	uint8_t pat_section;		/* PAT section the program was listed in */
+	uint8_t pmt_version;
+	uint64_t pmt_seen;
+	uint64_t pmt_reported;
+};
+
+struct ts_monitor {
+	/* read by other threads */
+	uint32_t in_sync;
+	uint32_t programs;
+	uint32_t programs_used;
+	struct ts_monitor_counters counters;
+
+	/* allocated on first use and never freed or moved, so other threads
+	 * may read them without locking */
+	struct ts_monitor_pid *pids[TRANSPORT_MAX_PIDS];
+	struct ts_monitor_program *program_slots;
+
+	/* PIDs with nonzero flags; twice the size, for ts_monitor_update_refs() */
+	uint16_t *refs;
+	int nrefs;
+
+	int flags;
+	uint64_t pid_timeout;
+	uint64_t now;
+	int started;
+
+	int offset;			/* where the next packet starts in the next batch */
+	int good_syncs;			/* sync bytes in a row while acquiring sync */
+	int bad_syncs;
+
+	/* pcr_time */
+	int time_pid;
+	uint64_t time_pcr;
+
+	uint8_t pat_version;
+	uint8_t pat_sections[32];	/* bitmap of sections of pat_version seen */
+	uint64_t pat_seen;
+	uint64_t pat_reported;
+	int cat_seen;
+	uint64_t cat_reported;
+	int scrambled_in_batch;
+	int refs_dirty;
+
+	struct section_demux *sdemux;
+	struct pcr_clock *clk;
+};
+
+static const uint16_t ts_monitor_psi_pids[] = {
+	TRANSPORT_PAT_PID, TRANSPORT_CAT_PID, TRANSPORT_NIT_PID,
+	TRANSPORT_SDT_PID, TRANSPORT_EIT_PID, TRANSPORT_TDT_PID,
+};
+
+static void ts_monitor_packet(struct ts_monitor *mon, uint8_t *buf);
+static void ts_monitor_section(void *arg, int pid, uint8_t *section, int len);
+static void ts_monitor_pat(struct ts_monitor *mon, uint8_t *section, int len);
+static void ts_monitor_pmt(struct ts_monitor *mon, int pid, uint8_t *section, int len);
+static void ts_monitor_update_refs(struct ts_monitor *mon);
+static void ts_monitor_check_intervals(struct ts_monitor *mon);
+static void ts_monitor_count(struct ts_monitor *mon, struct ts_monitor_pid *p, int pid, int counter);
+static struct ts_monitor_pid *ts_monitor_pid(struct ts_monitor *mon, int pid);
+static struct ts_monitor_program *ts_monitor_find_program(struct ts_monitor *mon,
+							  int program_number, int active);
+
+/* counters are only ever written by the thread feeding the monitor, so a
+ * relaxed load and store is enough; it just stops them being torn */
+static inline void ts_monitor_inc(uint64_t *counter)
+{
+	__atomic_store_n(counter, __atomic_load_n(counter, __ATOMIC_RELAXED) + 1, __ATOMIC_RELAXED);
+}
+
+static inline void ts_monitor_copy(struct ts_monitor_counters *dst,
+				   struct ts_monitor_counters *src)
+{
+	uint64_t *d = (uint64_t *) dst;
+	uint64_t *s = (uint64_t *) src;
+	unsigned int i;
+
+	for(i=0; i < NCOUNTERS; i++)
+		d[i] = __atomic_load_n(&s[i], __ATOMIC_RELAXED);
+}
+
+static inline void ts_monitor_set16(uint16_t *dst, uint16_t value)
+{
+	__atomic_store_n(dst, value, __ATOMIC_RELAXED);
+}
+
+static inline uint16_t ts_monitor_get16(uint16_t *src)
+{
+	return __atomic_load_n(src, __ATOMIC_RELAXED);
+}
+
+/* has more than interval passed since something was last seen, or last reported
+ * missing? If so, note that it is being reported now. */
+static inline int ts_monitor_overdue(uint64_t now, uint64_t seen, uint64_t *reported,
+				     uint64_t interval)
+{
+	uint64_t last = (seen > *reported) ? seen : *reported;
+
+	if ((now <= last) || ((now - last) <= interval))
+		return 0;
+	*reported = now;
+	return 1;
+}
+
+static inline uint64_t ts_monitor_pcr(uint8_t *buf)
+{
+	uint64_t pcr;
+
+	pcr = (((uint64_t) buf[6] << 25) |
+	       ((uint64_t) buf[7] << 17) |
+	       ((uint64_t) buf[8] << 9) |
+	       ((uint64_t) buf[9] << 1) |
+	       ((uint64_t) buf[10] >> 7)) * 300ULL;
+	return pcr + (((buf[10] & 1) << 8) | buf[11]);
+}
+
+static inline int ts_monitor_av_stream(int stream_type)
+{
+	switch(stream_type) {
+	case 0x01: /* MPEG-1 video */
+	case 0x02: /* MPEG-2 video */
+	case 0x03: /* MPEG-1 audio */
+	case 0x04: /* MPEG-2 audio */
+	case 0x0f: /* AAC audio */
+	case 0x10: /* MPEG-4 video */
+	case 0x11: /* LATM AAC audio */
+	case 0x1b: /* H.264 video */
+	case 0x24: /* HEVC video */
+	case 0x81: /* ATSC AC-3 audio */
+	case 0x87: /* ATSC E-AC-3 audio */
+		return 1;
+	}
+	return 0;
+}
+
+struct ts_monitor *ts_monitor_create(int flags, uint64_t pid_timeout)
+{
+	struct ts_monitor *mon;
+
+	mon = (struct ts_monitor *) malloc(sizeof(struct ts_monitor));
+	if (mon == NULL)
+		return NULL;
+	memset(mon, 0, sizeof(struct ts_monitor));
+	mon->flags = flags;
+	mon->pid_timeout = pid_timeout ? pid_timeout : TS_MONITOR_DEFAULT_PID_TIMEOUT;
+	mon->pat_version = NO_VERSION;
+	mon->time_pid = -1;
+
+	mon->program_slots = (struct ts_monitor_program *)
+		calloc(TS_MONITOR_MAX_PROGRAMS, sizeof(struct ts_monitor_program));
+	mon->refs = (uint16_t *) malloc(2 * TRANSPORT_MAX_PIDS * sizeof(uint16_t));
+	mon->sdemux = section_demux_create(4096, ts_monitor_section, mon);
+	mon->clk = pcr_clock_create();
+	if ((mon->program_slots == NULL) || (mon->refs == NULL) ||
+	    (mon->sdemux == NULL) || (mon->clk == NULL)) {
+		ts_monitor_destroy(mon);
+		return NULL;
+	}
+	ts_monitor_update_refs(mon);
+
+	return mon;
+}
+
+void ts_monitor_destroy(struct ts_monitor *mon)
+{
+	int i;
+
+	for(i=0; i < TRANSPORT_MAX_PIDS; i++)
+		free(mon->pids[i]);
+	if (mon->sdemux)
+		section_demux_destroy(mon->sdemux);
+	if (mon->clk)
+		pcr_clock_destroy(mon->clk);
+	free(mon->program_slots);
+	free(mon->refs);
+	free(mon);
+}
+
+void ts_monitor_add_packets(struct ts_monitor *mon, uint8_t *buf, int count,
+			    uint64_t now)
+{
+	int len = count * PACKET_SIZE;
+	int pos = mon->offset;
+	int i;
+
+	if (!(mon->flags & ts_monitor_flag_pcr_time))
+		mon->now = now;
+	if (!mon->started) {
+		mon->pat_seen = mon->now;
+		mon->cat_reported = mon->now;
+		mon->started = 1;
+	}
+	mon->scrambled_in_batch = 0;
+
+	while(pos < len) {
+		if (!mon->in_sync) {
+			/* look for SYNC_ACQUIRE sync bytes in a row; the run may
+			 * have started in an earlier batch */
+			if (buf[pos] != TRANSPORT_PACKET_SYNC) {
+				/* try again from the byte after the run's first
+				 * one, or from the start of this batch */
+				pos -= mon->good_syncs * PACKET_SIZE;
+				pos = (pos < 0) ? 0 : pos + 1;
+				mon->good_syncs = 0;
+				continue;
+			}
+			if (++mon->good_syncs < SYNC_ACQUIRE) {
+				pos += PACKET_SIZE;
+				continue;
+			}
+
+			/* start with the run's first packet in this batch */
+			i = mon->good_syncs - 1;
+			if (i > (pos / PACKET_SIZE))
+				i = pos / PACKET_SIZE;
+			pos -= i * PACKET_SIZE;
+			mon->good_syncs = 0;
+			__atomic_store_n(&mon->in_sync, 1, __ATOMIC_RELAXED);
+			mon->bad_syncs = 0;
+		}
+		if ((pos + PACKET_SIZE) > len)
+			break;
+
+		if (buf[pos] != TRANSPORT_PACKET_SYNC) {
+			ts_monitor_inc(&mon->counters.sync_byte_errors);
+			if (++mon->bad_syncs >= SYNC_LOSE) {
+				ts_monitor_inc(&mon->counters.sync_losses);
+				__atomic_store_n(&mon->in_sync, 0, __ATOMIC_RELAXED);
+				/* the straddling packet, if any, is lost */
+				continue;
+			}
+		} else {
+			mon->bad_syncs = 0;
+			ts_monitor_packet(mon, buf + pos);
+		}
+		pos += PACKET_SIZE;
+	}
+	if (mon->in_sync)
+		mon->offset = (pos + PACKET_SIZE - len) % PACKET_SIZE;
+	else
+		mon->offset = pos - len;	/* the next sync byte of the run, if any */
+
+	if (mon->refs_dirty)
+		ts_monitor_update_refs(mon);
+	ts_monitor_check_intervals(mon);
+}
+
+void ts_monitor_get_stats(struct ts_monitor *mon, struct ts_monitor_stats *stats)
+{
+	stats->in_sync = __atomic_load_n(&mon->in_sync, __ATOMIC_RELAXED);
+	stats->programs = __atomic_load_n(&mon->programs, __ATOMIC_RELAXED);
+	ts_monitor_copy(&stats->counters, &mon->counters);
+}
+
+int ts_monitor_get_pid_stats(struct ts_monitor *mon, int pid,
+			     struct ts_monitor_counters *counters)
+{
+	struct ts_monitor_pid *p;
+
+	if ((pid < 0) || (pid >= TRANSPORT_MAX_PIDS))
+		return -EINVAL;
+
+	p = __atomic_load_n(&mon->pids[pid], __ATOMIC_ACQUIRE);
+	if (p == NULL) {
+		memset(counters, 0, sizeof(struct ts_monitor_counters));
+		return 0;
+	}
+	ts_monitor_copy(counters, &p->counters);
+	return 0;
+}
+
+int ts_monitor_get_programs(struct ts_monitor *mon, uint16_t *program_numbers, int max)
+{
+	struct ts_monitor_program *prog;
+	int used = __atomic_load_n(&mon->programs_used, __ATOMIC_ACQUIRE);
+	int count = 0;
+	int i;
+
+	for(i=0; (i < used) && (count < max); i++) {
+		prog = &mon->program_slots[i];
+		if (ts_monitor_get16(&prog->active))
+			program_numbers[count++] = ts_monitor_get16(&prog->program_number);
+	}
+	return count;
+}
+
+int ts_monitor_get_program_stats(struct ts_monitor *mon, int program_number,
+				 struct ts_monitor_program_stats *stats)
+{
+	struct ts_monitor_program *prog = NULL;
+	struct ts_monitor_counters pidc;
+	uint16_t pids[TS_MONITOR_MAX_PROGRAM_PIDS + 2];
+	int used = __atomic_load_n(&mon->programs_used, __ATOMIC_ACQUIRE);
+	int npids;
+	int i;
+	int j;
+
+	for(i=0; i < used; i++) {
+		if (ts_monitor_get16(&mon->program_slots[i].active) &&
+		    (ts_monitor_get16(&mon->program_slots[i].program_number) == program_number)) {
+			prog = &mon->program_slots[i];
+			break;
+		}
+	}
+	if (prog == NULL)
+		return -ENOENT;
+
+	stats->program_number = program_number;
+	stats->pmt_pid = ts_monitor_get16(&prog->pmt_pid);
+	stats->pcr_pid = ts_monitor_get16(&prog->pcr_pid);
+	ts_monitor_copy(&stats->counters, &prog->counters);
+
+	/* packets are counted per PID; add up the program's PIDs */
+	npids = ts_monitor_get16(&prog->npids);
+	if (npids > TS_MONITOR_MAX_PROGRAM_PIDS)
+		npids = TS_MONITOR_MAX_PROGRAM_PIDS;
+	for(i=0; i < npids; i++)
+		pids[i] = ts_monitor_get16(&prog->pids[i]);
+	pids[npids++] = stats->pmt_pid;
+	pids[npids++] = stats->pcr_pid;
+	for(i=0; i < npids; i++) {
+		for(j=0; j < i; j++) {
+			if (pids[j] == pids[i])
+				break;
+		}
+		if ((j < i) || (pids[i] == TRANSPORT_NULL_PID))
+			continue;
+		ts_monitor_get_pid_stats(mon, pids[i], &pidc);
+		stats->counters.packets += pidc.packets;
+		stats->counters.scrambled += pidc.scrambled;
+	}
+
+	return 0;
+}
+
+static void ts_monitor_packet(struct ts_monitor *mon, uint8_t *buf)
+{
+	struct transport_packet *pkt = (struct transport_packet *) buf;
+	struct ts_monitor_pid *p;
+	int pid = transport_packet_pid(pkt);
+	int afc = (buf[3] >> 4) & 3;
+	int discontinuity = 0;
+	int scrambled;
+	int events;
+	uint8_t *payload;
+	int payload_len;
+	uint64_t pcr;
+	uint64_t delta;
+
+	ts_monitor_inc(&mon->counters.packets);
+	if ((p = ts_monitor_pid(mon, pid)) == NULL)
+		return;
+	ts_monitor_inc(&p->counters.packets);
+	p->seen = mon->now;
+
+	if (buf[1] & 0x80) {
+		ts_monitor_count(mon, p, pid, COUNTER(transport_errors));
+		if (p->flags & pid_flag_psi)
+			section_demux_reset_pid(mon->sdemux, pid);
+		return;
+	}
+
+	/* find the payload */
+	payload = buf + 4;
+	payload_len = PACKET_SIZE - 4;
+	if (afc & 2) {
+		if (buf[4] > (PACKET_SIZE - 5)) {
+			if (p->flags & pid_flag_psi)
+				section_demux_reset_pid(mon->sdemux, pid);
+			return;
+		}
+		if (buf[4])
+			discontinuity = buf[5] & transport_adaptation_flag_discontinuity;
+		payload += 1 + buf[4];
+		payload_len -= 1 + buf[4];
+	}
+	if (!(afc & 1))
+		payload_len = 0;
+
+	if (transport_packet_continuity_check(pkt, discontinuity, &p->continuity)) {
+		p->continuity = 0;
+		ts_monitor_count(mon, p, pid, COUNTER(cc_errors));
+		if (p->flags & pid_flag_psi)
+			section_demux_reset_pid(mon->sdemux, pid);
+	}
+
+	scrambled = buf[3] & 0xc0;
+	if (scrambled) {
+		ts_monitor_inc(&mon->counters.scrambled);
+		ts_monitor_inc(&p->counters.scrambled);
+		mon->scrambled_in_batch = 1;
+		if (pid == TRANSPORT_PAT_PID)
+			ts_monitor_count(mon, p, pid, COUNTER(pat_errors));
+		else if (p->flags & pid_flag_pmt)
+			ts_monitor_count(mon, p, pid, COUNTER(pmt_errors));
+	}
+
+	/* PCRs */
+	events = pcr_clock_add_packet(mon->clk, pkt);
+	if (events & pcr_clock_event_pcr) {
+		pcr = ts_monitor_pcr(buf);
+		if (p->pcr_valid && !discontinuity) {
+			delta = pcr_clock_delta(pcr, p->pcr);
+			if (delta > PCR_CLOCK_MAX_GAP)
+				ts_monitor_count(mon, p, pid, COUNTER(pcr_discontinuity_errors));
+			else if (delta > TS_MONITOR_PCR_INTERVAL)
+				ts_monitor_count(mon, p, pid, COUNTER(pcr_repetition_errors));
+		}
+		if (events & pcr_clock_event_jitter)
+			ts_monitor_count(mon, p, pid, COUNTER(pcr_accuracy_errors));
+
+		/* recordings are timed by the first PCR PID seen */
+		if (mon->flags & ts_monitor_flag_pcr_time) {
+			if (mon->time_pid < 0) {
+				mon->time_pid = pid;
+			} else if ((pid == mon->time_pid) && !discontinuity) {
+				delta = pcr_clock_delta(pcr, mon->time_pcr);
+				if (delta < PCR_TIME_MAX_STEP)
+					mon->now += (delta * 1000ULL) / 27ULL;
+			}
+			if (pid == mon->time_pid)
+				mon->time_pcr = pcr;
+		}
+
+		p->pcr = pcr;
+		p->pcr_valid = 1;
+	}
+
+	if (payload_len == 0)
+		return;
+
+	if ((p->flags & pid_flag_psi) && !scrambled) {
+		section_demux_add_payload(mon->sdemux, pid, payload, payload_len,
+					  pkt->payload_unit_start_indicator);
+	} else if ((p->flags & pid_flag_pts) && pkt->payload_unit_start_indicator && !scrambled) {
+		/* a PES header with an MPEG-2 PTS? */
+		if ((payload_len >= 14) &&
+		    (payload[0] == 0x00) && (payload[1] == 0x00) && (payload[2] == 0x01) &&
+		    ((payload[6] & 0xc0) == 0x80) && (payload[7] & 0x80))
+			p->pts_seen = mon->now;
+	}
+}
+
+static void ts_monitor_section(void *arg, int pid, uint8_t *section, int len)
+{
+	struct ts_monitor *mon = (struct ts_monitor *) arg;
+	struct ts_monitor_pid *p = mon->pids[pid];
+	int table_id;
+
+	if (section_view_check(section, len))
+		return;
+	table_id = section_view_table_id(section);
+
+	/* sections with a CRC: the long form ones, and the TOT */
+	if (section_view_syntax_indicator(section) || (table_id == stag_dvb_time_offset)) {
+		if ((len < CRC_SIZE) || crc32(CRC32_INIT, section, len)) {
+			ts_monitor_count(mon, p, pid, COUNTER(crc_errors));
+			return;
+		}
+	}
+
+	switch(pid) {
+	case TRANSPORT_PAT_PID:
+		if (table_id != stag_mpeg_program_association) {
+			ts_monitor_count(mon, p, pid, COUNTER(pat_errors));
+			return;
+		}
+		ts_monitor_pat(mon, section, len);
+		return;
+
+	case TRANSPORT_CAT_PID:
+		if (table_id != stag_mpeg_conditional_access) {
+			ts_monitor_count(mon, p, pid, COUNTER(cat_errors));
+			return;
+		}
+		mon->cat_seen = 1;
+		return;
+	}
+
+	if ((p->flags & pid_flag_pmt) && (table_id == stag_mpeg_program_map))
+		ts_monitor_pmt(mon, pid, section, len);
+}
+
+static void ts_monitor_pat(struct ts_monitor *mon, uint8_t *section, int len)
+{
+	struct ts_monitor_program *prog;
+	const uint8_t *pos;
+	int version;
+	int section_number;
+	int last_section_number;
+	int program_number;
+	int pmt_pid;
+	int i;
+
+	if (mpeg_pat_view_check(section, len) || !section_view_current_next_indicator(section))
+		return;
+
+	if (ts_monitor_overdue(mon->now, mon->pat_seen, &mon->pat_reported,
+			       TS_MONITOR_PSI_INTERVAL))
+		ts_monitor_count(mon, mon->pids[TRANSPORT_PAT_PID], TRANSPORT_PAT_PID,
+				 COUNTER(pat_errors));
+	mon->pat_seen = mon->now;
+
+	/* only look inside new sections */
+	version = section_view_version_number(section);
+	section_number = section_view_section_number(section);
+	last_section_number = section_view_last_section_number(section);
+	if (version != mon->pat_version) {
+		memset(mon->pat_sections, 0, sizeof(mon->pat_sections));
+		mon->pat_version = version;
+	}
+	if (mon->pat_sections[section_number >> 3] & (1 << (section_number & 7)))
+		return;
+	mon->pat_sections[section_number >> 3] |= 1 << (section_number & 7);
+
+	/* forget programs which were in this section, or in ones which no longer exist */
+	for(i=0; i < (int) mon->programs_used; i++) {
+		prog = &mon->program_slots[i];
+		if (prog->active && ((prog->pat_section == section_number) ||
+				     (prog->pat_section > last_section_number))) {
+			ts_monitor_set16(&prog->active, 0);
+			mon->refs_dirty = 1;
+		}
+	}
+
+	mpeg_pat_view_programs_for_each(section, pos) {
+		program_number = mpeg_pat_view_program_number(pos);
+		pmt_pid = mpeg_pat_view_program_pid(pos);
+
+		/* program 0 gives the network PID */
+		if (program_number == 0)
+			continue;
+
+		prog = ts_monitor_find_program(mon, program_number, 0);
+		if (prog == NULL) {
+			if (mon->programs_used == TS_MONITOR_MAX_PROGRAMS)
+				continue;
+			prog = &mon->program_slots[mon->programs_used];
+			ts_monitor_set16(&prog->program_number, program_number);
+			ts_monitor_set16(&prog->pmt_pid, TRANSPORT_NULL_PID);
+			__atomic_store_n(&mon->programs_used, mon->programs_used + 1,
+					 __ATOMIC_RELEASE);
+		}
+
+		/* a program which is new, or has moved, starts afresh */
+		if (prog->pmt_pid != pmt_pid) {
+			ts_monitor_set16(&prog->pmt_pid, pmt_pid);
+			ts_monitor_set16(&prog->pcr_pid, TRANSPORT_NULL_PID);
+			ts_monitor_set16(&prog->npids, 0);
+			prog->pmt_version = NO_VERSION;
+			prog->pmt_seen = mon->now;
+			prog->pmt_reported = mon->now;
+		}
+		if (!prog->active)
+			prog->pmt_reported = mon->now;
+		prog->pat_section = section_number;
+		ts_monitor_set16(&prog->active, 1);
+		mon->refs_dirty = 1;
+	}
+}
+
+static void ts_monitor_pmt(struct ts_monitor *mon, int pid, uint8_t *section, int len)
+{
+	struct ts_monitor_program *prog;
+	const uint8_t *pos;
+	int version;
+	int npids = 0;
+
+	if (mpeg_pmt_view_check(section, len) || !section_view_current_next_indicator(section))
+		return;
+	prog = ts_monitor_find_program(mon, mpeg_pmt_view_program_number(section), 1);
+	if ((prog == NULL) || (prog->pmt_pid != pid))
+		return;
+
+	if (ts_monitor_overdue(mon->now, prog->pmt_seen, &prog->pmt_reported,
+			       TS_MONITOR_PSI_INTERVAL))
+		ts_monitor_count(mon, mon->pids[pid], pid, COUNTER(pmt_errors));
+	prog->pmt_seen = mon->now;
+
+	version = section_view_version_number(section);
+	if (version == prog->pmt_version)
+		return;
+	prog->pmt_version = version;
+
+	ts_monitor_set16(&prog->pcr_pid, mpeg_pmt_view_pcr_pid(section));
+	mpeg_pmt_view_streams_for_each(section, pos) {
+		if (npids == TS_MONITOR_MAX_PROGRAM_PIDS)
+			break;
+		prog->types[npids] = mpeg_pmt_view_stream_type(pos);
+		ts_monitor_set16(&prog->pids[npids], mpeg_pmt_view_stream_pid(pos));
+		npids++;
+	}
+	ts_monitor_set16(&prog->npids, npids);
+	mon->refs_dirty = 1;
+}
+
+static void ts_monitor_ref(struct ts_monitor *mon, int pid, int flags, int program)
+{
+	struct ts_monitor_pid *p;
+
+	if ((p = ts_monitor_pid(mon, pid)) == NULL)
+		return;
+
+	if (p->flags == 0)
+		mon->refs[mon->nrefs++] = pid;
+	p->flags |= flags;
+	if (program)
+		p->programs++;
+
+	/* newly referenced PIDs get a full interval before they are missed */
+	if ((flags & pid_flag_ref) && !(p->old_flags & pid_flag_ref))
+		p->reported = mon->now;
+	if ((flags & pid_flag_pts) && !(p->old_flags & pid_flag_pts))
+		p->pts_reported = mon->now;
+}
+
+static void ts_monitor_update_refs(struct ts_monitor *mon)
+{
+	struct ts_monitor_program *prog;
+	struct ts_monitor_pid *p;
+	uint16_t *old;
+	int nold = mon->nrefs;
+	int programs = 0;
+	int i;
+	int j;
+
+	/* the old list is kept at the end of refs while the new one is built */
+	old = mon->refs + TRANSPORT_MAX_PIDS;
+	memcpy(old, mon->refs, nold * sizeof(uint16_t));
+	for(i=0; i < nold; i++) {
+		p = mon->pids[old[i]];
+		p->old_flags = p->flags;
+		p->flags = 0;
+		p->programs = 0;
+	}
+	mon->nrefs = 0;
+
+	for(i=0; i < (int) (sizeof(ts_monitor_psi_pids) / sizeof(uint16_t)); i++)
+		ts_monitor_ref(mon, ts_monitor_psi_pids[i], pid_flag_psi, 0);
+
+	for(i=0; i < (int) mon->programs_used; i++) {
+		prog = &mon->program_slots[i];
+		if (!prog->active)
+			continue;
+		programs++;
+
+		ts_monitor_ref(mon, prog->pmt_pid, pid_flag_psi | pid_flag_pmt, 1);
+		if (prog->pcr_pid != TRANSPORT_NULL_PID)
+			ts_monitor_ref(mon, prog->pcr_pid, pid_flag_pcr | pid_flag_ref, 1);
+		for(j=0; j < prog->npids; j++) {
+			ts_monitor_ref(mon, prog->pids[j],
+				       pid_flag_ref |
+				       (ts_monitor_av_stream(prog->types[j]) ? pid_flag_pts : 0), 1);
+		}
+	}
+
+	/* PIDs no longer referenced stop being reassembled */
+	for(i=0; i < nold; i++) {
+		p = mon->pids[old[i]];
+		if ((p->old_flags & pid_flag_psi) && !(p->flags & pid_flag_psi))
+			section_demux_reset_pid(mon->sdemux, old[i]);
+		p->old_flags = 0;
+	}
+
+	__atomic_store_n(&mon->programs, programs, __ATOMIC_RELAXED);
+	mon->refs_dirty = 0;
+}
+
+static void ts_monitor_check_intervals(struct ts_monitor *mon)
+{
+	struct ts_monitor_program *prog;
+	struct ts_monitor_pid *p;
+	uint64_t now = mon->now;
+	int pid;
+	int i;
+
+	if (ts_monitor_overdue(now, mon->pat_seen, &mon->pat_reported, TS_MONITOR_PSI_INTERVAL))
+		ts_monitor_count(mon, mon->pids[TRANSPORT_PAT_PID], TRANSPORT_PAT_PID,
+				 COUNTER(pat_errors));
+
+	for(i=0; i < (int) mon->programs_used; i++) {
+		prog = &mon->program_slots[i];
+		if (prog->active &&
+		    ts_monitor_overdue(now, prog->pmt_seen, &prog->pmt_reported,
+				       TS_MONITOR_PSI_INTERVAL))
+			ts_monitor_count(mon, mon->pids[prog->pmt_pid], prog->pmt_pid,
+					 COUNTER(pmt_errors));
+	}
+
+	for(i=0; i < mon->nrefs; i++) {
+		pid = mon->refs[i];
+		p = mon->pids[pid];
+
+		if ((p->flags & pid_flag_ref) &&
+		    ts_monitor_overdue(now, p->seen, &p->reported, mon->pid_timeout))
+			ts_monitor_count(mon, p, pid, COUNTER(pid_errors));
+		if ((p->flags & pid_flag_pts) &&
+		    ts_monitor_overdue(now, p->pts_seen, &p->pts_reported,
+				       TS_MONITOR_PTS_INTERVAL))
+			ts_monitor_count(mon, p, pid, COUNTER(pts_errors));
+	}
+
+	if (mon->scrambled_in_batch && !mon->cat_seen &&
+	    ts_monitor_overdue(now, 0, &mon->cat_reported, TS_MONITOR_PSI_INTERVAL))
+		ts_monitor_count(mon, mon->pids[TRANSPORT_CAT_PID], TRANSPORT_CAT_PID,
+				 COUNTER(cat_errors));
+}
+
+static void ts_monitor_count(struct ts_monitor *mon, struct ts_monitor_pid *p, int pid, int counter)
+{
+	struct ts_monitor_program *prog;
+	int i;
+	int j;
+
+	ts_monitor_inc(((uint64_t *) &mon->counters) + counter);
+	if (p == NULL)
+		return;
+	ts_monitor_inc(((uint64_t *) &p->counters) + counter);
+	if (p->programs == 0)
+		return;
+
+	for(i=0; i < (int) mon->programs_used; i++) {
+		prog = &mon->program_slots[i];
+		if (!prog->active)
+			continue;
+
+		if ((prog->pmt_pid == pid) || (prog->pcr_pid == pid)) {
+			ts_monitor_inc(((uint64_t *) &prog->counters) + counter);
+			continue;
+		}
+		for(j=0; j < prog->npids; j++) {
+			if (prog->pids[j] == pid) {
+				ts_monitor_inc(((uint64_t *) &prog->counters) + counter);
+				break;
+			}
+		}
+	}
+}
+
+static struct ts_monitor_pid *ts_monitor_pid(struct ts_monitor *mon, int pid)
+{
+	struct ts_monitor_pid *p = mon->pids[pid];
+
+	if (p != NULL)
+		return p;
+
+	p = (struct ts_monitor_pid *) malloc(sizeof(struct ts_monitor_pid));
+	if (p == NULL)
+		return NULL;
+	memset(p, 0, sizeof(struct ts_monitor_pid));
+	p->seen = mon->now;
+
+	/* publish it only once it is initialised */
+	__atomic_store_n(&mon->pids[pid], p, __ATOMIC_RELEASE);
+	return p;
+}
+
+static struct ts_monitor_program *ts_monitor_find_program(struct ts_monitor *mon,
+							  int program_number, int active)
+{
+	struct ts_monitor_program *prog;
+	int i;
+
+	for(i=0; i < (int) mon->programs_used; i++) {
+		prog = &mon->program_slots[i];
+		if ((prog->program_number == program_number) && (prog->active || !active))
+			return prog;
+	}
+	return NULL;
+}
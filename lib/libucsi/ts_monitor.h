@@ -0,0 +1,214 @@
+/**
+ * transport stream monitoring and error statistics.
+ *
+ * Copyright (c) 2026 by agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef _UCSI_TS_MONITOR_H
+#define _UCSI_TS_MONITOR_H 1
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <libucsi/transport_packet.h>
+#include <libucsi/pcr_clock.h>
+
+/**
+ * Maximum number of programs followed. Programs beyond this in the PAT are
+ * not checked individually.
+ */
+#define TS_MONITOR_MAX_PROGRAMS 256
+
+/**
+ * Maximum number of elementary streams followed per program.
+ */
+#define TS_MONITOR_MAX_PROGRAM_PIDS 64
+
+/**
+ * PAT and PMT sections must repeat at least this often (0.5s, in ns).
+ */
+#define TS_MONITOR_PSI_INTERVAL 500000000ULL
+
+/**
+ * PTSs of audio and video streams must repeat at least this often (0.7s, in ns).
+ */
+#define TS_MONITOR_PTS_INTERVAL 700000000ULL
+
+/**
+ * PCRs must repeat at least this often (40ms, in 27MHz ticks).
+ */
+#define TS_MONITOR_PCR_INTERVAL (PCR_CLOCK_HZ / 25)
+
+/**
+ * Default time a PID referred to by a PMT may be absent for (5s, in ns).
+ */
+#define TS_MONITOR_DEFAULT_PID_TIMEOUT 5000000000ULL
+
+/**
+ * Flags for ts_monitor_create().
+ */
+enum ts_monitor_flags {
+	/* time the stream by its PCRs, rather than the times passed with each batch */
+	ts_monitor_flag_pcr_time	= 0x01,
+};
+
+/**
+ * Counts of the ETSI TR 101 290 priority 1 and 2 indicators. The same
+ * structure is used for the whole stream, for each PID, and for each
+ * program; indicators which do not apply at a level are always zero.
+ */
+struct ts_monitor_counters {
+	uint64_t packets;			/* TS packets analysed */
+	uint64_t scrambled;			/* of which transport_scrambling_control was set */
+
+	/* priority 1 */
+	uint64_t sync_losses;			/* 1.1 TS_sync_loss */
+	uint64_t sync_byte_errors;		/* 1.2 Sync_byte_error */
+	uint64_t pat_errors;			/* 1.3 PAT_error_2 */
+	uint64_t cc_errors;			/* 1.4 Continuity_count_error */
+	uint64_t pmt_errors;			/* 1.5 PMT_error_2 */
+	uint64_t pid_errors;			/* 1.6 PID_error */
+
+	/* priority 2 */
+	uint64_t transport_errors;		/* 2.1 Transport_error */
+	uint64_t crc_errors;			/* 2.2 CRC_error */
+	uint64_t pcr_repetition_errors;		/* 2.3a PCR_repetition_error */
+	uint64_t pcr_discontinuity_errors;	/* 2.3b PCR_discontinuity_indicator_error */
+	uint64_t pcr_accuracy_errors;		/* 2.4 PCR_accuracy_error */
+	uint64_t pts_errors;			/* 2.5 PTS_error */
+	uint64_t cat_errors;			/* 2.6 CAT_error */
+};
+
+/**
+ * Overall state of a ts_monitor.
+ */
+struct ts_monitor_stats {
+	uint32_t in_sync;			/* nonzero while the stream is in sync */
+	uint32_t programs;			/* number of programs in the PAT */
+	struct ts_monitor_counters counters;	/* totals for the whole stream */
+};
+
+/**
+ * State of one program.
+ */
+struct ts_monitor_program_stats {
+	uint16_t program_number;
+	uint16_t pmt_pid;
+	uint16_t pcr_pid;			/* or 0x1fff if not known yet */
+	struct ts_monitor_counters counters;	/* errors on the program's PIDs */
+};
+
+/**
+ * Opaque type representing a transport stream health monitor, measuring
+ * the ETSI TR 101 290 priority 1 and 2 indicators continuously on every PID.
+ *
+ * Packets are analysed in batches, straight from the capture buffer. Each
+ * one costs a continuity check and a few counter updates; only the PSI/SI
+ * PIDs are reassembled into sections, and only audio and video PIDs have
+ * their PES headers looked at. Repetition intervals are measured with the
+ * time passed with each batch, so batches should be short compared with
+ * 40ms, or use ts_monitor_flag_pcr_time (e.g. for recordings).
+ *
+ * A ts_monitor must be fed from a single thread, but the statistics may be
+ * read at any time from any other thread without locking: every counter is
+ * read and written atomically, though a set of counters is not one
+ * consistent snapshot.
+ */
+struct ts_monitor;
+
+/**
+ * Create a new ts_monitor.
+ *
+ * @param flags Orred enum ts_monitor_flags.
+ * @param pid_timeout How long a PID referred to by a PMT may be absent for
+ * before a PID_error, in ns, or 0 for TS_MONITOR_DEFAULT_PID_TIMEOUT.
+ * @return The new instance, or NULL on error.
+ */
+extern struct ts_monitor *ts_monitor_create(int flags, uint64_t pid_timeout);
+
+/**
+ * Destroy a ts_monitor. No other thread may be reading its statistics.
+ *
+ * @param mon The instance to destroy.
+ */
+extern void ts_monitor_destroy(struct ts_monitor *mon);
+
+/**
+ * Analyse a batch of contiguous transport packets, e.g. as returned by
+ * dvbtsinput_read(). Sync is checked and regained as TR 101 290 describes,
+ * with the sync bytes counted across batches, so even batches of one packet
+ * regain it; if it is regained at a different offset, packets straddling
+ * the end of one batch and the start of the next are lost.
+ *
+ * @param mon The ts_monitor.
+ * @param buf The packets.
+ * @param count Number of packets.
+ * @param now Time the batch was received, in ns, from a monotonic clock
+ * (e.g. CLOCK_MONOTONIC). Ignored with ts_monitor_flag_pcr_time.
+ */
+extern void ts_monitor_add_packets(struct ts_monitor *mon, uint8_t *buf, int count,
+				   uint64_t now);
+
+/**
+ * Retrieve the overall state of a ts_monitor. May be called from any thread.
+ *
+ * @param mon The ts_monitor.
+ * @param stats Where to put the state.
+ */
+extern void ts_monitor_get_stats(struct ts_monitor *mon, struct ts_monitor_stats *stats);
+
+/**
+ * Retrieve the counters for one PID. May be called from any thread.
+ *
+ * @param mon The ts_monitor.
+ * @param pid The PID.
+ * @param counters Where to put the counters.
+ * @return 0 on success, or -EINVAL if the PID is out of range.
+ */
+extern int ts_monitor_get_pid_stats(struct ts_monitor *mon, int pid,
+				    struct ts_monitor_counters *counters);
+
+/**
+ * List the programs currently in the PAT. May be called from any thread.
+ *
+ * @param mon The ts_monitor.
+ * @param program_numbers Where to put the program_numbers.
+ * @param max Size of program_numbers.
+ * @return Number of program_numbers stored.
+ */
+extern int ts_monitor_get_programs(struct ts_monitor *mon, uint16_t *program_numbers, int max);
+
+/**
+ * Retrieve the state of one program. May be called from any thread.
+ *
+ * @param mon The ts_monitor.
+ * @param program_number The program_number.
+ * @param stats Where to put the state.
+ * @return 0 on success, or -ENOENT if the program is not in the PAT.
+ */
+extern int ts_monitor_get_program_stats(struct ts_monitor *mon, int program_number,
+					struct ts_monitor_program_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,510 @@
+/**
+ * ULE SNDU reassembly from transport stream packets.
+ *
+ * Copyright (c) 2026 by agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <libucsi/crc32.h>
+#include "ule_demux.h"
+
+/* the D bit and Length field, then the Type field */
+#define ULE_HDR_SIZE 4
+#define ULE_NPA_SIZE 6
+#define ULE_CRC_SIZE 4
+#define ULE_ETH_HDR_SIZE 14
+
+/* Type fields below this are Next-Headers (RFC 4326 section 4.4) */
+#define ULE_TYPE_MIN_ETHERTYPE 0x0600
+
+/* the H-LEN field of a Next-Header; 6 and 7 (Type 0x0600-0x07ff) are reserved */
+#define ULE_HLEN(type) (((type) >> 8) & 0x07)
+#define ULE_MAX_HLEN 5
+#define ULE_TYPE_HLEN_MASK 0xf800
+
+/* mandatory extension headers (H-LEN 0) */
+#define ULE_EXT_TEST_SNDU 0x0000
+#define ULE_EXT_BRIDGED_FRAME 0x0001
+
+#define ETHERTYPE_IPV4 0x0800
+#define ETHERTYPE_IPV6 0x86dd
+
+struct ule_demux_pid {
+	struct ule_demux_pid_stats stats;
+	uint8_t *sndu;			/* the SNDU being reassembled */
+	int have;			/* bytes of it received so far */
+	int need;			/* its full size, or 0 until the Length field is known */
+	int synced;			/* nonzero once a Payload Pointer has been followed */
+	int last_cc;			/* continuity_counter of the last payload, or -1 */
+	unsigned char continuity;
+	uint16_t pid;
+};
+
+struct ule_demux {
+	/* index+1 into pids for each PID, 0 if not added */
+	uint16_t pid_index[TRANSPORT_MAX_PIDS];
+	struct ule_demux_pid *pids;
+	int pids_count;
+	int pids_alloc;
+
+	/* wanted NPA addresses, as 48 bit integers */
+	uint64_t *npas;
+	int npas_count;
+	int flags;
+
+	/* the packet pool: packets[0..used) are waiting to be delivered */
+	uint8_t *pool;
+	struct ule_demux_packet *packets;
+	int pool_size;
+	int used;
+
+	ule_demux_callback callback;
+	void *arg;
+
+	uint64_t batches;
+};
+
+static void ule_demux_resync(struct ule_demux_pid *p);
+static int ule_demux_sndu_size(uint8_t *hdr);
+static void ule_demux_payload(struct ule_demux *udemux, struct ule_demux_pid *p,
+			      uint8_t *data, int len);
+static void ule_demux_sndu(struct ule_demux *udemux, struct ule_demux_pid *p,
+			   uint8_t *sndu, int size);
+static int ule_demux_npa_wanted(struct ule_demux *udemux, uint64_t npa);
+
+struct ule_demux *ule_demux_create(int pool_size, int flags,
+				   ule_demux_callback callback, void *arg)
+{
+	struct ule_demux *udemux;
+	int i;
+
+	if ((pool_size <= 0) || (callback == NULL))
+		return NULL;
+
+	udemux = (struct ule_demux *) malloc(sizeof(struct ule_demux));
+	if (udemux == NULL)
+		return NULL;
+	memset(udemux, 0, sizeof(struct ule_demux));
+	udemux->flags = flags;
+	udemux->pool_size = pool_size;
+	udemux->callback = callback;
+	udemux->arg = arg;
+
+	udemux->pool = (uint8_t *) malloc((size_t) pool_size * ULE_DEMUX_PACKET_SIZE);
+	udemux->packets = (struct ule_demux_packet *)
+		malloc(pool_size * sizeof(struct ule_demux_packet));
+	if ((udemux->pool == NULL) || (udemux->packets == NULL)) {
+		ule_demux_destroy(udemux);
+		return NULL;
+	}
+
+	for(i=0; i < pool_size; i++)
+		udemux->packets[i].data = udemux->pool + ((size_t) i * ULE_DEMUX_PACKET_SIZE);
+
+	return udemux;
+}
+
+void ule_demux_destroy(struct ule_demux *udemux)
+{
+	int i;
+
+	for(i=0; i < udemux->pids_count; i++)
+		free(udemux->pids[i].sndu);
+	free(udemux->packets);
+	free(udemux->pool);
+	free(udemux->npas);
+	free(udemux->pids);
+	free(udemux);
+}
+
+int ule_demux_add_pid(struct ule_demux *udemux, int pid)
+{
+	struct ule_demux_pid *p;
+	uint8_t *sndu;
+
+	if ((pid < 0) || (pid >= TRANSPORT_MAX_PIDS))
+		return -EINVAL;
+	if (udemux->pid_index[pid])
+		return 0;
+
+	if (udemux->pids_count == udemux->pids_alloc) {
+		int newalloc = udemux->pids_alloc ? udemux->pids_alloc * 2 : 16;
+
+		p = (struct ule_demux_pid *)
+			realloc(udemux->pids, newalloc * sizeof(struct ule_demux_pid));
+		if (p == NULL)
+			return -ENOMEM;
+		udemux->pids = p;
+		udemux->pids_alloc = newalloc;
+	}
+	if ((sndu = (uint8_t *) malloc(ULE_MAX_SNDU_SIZE)) == NULL)
+		return -ENOMEM;
+
+	p = &udemux->pids[udemux->pids_count++];
+	memset(p, 0, sizeof(struct ule_demux_pid));
+	p->sndu = sndu;
+	p->last_cc = -1;
+	p->pid = pid;
+	udemux->pid_index[pid] = udemux->pids_count;
+
+	return 0;
+}
+
+int ule_demux_add_npa(struct ule_demux *udemux, const uint8_t npa[6])
+{
+	uint64_t *npas;
+	uint64_t key = 0;
+	int i;
+
+	for(i=0; i < 6; i++)
+		key = (key << 8) | npa[i];
+	if (ule_demux_npa_wanted(udemux, key))
+		return 0;
+
+	npas = (uint64_t *) realloc(udemux->npas, (udemux->npas_count + 1) * sizeof(uint64_t));
+	if (npas == NULL)
+		return -ENOMEM;
+	npas[udemux->npas_count++] = key;
+	udemux->npas = npas;
+
+	return 0;
+}
+
+int ule_demux_add_packet(struct ule_demux *udemux,
+			 struct transport_packet *pkt)
+{
+	struct ule_demux_pid *p;
+	struct transport_values tsvals;
+	int pid = transport_packet_pid(pkt);
+	int discontinuity;
+	uint8_t *payload;
+	int len;
+	int pp;
+
+	if (udemux->pid_index[pid] == 0)
+		return 0;
+	p = &udemux->pids[udemux->pid_index[pid] - 1];
+	p->stats.packets++;
+
+	if (pkt->transport_error_indicator || pkt->transport_scrambling_control ||
+	    (transport_packet_values_extract(pkt, &tsvals, 0) < 0)) {
+		p->stats.ts_errors++;
+		ule_demux_resync(p);
+		return -EINVAL;
+	}
+
+	discontinuity = tsvals.flags & transport_adaptation_flag_discontinuity;
+	if (transport_packet_continuity_check(pkt, discontinuity, &p->continuity)) {
+		p->continuity = 0;
+		p->stats.continuity_errors++;
+		ule_demux_resync(p);
+		return -EPROTO;
+	}
+	if (tsvals.payload_length == 0)
+		return 0;
+
+	/* a duplicate passes the continuity check, but must not be used twice */
+	if (!discontinuity && (pkt->continuity_counter == p->last_cc))
+		return 0;
+	p->last_cc = pkt->continuity_counter;
+
+	payload = tsvals.payload;
+	len = tsvals.payload_length;
+	if (!pkt->payload_unit_start_indicator) {
+		if (p->synced)
+			ule_demux_payload(udemux, p, payload, len);
+		return 0;
+	}
+
+	/* the Payload Pointer gives where the first SNDU starting here begins */
+	pp = payload[0];
+	payload++;
+	len--;
+	if (pp >= len) {
+		p->stats.pp_errors++;
+		ule_demux_resync(p);
+		return -EINVAL;
+	}
+
+	/* the SNDU in progress must end exactly there */
+	if (p->synced) {
+		ule_demux_payload(udemux, p, payload, pp);
+		if (p->have)
+			p->stats.pp_errors++;
+	}
+	p->have = 0;
+	p->need = 0;
+	p->synced = 1;
+	ule_demux_payload(udemux, p, payload + pp, len - pp);
+
+	return 0;
+}
+
+void ule_demux_add_packets(struct ule_demux *udemux, uint8_t *buf, int count)
+{
+	struct transport_packet *pkt;
+	int i;
+
+	for(i=0; i < count; i++, buf += TRANSPORT_PACKET_LENGTH) {
+		if ((pkt = transport_packet_init(buf)) == NULL)
+			continue;
+		ule_demux_add_packet(udemux, pkt);
+	}
+}
+
+void ule_demux_flush(struct ule_demux *udemux)
+{
+	if (udemux->used == 0)
+		return;
+
+	udemux->callback(udemux->arg, udemux->packets, udemux->used);
+	udemux->used = 0;
+	udemux->batches++;
+}
+
+void ule_demux_get_stats(struct ule_demux *udemux,
+			 struct ule_demux_stats *stats)
+{
+	struct ule_demux_pid_stats *t = &stats->total;
+	int i;
+
+	memset(stats, 0, sizeof(struct ule_demux_stats));
+	stats->pids = udemux->pids_count;
+	stats->pool_size = udemux->pool_size;
+	stats->batches = udemux->batches;
+
+	for(i=0; i < udemux->pids_count; i++) {
+		struct ule_demux_pid_stats *s = &udemux->pids[i].stats;
+
+		t->packets += s->packets;
+		t->sndus += s->sndus;
+		t->pdus += s->pdus;
+		t->bytes += s->bytes;
+		t->npa_filtered += s->npa_filtered;
+		t->crc_errors += s->crc_errors;
+		t->test_sndus += s->test_sndus;
+		t->unsupported += s->unsupported;
+		t->invalid += s->invalid;
+		t->extensions += s->extensions;
+		t->pp_errors += s->pp_errors;
+		t->continuity_errors += s->continuity_errors;
+		t->ts_errors += s->ts_errors;
+	}
+}
+
+int ule_demux_get_pid_stats(struct ule_demux *udemux, int pid,
+			    struct ule_demux_pid_stats *stats)
+{
+	if ((pid < 0) || (pid >= TRANSPORT_MAX_PIDS) || (udemux->pid_index[pid] == 0))
+		return -ENOENT;
+
+	memcpy(stats, &udemux->pids[udemux->pid_index[pid] - 1].stats,
+	       sizeof(struct ule_demux_pid_stats));
+	return 0;
+}
+
+static void ule_demux_resync(struct ule_demux_pid *p)
+{
+	p->have = 0;
+	p->need = 0;
+	p->synced = 0;
+	p->last_cc = -1;
+}
+
+static void ule_demux_payload(struct ule_demux *udemux, struct ule_demux_pid *p,
+			      uint8_t *data, int len)
+{
+	int n;
+
+	while(len > 0) {
+		if (p->have == 0) {
+			/* the End Indicator: the rest of the packet is padding */
+			if ((data[0] == 0xff) && ((len == 1) || (data[1] == 0xff)))
+				return;
+
+			/* an SNDU wholly within this packet can be used in place */
+			if (len >= 2) {
+				n = ule_demux_sndu_size(data);
+				if ((n > 0) && (n <= len)) {
+					ule_demux_sndu(udemux, p, data, n);
+					data += n;
+					len -= n;
+					continue;
+				}
+			}
+		}
+
+		/* the D bit and Length field may themselves be split across packets */
+		if (p->have < 2) {
+			p->sndu[p->have++] = *data++;
+			len--;
+			if (p->have < 2)
+				continue;
+
+			if ((p->need = ule_demux_sndu_size(p->sndu)) < 0) {
+				p->stats.pp_errors++;
+				ule_demux_resync(p);
+				return;
+			}
+			continue;
+		}
+
+		n = p->need - p->have;
+		if (n > len)
+			n = len;
+		memcpy(p->sndu + p->have, data, n);
+		p->have += n;
+		data += n;
+		len -= n;
+
+		if (p->have == p->need) {
+			ule_demux_sndu(udemux, p, p->sndu, p->need);
+			p->have = 0;
+			p->need = 0;
+		}
+	}
+}
+
+static int ule_demux_sndu_size(uint8_t *hdr)
+{
+	int length = ((hdr[0] & 0x7f) << 8) | hdr[1];
+
+	/* the Length counts everything after the Type field, including the CRC32 */
+	if (length < ULE_CRC_SIZE + ((hdr[0] & 0x80) ? 0 : ULE_NPA_SIZE))
+		return -1;
+	return ULE_HDR_SIZE + length;
+}
+
+static void ule_demux_sndu(struct ule_demux *udemux, struct ule_demux_pid *p,
+			   uint8_t *sndu, int size)
+{
+	struct ule_demux_packet *out;
+	uint64_t npa = 0;
+	uint16_t type;
+	int pos = ULE_HDR_SIZE;
+	int end = size - ULE_CRC_SIZE;
+	int hlen;
+	int i;
+
+	p->stats.sndus++;
+
+	/* the CRC32 covers the whole SNDU, so checking it through the CRC leaves 0 */
+	if (crc32(CRC32_INIT, sndu, size)) {
+		p->stats.crc_errors++;
+		return;
+	}
+
+	/* the D bit is clear if a destination NPA address follows the Type field */
+	if (!(sndu[0] & 0x80)) {
+		for(i=0; i < ULE_NPA_SIZE; i++)
+			npa = (npa << 8) | sndu[pos + i];
+		if (!(udemux->flags & ule_demux_flag_promiscuous) &&
+		    !((udemux->flags & ule_demux_flag_multicast) && (sndu[pos] & 0x01)) &&
+		    !ule_demux_npa_wanted(udemux, npa)) {
+			p->stats.npa_filtered++;
+			return;
+		}
+		pos += ULE_NPA_SIZE;
+	}
+
+	/* follow the chain of extension headers until the Type is an ethertype */
+	type = (sndu[2] << 8) | sndu[3];
+	while(!(type & ULE_TYPE_HLEN_MASK)) {
+		hlen = ULE_HLEN(type);
+
+		/* a reserved H-LEN: the SNDU can't be decoded */
+		if (hlen > ULE_MAX_HLEN) {
+			p->stats.invalid++;
+			return;
+		}
+
+		if (hlen) {
+			/* optional: 2*H-LEN bytes, the last two being the next Type */
+			if (pos + (2 * hlen) > end) {
+				p->stats.invalid++;
+				return;
+			}
+			pos += 2 * hlen;
+			type = (sndu[pos - 2] << 8) | sndu[pos - 1];
+			p->stats.extensions++;
+			continue;
+		}
+
+		/* mandatory: the SNDU must be discarded unless it is understood */
+		switch(type) {
+		case ULE_EXT_TEST_SNDU:
+			p->stats.test_sndus++;
+			return;
+
+		case ULE_EXT_BRIDGED_FRAME:
+			/* an Ethernet frame without its FCS; only the ethertype is used */
+			if (pos + ULE_ETH_HDR_SIZE > end) {
+				p->stats.invalid++;
+				return;
+			}
+			type = (sndu[pos + 12] << 8) | sndu[pos + 13];
+			pos += ULE_ETH_HDR_SIZE;
+			if (type < ULE_TYPE_MIN_ETHERTYPE) {
+				/* an IEEE 802.3 length; LLC frames are not supported */
+				p->stats.unsupported++;
+				return;
+			}
+			break;
+
+		default:
+			p->stats.unsupported++;
+			return;
+		}
+	}
+
+	if ((type != ETHERTYPE_IPV4) && (type != ETHERTYPE_IPV6)) {
+		p->stats.unsupported++;
+		return;
+	}
+	if ((pos >= end) || (end - pos > ULE_DEMUX_PACKET_SIZE)) {
+		p->stats.invalid++;
+		return;
+	}
+
+	out = &udemux->packets[udemux->used++];
+	memcpy(out->data, sndu + pos, end - pos);
+	out->len = end - pos;
+	out->pid = p->pid;
+	out->protocol = type;
+	for(i=0; i < ULE_NPA_SIZE; i++)
+		out->npa[i] = npa >> (8 * (ULE_NPA_SIZE - 1 - i));
+
+	p->stats.pdus++;
+	p->stats.bytes += end - pos;
+
+	/* the pool is full: hand it over, then we're guaranteed room */
+	if (udemux->used == udemux->pool_size)
+		ule_demux_flush(udemux);
+}
+
+static int ule_demux_npa_wanted(struct ule_demux *udemux, uint64_t npa)
+{
+	int i;
+
+	for(i=0; i < udemux->npas_count; i++) {
+		if (udemux->npas[i] == npa)
+			return 1;
+	}
+	return 0;
+}
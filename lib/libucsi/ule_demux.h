@@ -0,0 +1,234 @@
+/**
+ * ULE SNDU reassembly from transport stream packets.
+ *
+ * Copyright (c) 2026 by agent <agent@local>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef _UCSI_ULE_DEMUX_H
+#define _UCSI_ULE_DEMUX_H 1
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <libucsi/transport_packet.h>
+
+/**
+ * Largest possible SNDU: the 4 byte header, and up to 32767 bytes counted by
+ * its Length field.
+ */
+#define ULE_MAX_SNDU_SIZE (4 + 0x7fff)
+
+/**
+ * Size of each buffer in the packet pool: enough for the largest PDU an SNDU
+ * can carry.
+ */
+#define ULE_DEMUX_PACKET_SIZE 32768
+
+/**
+ * Default number of packets in the pool (and so in each delivered batch).
+ */
+#define ULE_DEMUX_DEFAULT_POOL 64
+
+/**
+ * Flags for ule_demux_create().
+ */
+enum ule_demux_flags {
+	/* accept every destination NPA address, regardless of the configured list */
+	ule_demux_flag_promiscuous	= 0x01,
+	/* also accept group (multicast and broadcast) NPA addresses */
+	ule_demux_flag_multicast	= 0x02,
+};
+
+/**
+ * A received PDU. The data lives in the demux's packet pool.
+ */
+struct ule_demux_packet {
+	uint8_t *data;		/* the PDU */
+	uint16_t len;		/* its length */
+	uint16_t pid;		/* PID it arrived on */
+	uint16_t protocol;	/* ethertype: 0x0800 (IPv4) or 0x86dd (IPv6) */
+	uint8_t npa[6];		/* destination NPA address, most significant byte first
+				   (all zero if the SNDU had none) */
+};
+
+/**
+ * Per-PID statistics maintained by a ule_demux. Every SNDU reassembled is
+ * counted in exactly one of pdus or the drop counters.
+ */
+struct ule_demux_pid_stats {
+	uint64_t packets;		/* TS packets received */
+	uint64_t sndus;			/* SNDUs reassembled */
+	uint64_t pdus;			/* PDUs delivered */
+	uint64_t bytes;			/* bytes of PDU delivered */
+	uint64_t npa_filtered;		/* dropped: destination NPA address not wanted */
+	uint64_t crc_errors;		/* dropped: CRC32 mismatch */
+	uint64_t test_sndus;		/* dropped: Test SNDUs */
+	uint64_t unsupported;		/* dropped: unknown mandatory extension header,
+					   or not IPv4/IPv6 */
+	uint64_t invalid;		/* dropped: malformed SNDU or extension header */
+	uint64_t extensions;		/* optional extension headers skipped */
+	uint64_t pp_errors;		/* partial SNDUs abandoned: Payload Pointer mismatch,
+					   or bad Length field */
+	uint64_t continuity_errors;	/* TS packets with a continuity error
+					   (any partial SNDU is abandoned) */
+	uint64_t ts_errors;		/* TS packets with transport_error_indicator set,
+					   scrambled, or otherwise unusable */
+};
+
+/**
+ * Statistics maintained by a ule_demux, totalled over all PIDs.
+ */
+struct ule_demux_stats {
+	uint32_t pids;			/* number of PIDs added */
+	uint32_t pool_size;		/* number of packets in the pool */
+	uint64_t batches;		/* batches delivered to the callback */
+	struct ule_demux_pid_stats total;
+};
+
+/**
+ * Callback receiving a batch of PDUs, in arrival order. The packet buffers go
+ * back to the pool when the callback returns, so it must have finished with
+ * them (e.g. written them out) by then. The callback must not feed more data
+ * into the ule_demux.
+ *
+ * @param arg Private argument supplied to ule_demux_create().
+ * @param packets The PDUs.
+ * @param count Number of PDUs (1 to the pool size).
+ */
+typedef void (*ule_demux_callback)(void *arg, struct ule_demux_packet *packets, int count);
+
+/**
+ * Opaque type representing a userspace Unidirectional Lightweight
+ * Encapsulation (RFC 4326) receiver.
+ *
+ * SNDUs are reassembled from any number of PIDs, including SNDUs packed
+ * back to back and split across TS packets. Each one's CRC32 is checked, its
+ * extension headers processed (RFC 4326 section 5: Test SNDUs are discarded,
+ * Bridged-Frame SNDUs have their MAC header removed, optional extension
+ * headers are skipped, and SNDUs with other mandatory extension headers, or
+ * with the reserved H-LEN values 6 and 7, are discarded), and it is filtered on its destination NPA address. The IPv4
+ * and IPv6 PDUs are copied into a preallocated pool of packet buffers, and
+ * handed to the callback in batches when the pool fills up, or when
+ * ule_demux_flush() is called.
+ *
+ * A ule_demux is not thread safe; to spread a feed across cores, give each
+ * thread its own ule_demux with a share of the PIDs.
+ */
+struct ule_demux;
+
+/**
+ * Create a new ule_demux.
+ *
+ * @param pool_size Number of packet buffers, i.e. the largest batch the
+ * callback will receive (e.g. ULE_DEMUX_DEFAULT_POOL).
+ * @param flags Orred enum ule_demux_flags.
+ * @param callback Callback to receive the PDUs.
+ * @param arg Private argument to pass to the callback.
+ * @return The new instance, or NULL on error.
+ */
+extern struct ule_demux *ule_demux_create(int pool_size, int flags,
+					  ule_demux_callback callback, void *arg);
+
+/**
+ * Destroy a ule_demux. Any PDUs not yet delivered are discarded.
+ *
+ * @param udemux The instance to destroy.
+ */
+extern void ule_demux_destroy(struct ule_demux *udemux);
+
+/**
+ * Start receiving SNDUs on a PID. Packets for PIDs which have not been added
+ * are ignored. Reception starts at the first TS packet with
+ * payload_unit_start_indicator set.
+ *
+ * @param udemux The ule_demux.
+ * @param pid The PID.
+ * @return 0 on success, or a negative error code.
+ */
+extern int ule_demux_add_pid(struct ule_demux *udemux, int pid);
+
+/**
+ * Add a destination NPA address to accept. Unless ule_demux_flag_promiscuous
+ * was given, only SNDUs for the addresses added, SNDUs without one (D bit
+ * set), and, with ule_demux_flag_multicast, SNDUs for group addresses are
+ * delivered.
+ *
+ * @param udemux The ule_demux.
+ * @param npa The NPA address, most significant byte first.
+ * @return 0 on success, or a negative error code.
+ */
+extern int ule_demux_add_npa(struct ule_demux *udemux, const uint8_t npa[6]);
+
+/**
+ * Process a transport packet. The continuity counter is checked.
+ *
+ * @param udemux The ule_demux.
+ * @param pkt The transport packet.
+ * @return 0 on success (including packets for PIDs not added), -EPROTO on a
+ * continuity error, or another negative error code if the packet was invalid.
+ */
+extern int ule_demux_add_packet(struct ule_demux *udemux,
+				struct transport_packet *pkt);
+
+/**
+ * Process a buffer of contiguous transport packets, e.g. as returned by
+ * dvbtsinput_read(). Errors are counted in the statistics.
+ *
+ * @param udemux The ule_demux.
+ * @param buf The packets.
+ * @param count Number of packets.
+ */
+extern void ule_demux_add_packets(struct ule_demux *udemux, uint8_t *buf, int count);
+
+/**
+ * Deliver any PDUs waiting in the pool to the callback now. Call this after
+ * each read from a live source, so PDUs are not held back waiting for the
+ * pool to fill.
+ *
+ * @param udemux The ule_demux.
+ */
+extern void ule_demux_flush(struct ule_demux *udemux);
+
+/**
+ * Retrieve the statistics of a ule_demux.
+ *
+ * @param udemux The ule_demux.
+ * @param stats Where to put the statistics.
+ */
+extern void ule_demux_get_stats(struct ule_demux *udemux,
+				struct ule_demux_stats *stats);
+
+/**
+ * Retrieve the statistics for one PID.
+ *
+ * @param udemux The ule_demux.
+ * @param pid The PID.
+ * @param stats Where to put the statistics.
+ * @return 0 on success, or -ENOENT if the PID has not been added.
+ */
+extern int ule_demux_get_pid_stats(struct ule_demux *udemux, int pid,
+				   struct ule_demux_pid_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
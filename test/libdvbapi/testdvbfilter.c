@@ -0,0 +1,413 @@
+/*
+ * dvbfilter pool test application.
+ *
+ * Copyright (C) 2026 agent (agent@local)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/eventfd.h>
+#include <libdvbapi/dvbdemux.h>
+#include <libdvbapi/dvbfilter.h>
+
+/*
+ * The pool is run against the stub demux below rather than a real device:
+ * every demux fd is an eventfd, which a check makes readable by writing to
+ * it. These definitions stand in for the ones in libdvbapi's dvbdemux.o.
+ */
+
+#define STUB_MAX_FDS 1024
+
+struct stub_state {
+	int opens;
+	int add_pid_errno;		/* errno for dvbdemux_add_pid(), or 0 */
+	int add_pids;
+	int remove_pids;
+	int last_removed_pid;
+	int stops[STUB_MAX_FDS];
+	int output[STUB_MAX_FDS];
+};
+
+static struct stub_state stub;
+
+int dvbdemux_open_demux(int adapter, int demuxdevice, int nonblocking)
+{
+	(void) adapter;
+	(void) demuxdevice;
+	(void) nonblocking;
+
+	stub.opens++;
+	return eventfd(0, EFD_NONBLOCK);
+}
+
+int dvbdemux_set_section_filter(int fd, int pid, uint8_t filter[18], uint8_t mask[18],
+				int start, int checkcrc)
+{
+	(void) pid;
+	(void) filter;
+	(void) mask;
+	(void) start;
+	(void) checkcrc;
+
+	stub.output[fd] = DVBDEMUX_OUTPUT_DEMUX;
+	return 0;
+}
+
+int dvbdemux_set_pes_filter(int fd, int pid, int input, int output, int pestype, int start)
+{
+	(void) pid;
+	(void) input;
+	(void) pestype;
+	(void) start;
+
+	stub.output[fd] = output;
+	return 0;
+}
+
+int dvbdemux_set_pid_filter(int fd, int pid, int input, int output, int start)
+{
+	(void) pid;
+	(void) input;
+	(void) start;
+
+	stub.output[fd] = output;
+	return 0;
+}
+
+int dvbdemux_add_pid(int fd, int pid)
+{
+	(void) fd;
+	(void) pid;
+
+	if (stub.add_pid_errno) {
+		errno = stub.add_pid_errno;
+		return -1;
+	}
+	stub.add_pids++;
+	return 0;
+}
+
+int dvbdemux_remove_pid(int fd, int pid)
+{
+	(void) fd;
+
+	stub.remove_pids++;
+	stub.last_removed_pid = pid;
+	return 0;
+}
+
+int dvbdemux_stop(int fd)
+{
+	stub.stops[fd]++;
+	return 0;
+}
+
+int reuse_check(void);
+int dispatch_check(void);
+int shared_check(void);
+int fallback_check(void);
+
+int main(int argc, char *argv[])
+{
+	(void) argc;
+	(void) argv;
+
+	// check stopped fds are reused for the next filter
+	if (reuse_check()) {
+		fprintf(stderr, "XXXX fd reuse check failed\n");
+		exit(1);
+	}
+
+	// check callbacks run, and events for replaced filters are dropped
+	if (dispatch_check()) {
+		fprintf(stderr, "XXXX dispatch check failed\n");
+		exit(1);
+	}
+
+	// check TS demux PIDs share one fd, and are reference counted
+	if (shared_check()) {
+		fprintf(stderr, "XXXX shared fd check failed\n");
+		exit(1);
+	}
+
+	// check a kernel without DMX_ADD_PID gets one fd per PID
+	if (fallback_check()) {
+		fprintf(stderr, "XXXX DMX_ADD_PID fallback check failed\n");
+		exit(1);
+	}
+
+	printf("dvbfilter checks passed\n");
+	return 0;
+}
+
+static void check_callback(struct dvbfilter_pool *pool, int filter, int fd, void *arg)
+{
+	(void) pool;
+	(void) filter;
+	(void) fd;
+	(*(int *) arg)++;
+}
+
+int reuse_check(void)
+{
+	struct dvbfilter_pool *pool;
+	struct dvbfilter_pool_stats stats;
+	uint8_t filter[18];
+	uint8_t mask[18];
+	int calls = 0;
+	int a, b;
+	int fd;
+	int ret = -1;
+
+	memset(&stub, 0, sizeof(stub));
+	memset(filter, 0, sizeof(filter));
+	memset(mask, 0, sizeof(mask));
+	if ((pool = dvbfilter_pool_create(0, 0)) == NULL)
+		return -1;
+
+	if ((a = dvbfilter_add_section(pool, 0x10, filter, mask, 1, NULL, NULL)) < 0)
+		goto exit;
+	fd = dvbfilter_get_fd(pool, a);
+
+	// a removed filter's fd is stopped, and set up again for the next one
+	if (dvbfilter_remove(pool, a) || (stub.stops[fd] != 1) ||
+	    (dvbfilter_remove(pool, a) != -EINVAL) || (dvbfilter_get_fd(pool, a) != -EINVAL))
+		goto exit;
+	if ((b = dvbfilter_add_pid(pool, 0x20, DVBDEMUX_OUTPUT_DEMUX, check_callback, &calls)) < 0)
+		goto exit;
+	if ((dvbfilter_get_fd(pool, b) != fd) || (stub.output[fd] != DVBDEMUX_OUTPUT_DEMUX) ||
+	    (stub.opens != 1))
+		goto exit;
+
+	// nothing is read from a DVR filter, so it cannot have a callback
+	if (dvbfilter_add_pid(pool, 0x21, DVBDEMUX_OUTPUT_DVR, check_callback, &calls) != -EINVAL)
+		goto exit;
+
+	dvbfilter_remove_all(pool);
+	dvbfilter_pool_get_stats(pool, &stats);
+	if ((stats.filters != 0) || (stats.fds != 1) || (stats.fds_opened != 1) ||
+	    (stats.fds_reused != 1))
+		goto exit;
+	ret = 0;
+
+exit:
+	dvbfilter_pool_destroy(pool);
+	return ret;
+}
+
+struct dispatch_check_state {
+	int filters[2];
+	int fds[2];
+	int calls[2];
+	int replacement;
+	int replacement_calls;
+	int stale;
+};
+
+static void dispatch_check_replacement(struct dvbfilter_pool *pool, int filter, int fd, void *arg)
+{
+	struct dispatch_check_state *st = (struct dispatch_check_state *) arg;
+	uint64_t val;
+
+	(void) pool;
+	if ((filter != st->replacement) || (read(fd, &val, sizeof(val)) != sizeof(val)))
+		st->stale++;
+	st->replacement_calls++;
+}
+
+static void dispatch_check_callback(struct dvbfilter_pool *pool, int filter, int fd, void *arg)
+{
+	struct dispatch_check_state *st = (struct dispatch_check_state *) arg;
+	uint8_t sfilter[18];
+	uint8_t mask[18];
+	uint64_t val;
+	int i = (filter == st->filters[0]) ? 0 : 1;
+
+	if ((filter != st->filters[i]) || (fd != st->fds[i]) ||
+	    (read(fd, &val, sizeof(val)) != sizeof(val))) {
+		st->stale++;
+		return;
+	}
+	st->calls[i]++;
+
+	// replace the other filter; the new one takes over its ID and its
+	// fd, which is still readable and still has an event pending
+	memset(sfilter, 0, sizeof(sfilter));
+	memset(mask, 0, sizeof(mask));
+	dvbfilter_remove(pool, st->filters[!i]);
+	st->replacement = dvbfilter_add_section(pool, 0x12, sfilter, mask, 1,
+						dispatch_check_replacement, st);
+}
+
+int dispatch_check(void)
+{
+	struct dvbfilter_pool *pool;
+	struct dispatch_check_state st;
+	uint8_t filter[18];
+	uint8_t mask[18];
+	uint64_t one = 1;
+	int i;
+	int ret = -1;
+
+	memset(&stub, 0, sizeof(stub));
+	memset(&st, 0, sizeof(st));
+	memset(filter, 0, sizeof(filter));
+	memset(mask, 0, sizeof(mask));
+	if ((pool = dvbfilter_pool_create(0, 0)) == NULL)
+		return -1;
+
+	// nothing is readable yet
+	for(i=0; i < 2; i++) {
+		st.filters[i] = dvbfilter_add_section(pool, 0x10 + i, filter, mask, 1,
+						      dispatch_check_callback, &st);
+		if (st.filters[i] < 0)
+			goto exit;
+		st.fds[i] = dvbfilter_get_fd(pool, st.filters[i]);
+	}
+	if (dvbfilter_pool_dispatch(pool, 0) != 0)
+		goto exit;
+
+	// both become readable; whichever runs first replaces the other
+	for(i=0; i < 2; i++) {
+		if (write(st.fds[i], &one, sizeof(one)) != sizeof(one))
+			goto exit;
+	}
+	if ((dvbfilter_pool_dispatch(pool, 0) != 1) ||
+	    ((st.calls[0] + st.calls[1]) != 1) || st.replacement_calls || st.stale)
+		goto exit;
+	i = st.calls[0] ? 1 : 0;
+	if ((st.replacement != st.filters[i]) ||
+	    (dvbfilter_get_fd(pool, st.replacement) != st.fds[i]))
+		goto exit;
+
+	// the replacement gets its own event on the next dispatch
+	if ((dvbfilter_pool_dispatch(pool, 0) != 1) || (st.replacement_calls != 1) || st.stale)
+		goto exit;
+	if (dvbfilter_pool_dispatch(pool, 0) != 0)
+		goto exit;
+	ret = 0;
+
+exit:
+	dvbfilter_pool_destroy(pool);
+	return ret;
+}
+
+int shared_check(void)
+{
+	struct dvbfilter_pool *pool;
+	struct dvbfilter_pool_stats stats;
+	int shared;
+	int a, b, c, d;
+	int ret = -1;
+
+	memset(&stub, 0, sizeof(stub));
+	if ((pool = dvbfilter_pool_create(0, 0)) == NULL)
+		return -1;
+
+	// the shared fd exists before any PIDs are added
+	if ((shared = dvbfilter_pool_get_shared_fd(pool)) < 0)
+		goto exit;
+	if (dvbfilter_pool_get_shared_fd(pool) != shared)
+		goto exit;
+
+	// the first PID sets the filter up, and the others are added to it
+	a = dvbfilter_add_pid(pool, 0x100, DVBDEMUX_OUTPUT_TS_DEMUX, NULL, NULL);
+	b = dvbfilter_add_pid(pool, 0x101, DVBDEMUX_OUTPUT_TS_DEMUX, NULL, NULL);
+	c = dvbfilter_add_pid(pool, 0x100, DVBDEMUX_OUTPUT_TS_DEMUX, NULL, NULL);
+	if ((a < 0) || (b < 0) || (c < 0) ||
+	    (dvbfilter_get_fd(pool, a) != shared) || (dvbfilter_get_fd(pool, b) != shared) ||
+	    (dvbfilter_get_fd(pool, c) != shared) ||
+	    (stub.output[shared] != DVBDEMUX_OUTPUT_TS_DEMUX) || (stub.add_pids != 1) ||
+	    (stub.opens != 1))
+		goto exit;
+	dvbfilter_pool_get_stats(pool, &stats);
+	if ((stats.pids_shared != 2) || (stats.filters != 3))
+		goto exit;
+
+	// a filter with a callback still gets an fd of its own
+	if ((d = dvbfilter_add_pid(pool, 0x102, DVBDEMUX_OUTPUT_TS_DEMUX, check_callback, &ret)) < 0)
+		goto exit;
+	if ((dvbfilter_get_fd(pool, d) == shared) || (stub.add_pids != 1))
+		goto exit;
+	dvbfilter_remove(pool, d);
+
+	// a PID only goes once its last filter does
+	dvbfilter_remove(pool, a);
+	if (stub.remove_pids != 0)
+		goto exit;
+	dvbfilter_remove(pool, c);
+	if ((stub.remove_pids != 1) || (stub.last_removed_pid != 0x100) || stub.stops[shared])
+		goto exit;
+
+	// the last PID stops the fd, which is kept for the next one
+	dvbfilter_remove(pool, b);
+	if ((stub.remove_pids != 1) || (stub.stops[shared] != 1))
+		goto exit;
+	a = dvbfilter_add_pid(pool, 0x200, DVBDEMUX_OUTPUT_TS_DEMUX, NULL, NULL);
+	if ((a < 0) || (dvbfilter_get_fd(pool, a) != shared) || (stub.add_pids != 1))
+		goto exit;
+	dvbfilter_pool_get_stats(pool, &stats);
+	if ((stats.pids_shared != 1) || (stats.filters != 1))
+		goto exit;
+	ret = 0;
+
+exit:
+	dvbfilter_pool_destroy(pool);
+	return ret;
+}
+
+int fallback_check(void)
+{
+	struct dvbfilter_pool *pool;
+	struct dvbfilter_pool_stats stats;
+	int shared;
+	int a, b, c;
+	int ret = -1;
+
+	memset(&stub, 0, sizeof(stub));
+	stub.add_pid_errno = ENOTTY;
+	if ((pool = dvbfilter_pool_create(0, 0)) == NULL)
+		return -1;
+
+	a = dvbfilter_add_pid(pool, 0x100, DVBDEMUX_OUTPUT_TS_DEMUX, NULL, NULL);
+	b = dvbfilter_add_pid(pool, 0x101, DVBDEMUX_OUTPUT_TS_DEMUX, NULL, NULL);
+	if ((a < 0) || (b < 0))
+		goto exit;
+	shared = dvbfilter_pool_get_shared_fd(pool);
+	if ((dvbfilter_get_fd(pool, a) != shared) || (dvbfilter_get_fd(pool, b) == shared) ||
+	    (stub.output[dvbfilter_get_fd(pool, b)] != DVBDEMUX_OUTPUT_TS_DEMUX))
+		goto exit;
+
+	// once DMX_ADD_PID has failed, it is not tried again
+	stub.add_pid_errno = EINVAL;
+	if ((c = dvbfilter_add_pid(pool, 0x102, DVBDEMUX_OUTPUT_TS_DEMUX, NULL, NULL)) < 0)
+		goto exit;
+	if ((dvbfilter_get_fd(pool, c) == shared) ||
+	    (dvbfilter_get_fd(pool, c) == dvbfilter_get_fd(pool, b)))
+		goto exit;
+	dvbfilter_pool_get_stats(pool, &stats);
+	if ((stats.pids_shared != 1) || (stats.fds != 3))
+		goto exit;
+	ret = 0;
+
+exit:
+	dvbfilter_pool_destroy(pool);
+	return ret;
+}
@@ -0,0 +1,1475 @@
+/*
+ * libucsi throughput benchmarks.
+ *
+ * Copyright (C) 2026 agent (agent@local)
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <libucsi/crc32.h>
+#include <libucsi/section_buf.h>
+#include <libucsi/section_demux.h>
+#include <libucsi/mpe_demux.h>
+#include <libucsi/ule_demux.h>
+#include <libucsi/ts_monitor.h>
+#include <libucsi/descriptor_registry.h>
+#include <libucsi/mpeg/section.h>
+#include <libucsi/dvb/section.h>
+#include <libucsi/dvb/descriptor.h>
+#include <libucsi/dvb/mpe_fec.h>
+#include <libucsi/atsc/section.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+void usage(void);
+double now(void);
+void report(char *name, double secs, double bytes, double items);
+int bench_crc32(int argc, char *argv[]);
+int bench_eit(int argc, char *argv[]);
+int bench_ts(int argc, char *argv[]);
+int bench_atsctext(int argc, char *argv[]);
+int bench_mpe(int argc, char *argv[]);
+int bench_mpefec(int argc, char *argv[]);
+int bench_ule(int argc, char *argv[]);
+int bench_monitor(int argc, char *argv[]);
+uint8_t *map_file(char *filename, size_t *len);
+
+#define DEFAULT_CRC32_SIZE 1024
+#define DEFAULT_CRC32_BYTES (256*1024*1024)
+#define DEFAULT_EIT_PID 0x12
+#define DEFAULT_EIT_SECTIONS (1000*1000)
+#define DEFAULT_TS_PACKETS (10*1000*1000)
+#define DEFAULT_TS_SECTIONS (200*1000)
+#define DEFAULT_ATSC_TEXT_SEGMENTS (1000*1000)
+#define DEFAULT_MPE_PACKETS (10*1000*1000)
+#define DEFAULT_MPE_FEC_ROWS 1024
+#define DEFAULT_MPE_FEC_FRAMES 200
+#define DEFAULT_ULE_PACKETS (10*1000*1000)
+#define DEFAULT_MONITOR_PACKETS (10*1000*1000)
+#define DEFAULT_MONITOR_BATCH 64
+
+int main(int argc, char *argv[])
+{
+	if (argc < 2)
+		usage();
+
+	if (!strcmp(argv[1], "crc32"))
+		return bench_crc32(argc - 2, argv + 2);
+	if (!strcmp(argv[1], "eit"))
+		return bench_eit(argc - 2, argv + 2);
+	if (!strcmp(argv[1], "ts"))
+		return bench_ts(argc - 2, argv + 2);
+	if (!strcmp(argv[1], "atsctext"))
+		return bench_atsctext(argc - 2, argv + 2);
+	if (!strcmp(argv[1], "mpe"))
+		return bench_mpe(argc - 2, argv + 2);
+	if (!strcmp(argv[1], "mpefec"))
+		return bench_mpefec(argc - 2, argv + 2);
+	if (!strcmp(argv[1], "ule"))
+		return bench_ule(argc - 2, argv + 2);
+	if (!strcmp(argv[1], "monitor"))
+		return bench_monitor(argc - 2, argv + 2);
+
+	usage();
+	return 1;
+}
+
+void usage(void)
+{
+	fprintf(stderr, "Syntax: benchucsi crc32 [<buffer size>]\n");
+	fprintf(stderr, "        benchucsi eit <ts file> [<pid>]\n");
+	fprintf(stderr, "        benchucsi ts <ts file> [<ts file>...]\n");
+	fprintf(stderr, "        benchucsi atsctext <ts file> [<ts file>...]\n");
+	fprintf(stderr, "        benchucsi mpe <ts file> <pid> [<pid>...]\n");
+	fprintf(stderr, "        benchucsi mpefec [<rows>]\n");
+	fprintf(stderr, "        benchucsi ule <ts file> <pid> [<pid>...]\n");
+	fprintf(stderr, "        benchucsi monitor <ts file>\n");
+	exit(1);
+}
+
+double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + (ts.tv_nsec / 1e9);
+}
+
+void report(char *name, double secs, double bytes, double items)
+{
+	printf("%-24s %10.3f s %10.1f MB/s %12.0f items/s %10.1f ns/item\n",
+	       name, secs, bytes / secs / 1e6, items / secs, secs * 1e9 / items);
+}
+
+int bench_crc32(int argc, char *argv[])
+{
+	uint8_t buf[DVB_MAX_SECTION_BYTES];
+	size_t size = DEFAULT_CRC32_SIZE;
+	long iterations;
+	long n;
+	size_t i;
+	uint32_t crc;
+	uint32_t check = 0;
+	uint32_t sum = 0;
+	double start;
+
+	if (argc > 0)
+		size = atoi(argv[0]);
+	if ((size == 0) || (size > sizeof(buf))) {
+		fprintf(stderr, "Buffer size must be between 1 and %zu\n", sizeof(buf));
+		return 1;
+	}
+	iterations = DEFAULT_CRC32_BYTES / size;
+	for(i=0; i < size; i++)
+		buf[i] = random();
+
+	// the byte at a time table method
+	start = now();
+	for(n=0; n < iterations; n++) {
+		buf[0] = n;
+		crc = CRC32_INIT;
+		for(i=0; i < size; i++)
+			crc = (crc << 8) ^ crc32tbl[((crc >> 24) ^ buf[i]) & 0xff];
+		check ^= crc;
+	}
+	report("crc32 bytewise", now() - start, (double) iterations * size, iterations);
+
+	// the library implementation
+	start = now();
+	for(n=0; n < iterations; n++) {
+		buf[0] = n;
+		sum ^= crc32(CRC32_INIT, buf, size);
+	}
+	report("crc32", now() - start, (double) iterations * size, iterations);
+
+	if (sum != check) {
+		fprintf(stderr, "XXXX crc32 result mismatch\n");
+		return 1;
+	}
+
+	return 0;
+}
+
+struct sections {
+	uint8_t *buf;
+	size_t *offsets;
+	int count;
+	int max;
+	size_t used;
+	size_t size;
+};
+
+static void sections_add(struct sections *s, uint8_t *section, int len)
+{
+	if (s->count == s->max) {
+		s->max = s->max ? s->max * 2 : 1024;
+		s->offsets = realloc(s->offsets, (s->max + 1) * sizeof(size_t));
+	}
+	if ((s->used + len) > s->size) {
+		s->size = s->size ? s->size * 2 : 1024*1024;
+		s->buf = realloc(s->buf, s->size);
+	}
+	if ((s->offsets == NULL) || (s->buf == NULL)) {
+		fprintf(stderr, "Out of memory\n");
+		exit(1);
+	}
+
+	memcpy(s->buf + s->used, section, len);
+	s->offsets[s->count++] = s->used;
+	s->used += len;
+	s->offsets[s->count] = s->used;
+}
+
+static void sections_free(struct sections *s)
+{
+	free(s->buf);
+	free(s->offsets);
+}
+
+static void eit_collect(void *arg, int pid, uint8_t *section, int len)
+{
+	(void) pid;
+
+	if ((section[0] < stag_dvb_event_information_nownext_actual) || (section[0] > (stag_dvb_event_information_schedule_other + 0x0f)))
+		return;
+
+	sections_add((struct sections *) arg, section, len);
+}
+
+enum eit_walk {
+	EIT_WALK_NONE,		/* event ids and start times only */
+	EIT_WALK_TAGS,		/* look at every descriptor tag */
+	EIT_WALK_SWITCH,	/* decode short events with a switch */
+	EIT_WALK_VISITOR,	/* decode short events with a descriptor_visitor */
+};
+
+static int eit_visit_short_event(void *arg, struct descriptor *d, void *decoded)
+{
+	struct dvb_short_event_descriptor *dx = decoded;
+	(void) d;
+
+	*((long *) arg) += dx->event_name_length;
+	return 0;
+}
+
+static long eit_decode(struct sections *eit, long iterations, int lazy, enum eit_walk walk)
+{
+	uint8_t work[DVB_MAX_SECTION_BYTES];
+	struct descriptor_visitor visitor;
+	struct dvb_short_event_descriptor *dx;
+	struct dvb_eit_section *eit_section;
+	struct dvb_eit_event *event;
+	struct descriptor *desc;
+	struct section_ext *ext;
+	long sum = 0;
+	long n;
+	int i;
+
+	descriptor_visitor_init(&visitor, &sum);
+	descriptor_visitor_register(&visitor, &dvb_descriptor_registry,
+				    dtag_dvb_short_event, eit_visit_short_event);
+
+	for(n=0; n < iterations; n++) {
+		i = n % eit->count;
+
+		/* the codecs work in place, so start from a fresh copy each time */
+		memcpy(work, eit->buf + eit->offsets[i], eit->offsets[i+1] - eit->offsets[i]);
+		if ((ext = section_ext_decode(section_codec(work, eit->offsets[i+1] - eit->offsets[i]), 0)) == NULL)
+			continue;
+		if (lazy)
+			eit_section = dvb_eit_section_codec_lazy(ext);
+		else
+			eit_section = dvb_eit_section_codec(ext);
+		if (eit_section == NULL)
+			continue;
+
+		dvb_eit_section_events_for_each(eit_section, event) {
+			sum += event->event_id + event->start_time[4];
+
+			switch(walk) {
+			case EIT_WALK_NONE:
+				break;
+
+			case EIT_WALK_TAGS:
+				dvb_eit_event_descriptors_for_each(event, desc)
+					sum += desc->tag;
+				break;
+
+			case EIT_WALK_SWITCH:
+				dvb_eit_event_descriptors_for_each(event, desc) {
+					switch(desc->tag) {
+					case dtag_dvb_short_event:
+						if ((dx = dvb_short_event_descriptor_codec(desc)) != NULL)
+							sum += dx->event_name_length;
+						break;
+					}
+				}
+				break;
+
+			case EIT_WALK_VISITOR:
+				descriptor_visitor_visit(&visitor,
+							 (uint8_t *) event + sizeof(struct dvb_eit_event),
+							 event->descriptors_loop_length, NULL);
+				break;
+			}
+		}
+	}
+
+	return sum;
+}
+
+int bench_eit(int argc, char *argv[])
+{
+	struct sections eit;
+	struct section_demux *sdemux;
+	struct transport_packet *pkt;
+	uint8_t *data;
+	size_t len;
+	size_t i;
+	int pid = DEFAULT_EIT_PID;
+	long iterations = DEFAULT_EIT_SECTIONS;
+	double bytes;
+	double start;
+	long check;
+
+	if (argc < 1)
+		usage();
+	if (argc > 1)
+		pid = strtol(argv[1], NULL, 0);
+	if ((data = map_file(argv[0], &len)) == NULL)
+		return 1;
+
+	// extract the EIT sections
+	memset(&eit, 0, sizeof(eit));
+	if ((sdemux = section_demux_create(DVB_MAX_SECTION_BYTES, eit_collect, &eit)) == NULL) {
+		fprintf(stderr, "Failed to create section_demux\n");
+		return 1;
+	}
+	for(i=0; (i + TRANSPORT_PACKET_LENGTH) <= len; i += TRANSPORT_PACKET_LENGTH) {
+		pkt = transport_packet_init(data + i);
+		if ((pkt == NULL) || (transport_packet_pid(pkt) != pid))
+			continue;
+		section_demux_add_packet(sdemux, pkt);
+	}
+	section_demux_destroy(sdemux);
+	munmap(data, len);
+	if (eit.count == 0) {
+		fprintf(stderr, "No EIT sections found on PID 0x%04x\n", pid);
+		return 1;
+	}
+	bytes = (double) eit.used * iterations / eit.count;
+	printf("%i EIT sections, %zu bytes\n", eit.count, eit.used);
+
+	// event ids and start times only
+	start = now();
+	check = eit_decode(&eit, iterations, 0, EIT_WALK_NONE);
+	report("eit codec", now() - start, bytes, iterations);
+	start = now();
+	if (eit_decode(&eit, iterations, 1, EIT_WALK_NONE) != check)
+		goto mismatch;
+	report("eit codec lazy", now() - start, bytes, iterations);
+
+	// and every descriptor too
+	start = now();
+	check = eit_decode(&eit, iterations, 0, EIT_WALK_TAGS);
+	report("eit codec+descriptors", now() - start, bytes, iterations);
+	start = now();
+	if (eit_decode(&eit, iterations, 1, EIT_WALK_TAGS) != check)
+		goto mismatch;
+	report("eit lazy+descriptors", now() - start, bytes, iterations);
+
+	// decoding just the short events
+	start = now();
+	check = eit_decode(&eit, iterations, 1, EIT_WALK_SWITCH);
+	report("eit lazy+switch", now() - start, bytes, iterations);
+	start = now();
+	if (eit_decode(&eit, iterations, 1, EIT_WALK_VISITOR) != check)
+		goto mismatch;
+	report("eit lazy+visitor", now() - start, bytes, iterations);
+
+	sections_free(&eit);
+	return 0;
+
+mismatch:
+	fprintf(stderr, "XXXX eit result mismatch\n");
+	return 1;
+}
+
+/*
+ * The ts benchmark runs the whole parsing pipeline over a recording:
+ * reassembling sections from the transport packets, then for each table
+ * type, checking the CRC, running the table codec, and decoding every
+ * descriptor through the registries. Each stage is timed separately, and
+ * each includes the ones before it.
+ */
+enum pipeline_table {
+	PT_PAT, PT_CAT, PT_PMT,
+	PT_NIT, PT_SDT, PT_BAT, PT_EIT, PT_TDT, PT_TOT,
+	PT_MGT, PT_TVCT, PT_CVCT, PT_ATSC_EIT, PT_ETT, PT_STT,
+	PT_OTHER,
+	PT_COUNT,
+};
+
+static const char *pipeline_table_names[PT_COUNT] = {
+	"pat", "cat", "pmt",
+	"nit", "sdt", "bat", "eit", "tdt", "tot",
+	"mgt", "tvct", "cvct", "atsc eit", "ett", "stt",
+	"other",
+};
+
+enum pipeline_stage {
+	PS_CRC,			/* section_ext_decode() with CRC check */
+	PS_CODEC,		/* + the table codec */
+	PS_DESCRIPTORS,		/* + decoding every descriptor */
+};
+
+struct pipeline {
+	uint8_t pids[TRANSPORT_MAX_PIDS];	/* PIDs carrying tables */
+	int collect;				/* store the sections? */
+	long count;				/* sections received */
+	int atsc;				/* found an ATSC MGT? */
+	const struct descriptor_registry *registries[256];
+	struct sections tables[PT_COUNT];
+	long sum;
+};
+
+static enum pipeline_table pipeline_table(uint8_t table_id)
+{
+	switch(table_id) {
+	case stag_mpeg_program_association:
+		return PT_PAT;
+	case stag_mpeg_conditional_access:
+		return PT_CAT;
+	case stag_mpeg_program_map:
+		return PT_PMT;
+	case stag_dvb_network_information_actual:
+	case stag_dvb_network_information_other:
+		return PT_NIT;
+	case stag_dvb_service_description_actual:
+	case stag_dvb_service_description_other:
+		return PT_SDT;
+	case stag_dvb_bouquet_association:
+		return PT_BAT;
+	case stag_dvb_time_date:
+		return PT_TDT;
+	case stag_dvb_time_offset:
+		return PT_TOT;
+	case stag_atsc_master_guide:
+		return PT_MGT;
+	case stag_atsc_terrestrial_virtual_channel:
+		return PT_TVCT;
+	case stag_atsc_cable_virtual_channel:
+		return PT_CVCT;
+	case stag_atsc_event_information:
+		return PT_ATSC_EIT;
+	case stag_atsc_extended_text:
+		return PT_ETT;
+	case stag_atsc_system_time:
+		return PT_STT;
+	}
+
+	if ((table_id >= stag_dvb_event_information_nownext_actual) &&
+	    (table_id <= (stag_dvb_event_information_schedule_other + 0x0f)))
+		return PT_EIT;
+	return PT_OTHER;
+}
+
+// follow the PAT and MGT to find the rest of the tables
+static void pipeline_discover(void *arg, int pid, uint8_t *section, int len)
+{
+	struct pipeline *p = (struct pipeline *) arg;
+	uint8_t buf[DVB_MAX_SECTION_BYTES];
+	struct section_ext *ext;
+	struct mpeg_pat_section *pat;
+	struct mpeg_pat_program *program;
+	struct atsc_section_psip *psip;
+	struct atsc_mgt_section *mgt;
+	struct atsc_mgt_table *table;
+	int idx;
+	(void) pid;
+
+	memcpy(buf, section, len);
+	if ((ext = section_ext_decode(section_codec(buf, len), 1)) == NULL)
+		return;
+
+	switch(buf[0]) {
+	case stag_mpeg_program_association:
+		if ((pat = mpeg_pat_section_codec(ext)) == NULL)
+			return;
+		mpeg_pat_section_programs_for_each(pat, program) {
+			if (program->program_number)
+				p->pids[program->pid] = 1;
+		}
+		break;
+
+	case stag_atsc_master_guide:
+		if (((psip = atsc_section_psip_decode(ext)) == NULL) ||
+		    ((mgt = atsc_mgt_section_codec(psip)) == NULL))
+			return;
+		atsc_mgt_section_tables_for_each(mgt, table, idx)
+			p->pids[table->table_type_PID] = 1;
+		p->atsc = 1;
+		break;
+	}
+}
+
+static void pipeline_collect(void *arg, int pid, uint8_t *section, int len)
+{
+	struct pipeline *p = (struct pipeline *) arg;
+	(void) pid;
+
+	p->count++;
+	if (p->collect)
+		sections_add(&p->tables[pipeline_table(section[0])], section, len);
+}
+
+static void pipeline_descriptor(struct pipeline *p, struct descriptor *d)
+{
+	if ((p->registries[d->tag] != NULL) &&
+	    (descriptor_registry_codec(p->registries[d->tag], d) != NULL))
+		p->sum += d->tag;
+}
+
+#define pipeline_descriptors(p, stage, for_each, arg) \
+	do { \
+		struct descriptor *_d; \
+		if ((stage) == PS_DESCRIPTORS) { \
+			for_each(arg, _d) \
+				pipeline_descriptor(p, _d); \
+		} \
+	} while(0)
+
+static void pipeline_mpeg(struct pipeline *p, struct section_ext *ext, enum pipeline_stage stage)
+{
+	switch(ext->table_id) {
+	case stag_mpeg_program_association:
+	{
+		struct mpeg_pat_section *pat;
+		struct mpeg_pat_program *program;
+
+		if ((pat = mpeg_pat_section_codec(ext)) == NULL)
+			return;
+		mpeg_pat_section_programs_for_each(pat, program)
+			p->sum += program->pid;
+		break;
+	}
+
+	case stag_mpeg_conditional_access:
+	{
+		struct mpeg_cat_section *cat;
+
+		if ((cat = mpeg_cat_section_codec(ext)) == NULL)
+			return;
+		pipeline_descriptors(p, stage, mpeg_cat_section_descriptors_for_each, cat);
+		break;
+	}
+
+	case stag_mpeg_program_map:
+	{
+		struct mpeg_pmt_section *pmt;
+		struct mpeg_pmt_stream *stream;
+
+		if ((pmt = mpeg_pmt_section_codec(ext)) == NULL)
+			return;
+		pipeline_descriptors(p, stage, mpeg_pmt_section_descriptors_for_each, pmt);
+		mpeg_pmt_section_streams_for_each(pmt, stream) {
+			p->sum += stream->pid;
+			pipeline_descriptors(p, stage, mpeg_pmt_stream_descriptors_for_each, stream);
+		}
+		break;
+	}
+	}
+}
+
+static void pipeline_dvb(struct pipeline *p, struct section_ext *ext, enum pipeline_stage stage)
+{
+	switch(pipeline_table(ext->table_id)) {
+	case PT_NIT:
+	{
+		struct dvb_nit_section *nit;
+		struct dvb_nit_section_part2 *part2;
+		struct dvb_nit_transport *transport;
+
+		if ((nit = dvb_nit_section_codec(ext)) == NULL)
+			return;
+		pipeline_descriptors(p, stage, dvb_nit_section_descriptors_for_each, nit);
+		part2 = dvb_nit_section_part2(nit);
+		dvb_nit_section_transports_for_each(nit, part2, transport) {
+			p->sum += transport->transport_stream_id;
+			pipeline_descriptors(p, stage, dvb_nit_transport_descriptors_for_each, transport);
+		}
+		break;
+	}
+
+	case PT_SDT:
+	{
+		struct dvb_sdt_section *sdt;
+		struct dvb_sdt_service *service;
+
+		if ((sdt = dvb_sdt_section_codec(ext)) == NULL)
+			return;
+		dvb_sdt_section_services_for_each(sdt, service) {
+			p->sum += service->service_id;
+			pipeline_descriptors(p, stage, dvb_sdt_service_descriptors_for_each, service);
+		}
+		break;
+	}
+
+	case PT_BAT:
+	{
+		struct dvb_bat_section *bat;
+		struct dvb_bat_section_part2 *part2;
+		struct dvb_bat_transport *transport;
+
+		if ((bat = dvb_bat_section_codec(ext)) == NULL)
+			return;
+		pipeline_descriptors(p, stage, dvb_bat_section_descriptors_for_each, bat);
+		part2 = dvb_bat_section_part2(bat);
+		dvb_bat_section_transports_for_each(part2, transport) {
+			p->sum += transport->transport_stream_id;
+			pipeline_descriptors(p, stage, dvb_bat_transport_descriptors_for_each, transport);
+		}
+		break;
+	}
+
+	case PT_EIT:
+	{
+		struct dvb_eit_section *eit;
+		struct dvb_eit_event *event;
+
+		if ((eit = dvb_eit_section_codec(ext)) == NULL)
+			return;
+		dvb_eit_section_events_for_each(eit, event) {
+			p->sum += event->event_id;
+			pipeline_descriptors(p, stage, dvb_eit_event_descriptors_for_each, event);
+		}
+		break;
+	}
+
+	default:
+		break;
+	}
+}
+
+static void pipeline_atsc(struct pipeline *p, struct section_ext *ext, enum pipeline_stage stage)
+{
+	struct atsc_section_psip *psip;
+	int idx;
+
+	if ((psip = atsc_section_psip_decode(ext)) == NULL)
+		return;
+
+	switch(ext->table_id) {
+	case stag_atsc_master_guide:
+	{
+		struct atsc_mgt_section *mgt;
+		struct atsc_mgt_table *table;
+		struct atsc_mgt_section_part2 *part2;
+
+		if ((mgt = atsc_mgt_section_codec(psip)) == NULL)
+			return;
+		atsc_mgt_section_tables_for_each(mgt, table, idx) {
+			p->sum += table->table_type_PID;
+			pipeline_descriptors(p, stage, atsc_mgt_table_descriptors_for_each, table);
+		}
+		part2 = atsc_mgt_section_part2(mgt);
+		pipeline_descriptors(p, stage, atsc_mgt_section_part2_descriptors_for_each, part2);
+		break;
+	}
+
+	case stag_atsc_terrestrial_virtual_channel:
+	{
+		struct atsc_tvct_section *tvct;
+		struct atsc_tvct_channel *channel;
+		struct atsc_tvct_section_part2 *part2;
+
+		if ((tvct = atsc_tvct_section_codec(psip)) == NULL)
+			return;
+		atsc_tvct_section_channels_for_each(tvct, channel, idx) {
+			p->sum += channel->source_id;
+			pipeline_descriptors(p, stage, atsc_tvct_channel_descriptors_for_each, channel);
+		}
+		part2 = atsc_tvct_section_part2(tvct);
+		pipeline_descriptors(p, stage, atsc_tvct_section_part2_descriptors_for_each, part2);
+		break;
+	}
+
+	case stag_atsc_cable_virtual_channel:
+	{
+		struct atsc_cvct_section *cvct;
+		struct atsc_cvct_channel *channel;
+		struct atsc_cvct_section_part2 *part2;
+
+		if ((cvct = atsc_cvct_section_codec(psip)) == NULL)
+			return;
+		atsc_cvct_section_channels_for_each(cvct, channel, idx) {
+			p->sum += channel->source_id;
+			pipeline_descriptors(p, stage, atsc_cvct_channel_descriptors_for_each, channel);
+		}
+		part2 = atsc_cvct_section_part2(cvct);
+		pipeline_descriptors(p, stage, atsc_cvct_section_part2_descriptors_for_each, part2);
+		break;
+	}
+
+	case stag_atsc_event_information:
+	{
+		struct atsc_eit_section *eit;
+		struct atsc_eit_event *event;
+		struct atsc_eit_event_part2 *part2;
+
+		if ((eit = atsc_eit_section_codec(psip)) == NULL)
+			return;
+		atsc_eit_section_events_for_each(eit, event, idx) {
+			p->sum += event->event_id;
+			part2 = atsc_eit_event_part2(event);
+			pipeline_descriptors(p, stage, atsc_eit_event_part2_descriptors_for_each, part2);
+		}
+		break;
+	}
+
+	case stag_atsc_extended_text:
+	{
+		struct atsc_ett_section *ett;
+
+		if ((ett = atsc_ett_section_codec(psip)) == NULL)
+			return;
+		p->sum += ett->ETM_source_id;
+		break;
+	}
+
+	case stag_atsc_system_time:
+	{
+		struct atsc_stt_section *stt;
+
+		if ((stt = atsc_stt_section_codec(psip)) == NULL)
+			return;
+		p->sum += stt->system_time;
+		pipeline_descriptors(p, stage, atsc_stt_section_descriptors_for_each, stt);
+		break;
+	}
+	}
+}
+
+static void pipeline_decode(struct pipeline *p, enum pipeline_table table,
+			    uint8_t *buf, int len, enum pipeline_stage stage)
+{
+	struct section *section;
+	struct section_ext *ext;
+
+	if ((section = section_codec(buf, len)) == NULL)
+		return;
+
+	// the short form tables
+	if ((table == PT_TDT) || (table == PT_TOT)) {
+		struct dvb_tot_section *tot;
+
+		if (stage == PS_CRC) {
+			if (table == PT_TOT)
+				p->sum += section_check_crc(section);
+			return;
+		}
+		if (table == PT_TDT) {
+			if (dvb_tdt_section_codec(section) != NULL)
+				p->sum++;
+			return;
+		}
+		if ((tot = dvb_tot_section_codec(section)) == NULL)
+			return;
+		pipeline_descriptors(p, stage, dvb_tot_section_descriptors_for_each, tot);
+		return;
+	}
+
+	if ((ext = section_ext_decode(section, 1)) == NULL)
+		return;
+	if (stage == PS_CRC) {
+		p->sum += ext->table_id_ext;
+		return;
+	}
+
+	if (table <= PT_PMT)
+		pipeline_mpeg(p, ext, stage);
+	else if (table <= PT_TOT)
+		pipeline_dvb(p, ext, stage);
+	else if (table <= PT_STT)
+		pipeline_atsc(p, ext, stage);
+}
+
+static int pipeline_demux(struct pipeline *p, uint8_t *data, size_t len,
+			  section_demux_callback callback)
+{
+	struct section_demux *sdemux;
+	struct transport_packet *pkt;
+	size_t i;
+
+	if ((sdemux = section_demux_create(DVB_MAX_SECTION_BYTES, callback, p)) == NULL) {
+		fprintf(stderr, "Failed to create section_demux\n");
+		return -1;
+	}
+	for(i=0; (i + TRANSPORT_PACKET_LENGTH) <= len; i += TRANSPORT_PACKET_LENGTH) {
+		if ((pkt = transport_packet_init(data + i)) == NULL)
+			continue;
+		if (p->pids[transport_packet_pid(pkt)])
+			section_demux_add_packet(sdemux, pkt);
+	}
+	section_demux_destroy(sdemux);
+
+	return 0;
+}
+
+// find the tables in a recording, and collect their sections
+static int pipeline_load(struct pipeline *p, uint8_t *data, size_t len)
+{
+	int i;
+
+	// find the PIDs carrying tables
+	memset(p, 0, sizeof(struct pipeline));
+	p->pids[TRANSPORT_PAT_PID] = 1;
+	p->pids[TRANSPORT_CAT_PID] = 1;
+	p->pids[TRANSPORT_NIT_PID] = 1;
+	p->pids[TRANSPORT_SDT_PID] = 1;
+	p->pids[TRANSPORT_EIT_PID] = 1;
+	p->pids[TRANSPORT_TDT_PID] = 1;
+	p->pids[ATSC_BASE_PID] = 1;
+	if (pipeline_demux(p, data, len, pipeline_discover))
+		return -1;
+
+	// the descriptors which may appear depend on the standard
+	for(i=0; i < 256; i++) {
+		if (mpeg_descriptor_registry.codecs[i])
+			p->registries[i] = &mpeg_descriptor_registry;
+		else if (dvb_descriptor_registry.codecs[i])
+			p->registries[i] = &dvb_descriptor_registry;
+		else if (p->atsc && atsc_descriptor_registry.codecs[i])
+			p->registries[i] = &atsc_descriptor_registry;
+	}
+
+	// collect the sections
+	p->collect = 1;
+	if (pipeline_demux(p, data, len, pipeline_collect))
+		return -1;
+	p->collect = 0;
+
+	return 0;
+}
+
+static int bench_ts_file(char *filename)
+{
+	uint8_t work[DVB_MAX_SECTION_BYTES];
+	struct pipeline p;
+	struct sections *s;
+	uint8_t *data;
+	size_t len;
+	long packets;
+	long passes;
+	long iterations;
+	long n;
+	int table;
+	int stage;
+	int i;
+	double start;
+	double secs;
+	char name[64];
+	static const char *stage_names[] = { "crc", "codec", "descriptors" };
+
+	if ((data = map_file(filename, &len)) == NULL)
+		return 1;
+	packets = len / TRANSPORT_PACKET_LENGTH;
+	if (packets == 0) {
+		fprintf(stderr, "No packets in %s\n", filename);
+		munmap(data, len);
+		return 1;
+	}
+
+	if (pipeline_load(&p, data, len))
+		goto error;
+	printf("%s: %li packets, %li sections\n", filename, packets, p.count);
+	if (p.count == 0) {
+		fprintf(stderr, "No sections found in %s\n", filename);
+		goto error;
+	}
+
+	// time the reassembly
+	passes = (DEFAULT_TS_PACKETS + packets - 1) / packets;
+	p.count = 0;
+	start = now();
+	for(n=0; n < passes; n++)
+		pipeline_demux(&p, data, len, pipeline_collect);
+	secs = now() - start;
+	report("ts packets", secs, (double) len * passes, (double) packets * passes);
+	report("ts sections", secs, (double) len * passes, p.count);
+	munmap(data, len);
+
+	// and then each table type through each stage
+	for(table=0; table < PT_OTHER; table++) {
+		s = &p.tables[table];
+		if (s->count == 0)
+			continue;
+		iterations = s->count;
+		if (iterations < DEFAULT_TS_SECTIONS)
+			iterations = (DEFAULT_TS_SECTIONS / s->count) * s->count;
+
+		for(stage=PS_CRC; stage <= PS_DESCRIPTORS; stage++) {
+			start = now();
+			for(n=0; n < iterations; n++) {
+				i = n % s->count;
+				// the codecs work in place, so start from a fresh copy each time
+				memcpy(work, s->buf + s->offsets[i], s->offsets[i+1] - s->offsets[i]);
+				pipeline_decode(&p, table, work, s->offsets[i+1] - s->offsets[i], stage);
+			}
+			sprintf(name, "%s %s", pipeline_table_names[table], stage_names[stage]);
+			report(name, now() - start, (double) s->used * iterations / s->count, iterations);
+		}
+	}
+
+	for(table=0; table < PT_COUNT; table++)
+		sections_free(&p.tables[table]);
+	return 0;
+
+error:
+	for(table=0; table < PT_COUNT; table++)
+		sections_free(&p.tables[table]);
+	munmap(data, len);
+	return 1;
+}
+
+int bench_ts(int argc, char *argv[])
+{
+	int ret = 0;
+	int i;
+
+	if (argc < 1)
+		usage();
+
+	for(i=0; i < argc; i++) {
+		if (i)
+			printf("\n");
+		ret |= bench_ts_file(argv[i]);
+	}
+
+	return ret;
+}
+
+/*
+ * The atsctext benchmark decodes every text segment found in the ATSC EIT
+ * titles and ETT messages of a recording, by compression type.
+ */
+static const char *atsctext_names[] = {
+	"atsc text none", "atsc text title", "atsc text description",
+};
+
+static void atsctext_collect(struct sections *segments, struct atsc_text *text)
+{
+	struct atsc_text_string *str;
+	struct atsc_text_string_segment *seg;
+	int idx;
+	int idx2;
+
+	if (text == NULL)
+		return;
+
+	atsc_text_strings_for_each(text, str, idx) {
+		atsc_text_string_segments_for_each(str, seg, idx2) {
+			if (seg->compression_type > ATSC_TEXT_COMPRESS_PROGRAM_DESCRIPTION)
+				continue;
+			sections_add(&segments[seg->compression_type], (uint8_t *) seg,
+				     sizeof(struct atsc_text_string_segment) + seg->number_bytes);
+		}
+	}
+}
+
+static void atsctext_section(struct sections *segments, uint8_t *buf, int len)
+{
+	struct section_ext *ext;
+	struct atsc_section_psip *psip;
+	struct atsc_eit_section *eit;
+	struct atsc_eit_event *event;
+	struct atsc_ett_section *ett;
+	int idx;
+
+	if (((ext = section_ext_decode(section_codec(buf, len), 1)) == NULL) ||
+	    ((psip = atsc_section_psip_decode(ext)) == NULL))
+		return;
+
+	if (ext->table_id == stag_atsc_event_information) {
+		if ((eit = atsc_eit_section_codec(psip)) == NULL)
+			return;
+		atsc_eit_section_events_for_each(eit, event, idx)
+			atsctext_collect(segments, atsc_eit_event_name_title_text(event));
+	} else {
+		if ((ett = atsc_ett_section_codec(psip)) == NULL)
+			return;
+		atsctext_collect(segments, atsc_ett_section_extended_text_message(ett));
+	}
+}
+
+static int bench_atsctext_file(char *filename)
+{
+	uint8_t work[DVB_MAX_SECTION_BYTES];
+	struct sections segments[ATSC_TEXT_COMPRESS_PROGRAM_DESCRIPTION + 1];
+	struct atsc_text_string_segment *seg;
+	struct pipeline p;
+	struct sections *s;
+	uint8_t *data;
+	uint8_t *dest = NULL;
+	size_t destsize = 0;
+	size_t destpos;
+	size_t len;
+	size_t chars = 0;
+	long iterations;
+	long n;
+	int table;
+	int type;
+	int i;
+	double start;
+
+	if ((data = map_file(filename, &len)) == NULL)
+		return 1;
+	memset(segments, 0, sizeof(segments));
+	if (pipeline_load(&p, data, len))
+		goto error;
+	munmap(data, len);
+	data = NULL;
+
+	// pull out the text segments
+	for(table=PT_ATSC_EIT; table <= PT_ETT; table++) {
+		s = &p.tables[table];
+		for(i=0; i < s->count; i++) {
+			memcpy(work, s->buf + s->offsets[i], s->offsets[i+1] - s->offsets[i]);
+			atsctext_section(segments, work, s->offsets[i+1] - s->offsets[i]);
+		}
+	}
+	printf("%s: %i eit sections, %i ett sections, %i/%i/%i text segments\n", filename,
+	       p.tables[PT_ATSC_EIT].count, p.tables[PT_ETT].count,
+	       segments[0].count, segments[1].count, segments[2].count);
+
+	for(type=0; type <= ATSC_TEXT_COMPRESS_PROGRAM_DESCRIPTION; type++) {
+		s = &segments[type];
+		if (s->count == 0)
+			continue;
+		iterations = s->count;
+		if (iterations < DEFAULT_ATSC_TEXT_SEGMENTS)
+			iterations = (DEFAULT_ATSC_TEXT_SEGMENTS / s->count) * s->count;
+
+		start = now();
+		for(n=0; n < iterations; n++) {
+			seg = (struct atsc_text_string_segment *) (s->buf + s->offsets[n % s->count]);
+			destpos = 0;
+			atsc_text_segment_decode(seg, &dest, &destsize, &destpos);
+			chars += destpos;
+		}
+		report((char *) atsctext_names[type], now() - start,
+		       (double) (s->used - (s->count * sizeof(struct atsc_text_string_segment))) *
+		       iterations / s->count, iterations);
+	}
+	printf("%zu bytes of text decoded\n", chars);
+
+	free(dest);
+	for(table=0; table < PT_COUNT; table++)
+		sections_free(&p.tables[table]);
+	for(type=0; type <= ATSC_TEXT_COMPRESS_PROGRAM_DESCRIPTION; type++)
+		sections_free(&segments[type]);
+	return 0;
+
+error:
+	for(table=0; table < PT_COUNT; table++)
+		sections_free(&p.tables[table]);
+	munmap(data, len);
+	return 1;
+}
+
+int bench_atsctext(int argc, char *argv[])
+{
+	int ret = 0;
+	int i;
+
+	if (argc < 1)
+		usage();
+
+	for(i=0; i < argc; i++) {
+		if (i)
+			printf("\n");
+		ret |= bench_atsctext_file(argv[i]);
+	}
+
+	return ret;
+}
+
+static void mpe_count(void *arg, struct mpe_demux_packet *packets, int count)
+{
+	long *batches = (long *) arg;
+
+	(void) packets;
+	(void) count;
+	(*batches)++;
+}
+
+int bench_mpe(int argc, char *argv[])
+{
+	struct mpe_demux *mdemux;
+	struct mpe_demux_stats stats;
+	uint64_t datagrams = 0;
+	uint64_t bytes = 0;
+	uint8_t *data;
+	size_t len;
+	long packets;
+	long passes;
+	long batches = 0;
+	long n;
+	int i;
+	double start;
+	double secs = 0;
+
+	if (argc < 2)
+		usage();
+	if ((data = map_file(argv[0], &len)) == NULL)
+		return 1;
+	packets = len / TRANSPORT_PACKET_LENGTH;
+	passes = (DEFAULT_MPE_PACKETS + packets - 1) / packets;
+
+	// a fresh receiver each pass, so the continuity counters don't wrap
+	for(n=0; n < passes; n++) {
+		mdemux = mpe_demux_create(MPE_DEMUX_DEFAULT_POOL, mpe_demux_flag_promiscuous,
+					  mpe_count, &batches);
+		if (mdemux == NULL) {
+			fprintf(stderr, "Failed to create mpe_demux\n");
+			munmap(data, len);
+			return 1;
+		}
+		for(i=1; i < argc; i++)
+			mpe_demux_add_pid(mdemux, strtol(argv[i], NULL, 0));
+
+		start = now();
+		mpe_demux_add_packets(mdemux, data, packets);
+		mpe_demux_flush(mdemux);
+		secs += now() - start;
+
+		mpe_demux_get_stats(mdemux, &stats);
+		datagrams += stats.total.datagrams;
+		bytes += stats.total.bytes;
+		mpe_demux_destroy(mdemux);
+	}
+
+	printf("%s: %li packets, %llu datagrams per pass, %llu dropped\n", argv[0], packets,
+	       (unsigned long long) stats.total.datagrams,
+	       (unsigned long long) (stats.total.sections - stats.total.datagrams));
+	if (datagrams == 0) {
+		fprintf(stderr, "No datagrams found in %s\n", argv[0]);
+		munmap(data, len);
+		return 1;
+	}
+	report("ts packets", secs, (double) len * passes, (double) packets * passes);
+	report("mpe datagrams", secs, (double) bytes, (double) datagrams);
+	report("mpe batches", secs, (double) bytes, (double) batches);
+
+	munmap(data, len);
+	return 0;
+}
+
+static void ule_count(void *arg, struct ule_demux_packet *packets, int count)
+{
+	long *batches = (long *) arg;
+
+	(void) packets;
+	(void) count;
+	(*batches)++;
+}
+
+int bench_ule(int argc, char *argv[])
+{
+	struct ule_demux *udemux;
+	struct ule_demux_stats stats;
+	uint64_t sndus = 0;
+	uint64_t bytes = 0;
+	uint8_t *data;
+	size_t len;
+	long packets;
+	long passes;
+	long batches = 0;
+	long n;
+	int i;
+	double start;
+	double secs = 0;
+
+	if (argc < 2)
+		usage();
+	if ((data = map_file(argv[0], &len)) == NULL)
+		return 1;
+	packets = len / TRANSPORT_PACKET_LENGTH;
+	passes = (DEFAULT_ULE_PACKETS + packets - 1) / packets;
+
+	// a fresh receiver each pass, so the continuity counters don't wrap
+	for(n=0; n < passes; n++) {
+		udemux = ule_demux_create(ULE_DEMUX_DEFAULT_POOL, ule_demux_flag_promiscuous,
+					  ule_count, &batches);
+		if (udemux == NULL) {
+			fprintf(stderr, "Failed to create ule_demux\n");
+			munmap(data, len);
+			return 1;
+		}
+		for(i=1; i < argc; i++)
+			ule_demux_add_pid(udemux, strtol(argv[i], NULL, 0));
+
+		start = now();
+		ule_demux_add_packets(udemux, data, packets);
+		ule_demux_flush(udemux);
+		secs += now() - start;
+
+		ule_demux_get_stats(udemux, &stats);
+		sndus += stats.total.sndus;
+		bytes += stats.total.bytes;
+		ule_demux_destroy(udemux);
+	}
+
+	printf("%s: %li packets, %llu SNDUs per pass, %llu PDUs, %llu dropped\n", argv[0], packets,
+	       (unsigned long long) stats.total.sndus, (unsigned long long) stats.total.pdus,
+	       (unsigned long long) (stats.total.sndus - stats.total.pdus));
+	if (sndus == 0) {
+		fprintf(stderr, "No SNDUs found in %s\n", argv[0]);
+		munmap(data, len);
+		return 1;
+	}
+	report("ts packets", secs, (double) len * passes, (double) packets * passes);
+	report("ule sndus", secs, (double) bytes, (double) sndus);
+	report("ule batches", secs, (double) bytes, (double) batches);
+
+	munmap(data, len);
+	return 0;
+}
+
+int bench_monitor(int argc, char *argv[])
+{
+	struct ts_monitor *mon;
+	struct ts_monitor_stats stats;
+	struct ts_monitor_counters *c = &stats.counters;
+	uint8_t *data;
+	size_t len;
+	long packets;
+	long passes;
+	long n;
+	long i;
+	int count;
+	double start;
+	double secs = 0;
+
+	if (argc < 1)
+		usage();
+	if ((data = map_file(argv[0], &len)) == NULL)
+		return 1;
+	packets = len / TRANSPORT_PACKET_LENGTH;
+	passes = (DEFAULT_MONITOR_PACKETS + packets - 1) / packets;
+
+	// a fresh monitor each pass, timed by the file's PCRs, in capture sized batches
+	for(n=0; n < passes; n++) {
+		if ((mon = ts_monitor_create(ts_monitor_flag_pcr_time, 0)) == NULL) {
+			fprintf(stderr, "Failed to create ts_monitor\n");
+			munmap(data, len);
+			return 1;
+		}
+
+		start = now();
+		for(i=0; i < packets; i += count) {
+			count = (packets - i < DEFAULT_MONITOR_BATCH) ? packets - i : DEFAULT_MONITOR_BATCH;
+			ts_monitor_add_packets(mon, data + (i * TRANSPORT_PACKET_LENGTH), count, 0);
+		}
+		secs += now() - start;
+
+		ts_monitor_get_stats(mon, &stats);
+		ts_monitor_destroy(mon);
+	}
+
+	printf("%s: %li packets, %u programs, in sync %u\n", argv[0], packets,
+	       stats.programs, stats.in_sync);
+	printf("  1.1 sync loss %llu, 1.2 sync byte %llu, 1.3 PAT %llu, 1.4 CC %llu, "
+	       "1.5 PMT %llu, 1.6 PID %llu\n",
+	       (unsigned long long) c->sync_losses, (unsigned long long) c->sync_byte_errors,
+	       (unsigned long long) c->pat_errors, (unsigned long long) c->cc_errors,
+	       (unsigned long long) c->pmt_errors, (unsigned long long) c->pid_errors);
+	printf("  2.1 transport %llu, 2.2 CRC %llu, 2.3a PCR repetition %llu, "
+	       "2.3b PCR discontinuity %llu, 2.4 PCR accuracy %llu, 2.5 PTS %llu, 2.6 CAT %llu\n",
+	       (unsigned long long) c->transport_errors, (unsigned long long) c->crc_errors,
+	       (unsigned long long) c->pcr_repetition_errors,
+	       (unsigned long long) c->pcr_discontinuity_errors,
+	       (unsigned long long) c->pcr_accuracy_errors, (unsigned long long) c->pts_errors,
+	       (unsigned long long) c->cat_errors);
+	report("ts packets", secs, (double) len * passes, (double) packets * passes);
+
+	munmap(data, len);
+	return 0;
+}
+
+static void mpefec_count(void *arg, uint8_t *datagram, int len, int recovered, int mac)
+{
+	long *datagrams = (long *) arg;
+
+	(void) datagram;
+	(void) len;
+	(void) recovered;
+	(void) mac;
+	(*datagrams)++;
+}
+
+/* build a datagram section (column < 0) or MPE-FEC section for a frame */
+static int mpefec_section(uint8_t *buf, uint8_t *frame, int rows, int address, int len,
+			  int column, int padding, int last)
+{
+	uint32_t crc;
+
+	if (column < 0) {
+		buf[0] = stag_mpeg_datagram;
+		memcpy(buf + 12, frame + address, len);
+		buf[3] = 0;
+		buf[4] = 0;
+		buf[6] = 0;
+		buf[7] = 0;
+		buf[9] = last ? 0x08 : 0;
+	} else {
+		buf[0] = stag_dvb_mpe_fec;
+		address = column * rows;
+		len = rows;
+		memcpy(buf + 12, frame + ((MPE_FEC_ADT_COLUMNS + column) * rows), len);
+		buf[3] = padding;
+		buf[4] = 0xff;
+		buf[6] = column;
+		buf[7] = MPE_FEC_RS_COLUMNS - 1;
+		buf[9] = last ? 0x04 : 0;
+	}
+	len += 12 + CRC_SIZE;
+	buf[1] = 0xb0 | ((len - 3) >> 8);
+	buf[2] = len - 3;
+	buf[5] = 0xc1;
+	buf[8] = 0;
+	buf[9] |= (address >> 16) & 0x03;
+	buf[10] = address >> 8;
+	buf[11] = address;
+	crc = crc32(CRC32_INIT, buf, len - CRC_SIZE);
+	buf[len - 4] = crc >> 24;
+	buf[len - 3] = crc >> 16;
+	buf[len - 2] = crc >> 8;
+	buf[len - 1] = crc;
+
+	return len;
+}
+
+int bench_mpefec(int argc, char *argv[])
+{
+	static const int losses[] = { 0, 16, 32, 64 };
+	struct sections secs;
+	struct mpe_fec *fec;
+	struct mpe_fec_stats stats;
+	uint8_t buf[DVB_MAX_SECTION_BYTES];
+	uint8_t *frame;
+	uint8_t *drop;
+	char name[32];
+	int rows = DEFAULT_MPE_FEC_ROWS;
+	int datagrams = 0;
+	int pos = 0;
+	int budget;
+	int len;
+	int cols;
+	int l;
+	int i;
+	long delivered = 0;
+	long n;
+	double start;
+
+	if (argc > 0)
+		rows = atoi(argv[0]);
+	if ((rows < MPE_FEC_MIN_ROWS) || (rows > MPE_FEC_MAX_ROWS) || (rows % 256))
+		usage();
+
+	// a frame of typical datagrams, with a column of padding
+	frame = (uint8_t *) calloc(MPE_FEC_COLUMNS, rows);
+	memset(&secs, 0, sizeof(secs));
+	srand(1);
+	while(1) {
+		len = 40 + (rand() % 1460);
+		if (pos + len > (MPE_FEC_ADT_COLUMNS - 1) * rows)
+			break;
+		frame[pos] = 0x45;
+		frame[pos + 2] = len >> 8;
+		frame[pos + 3] = len;
+		for(i=4; i < len; i++)
+			frame[pos + i] = rand();
+		pos += len;
+		datagrams++;
+	}
+
+	start = now();
+	for(n=0; n < DEFAULT_MPE_FEC_FRAMES; n++)
+		mpe_fec_encode(frame, rows);
+	report("mpefec encode", now() - start,
+	       (double) MPE_FEC_ADT_COLUMNS * rows * DEFAULT_MPE_FEC_FRAMES, DEFAULT_MPE_FEC_FRAMES);
+
+	pos = 0;
+	srand(1);
+	for(i=0; i < datagrams; i++) {
+		len = 40 + (rand() % 1460);
+		for(l=4; l < len; l++)
+			rand();
+		sections_add(&secs, buf, mpefec_section(buf, frame, rows, pos, len, -1, 0,
+							 i == datagrams - 1));
+		pos += len;
+	}
+	for(i=0; i < MPE_FEC_RS_COLUMNS; i++)
+		sections_add(&secs, buf, mpefec_section(buf, frame, rows, 0, 0, i, 1,
+							 i == MPE_FEC_RS_COLUMNS - 1));
+	printf("%i rows, %i datagrams, %i sections per frame\n", rows, datagrams, secs.count);
+
+	// lose whole sections at random, up to a number of columns' worth
+	drop = (uint8_t *) malloc(secs.count);
+	for(l=0; l < (int) (sizeof(losses) / sizeof(losses[0])); l++) {
+		memset(drop, 0, secs.count);
+		budget = losses[l];
+		while(budget > 0) {
+			i = rand() % secs.count;
+			if (drop[i])
+				continue;
+			cols = 1;
+			if (i < datagrams) {
+				uint32_t a = (secs.buf[secs.offsets[i] + 9] & 0x03) << 16 |
+					     secs.buf[secs.offsets[i] + 10] << 8 |
+					     secs.buf[secs.offsets[i] + 11];
+				len = secs.offsets[i+1] - secs.offsets[i] - 16;
+				cols = ((a + len - 1) / rows) - (a / rows) + 1;
+			}
+			if (cols > budget)
+				break;
+			drop[i] = 1;
+			budget -= cols;
+		}
+
+		fec = mpe_fec_create(rows, mpefec_count, &delivered);
+		delivered = 0;
+		start = now();
+		for(n=0; n < DEFAULT_MPE_FEC_FRAMES; n++) {
+			for(i=0; i < secs.count; i++) {
+				if (!drop[i]) {
+					memcpy(buf, secs.buf + secs.offsets[i], secs.offsets[i+1] - secs.offsets[i]);
+					mpe_fec_add_section(fec, buf, secs.offsets[i+1] - secs.offsets[i]);
+				}
+			}
+			mpe_fec_flush(fec);
+		}
+		sprintf(name, "mpefec %i columns lost", losses[l] - budget);
+		report(name, now() - start, (double) pos * DEFAULT_MPE_FEC_FRAMES,
+		       DEFAULT_MPE_FEC_FRAMES);
+		mpe_fec_get_stats(fec, &stats);
+		printf("%24s %li datagrams, %llu recovered, %llu lost\n", "",
+		       delivered / DEFAULT_MPE_FEC_FRAMES,
+		       (unsigned long long) stats.recovered / DEFAULT_MPE_FEC_FRAMES,
+		       (unsigned long long) stats.lost / DEFAULT_MPE_FEC_FRAMES);
+		mpe_fec_destroy(fec);
+	}
+
+	free(drop);
+	free(frame);
+	sections_free(&secs);
+	return 0;
+}
+
+uint8_t *map_file(char *filename, size_t *len)
+{
+	struct stat st;
+	void *buf;
+	int fd;
+
+	if ((fd = open(filename, O_RDONLY)) < 0) {
+		fprintf(stderr, "Failed to open file %s\n", filename);
+		return NULL;
+	}
+	if ((fstat(fd, &st) < 0) || (st.st_size == 0)) {
+		fprintf(stderr, "Failed to read file %s\n", filename);
+		close(fd);
+		return NULL;
+	}
+
+	// private, so the in place codecs never write back to the file
+	buf = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (buf == MAP_FAILED) {
+		fprintf(stderr, "Failed to map file %s\n", filename);
+		return NULL;
+	}
+	madvise(buf, st.st_size, MADV_WILLNEED);
+
+	*len = st.st_size;
+	return (uint8_t *) buf;
+}
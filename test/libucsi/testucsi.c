@@ -26,9 +26,22 @@
 #include <libucsi/atsc/section.h>
 #include <libucsi/transport_packet.h>
 #include <libucsi/section_buf.h>
+#include <libucsi/section_demux.h>
+#include <libucsi/pes_demux.h>
+#include <libucsi/pcr_clock.h>
+#include <libucsi/transport_demux.h>
 #include <libucsi/dvb/types.h>
+#include <libucsi/dvb/text.h>
+#include <libucsi/dvb/mpe_fec.h>
+#include <libucsi/mpe_demux.h>
+#include <libucsi/section_cache.h>
+#include <libucsi/table_assembler.h>
+#include <libucsi/section_packetizer.h>
+#include <libucsi/ule_demux.h>
+#include <libucsi/ts_monitor.h>
 #include <libdvbapi/dvbdemux.h>
 #include <libdvbapi/dvbfe.h>
+#include <libdvbapi/dvbtsinput.h>
 #include <libdvbcfg/dvbcfg_zapchannel.h>
 #include <libdvbsec/dvbsec_api.h>
 #include <libdvbsec/dvbsec_cfg.h>
@@ -38,7 +51,9 @@
 #include <stdarg.h>
 #include <fcntl.h>
 
-void receive_data(int dvrfd, int timeout, int data_type);
+void receive_data(struct dvbtsinput *input, int timeout, int data_type);
+void receive_packets(void *arg, int pid, struct transport_packet_info *pkts, int count);
+void receive_section(void *arg, int pid, uint8_t *section, int len);
 void parse_section(uint8_t *buf, int len, int pid, int data_type);
 void parse_dvb_section(uint8_t *buf, int len, int pid, int data_type, struct section *section);
 void parse_atsc_section(uint8_t *buf, int len, int pid, int data_type, struct section *section);
@@ -50,9 +65,25 @@ void hexdump(int indent, char *prefix, uint8_t *buf, int buflen);
 void atsctextdump(char *header, int indent, struct atsc_text *atext, int len);
 int channels_cb(struct dvbcfg_zapchannel *channel, void *private);
 void ts_from_file(char *filename, int data_type);
+int crc32_check(void);
+int dvbdate_check(void);
+int dvb_text_check(void);
+int transport_demux_check(void);
+int section_demux_check(void);
+int view_check(void);
+int cache_check(void);
+int table_assembler_check(void);
+int pes_demux_check(void);
+int pcr_check(void);
+int packetizer_check(void);
+int mpe_fec_check(void);
+int mpe_demux_fec_check(void);
+int ule_check(void);
+int ts_monitor_check(void);
 
 #define TIME_CHECK_VAL 1131835761
 #define DURATION_CHECK_VAL 5643
+#define CRC32_CHECK_VAL 0x0376e6e7
 
 #define MAX_TUNE_TIME 3000
 #define MAX_DUMP_TIME 60
@@ -61,6 +92,13 @@ void ts_from_file(char *filename, int data_type);
 #define DATA_TYPE_DVB 1
 #define DATA_TYPE_ATSC 2
 
+#define DUMP_CACHE_ENTRIES 4096
+
+struct receive_state {
+	int data_type;
+	struct section_cache *cache;
+};
+
 
 struct dvbfe_handle *fe;
 struct dvbfe_info feinfo;
@@ -77,13 +115,17 @@ int main(int argc, char *argv[])
 
 	// process arguments
 	if ((argc < 3) || (argc > 4)) {
-		fprintf(stderr, "Syntax: testucsi <adapter id>|-atscfile <filename> <zapchannels file> [<pid to limit to>]\n");
+		fprintf(stderr, "Syntax: testucsi <adapter id>|-atscfile <filename>|-dvbfile <filename> <zapchannels file> [<pid to limit to>]\n");
 		exit(1);
 	}
 	if (!strcmp(argv[1], "-atscfile")) {
 		ts_from_file(argv[2], DATA_TYPE_ATSC);
 		exit(0);
 	}
+	if (!strcmp(argv[1], "-dvbfile")) {
+		ts_from_file(argv[2], DATA_TYPE_DVB);
+		exit(0);
+	}
 	adapter = atoi(argv[1]);
 	channelsfile = argv[2];
 	if (argc == 4)
@@ -104,6 +146,96 @@ int main(int argc, char *argv[])
 		exit(1);
 	}
 
+	// check the crc32 implementation
+	if (crc32_check()) {
+		fprintf(stderr, "XXXX crc32 function check failed\n");
+		exit(1);
+	}
+
+	// check the dvbdate conversions over the whole MJD range
+	if (dvbdate_check()) {
+		fprintf(stderr, "XXXX dvbdate range check failed\n");
+		exit(1);
+	}
+
+	// check the transport demux resynchronises and carries packets over
+	if (transport_demux_check()) {
+		fprintf(stderr, "XXXX transport demux check failed\n");
+		exit(1);
+	}
+
+	// check the section demux splits and reassembles sections at packet boundaries
+	if (section_demux_check()) {
+		fprintf(stderr, "XXXX section demux check failed\n");
+		exit(1);
+	}
+
+	// check the read-only section views, and that they reject truncated sections
+	if (view_check()) {
+		fprintf(stderr, "XXXX section view check failed\n");
+		exit(1);
+	}
+
+	// check the section cache replaces changed sections
+	if (cache_check()) {
+		fprintf(stderr, "XXXX section cache check failed\n");
+		exit(1);
+	}
+
+	// check tables are assembled from sections received in any order
+	if (table_assembler_check()) {
+		fprintf(stderr, "XXXX table assembler check failed\n");
+		exit(1);
+	}
+
+	// check PES packets are reassembled and split into chunks
+	if (pes_demux_check()) {
+		fprintf(stderr, "XXXX PES demux check failed\n");
+		exit(1);
+	}
+
+	// check the PCR clock locks on, and follows wraps and discontinuities
+	if (pcr_check()) {
+		fprintf(stderr, "XXXX PCR clock check failed\n");
+		exit(1);
+	}
+
+	// check packetized sections come back out of the section demux unchanged
+	if (packetizer_check()) {
+		fprintf(stderr, "XXXX section packetizer check failed\n");
+		exit(1);
+	}
+
+	// check DVB strings are converted to UTF-8
+	if (dvb_text_check()) {
+		fprintf(stderr, "XXXX dvb text conversion check failed\n");
+		exit(1);
+	}
+
+	// check MPE-FEC frames are rebuilt after losses
+	if (mpe_fec_check()) {
+		fprintf(stderr, "XXXX MPE-FEC check failed\n");
+		exit(1);
+	}
+
+	// check the MAC filter on MPE-FEC PIDs
+	if (mpe_demux_fec_check()) {
+		fprintf(stderr, "XXXX MPE-FEC MAC filter check failed\n");
+		exit(1);
+	}
+
+	// check ULE SNDUs are reassembled and their extension headers processed
+	if (ule_check()) {
+		fprintf(stderr, "XXXX ULE check failed\n");
+		exit(1);
+	}
+
+	// check the TR 101 290 monitor finds the errors injected into a stream
+	if (ts_monitor_check()) {
+		fprintf(stderr, "XXXX TR 101 290 monitor check failed\n");
+		exit(1);
+	}
+
 	// open the frontend
 	if ((fe = dvbfe_open(adapter, 0, 0)) == NULL) {
 		perror("open frontend");
@@ -155,13 +287,1921 @@ int main(int argc, char *argv[])
         return 0;
 }
 
+int crc32_check(void)
+{
+	uint8_t buf[DVB_MAX_SECTION_BYTES];
+	uint32_t crc;
+	size_t len;
+	size_t off;
+	size_t i;
+
+	// the standard CRC-32/MPEG-2 check value
+	if (crc32(CRC32_INIT, (uint8_t*) "123456789", 9) != CRC32_CHECK_VAL)
+		return -1;
+
+	// compare against the byte at a time table method over the range of
+	// lengths and alignments a section can have
+	for(i=0; i < sizeof(buf); i++)
+		buf[i] = random();
+	for(off=0; off < 8; off++) {
+		for(len=0; len <= sizeof(buf) - off; len += (len < 256) ? 1 : 61) {
+			crc = CRC32_INIT;
+			for(i=0; i < len; i++)
+				crc = (crc << 8) ^ crc32tbl[((crc >> 24) ^ buf[off+i]) & 0xff];
+			if (crc32(CRC32_INIT, buf + off, len) != crc)
+				return -1;
+		}
+	}
+
+	return 0;
+}
+
+int dvbdate_check(void)
+{
+	static const int hms[][3] = { {0,0,0}, {12,34,56}, {23,59,59} };
+	dvbdate_t dates[3];
+	dvbdate_t dvbdate;
+	time_t times[3];
+	struct tm tm;
+	struct tm ref;
+	time_t t;
+	int mjd;
+	int k;
+	int l;
+	int i;
+
+	for(mjd=0; mjd <= 0xffff; mjd++) {
+		for(i=0; i < 3; i++) {
+			dates[i][0] = mjd >> 8;
+			dates[i][1] = mjd;
+			dates[i][2] = integer_to_bcd(hms[i][0]);
+			dates[i][3] = integer_to_bcd(hms[i][1]);
+			dates[i][4] = integer_to_bcd(hms[i][2]);
+		}
+		dvbdate_to_unixtime_batch((uint8_t *) dates, sizeof(dvbdate_t), 3, times);
+
+		for(i=0; i < 3; i++) {
+			t = dvbdate_to_unixtime(dates[i]);
+			if (t != times[i])
+				return -1;
+
+			// round trip (1969-12-31 23:59:59 is the 'undefined' value)
+			unixtime_to_dvbdate(t, dvbdate);
+			if ((t != -1) && memcmp(dvbdate, dates[i], sizeof(dvbdate_t)))
+				return -1;
+
+			// the EN 300 468 Annex C formulae (the previous floating
+			// point implementation) are only valid from 1900-03-01
+			if (mjd < 15079)
+				continue;
+
+			memset(&ref, 0, sizeof(ref));
+			ref.tm_year = (int) ((mjd - 15078.2) / 365.25);
+			ref.tm_mon = (int) (((mjd - 14956.1) - (int) (ref.tm_year * 365.25)) / 30.6001);
+			ref.tm_mday = mjd - 14956 - (int) (ref.tm_year * 365.25) - (int) (ref.tm_mon * 30.6001);
+			k = ((ref.tm_mon == 14) || (ref.tm_mon == 15)) ? 1 : 0;
+			ref.tm_year += k;
+			ref.tm_mon = ref.tm_mon - 2 - k * 12;
+
+			gmtime_r(&t, &tm);
+			if ((tm.tm_year != ref.tm_year) ||
+			    (tm.tm_mon != ref.tm_mon) ||
+			    (tm.tm_mday != ref.tm_mday) ||
+			    (tm.tm_hour != hms[i][0]) ||
+			    (tm.tm_min != hms[i][1]) ||
+			    (tm.tm_sec != hms[i][2]))
+				return -1;
+
+			tm.tm_mon++;
+			l = ((tm.tm_mon == 1) || (tm.tm_mon == 2)) ? 1 : 0;
+			if (14956 + tm.tm_mday + (int) ((tm.tm_year - l) * 365.25) +
+			    (int) ((tm.tm_mon + 1 + l * 12) * 30.6001) != mjd)
+				return -1;
+		}
+	}
+
+	// the undefined value
+	memset(dvbdate, 0xff, sizeof(dvbdate_t));
+	if (dvbdate_to_unixtime(dvbdate) != -1)
+		return -1;
+
+	return 0;
+}
+
+#define TRANSPORT_DEMUX_CHECK_PACKETS 40
+
+struct transport_demux_check_state {
+	int next_all;
+	int next_pid;
+	int corrupt;
+};
+
+static void transport_demux_check_all(void *arg, int pid,
+				      struct transport_packet_info *pkts, int count)
+{
+	struct transport_demux_check_state *st = (struct transport_demux_check_state *) arg;
+	uint8_t *buf;
+	int i;
+
+	for(i=0; i < count; i++) {
+		buf = (uint8_t *) pkts[i].pkt;
+		if ((pid != TRANSPORT_DEMUX_ALL_PIDS) ||
+		    (pkts[i].pid != 0x100 + (st->next_all % 3)) ||
+		    (pkts[i].continuity_counter != (st->next_all & 0x0f)) ||
+		    (buf[4] != st->next_all) || (buf[TRANSPORT_PACKET_LENGTH - 1] != st->next_all))
+			st->corrupt++;
+		st->next_all++;
+	}
+}
+
+static void transport_demux_check_pid(void *arg, int pid,
+				      struct transport_packet_info *pkts, int count)
+{
+	struct transport_demux_check_state *st = (struct transport_demux_check_state *) arg;
+	int i;
+
+	for(i=0; i < count; i++) {
+		if ((pid != 0x101) || (pkts[i].pid != 0x101) ||
+		    (((uint8_t *) pkts[i].pkt)[4] != st->next_pid))
+			st->corrupt++;
+		st->next_pid += 3;
+	}
+}
+
+int transport_demux_check(void)
+{
+	// feed sizes which split packets, and the garbage, across calls
+	static const int chunks[] = { 1, 187, 188, 189, 300, 61, 1000, 2, 377 };
+	uint8_t stream[(TRANSPORT_DEMUX_CHECK_PACKETS * TRANSPORT_PACKET_LENGTH) + 100];
+	struct transport_demux_check_state st;
+	struct transport_demux *demux;
+	struct transport_demux_stats stats;
+	size_t len = 0;
+	size_t pos;
+	size_t tmp;
+	int garbage;
+	int ret = -1;
+	int i;
+	int j;
+
+	for(i=0; i < TRANSPORT_DEMUX_CHECK_PACKETS; i++) {
+		// misaligned start, and garbage mid stream
+		garbage = (i == 0) ? 5 : (i == 11) ? 77 : (i == 26) ? 1 : 0;
+		memset(stream + len, 0x00, garbage);
+		len += garbage;
+
+		stream[len] = TRANSPORT_PACKET_SYNC;
+		stream[len + 1] = 0x01;
+		stream[len + 2] = i % 3;
+		stream[len + 3] = 0x10 | (i & 0x0f);
+		memset(stream + len + 4, i, TRANSPORT_PACKET_LENGTH - 4);
+		len += TRANSPORT_PACKET_LENGTH;
+	}
+
+	for(j=0; j < 2; j++) {
+		if ((demux = transport_demux_create()) == NULL)
+			return -1;
+		memset(&st, 0, sizeof(st));
+		st.next_pid = 1;
+		if (transport_demux_register(demux, TRANSPORT_DEMUX_ALL_PIDS,
+					     transport_demux_check_all, &st) ||
+		    transport_demux_register(demux, 0x101, transport_demux_check_pid, &st))
+			goto exit;
+
+		// all in one go, then in pieces
+		if (j == 0) {
+			transport_demux_feed(demux, stream, len);
+		} else {
+			for(pos=0, i=0; pos < len; pos += tmp, i++) {
+				tmp = chunks[i % (sizeof(chunks) / sizeof(chunks[0]))];
+				if (tmp > len - pos)
+					tmp = len - pos;
+				transport_demux_feed(demux, stream + pos, tmp);
+			}
+		}
+
+		transport_demux_get_stats(demux, &stats);
+		if (st.corrupt || (st.next_all != TRANSPORT_DEMUX_CHECK_PACKETS) ||
+		    (st.next_pid != 1 + (3 * ((TRANSPORT_DEMUX_CHECK_PACKETS + 1) / 3))) ||
+		    (stats.packets != TRANSPORT_DEMUX_CHECK_PACKETS) ||
+		    (stats.skipped_bytes != 5 + 77 + 1) || (stats.sync_losses < 3))
+			goto exit;
+		transport_demux_destroy(demux);
+	}
+
+	return 0;
+
+exit:
+	transport_demux_destroy(demux);
+	return ret;
+}
+
+static int check_ext_section(uint8_t *buf, int table_id, int table_id_ext, int version,
+			     int section_number, int last_section_number, int datalen, int fill)
+{
+	int len = 8 + datalen + 4;
+	uint32_t crc;
+
+	buf[0] = table_id;
+	buf[1] = 0xb0 | ((len - 3) >> 8);
+	buf[2] = len - 3;
+	buf[3] = table_id_ext >> 8;
+	buf[4] = table_id_ext;
+	buf[5] = 0xc1 | ((version & 0x1f) << 1);
+	buf[6] = section_number;
+	buf[7] = last_section_number;
+	memset(buf + 8, fill, datalen);
+	crc = crc32(CRC32_INIT, buf, len - 4);
+	buf[len - 4] = crc >> 24;
+	buf[len - 3] = crc >> 16;
+	buf[len - 2] = crc >> 8;
+	buf[len - 1] = crc;
+
+	return len;
+}
+
+#define SECTION_DEMUX_CHECK_SECTIONS 6
+
+struct section_demux_check_state {
+	uint8_t sections[SECTION_DEMUX_CHECK_SECTIONS][256];
+	int lens[SECTION_DEMUX_CHECK_SECTIONS];
+	int next;
+	int corrupt;
+};
+
+static void section_demux_check_section(void *arg, int pid, uint8_t *section, int len)
+{
+	struct section_demux_check_state *st = (struct section_demux_check_state *) arg;
+
+	if ((pid != 0x100) || (st->next >= SECTION_DEMUX_CHECK_SECTIONS) ||
+	    (len != st->lens[st->next]) || memcmp(section, st->sections[st->next], len))
+		st->corrupt++;
+	st->next++;
+}
+
+static int section_demux_check_packet(struct section_demux *sdemux, int pusi, int cc,
+				      uint8_t *payload, int len)
+{
+	uint8_t buf[TRANSPORT_PACKET_LENGTH];
+	struct transport_packet *pkt;
+
+	buf[0] = TRANSPORT_PACKET_SYNC;
+	buf[1] = (pusi ? 0x40 : 0) | 0x01;
+	buf[2] = 0x00;
+	buf[3] = 0x10 | cc;
+	memset(buf + 4, 0xff, TRANSPORT_PACKET_LENGTH - 4);
+	memcpy(buf + 4, payload, len);
+
+	if ((pkt = transport_packet_init(buf)) == NULL)
+		return -1;
+	return section_demux_add_packet(sdemux, pkt);
+}
+
+int section_demux_check(void)
+{
+	// the first three and the head of the fourth fill a packet, leaving only
+	// two bytes of the fourth's header there
+	static const int lens[SECTION_DEMUX_CHECK_SECTIONS] = { 40, 60, 81, 200, 30, 25 };
+	struct section_demux_check_state st;
+	struct section_demux_stats stats;
+	struct section_demux *sdemux;
+	uint8_t payload[TRANSPORT_PACKET_LENGTH - 4];
+	int ret = -1;
+	int pos;
+	int i;
+
+	memset(&st, 0, sizeof(st));
+	for(i=0; i < SECTION_DEMUX_CHECK_SECTIONS; i++)
+		st.lens[i] = check_ext_section(st.sections[i], 0x40 + i, i, 0, 0, 0,
+					       lens[i] - 12, 0x20 + i);
+
+	if ((sdemux = section_demux_create(DVB_MAX_SECTION_BYTES,
+					   section_demux_check_section, &st)) == NULL)
+		return -1;
+
+	// several sections in one packet, the last with its header split
+	payload[0] = 0;
+	pos = 1;
+	for(i=0; i < 3; i++) {
+		memcpy(payload + pos, st.sections[i], lens[i]);
+		pos += lens[i];
+	}
+	memcpy(payload + pos, st.sections[3], 2);
+	if (section_demux_check_packet(sdemux, 1, 0, payload, sizeof(payload)) ||
+	    (st.next != 3))
+		goto exit;
+
+	// the fourth continues, and its tail is skipped by the next pointer_field
+	if (section_demux_check_packet(sdemux, 0, 1, st.sections[3] + 2, 184) ||
+	    (st.next != 3))
+		goto exit;
+	payload[0] = lens[3] - 2 - 184;
+	memcpy(payload + 1, st.sections[3] + 2 + 184, payload[0]);
+	memcpy(payload + 1 + payload[0], st.sections[4], lens[4]);
+	if (section_demux_check_packet(sdemux, 1, 2, payload, 1 + payload[0] + lens[4]) ||
+	    (st.next != 5))
+		goto exit;
+
+	// a lost packet is a continuity error
+	payload[0] = 0;
+	memcpy(payload + 1, st.sections[5], lens[5]);
+	if ((section_demux_check_packet(sdemux, 1, 4, payload, 1 + lens[5]) != -EPROTO) ||
+	    (st.next != 5))
+		goto exit;
+
+	// but not after a reset, when the PID's packets were skipped on purpose
+	if (section_demux_check_packet(sdemux, 1, 5, payload, 1 + lens[5]) ||
+	    (st.next != 6))
+		goto exit;
+	section_demux_reset_pid(sdemux, 0x100);
+	st.next = 5;
+	if (section_demux_check_packet(sdemux, 1, 11, payload, 1 + lens[5]) ||
+	    (st.next != 6))
+		goto exit;
+
+	section_demux_get_stats(sdemux, &stats);
+	if (st.corrupt || (stats.continuity_errors != 1) || (stats.section_errors != 0))
+		goto exit;
+	ret = 0;
+
+exit:
+	section_demux_destroy(sdemux);
+	return ret;
+}
+
+static int view_check_crc(uint8_t *buf, int len)
+{
+	uint32_t crc = crc32(CRC32_INIT, buf, len - 4);
+
+	buf[len - 4] = crc >> 24;
+	buf[len - 3] = crc >> 16;
+	buf[len - 2] = crc >> 8;
+	buf[len - 1] = crc;
+	return crc;
+}
+
+int view_check(void)
+{
+	static const uint8_t pmt[] = {
+		0x02, 0xb0, 0x20, 0x01, 0x01, 0xc7, 0x00, 0x00,
+		0xe1, 0x00, 0xf0, 0x06,			// pcr_pid, program_info_length
+		0x09, 0x04, 0x0b, 0x00, 0xe2, 0x00,	// CA descriptor
+		0x02, 0xe1, 0x01, 0xf0, 0x03,		// video stream
+		0x52, 0x01, 0x01,			// stream_identifier descriptor
+		0x04, 0xe1, 0x02, 0xf0, 0x00,		// audio stream
+		0x00, 0x00, 0x00, 0x00 };
+	static const uint8_t eit[] = {
+		0x4e, 0xf0, 0x2c, 0x00, 0x10, 0xc3, 0x00, 0x01,
+		0x00, 0x22, 0x00, 0x33, 0x01, 0x4f,	// tsid, onid, segment_last, last_table_id
+		0x12, 0x34, 0xd0, 0x21, 0x12, 0x00, 0x00,	// event_id, start_time
+		0x01, 0x30, 0x00, 0x80, 0x05,		// duration, running, descriptors_loop_length
+		0x4d, 0x03, 0x65, 0x6e, 0x67,		// short_event descriptor
+		0x12, 0x35, 0xd0, 0x21, 0x13, 0x30, 0x00,
+		0x00, 0x30, 0x00, 0x20, 0x00,
+		0x00, 0x00, 0x00, 0x00 };
+	uint8_t buf[sizeof(pmt) + sizeof(eit)];
+	uint8_t orig[sizeof(buf)];
+	const struct descriptor *d;
+	const uint8_t *pos;
+	uint32_t crc;
+	int count;
+	int len;
+
+	// PMT accessors
+	len = sizeof(pmt);
+	memcpy(buf, pmt, len);
+	crc = view_check_crc(buf, len);
+	memcpy(orig, buf, len);
+	if (section_view_check(buf, len) || section_view_ext_check(buf, 1) ||
+	    mpeg_pmt_view_check(buf, len))
+		return -1;
+	if ((section_view_table_id(buf) != 0x02) || !section_view_syntax_indicator(buf) ||
+	    (section_view_length(buf) != (size_t) len) ||
+	    (section_view_ext_length(buf) != (size_t) len - 4) ||
+	    (section_view_table_id_ext(buf) != 0x0101) ||
+	    (section_view_version_number(buf) != 3) ||
+	    !section_view_current_next_indicator(buf) ||
+	    (section_view_section_number(buf) != 0) ||
+	    (section_view_last_section_number(buf) != 0) ||
+	    (section_view_crc32(buf) != crc) ||
+	    (mpeg_pmt_view_program_number(buf) != 0x0101) ||
+	    (mpeg_pmt_view_pcr_pid(buf) != 0x100) ||
+	    (mpeg_pmt_view_program_info_length(buf) != 6))
+		return -1;
+	count = 0;
+	mpeg_pmt_view_descriptors_for_each(buf, d) {
+		if ((d->tag != 0x09) || (d->len != 4))
+			return -1;
+		count++;
+	}
+	if (count != 1)
+		return -1;
+	count = 0;
+	mpeg_pmt_view_streams_for_each(buf, pos) {
+		if ((mpeg_pmt_view_stream_type(pos) != (count ? 0x04 : 0x02)) ||
+		    (mpeg_pmt_view_stream_pid(pos) != 0x101 + count) ||
+		    (mpeg_pmt_view_stream_es_info_length(pos) != (count ? 0 : 3)))
+			return -1;
+		mpeg_pmt_view_stream_descriptors_for_each(pos, d) {
+			if (count || (d->tag != 0x52) || (d->len != 1))
+				return -1;
+		}
+		count++;
+	}
+	if ((count != 2) || memcmp(buf, orig, len))
+		return -1;
+
+	// EIT accessors
+	len = sizeof(eit);
+	memcpy(buf, eit, len);
+	view_check_crc(buf, len);
+	if (dvb_eit_view_check(buf, len) ||
+	    (dvb_eit_view_service_id(buf) != 0x0010) ||
+	    (dvb_eit_view_transport_stream_id(buf) != 0x0022) ||
+	    (dvb_eit_view_original_network_id(buf) != 0x0033) ||
+	    (dvb_eit_view_segment_last_section_number(buf) != 1) ||
+	    (dvb_eit_view_last_table_id(buf) != 0x4f))
+		return -1;
+	count = 0;
+	dvb_eit_view_events_for_each(buf, pos) {
+		if ((dvb_eit_view_event_id(pos) != 0x1234 + count) ||
+		    (dvbdate_to_unixtime((uint8_t *) dvb_eit_view_event_start_time(pos)) !=
+		     1096804800 + (count * 5400)) ||
+		    (dvbduration_to_seconds((uint8_t *) dvb_eit_view_event_duration(pos)) !=
+		     (count ? 1800 : 5400)) ||
+		    (dvb_eit_view_event_running_status(pos) != (count ? 1 : 4)) ||
+		    (dvb_eit_view_event_free_ca_mode(pos) != 0) ||
+		    (dvb_eit_view_event_descriptors_loop_length(pos) != (count ? 0 : 5)))
+			return -1;
+		dvb_eit_view_event_descriptors_for_each(pos, d) {
+			if (count || (d->tag != 0x4d) || (d->len != 3))
+				return -1;
+		}
+		count++;
+	}
+	if (count != 2)
+		return -1;
+
+	// truncated buffers are rejected
+	for(len = 0; len < (int) sizeof(pmt); len++) {
+		if (!section_view_check(pmt, len) || !mpeg_pmt_view_check(pmt, len))
+			return -1;
+	}
+	for(len = 0; len < (int) sizeof(eit); len++) {
+		if (!section_view_check(eit, len) || !dvb_eit_view_check(eit, len))
+			return -1;
+	}
+
+	// as are sections whose inner lengths run past their end
+	len = sizeof(pmt);
+	memcpy(buf, orig, len);
+	buf[30] = 0x01;			// audio es_info_length
+	if (!mpeg_pmt_view_check(buf, len))
+		return -1;
+	memcpy(buf, orig, len);
+	buf[13] = 0x05;			// CA descriptor length
+	if (!mpeg_pmt_view_check(buf, len))
+		return -1;
+	memcpy(buf, orig, len);
+	buf[11] = 0xff;			// program_info_length
+	if (!mpeg_pmt_view_check(buf, len))
+		return -1;
+	len = sizeof(eit);
+	memcpy(buf, eit, len);
+	buf[25] = 0x06;			// descriptors_loop_length
+	if (!dvb_eit_view_check(buf, len))
+		return -1;
+
+	// and a short or corrupted extended section
+	memcpy(buf, orig, sizeof(pmt));
+	buf[20] ^= 0x01;
+	if (section_view_ext_check(buf, 0) || !section_view_ext_check(buf, 1))
+		return -1;
+	buf[1] = 0xb0;
+	buf[2] = 0x05;
+	if (section_view_check(buf, 8) || !section_view_ext_check(buf, 0))
+		return -1;
+
+	return 0;
+}
+
+int cache_check(void)
+{
+	static const uint8_t tdt[8] = { 0x70, 0x70, 0x05, 0xd0, 0x21, 0x12, 0x00, 0x00 };
+	struct section_cache *cache;
+	struct section_cache_stats stats;
+	uint8_t a[64];
+	uint8_t b[64];
+	uint8_t c[64];
+	int alen;
+	int blen;
+	int clen;
+	int ret = -1;
+	int i;
+
+	if ((cache = section_cache_create(4)) == NULL)
+		return -1;
+	alen = check_ext_section(a, 0x42, 0x1234, 1, 0, 1, 20, 0x11);
+	blen = check_ext_section(b, 0x42, 0x1234, 2, 0, 1, 20, 0x22);
+
+	// a new version replaces the old one, and a change back is seen too
+	if (section_cache_check(cache, 0x11, a, alen) ||
+	    !section_cache_check(cache, 0x11, a, alen) ||
+	    section_cache_check(cache, 0x11, b, blen) ||
+	    !section_cache_check(cache, 0x11, b, blen) ||
+	    section_cache_check(cache, 0x11, a, alen) ||
+	    !section_cache_check(cache, 0x11, a, alen))
+		goto exit;
+	section_cache_get_stats(cache, &stats);
+	if ((stats.entries != 1) || (stats.hits != 3) || (stats.misses != 3) ||
+	    (stats.changes != 2))
+		goto exit;
+
+	// the PID and section_number are part of the key
+	if (section_cache_check(cache, 0x12, a, alen))
+		goto exit;
+	clen = check_ext_section(c, 0x42, 0x1234, 1, 1, 1, 20, 0x11);
+	if (section_cache_check(cache, 0x11, c, clen) ||
+	    !section_cache_check(cache, 0x11, a, alen))
+		goto exit;
+
+	// removing a different version does nothing
+	section_cache_remove(cache, 0x11, b, blen);
+	if (!section_cache_check(cache, 0x11, a, alen))
+		goto exit;
+	section_cache_remove(cache, 0x11, a, alen);
+	if (section_cache_check(cache, 0x11, a, alen))
+		goto exit;
+
+	// the least recently seen entries are evicted when full
+	for(i=0; i < 4; i++) {
+		clen = check_ext_section(c, 0x4a, i, 0, 0, 0, 10, i);
+		if (section_cache_check(cache, 0x11, c, clen))
+			goto exit;
+	}
+	section_cache_get_stats(cache, &stats);
+	if ((stats.entries != 4) || (stats.evictions != 3) ||
+	    section_cache_check(cache, 0x11, a, alen) ||
+	    !section_cache_check(cache, 0x11, c, clen))
+		goto exit;
+
+	// sections without a CRC are never duplicates
+	if (section_cache_check(cache, 0x14, tdt, sizeof(tdt)) ||
+	    section_cache_check(cache, 0x14, tdt, sizeof(tdt)))
+		goto exit;
+	ret = 0;
+
+exit:
+	section_cache_destroy(cache);
+	return ret;
+}
+
+struct table_assembler_check_state {
+	struct table_assembler *ta;
+	int completed;
+	int last_table_id_ext;
+	int corrupt;
+};
+
+static void table_assembler_check_table(void *arg, struct table_assembler_table *table)
+{
+	struct table_assembler_check_state *st = (struct table_assembler_check_state *) arg;
+	uint8_t buf[64];
+	int i;
+
+	// the first table completing fills the assembler well past its
+	// initial size, then checks the table it was given is still intact
+	if ((st->completed++ == 0) && (table->table_id_ext == 1)) {
+		for(i=0; i < 200; i++) {
+			check_ext_section(buf, 0x42, 0x1000 + i, 0, 0, 1, 4, 0);
+			if (table_assembler_add(st->ta, 0x11, buf, 16) != TABLE_ASSEMBLER_NEW_SECTION)
+				st->corrupt++;
+		}
+	}
+	if ((table->pid != 0x11) && (table->pid != 0x12))
+		st->corrupt++;
+	if (!table->complete)
+		st->corrupt++;
+	st->last_table_id_ext = table->table_id_ext;
+}
+
+static int table_assembler_check_eit(uint8_t *buf, int section_number,
+				     int last_section_number, int segment_last_section_number)
+{
+	int len;
+	uint32_t crc;
+
+	len = check_ext_section(buf, 0x50, 0x0101, 3, section_number, last_section_number, 6, 0);
+	buf[8] = 0x00;		// transport_stream_id
+	buf[9] = 0x22;
+	buf[10] = 0x00;		// original_network_id
+	buf[11] = 0x33;
+	buf[12] = segment_last_section_number;
+	buf[13] = 0x50;		// last_table_id
+	crc = crc32(CRC32_INIT, buf, len - 4);
+	buf[len - 4] = crc >> 24;
+	buf[len - 3] = crc >> 16;
+	buf[len - 2] = crc >> 8;
+	buf[len - 1] = crc;
+
+	return len;
+}
+
+int table_assembler_check(void)
+{
+	static const int order[4] = { 2, 0, 3, 1 };
+	// sections 0-1, 8 and 16-17 exist; the others are after each
+	// segment's segment_last_section_number
+	static const int eit[5][2] = { { 16, 17 }, { 8, 8 }, { 1, 1 }, { 17, 17 }, { 0, 1 } };
+	struct table_assembler_check_state st;
+	struct table_assembler_stats stats;
+	uint8_t buf[64];
+	int len;
+	int res;
+	int ret = -1;
+	int i;
+
+	memset(&st, 0, sizeof(st));
+	if ((st.ta = table_assembler_create(table_assembler_check_table, &st)) == NULL)
+		return -1;
+
+	// out of order, with a repeat, completing on the last one
+	for(i=0; i < 4; i++) {
+		len = check_ext_section(buf, 0x42, 1, 5, order[i], 3, 4, i);
+		res = table_assembler_add(st.ta, 0x11, buf, len);
+		if (res != ((i == 3) ? TABLE_ASSEMBLER_COMPLETE : TABLE_ASSEMBLER_NEW_SECTION))
+			goto exit;
+		if ((i == 1) &&
+		    (table_assembler_add(st.ta, 0x11, buf, len) != TABLE_ASSEMBLER_IGNORED))
+			goto exit;
+	}
+	if (st.corrupt || (st.completed != 1) || (st.last_table_id_ext != 1))
+		goto exit;
+
+	// a new version starts it again
+	len = check_ext_section(buf, 0x42, 1, 6, 0, 3, 4, 0);
+	if (table_assembler_add(st.ta, 0x11, buf, len) != TABLE_ASSEMBLER_NEW_SECTION)
+		goto exit;
+
+	// an EIT schedule with gaps after each segment_last_section_number
+	for(i=0; i < 5; i++) {
+		len = table_assembler_check_eit(buf, eit[i][0], 17, eit[i][1]);
+		res = table_assembler_add(st.ta, 0x12, buf, len);
+		if (res != ((i == 4) ? TABLE_ASSEMBLER_COMPLETE : TABLE_ASSEMBLER_NEW_SECTION))
+			goto exit;
+	}
+	if (st.corrupt || (st.completed != 2) || (st.last_table_id_ext != 0x0101))
+		goto exit;
+
+	// sections not current are ignored
+	len = check_ext_section(buf, 0x42, 2, 0, 0, 0, 4, 0);
+	buf[5] &= ~1;
+	if (table_assembler_add(st.ta, 0x11, buf, len) != TABLE_ASSEMBLER_IGNORED)
+		goto exit;
+
+	table_assembler_get_stats(st.ta, &stats);
+	if ((stats.tables != 202) || (stats.complete != 1) || (stats.version_changes != 1) ||
+	    (stats.new_sections != 4 + 200 + 1 + 5) || (stats.ignored_sections != 2))
+		goto exit;
+	ret = 0;
+
+exit:
+	table_assembler_destroy(st.ta);
+	return ret;
+}
+
+#define PES_CHECK_CHUNK 512
+#define PES_CHECK_PACKETS 8
+
+struct pes_demux_check_state {
+	uint8_t packets[PES_CHECK_PACKETS][1100];
+	int lens[PES_CHECK_PACKETS];
+	int pids[PES_CHECK_PACKETS];
+	int next;		// next packet expected
+	int pos;		// bytes of it received so far
+	int calls;		// callbacks for it so far
+	int direct;
+	int corrupt;
+	uint8_t cc[2];
+};
+
+static void pes_demux_check_data(void *arg, int pid, struct pes_header *hdr,
+				 uint8_t *data, int len, int flags)
+{
+	struct pes_demux_check_state *st = (struct pes_demux_check_state *) arg;
+	int n = st->next;
+
+	if ((n >= PES_CHECK_PACKETS) || (data == NULL) || (len <= 0) ||
+	    (len > PES_CHECK_CHUNK) || (pid != st->pids[n]) ||
+	    (hdr->stream_id != st->packets[n][3])) {
+		st->corrupt++;
+		return;
+	}
+	if (flags & pes_demux_flag_start) {
+		st->pos = 0;
+		st->calls = 0;
+	}
+	if ((st->pos + len > st->lens[n]) || memcmp(data, st->packets[n] + st->pos, len)) {
+		st->corrupt++;
+		return;
+	}
+	st->pos += len;
+	st->calls++;
+	if (flags & pes_demux_flag_direct)
+		st->direct++;
+
+	if (flags & pes_demux_flag_end) {
+		if ((st->pos != st->lens[n]) ||
+		    (st->calls != (st->lens[n] + PES_CHECK_CHUNK - 1) / PES_CHECK_CHUNK))
+			st->corrupt++;
+		st->next++;
+	}
+}
+
+static int pes_demux_check_feed(struct pes_demux *pdemux, struct pes_demux_check_state *st,
+				int idx, int first, int last, int skip)
+{
+	uint8_t buf[TRANSPORT_PACKET_LENGTH];
+	struct transport_packet *pkt;
+	int pid = st->pids[idx];
+	int pos = 0;
+	int res = 0;
+	int count = 0;
+	int stuff;
+	int n;
+
+	// one PES packet, with adaptation field stuffing in its last TS packet
+	while(pos < st->lens[idx]) {
+		n = st->lens[idx] - pos;
+		if (n > 184)
+			n = 184;
+		buf[0] = TRANSPORT_PACKET_SYNC;
+		buf[1] = ((pos == 0) ? 0x40 : 0) | (pid >> 8);
+		buf[2] = pid;
+		buf[3] = ((n < 184) ? 0x30 : 0x10) | (st->cc[pid & 1]++ & 0x0f);
+		stuff = 184 - n;
+		if (stuff) {
+			buf[4] = stuff - 1;
+			if (stuff > 1) {
+				buf[5] = 0;
+				memset(buf + 6, 0xff, stuff - 2);
+			}
+		}
+		memcpy(buf + 4 + stuff, st->packets[idx] + pos, n);
+		pos += n;
+
+		if ((count >= first) && (count <= last) && (count != skip)) {
+			if ((pkt = transport_packet_init(buf)) == NULL)
+				return -1;
+			if ((n = pes_demux_add_packet(pdemux, pkt)) != 0)
+				res = n;
+		}
+		count++;
+	}
+
+	return res;
+}
+
+int pes_demux_check(void)
+{
+	// unbounded packets filling exactly one and two chunks, and others;
+	// then bounded ones over a chunk, and within one TS packet
+	static const int lens[PES_CHECK_PACKETS] = { 1024, 512, 700, 300, 600, 400, 1000, 100 };
+	struct pes_demux_check_state st;
+	struct pes_demux_stats stats;
+	struct pes_demux *pdemux;
+	int ret = -1;
+	int i;
+	int j;
+
+	memset(&st, 0, sizeof(st));
+	for(i=0; i < PES_CHECK_PACKETS; i++) {
+		int bounded = (i >= 6);
+
+		st.lens[i] = lens[i];
+		st.pids[i] = bounded ? 0x201 : 0x200;
+		st.packets[i][0] = 0;
+		st.packets[i][1] = 0;
+		st.packets[i][2] = 1;
+		st.packets[i][3] = bounded ? 0xc0 : 0xe0;
+		st.packets[i][4] = bounded ? (lens[i] - 6) >> 8 : 0;
+		st.packets[i][5] = bounded ? (lens[i] - 6) : 0;
+		st.packets[i][6] = 0x80;
+		st.packets[i][7] = 0;
+		st.packets[i][8] = 0;
+		for(j=9; j < lens[i]; j++)
+			st.packets[i][j] = i + j;
+	}
+
+	if ((pdemux = pes_demux_create(PES_CHECK_CHUNK, pes_demux_check_data, &st)) == NULL)
+		return -1;
+
+	// each unbounded packet ends when the next one starts
+	for(i=0; i < 4; i++) {
+		if (pes_demux_check_feed(pdemux, &st, i, 0, 100, -1) || (st.next != i))
+			goto exit;
+	}
+
+	// losing a TS packet loses that PES packet, but not the next
+	if ((pes_demux_check_feed(pdemux, &st, 4, 0, 100, 1) != -EPROTO) || (st.next != 4))
+		goto exit;
+	st.next = 5;
+	if (pes_demux_check_feed(pdemux, &st, 5, 0, 100, -1) || (st.next != 5) ||
+	    pes_demux_check_feed(pdemux, &st, 3, 0, 0, -1) || (st.next != 6))
+		goto exit;
+
+	// bounded ones are delivered as soon as they are complete
+	if (pes_demux_check_feed(pdemux, &st, 6, 0, 100, -1) || (st.next != 7) ||
+	    pes_demux_check_feed(pdemux, &st, 7, 0, 100, -1) || (st.next != 8) ||
+	    (st.direct != 1))
+		goto exit;
+
+	pes_demux_get_stats(pdemux, &stats);
+	if (st.corrupt || (stats.continuity_errors != 1) || (stats.pes_errors != 0) ||
+	    (stats.packets != 7) || (stats.direct != 1))
+		goto exit;
+	ret = 0;
+
+exit:
+	pes_demux_destroy(pdemux);
+	return ret;
+}
+
+// 4060800 bits/s is exactly 10000 27MHz ticks per packet
+#define PCR_CHECK_BITRATE 4060800
+#define PCR_CHECK_TPP 10000ULL
+#define PCR_CHECK_INTERVAL 20
+
+/*
+ * Feed one PCR interval of a mux: a PCR on 0x100, then 14 packets on 0x101
+ * and 5 on 0x102. Returns the events of the PCR packet.
+ */
+static int pcr_check_interval(struct pcr_clock *clk, uint64_t pcr, int discontinuity)
+{
+	uint8_t buf[TRANSPORT_PACKET_LENGTH];
+	struct transport_packet *pkt;
+	uint64_t base = pcr / 300;
+	int ext = pcr % 300;
+	int events = 0;
+	int i;
+
+	for(i=0; i < PCR_CHECK_INTERVAL; i++) {
+		memset(buf, 0xff, sizeof(buf));
+		buf[0] = TRANSPORT_PACKET_SYNC;
+		buf[1] = 0x01;
+		if (i == 0) {
+			buf[2] = 0x00;
+			buf[3] = 0x20;
+			buf[4] = 183;
+			buf[5] = transport_adaptation_flag_pcr |
+				 (discontinuity ? transport_adaptation_flag_discontinuity : 0);
+			buf[6] = base >> 25;
+			buf[7] = base >> 17;
+			buf[8] = base >> 9;
+			buf[9] = base >> 1;
+			buf[10] = ((base & 1) << 7) | 0x7e | (ext >> 8);
+			buf[11] = ext;
+		} else {
+			buf[2] = (i <= 14) ? 0x01 : 0x02;
+			buf[3] = 0x10 | (i & 0x0f);
+		}
+		if ((pkt = transport_packet_init(buf)) == NULL)
+			return -1;
+		if (i == 0)
+			events = pcr_clock_add_packet(clk, pkt);
+		else
+			pcr_clock_add_packet(clk, pkt);
+	}
+
+	return events;
+}
+
+int pcr_check(void)
+{
+	const uint64_t step = PCR_CHECK_TPP * PCR_CHECK_INTERVAL;
+	struct pcr_clock_program prog;
+	struct pcr_clock_stats stats;
+	struct pcr_clock *clk;
+	uint32_t bitrate;
+	uint32_t smoothed;
+	uint64_t pcr;
+	uint64_t now;
+	int ret = -1;
+	int events;
+	int i;
+
+	if ((clk = pcr_clock_create()) == NULL)
+		return -1;
+
+	// lock on, running through the wrap of the PCR
+	pcr = PCR_CLOCK_WRAP - (50 * step) + 123;
+	for(i=0; i < 100; i++) {
+		events = pcr_check_interval(clk, pcr, 0);
+		if (events & (pcr_clock_event_discontinuity | pcr_clock_event_jitter))
+			goto exit;
+		pcr = (pcr + step) % PCR_CLOCK_WRAP;
+	}
+	pcr_clock_get_stats(clk, &stats);
+	if ((stats.reference_pid != 0x100) || (stats.programs != 1) ||
+	    (stats.packets != 100 * PCR_CHECK_INTERVAL) ||
+	    (stats.bitrate != PCR_CHECK_BITRATE) || (stats.bitrate_smoothed != PCR_CHECK_BITRATE))
+		goto exit;
+	if (pcr_clock_now(clk, &now) ||
+	    (now != (pcr - step + (PCR_CHECK_INTERVAL - 1) * PCR_CHECK_TPP)))
+		goto exit;
+	if (pcr_clock_get_pid_bitrate(clk, 0x101, &bitrate, &smoothed) ||
+	    (bitrate != PCR_CHECK_BITRATE / PCR_CHECK_INTERVAL * 14) ||
+	    (smoothed != bitrate) ||
+	    pcr_clock_get_pid_bitrate(clk, 0x102, &bitrate, &smoothed) ||
+	    (bitrate != PCR_CHECK_BITRATE / PCR_CHECK_INTERVAL * 5))
+		goto exit;
+
+	// a single late PCR is jitter, but doesn't drag the clock off
+	events = pcr_check_interval(clk, pcr + 100, 0);
+	pcr += step;
+	if (!(events & pcr_clock_event_jitter))
+		goto exit;
+	for(i=0; i < 10; i++) {
+		if (pcr_check_interval(clk, pcr, 0) & pcr_clock_event_jitter)
+			goto exit;
+		pcr += step;
+	}
+
+	// a flagged jump starts the clock again without jitter
+	pcr += 1000000000ULL;
+	events = pcr_check_interval(clk, pcr, 1);
+	if (!(events & pcr_clock_event_discontinuity) || (events & pcr_clock_event_jitter))
+		goto exit;
+	pcr += step;
+	for(i=0; i < 20; i++) {
+		if (pcr_check_interval(clk, pcr, 0) &
+		    (pcr_clock_event_discontinuity | pcr_clock_event_jitter))
+			goto exit;
+		pcr += step;
+	}
+	if (pcr_clock_now(clk, &now) ||
+	    (now != (pcr - step + (PCR_CHECK_INTERVAL - 1) * PCR_CHECK_TPP)))
+		goto exit;
+
+	// as does a gap with no flag
+	pcr += PCR_CLOCK_MAX_GAP;
+	if (!(pcr_check_interval(clk, pcr, 0) & pcr_clock_event_discontinuity))
+		goto exit;
+
+	if (pcr_clock_get_program(clk, 0x100, &prog) || (prog.discontinuities != 2) ||
+	    (prog.jitter_errors != 1) || (prog.max_jitter != 100) ||
+	    (prog.max_interval != step + 100) || (prog.pcrs != 100 + 1 + 10 + 1 + 20 + 1))
+		goto exit;
+	ret = 0;
+
+exit:
+	pcr_clock_destroy(clk);
+	return ret;
+}
+
+#define PACKETIZER_CHECK_SECTIONS 8
+
+struct packetizer_check_state {
+	uint8_t sections[PACKETIZER_CHECK_SECTIONS][1024];
+	int lens[PACKETIZER_CHECK_SECTIONS];
+	int next;
+	int corrupt;
+};
+
+static void packetizer_check_section(void *arg, int pid, uint8_t *section, int len)
+{
+	struct packetizer_check_state *st = (struct packetizer_check_state *) arg;
+
+	if ((pid != 0x123) || (st->next >= PACKETIZER_CHECK_SECTIONS) ||
+	    (len != st->lens[st->next]) || memcmp(section, st->sections[st->next], len))
+		st->corrupt++;
+	st->next++;
+}
+
+int packetizer_check(void)
+{
+	// 366 and 182 bytes leave the last packet with exactly one byte free,
+	// after a continuation packet and after a pointer_field respectively
+	static const int lens[PACKETIZER_CHECK_SECTIONS] = { 366, 366, 182, 182, 366, 3, 1021, 550 };
+	struct packetizer_check_state st;
+	struct section_packetizer sp;
+	struct section_demux *sdemux;
+	struct transport_packet *pkt;
+	uint8_t out[SECTION_PACKETIZER_MAX_PACKETS(1024) * TRANSPORT_PACKET_LENGTH];
+	uint32_t crc;
+	int flags;
+	int count;
+	int i;
+	int j;
+
+	memset(&st, 0, sizeof(st));
+	for(i=0; i < PACKETIZER_CHECK_SECTIONS; i++) {
+		st.lens[i] = lens[i];
+		st.sections[i][0] = 0x80 + i;
+		st.sections[i][1] = 0xb0 | ((lens[i] - 3) >> 8);
+		st.sections[i][2] = lens[i] - 3;
+		for(j=3; j < lens[i]; j++)
+			st.sections[i][j] = 0x40 + ((i + j) % 0x80);
+		if (lens[i] > 3) {
+			crc = crc32(CRC32_INIT, st.sections[i], lens[i] - 4);
+			st.sections[i][lens[i] - 4] = crc >> 24;
+			st.sections[i][lens[i] - 3] = crc >> 16;
+			st.sections[i][lens[i] - 2] = crc >> 8;
+			st.sections[i][lens[i] - 1] = crc;
+		}
+	}
+
+	for(flags=0; flags <= section_packetizer_flag_pack; flags++) {
+		if ((sdemux = section_demux_create(DVB_MAX_SECTION_BYTES,
+						   packetizer_check_section, &st)) == NULL)
+			return -1;
+		section_packetizer_init(&sp, 0x123, flags);
+		st.next = 0;
+
+		for(i=0; i <= PACKETIZER_CHECK_SECTIONS; i++) {
+			if (i < PACKETIZER_CHECK_SECTIONS)
+				count = section_packetizer_add(&sp, st.sections[i], lens[i], out);
+			else
+				count = section_packetizer_flush(&sp, out);
+			for(j=0; j < count; j++) {
+				if ((pkt = transport_packet_init(out + (j * TRANSPORT_PACKET_LENGTH))) == NULL)
+					st.corrupt++;
+				else if (section_demux_add_packet(sdemux, pkt))
+					st.corrupt++;
+			}
+		}
+		section_demux_destroy(sdemux);
+
+		if (st.corrupt || (st.next != PACKETIZER_CHECK_SECTIONS))
+			return -1;
+	}
+
+	return 0;
+}
+
+struct text_check_case {
+	int flags;
+	const char *src;
+	int srclen;
+	int destlen;
+	const char *expect;
+	int ret;		/* expected return if not strlen(expect) */
+};
+
+static const struct text_check_case text_check_cases[] = {
+	// figure A.1, with and without precomposed forms for the diacritics
+	{ 0, "caf\xc2" "e", 5, 64, "caf\xc3\xa9", 0 },
+	{ 0, "\xc8" "o\xcb" "c\xc1" "A", 6, 64, "\xc3\xb6\xc3\xa7\xc3\x80", 0 },
+	{ 0, "\xc2" "q", 2, 64, "q\xcc\x81", 0 },
+	{ 0, "\xa4 \xa6", 3, 64, "\xe2\x82\xac #", 0 },
+
+	// the table A.3 character set selections
+	{ 0, "\x01\xb0", 2, 64, "\xd0\x90", 0 },
+	{ 0, "\x02\xc7", 2, 64, "\xd8\xa7", 0 },
+	{ 0, "\x03\xe1", 2, 64, "\xce\xb1", 0 },
+	{ 0, "\x04\xe0", 2, 64, "\xd7\x90", 0 },
+	{ 0, "\x05\xfd", 2, 64, "\xc4\xb1", 0 },
+	{ 0, "\x06\xa1", 2, 64, "\xc4\x84", 0 },
+	{ 0, "\x07\xa1", 2, 64, "\xe0\xb8\x81", 0 },
+	{ 0, "\x09\xa1", 2, 64, "\xe2\x80\x9d", 0 },
+	{ 0, "\x0a\xa1", 2, 64, "\xe1\xb8\x82", 0 },
+	{ 0, "\x0b\xa4", 2, 64, "\xe2\x82\xac", 0 },
+	{ 0, "\x0d\xc2" "e", 3, 64, "\xc3\xa9", 0 },
+	{ 0, "\x10\x00\x01\xe9", 4, 64, "\xc3\xa9", 0 },
+	{ 0, "\x10\x00\x02\xa1", 4, 64, "\xc4\x84", 0 },
+	{ 0, "\x10\x00\x0c\xc2" "e", 5, 64, "\xc3\xa9", 0 },
+	{ 0, "\x11\x00\x41\x04\x10", 5, 64, "A\xd0\x90", 0 },
+	{ 0, "\x12\xb0\xa1", 3, 64, "\xea\xb0\x80", 0 },
+	{ 0, "\x13\xc4\xe3", 3, 64, "\xe4\xbd\xa0", 0 },
+	{ 0, "\x14\xa4\x40", 3, 64, "\xe4\xb8\x80", 0 },
+	{ 0, "\x15" "caf\xc3\xa9", 6, 64, "caf\xc3\xa9", 0 },
+
+	// control codes, in each of the encodings they exist in
+	{ 0, "a\x8a" "b", 3, 64, "a b", 0 },
+	{ DVB_TEXT_CONV_NEWLINE, "a\x8a" "b", 3, 64, "a\nb", 0 },
+	{ 0, "\x86" "x\x87" "y", 4, 64, "xy", 0 },
+	{ DVB_TEXT_CONV_EMPHASIS, "\x86" "x\x87" "y", 4, 64, "*x*y", 0 },
+	{ DVB_TEXT_CONV_EMPHASIS, "\x86" "x", 2, 64, "*x*", 0 },
+	{ DVB_TEXT_CONV_EMPHASIS | DVB_TEXT_CONV_NEWLINE,
+	  "\x11\xe0\x86\x00" "x\xe0\x87\xe0\x8a", 9, 64, "*x*\n", 0 },
+	{ DVB_TEXT_CONV_NEWLINE, "\x15" "a\xee\x82\x8a" "b", 6, 64, "a\nb", 0 },
+
+	// malformed UTF-8
+	{ 0, "\x15\x80" "a\xc3", 4, 64, "\xef\xbf\xbd" "a\xef\xbf\xbd", 0 },
+	{ 0, "\x15\xe2\x82" "a", 4, 64, "\xef\xbf\xbd" "a", 0 },
+	{ 0, "\x15\xc0\xaf", 3, 64, "\xef\xbf\xbd\xef\xbf\xbd", 0 },
+	{ 0, "\x15\xed\xa0\x80", 4, 64, "\xef\xbf\xbd", 0 },
+
+	// truncation never splits a character
+	{ 0, "ab", 2, 3, "ab", 0 },
+	{ 0, "\x15" "a\xe2\x82\xac", 5, 3, "a", -E2BIG },
+	{ 0, "\xc2" "e\xc2" "e", 4, 4, "\xc3\xa9", -E2BIG },
+	{ 0, "\x15\x80", 2, 3, "", -E2BIG },
+	{ 0, "\x11\x00" "a\x20\xac", 5, 4, "a", -E2BIG },
+};
+
+int dvb_text_check(void)
+{
+	const struct text_check_case *c;
+	struct dvb_text_conv *tc;
+	char dest[64];
+	size_t i;
+	int ret;
+
+	for(i=0; i < sizeof(text_check_cases) / sizeof(text_check_cases[0]); i++) {
+		c = &text_check_cases[i];
+		if ((tc = dvb_text_conv_create(NULL, NULL, c->flags)) == NULL)
+			return -1;
+		ret = dvb_text_conv_decode(tc, (const uint8_t *) c->src, c->srclen,
+					   dest, c->destlen);
+		dvb_text_conv_destroy(tc);
+
+		if ((ret != (c->ret ? c->ret : (int) strlen(c->expect))) || strcmp(dest, c->expect)) {
+			fprintf(stderr, "XXXX dvb text case %i failed\n", (int) i);
+			return -1;
+		}
+	}
+
+	// conversion to another character set, and from a default one
+	if ((tc = dvb_text_conv_create("ISO-8859-1", NULL, 0)) == NULL)
+		return -1;
+	ret = dvb_text_conv_decode(tc, (const uint8_t *) "caf\xc2" "e", 5, dest, sizeof(dest));
+	dvb_text_conv_destroy(tc);
+	if ((ret != 4) || strcmp(dest, "caf\xe9"))
+		return -1;
+
+	if ((tc = dvb_text_conv_create(NULL, "ISO-8859-7", 0)) == NULL)
+		return -1;
+	ret = dvb_text_conv_decode(tc, (const uint8_t *) "\xe1", 1, dest, sizeof(dest));
+	dvb_text_conv_destroy(tc);
+	if ((ret != 2) || strcmp(dest, "\xce\xb1"))
+		return -1;
+
+	return 0;
+}
+
+struct mpe_fec_check_state {
+	struct mpe_fec *fec;
+	uint8_t frame[MPE_FEC_COLUMNS * MPE_FEC_MAX_ROWS];	/* as transmitted */
+	int addrs[MPE_FEC_ADT_COLUMNS * MPE_FEC_MAX_ROWS / 20];
+	int lens[MPE_FEC_ADT_COLUMNS * MPE_FEC_MAX_ROWS / 20];
+	int count;
+	int next;		/* index of the next datagram expected */
+	int delivered;
+	int corrupt;
+};
+
+static void mpe_fec_check_datagram(void *arg, uint8_t *datagram, int len, int recovered,
+				   int mac)
+{
+	struct mpe_fec_check_state *st = (struct mpe_fec_check_state *) arg;
+	int i;
+
+	// datagrams found in the rebuilt frame have no MAC address
+	if (mac != (recovered ? -1 : 0x3412)) {
+		st->corrupt++;
+		return;
+	}
+
+	// datagrams come out in order, with any that couldn't be rebuilt missing
+	for(i=st->next; i < st->count; i++) {
+		if ((st->lens[i] == len) && !memcmp(st->frame + st->addrs[i], datagram, len))
+			break;
+	}
+	if (i == st->count) {
+		st->corrupt++;
+		return;
+	}
+	st->next = i + 1;
+	st->delivered++;
+}
+
+static void mpe_fec_check_section(void *arg, int pid, uint8_t *section, int len)
+{
+	struct mpe_fec_check_state *st = (struct mpe_fec_check_state *) arg;
+
+	(void) pid;
+	mpe_fec_add_section(st->fec, section, len);
+}
+
+static uint8_t gf_mul_bitwise(uint8_t a, uint8_t b)
+{
+	uint8_t r = 0;
+
+	while(b) {
+		if (b & 1)
+			r ^= a;
+		a = (a << 1) ^ ((a & 0x80) ? 0x1d : 0);
+		b >>= 1;
+	}
+	return r;
+}
+
+static int mpe_fec_check_frame(struct mpe_fec_check_state *st, int rows, int mode)
+{
+	uint8_t sec[DVB_MAX_SECTION_BYTES];
+	uint8_t pkts[SECTION_PACKETIZER_MAX_PACKETS(DVB_MAX_SECTION_BYTES) * TRANSPORT_PACKET_LENGTH];
+	struct section_packetizer sp;
+	struct section_demux *sdemux;
+	struct mpe_fec_stats stats;
+	uint32_t address;
+	uint32_t crc;
+	uint8_t root;
+	uint8_t acc;
+	int budget = MPE_FEC_RS_COLUMNS;
+	int adt = MPE_FEC_ADT_COLUMNS * rows;
+	int pos = 0;
+	int npkts;
+	int len;
+	int col;
+	int i;
+	int j;
+	int k;
+
+	// fill most of the ADT with datagrams, and the rest with padding
+	memset(st->frame, 0, sizeof(st->frame));
+	st->count = 0;
+	while(1) {
+		len = 20 + (rand() % 1480);
+		if (pos + len > adt - rows)
+			break;
+		st->frame[pos] = 0x45;
+		st->frame[pos + 2] = len >> 8;
+		st->frame[pos + 3] = len;
+		for(i=4; i < len; i++)
+			st->frame[pos + i] = rand();
+		st->addrs[st->count] = pos;
+		st->lens[st->count++] = len;
+		pos += len;
+	}
+	mpe_fec_encode(st->frame, rows);
+
+	// every row must be a codeword, i.e. have roots 1, a, ... a^63
+	for(k=0; k < rows; k += 37) {
+		root = 1;
+		for(i=0; i < MPE_FEC_RS_COLUMNS; i++) {
+			acc = 0;
+			for(j=0; j < MPE_FEC_COLUMNS; j++)
+				acc = gf_mul_bitwise(acc, root) ^ st->frame[(j * rows) + k];
+			if (acc)
+				return -1;
+			root = gf_mul_bitwise(root, 2);
+		}
+	}
+
+	st->fec = mpe_fec_create(rows, mpe_fec_check_datagram, st);
+	sdemux = section_demux_create(DVB_MAX_SECTION_BYTES, mpe_fec_check_section, st);
+	if ((st->fec == NULL) || (sdemux == NULL))
+		return -1;
+	section_packetizer_init(&sp, 0x100, section_packetizer_flag_pack);
+	st->next = 0;
+	st->delivered = 0;
+	st->corrupt = 0;
+
+	// the datagram sections, then one MPE-FEC section per RS column
+	for(i=0; i < st->count + MPE_FEC_RS_COLUMNS; i++) {
+		if (i < st->count) {
+			address = st->addrs[i];
+			len = st->lens[i];
+			memcpy(sec + 12, st->frame + address, len);
+			sec[0] = stag_mpeg_datagram;
+			sec[3] = 0x12;
+			sec[4] = 0x34;
+			sec[6] = 0;
+			sec[7] = 0;
+			sec[9] = (i == st->count - 1) ? 0x08 : 0;	// table_boundary
+			col = ((address + len - 1) / rows) - (address / rows) + 1;
+		} else {
+			col = i - st->count;
+			address = col * rows;
+			len = rows;
+			memcpy(sec + 12, st->frame + ((MPE_FEC_ADT_COLUMNS + col) * rows), len);
+			sec[0] = stag_dvb_mpe_fec;
+			sec[3] = (adt - pos) / rows;
+			sec[4] = 0xff;
+			sec[6] = col;
+			sec[7] = MPE_FEC_RS_COLUMNS - 1;
+			sec[9] = (col == MPE_FEC_RS_COLUMNS - 1) ? 0x04 : 0;	// frame_boundary
+			col = 1;
+		}
+		len += 12 + CRC_SIZE;
+		sec[1] = 0xb0 | ((len - 3) >> 8);
+		sec[2] = len - 3;
+		sec[5] = 0xc1;
+		sec[8] = 0;
+		sec[9] |= (address >> 16) & 0x03;
+		sec[10] = address >> 8;
+		sec[11] = address;
+		crc = crc32(CRC32_INIT, sec, len - CRC_SIZE);
+		sec[len - 4] = crc >> 24;
+		sec[len - 3] = crc >> 16;
+		sec[len - 2] = crc >> 8;
+		sec[len - 1] = crc;
+
+		// mode 1: lose whole sections, but never more columns than can be rebuilt
+		if ((mode == 1) && ((rand() % 20) == 0) && (col <= budget)) {
+			budget -= col;
+			continue;
+		}
+
+		npkts = section_packetizer_add(&sp, sec, len, pkts);
+		for(j=0; j < npkts; j++) {
+			// modes 2 and 3: lose transport packets at random
+			if ((mode == 2) && ((rand() % 300) == 0))
+				continue;
+			if ((mode == 3) && ((rand() % 20) == 0))
+				continue;
+			section_demux_add_packet(sdemux, transport_packet_init(pkts + (j * TRANSPORT_PACKET_LENGTH)));
+		}
+	}
+	npkts = section_packetizer_flush(&sp, pkts);
+	if (npkts)
+		section_demux_add_packet(sdemux, transport_packet_init(pkts));
+	mpe_fec_flush(st->fec);
+	mpe_fec_get_stats(st->fec, &stats);
+	mpe_fec_destroy(st->fec);
+	section_demux_destroy(sdemux);
+
+	// a datagram which didn't come out exactly as sent is always an error
+	if (st->corrupt || (stats.frames != 1))
+		return -1;
+	switch(mode) {
+	case 0:
+		if ((st->delivered != st->count) || stats.recovered)
+			return -1;
+		break;
+	case 1:
+		if ((st->delivered != st->count) || (stats.recovered == 0))
+			return -1;
+		break;
+	case 3:
+		if (stats.lost == 0)
+			return -1;
+		break;
+	}
+
+	return 0;
+}
+
+int mpe_fec_check(void)
+{
+	static struct mpe_fec_check_state st;
+	int rows;
+	int mode;
+
+	srand(1);
+	for(rows=MPE_FEC_MIN_ROWS; rows <= MPE_FEC_MAX_ROWS; rows += 256) {
+		for(mode=0; mode < 4; mode++) {
+			if (mpe_fec_check_frame(&st, rows, mode))
+				return -1;
+		}
+	}
+
+	return 0;
+}
+
+struct mpe_demux_fec_check_state {
+	uint8_t frame[MPE_FEC_COLUMNS * MPE_FEC_MIN_ROWS];
+	int expect[4];
+	int count;
+	int corrupt;
+};
+
+static void mpe_demux_fec_check_batch(void *arg, struct mpe_demux_packet *packets, int count)
+{
+	struct mpe_demux_fec_check_state *st = (struct mpe_demux_fec_check_state *) arg;
+	struct mpe_demux_packet *p;
+	int i;
+
+	for(i=0; i < count; i++) {
+		p = &packets[i];
+		if ((st->count == 4) || (p->len != 100) || (p->pid != 0x200) ||
+		    memcmp(p->data, st->frame + (st->expect[st->count] * 100), 100))
+			st->corrupt++;
+		// only the last two MAC bytes are known, and none for a rebuilt datagram
+		else if ((st->expect[st->count] == 0) && ((p->mac[4] != 0x34) || (p->mac[5] != 0x12)))
+			st->corrupt++;
+		else if ((st->expect[st->count] == 3) && (p->mac[4] || p->mac[5]))
+			st->corrupt++;
+		st->count++;
+	}
+}
+
+int mpe_demux_fec_check(void)
+{
+	static const uint8_t wanted[6] = { 0x02, 0x00, 0x00, 0x00, 0x34, 0x12 };
+	// for the wanted MAC, another one, a multicast group, and the wanted MAC
+	// again but with its section lost
+	static const uint16_t macs[4] = { 0x3412, 0x5678, 0x5e01, 0x3412 };
+	static struct mpe_demux_fec_check_state st;
+	uint8_t sec[DVB_MAX_SECTION_BYTES];
+	uint8_t pkts[SECTION_PACKETIZER_MAX_PACKETS(DVB_MAX_SECTION_BYTES) * TRANSPORT_PACKET_LENGTH];
+	struct section_packetizer sp;
+	struct mpe_demux *mdemux;
+	struct mpe_demux_pid_stats stats;
+	int rows = MPE_FEC_MIN_ROWS;
+	int address;
+	int npkts;
+	int len;
+	uint32_t crc;
+	int ret = -1;
+	int i;
+	int j;
+
+	memset(&st, 0, sizeof(st));
+	for(i=0; i < 4; i++) {
+		memset(st.frame + (i * 100), i + 1, 100);
+		st.frame[i * 100] = 0x45;
+		st.frame[(i * 100) + 2] = 0;
+		st.frame[(i * 100) + 3] = 100;
+		st.frame[(i * 100) + 16] = (i == 2) ? 239 : 10;
+	}
+	mpe_fec_encode(st.frame, rows);
+	st.expect[0] = 0;
+	st.expect[1] = 2;
+	st.expect[2] = 3;
+
+	if ((mdemux = mpe_demux_create(16, mpe_demux_flag_multicast,
+				       mpe_demux_fec_check_batch, &st)) == NULL)
+		return -1;
+	if (mpe_demux_set_fec(mdemux, 0x200, rows) || mpe_demux_add_mac(mdemux, wanted))
+		goto exit;
+	section_packetizer_init(&sp, 0x200, section_packetizer_flag_pack);
+
+	for(i=0; i < 4 + MPE_FEC_RS_COLUMNS; i++) {
+		if (i == 3)
+			continue;
+		memset(sec, 0, 12);
+		if (i < 4) {
+			address = i * 100;
+			len = 100;
+			memcpy(sec + 12, st.frame + address, len);
+			sec[0] = stag_mpeg_datagram;
+			sec[3] = macs[i];
+			sec[4] = macs[i] >> 8;
+		} else {
+			address = (i - 4) * rows;
+			len = rows;
+			memcpy(sec + 12, st.frame + ((MPE_FEC_ADT_COLUMNS + i - 4) * rows), len);
+			sec[0] = stag_dvb_mpe_fec;
+			sec[3] = ((MPE_FEC_ADT_COLUMNS * rows) - 400) / rows;
+			sec[6] = i - 4;
+			sec[7] = MPE_FEC_RS_COLUMNS - 1;
+			sec[9] = (i == 3 + MPE_FEC_RS_COLUMNS) ? 0x04 : 0;	// frame_boundary
+		}
+		len += 12 + CRC_SIZE;
+		sec[1] = 0xb0 | ((len - 3) >> 8);
+		sec[2] = len - 3;
+		sec[5] = 0xc1;
+		sec[9] |= (address >> 16) & 0x03;
+		sec[10] = address >> 8;
+		sec[11] = address;
+		crc = crc32(CRC32_INIT, sec, len - CRC_SIZE);
+		sec[len - 4] = crc >> 24;
+		sec[len - 3] = crc >> 16;
+		sec[len - 2] = crc >> 8;
+		sec[len - 1] = crc;
+
+		npkts = section_packetizer_add(&sp, sec, len, pkts);
+		npkts += section_packetizer_flush(&sp, pkts + (npkts * TRANSPORT_PACKET_LENGTH));
+		for(j=0; j < npkts; j++)
+			mpe_demux_add_packet(mdemux, transport_packet_init(pkts + (j * TRANSPORT_PACKET_LENGTH)));
+	}
+	mpe_demux_flush(mdemux);
+
+	mpe_demux_get_pid_stats(mdemux, 0x200, &stats);
+	if (st.corrupt || (st.count != 3) || (stats.mac_filtered != 1) ||
+	    (stats.datagrams != 3) || (stats.recovered != 1))
+		goto exit;
+	ret = 0;
+
+exit:
+	mpe_demux_destroy(mdemux);
+	return ret;
+}
+
+#define ULE_CHECK_SNDUS 3000
+#define ULE_CHECK_KINDS 9
+
+struct ule_check_state {
+	uint8_t stream[ULE_CHECK_SNDUS * (ULE_MAX_SNDU_SIZE / 16)];
+	int starts[ULE_CHECK_SNDUS];
+	int pdus[ULE_CHECK_SNDUS];		/* offset of each PDU expected, in stream */
+	int lens[ULE_CHECK_SNDUS];
+	uint16_t protocols[ULE_CHECK_SNDUS];
+	int count;
+	int next;
+	int delivered;
+	int corrupt;
+};
+
+static void ule_check_batch(void *arg, struct ule_demux_packet *packets, int count)
+{
+	struct ule_check_state *st = (struct ule_check_state *) arg;
+	int i;
+	int j;
+
+	// PDUs come out in order, with any lost ones missing
+	for(i=0; i < count; i++) {
+		for(j=st->next; j < st->count; j++) {
+			if ((st->lens[j] == packets[i].len) && (st->protocols[j] == packets[i].protocol) &&
+			    !memcmp(st->stream + st->pdus[j], packets[i].data, packets[i].len))
+				break;
+		}
+		if (j == st->count) {
+			st->corrupt++;
+			continue;
+		}
+		st->next = j + 1;
+		st->delivered++;
+	}
+}
+
+static int ule_check_stream(struct ule_check_state *st, int *kinds)
+{
+	static const uint8_t wanted[6] = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55 };
+	uint8_t *sndu;
+	uint32_t crc;
+	uint16_t type;
+	int pos = 0;
+	int len;
+	int hdr;
+	int i;
+	int j;
+
+	st->count = 0;
+	for(i=0; i < ULE_CHECK_SNDUS; i++) {
+		sndu = st->stream + pos;
+		st->starts[i] = pos;
+		kinds[i] = rand() % ULE_CHECK_KINDS;
+		len = (rand() & 1) ? 1 + (rand() % 40) : 1 + (rand() % 1500);
+		type = ((kinds[i] == 1) || (kinds[i] == 4)) ? 0x86dd : 0x0800;
+
+		hdr = 4;
+		sndu[0] = 0x80;
+		switch(kinds[i]) {
+		case 1:	// for a wanted NPA address
+		case 2:	// for another one
+			sndu[0] = 0;
+			memcpy(sndu + 4, wanted, 6);
+			if (kinds[i] == 2)
+				sndu[9] ^= 0xff;
+			hdr += 6;
+			break;
+		case 3:	// with an Extension-Padding optional extension header
+			sndu[4] = 0xaa;
+			sndu[5] = 0xbb;
+			sndu[6] = type >> 8;
+			sndu[7] = type;
+			type = 0x0200;
+			hdr += 4;
+			break;
+		case 4:	// a Bridged-Frame
+			for(j=0; j < 12; j++)
+				sndu[4 + j] = rand();
+			sndu[16] = type >> 8;
+			sndu[17] = type;
+			type = 0x0001;
+			hdr += 14;
+			break;
+		case 5:	// a Test SNDU
+			type = 0x0000;
+			break;
+		case 6:	// an unknown mandatory extension header
+			type = 0x0007;
+			break;
+		case 8:	// a reserved H-LEN
+			type = (rand() & 1) ? 0x0600 : 0x07aa;
+			break;
+		}
+		sndu[2] = type >> 8;
+		sndu[3] = type;
+		for(j=0; j < len; j++)
+			sndu[hdr + j] = rand();
+		len += hdr + 4;
+		sndu[0] |= (len - 4) >> 8;
+		sndu[1] = len - 4;
+		crc = crc32(CRC32_INIT, sndu, len - 4);
+		sndu[len - 4] = crc >> 24;
+		sndu[len - 3] = crc >> 16;
+		sndu[len - 2] = crc >> 8;
+		sndu[len - 1] = crc;
+		if (kinds[i] == 7)	// a corrupt SNDU
+			sndu[hdr] ^= 0x01;
+
+		if ((kinds[i] <= 1) || (kinds[i] == 3) || (kinds[i] == 4)) {
+			st->pdus[st->count] = pos + hdr;
+			st->lens[st->count] = len - hdr - 4;
+			st->protocols[st->count++] = ((kinds[i] == 1) || (kinds[i] == 4)) ? 0x86dd : 0x0800;
+		}
+		pos += len;
+	}
+
+	return pos;
+}
+
+static int ule_check_run(struct ule_check_state *st, int mode)
+{
+	static const uint8_t wanted[6] = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55 };
+	static int kinds[ULE_CHECK_SNDUS];
+	uint8_t pkt[TRANSPORT_PACKET_LENGTH];
+	struct ule_demux *udemux;
+	struct ule_demux_pid_stats stats;
+	uint64_t expect[ULE_CHECK_KINDS];
+	int cc = 0;
+	int end;
+	int pos = 0;
+	int k = 0;
+	int len;
+	int s;
+	int i;
+
+	end = ule_check_stream(st, kinds);
+	memset(expect, 0, sizeof(expect));
+	for(i=0; i < ULE_CHECK_SNDUS; i++)
+		expect[kinds[i]]++;
+
+	if ((udemux = ule_demux_create(ULE_DEMUX_DEFAULT_POOL, 0, ule_check_batch, st)) == NULL)
+		return -1;
+	ule_demux_add_pid(udemux, 0x200);
+	ule_demux_add_npa(udemux, wanted);
+	st->next = 0;
+	st->delivered = 0;
+	st->corrupt = 0;
+
+	// pack the SNDUs back to back, with the Payload Pointer to the first starting in each packet
+	while(pos < end) {
+		memset(pkt, 0xff, sizeof(pkt));
+		pkt[0] = TRANSPORT_PACKET_SYNC;
+		pkt[1] = 0x02;
+		pkt[2] = 0x00;
+		pkt[3] = 0x10 | (cc++ & 0x0f);
+
+		while((k < ULE_CHECK_SNDUS) && (st->starts[k] < pos))
+			k++;
+		s = (k < ULE_CHECK_SNDUS) ? st->starts[k] - pos : end - pos;
+		if (s < 183) {
+			pkt[1] |= 0x40;
+			pkt[4] = s;
+			len = (end - pos < 183) ? end - pos : 183;
+			memcpy(pkt + 5, st->stream + pos, len);
+			pos += 183;
+		} else if (s == 183) {
+			// no room for it to start: a lone byte of padding
+			memcpy(pkt + 4, st->stream + pos, 183);
+			pos += 183;
+		} else {
+			len = (end - pos < 184) ? end - pos : 184;
+			memcpy(pkt + 4, st->stream + pos, len);
+			pos += 184;
+		}
+
+		// mode 0: duplicate packets now and then; mode 1: lose them
+		if ((mode == 0) && ((rand() % 100) == 0))
+			ule_demux_add_packet(udemux, transport_packet_init(pkt));
+		if ((mode == 1) && ((rand() % 50) == 0))
+			continue;
+		ule_demux_add_packet(udemux, transport_packet_init(pkt));
+	}
+	ule_demux_flush(udemux);
+	ule_demux_get_pid_stats(udemux, 0x200, &stats);
+	ule_demux_destroy(udemux);
+
+	// a PDU which didn't come out exactly as sent is always an error
+	if (st->corrupt)
+		return -1;
+	if (mode == 1)
+		return (stats.continuity_errors && (st->delivered < st->count)) ? 0 : -1;
+
+	if ((st->delivered != st->count) || (stats.pdus != (uint64_t) st->count) ||
+	    (stats.sndus != ULE_CHECK_SNDUS) ||
+	    (stats.npa_filtered != expect[2]) || (stats.extensions != expect[3]) ||
+	    (stats.test_sndus != expect[5]) || (stats.unsupported != expect[6]) ||
+	    (stats.crc_errors != expect[7]) || (stats.invalid != expect[8]) || stats.pp_errors ||
+	    stats.continuity_errors || stats.ts_errors)
+		return -1;
+
+	return 0;
+}
+
+int ule_check(void)
+{
+	static struct ule_check_state st;
+
+	srand(1);
+	if (ule_check_run(&st, 0) || ule_check_run(&st, 1))
+		return -1;
+
+	return 0;
+}
+
+#define TS_MONITOR_CHECK_TICKS 650
+#define TS_MONITOR_CHECK_SLOTS 20
+#define TS_MONITOR_CHECK_TICK 10000000ULL
+#define TS_MONITOR_CHECK_PCR_TICK (PCR_CLOCK_HZ / 100)
+
+static void ts_monitor_check_packet(uint8_t *pkt, int pid, int pusi, uint8_t *cc)
+{
+	memset(pkt, 0xff, TRANSPORT_PACKET_LENGTH);
+	pkt[0] = TRANSPORT_PACKET_SYNC;
+	pkt[1] = (pusi ? 0x40 : 0) | (pid >> 8);
+	pkt[2] = pid;
+	pkt[3] = 0x10;
+	if (cc)
+		pkt[3] |= (*cc)++ & 0x0f;
+}
+
+static void ts_monitor_check_section(uint8_t *pkt, int pid, uint8_t *cc,
+				     const uint8_t *section, int len)
+{
+	uint32_t crc;
+
+	ts_monitor_check_packet(pkt, pid, 1, cc);
+	pkt[4] = 0;
+	memcpy(pkt + 5, section, len);
+	crc = crc32(CRC32_INIT, pkt + 5, len);
+	pkt[5 + len] = crc >> 24;
+	pkt[6 + len] = crc >> 16;
+	pkt[7 + len] = crc >> 8;
+	pkt[8 + len] = crc;
+}
+
+static void ts_monitor_check_pes(uint8_t *pkt, int pts)
+{
+	static const uint8_t pes[14] = { 0x00, 0x00, 0x01, 0xc0, 0x00, 0x00,
+					 0x80, 0x80, 0x05, 0x21, 0x00, 0x01, 0x00, 0x01 };
+
+	memcpy(pkt + 4, pes, sizeof(pes));
+	if (!pts) {
+		pkt[11] = 0x00;
+		pkt[12] = 0x00;
+	}
+}
+
+int ts_monitor_check(void)
+{
+	// program 1: PMT on 0x100, MPEG-2 video and PCR on 0x101, MPEG-2 audio on 0x102
+	static const uint8_t pat[] = { 0x00, 0xb0, 0x0d, 0x00, 0x01, 0xc1, 0x00, 0x00,
+				       0x00, 0x01, 0xe1, 0x00 };
+	static const uint8_t pmt[] = { 0x02, 0xb0, 0x17, 0x00, 0x01, 0xc1, 0x00, 0x00,
+				       0xe1, 0x01, 0xf0, 0x00,
+				       0x02, 0xe1, 0x01, 0xf0, 0x00,
+				       0x04, 0xe1, 0x02, 0xf0, 0x00 };
+	uint8_t batch[TS_MONITOR_CHECK_SLOTS * TRANSPORT_PACKET_LENGTH];
+	uint8_t cc[3] = { 0, 0, 0 };
+	uint8_t pat_cc = 0;
+	uint8_t *pkt;
+	struct ts_monitor *mon;
+	struct ts_monitor_stats stats;
+	struct ts_monitor_program_stats prog;
+	struct ts_monitor_counters *c;
+	struct ts_monitor_counters audio;
+	uint16_t programs[4];
+	uint64_t pcr_base;
+	uint64_t pcr_offset = 0;
+	int slot;
+	int tick;
+	int ret = -1;
+
+	if ((mon = ts_monitor_create(0, 300000000ULL)) == NULL)
+		return -1;
+
+	for(tick=0; tick < TS_MONITOR_CHECK_TICKS; tick++) {
+		for(slot=0; slot < TS_MONITOR_CHECK_SLOTS; slot++)
+			ts_monitor_check_packet(batch + (slot * TRANSPORT_PACKET_LENGTH),
+						TRANSPORT_NULL_PID, 0, NULL);
+
+		// a PCR every 20ms, except for a 60ms gap at 4.1s and a 200ms jump at 4.3s
+		pkt = batch;
+		if (tick == 430)
+			pcr_offset = PCR_CLOCK_HZ / 5;
+		if (!(tick & 1) && (tick != 410) && (tick != 412)) {
+			ts_monitor_check_packet(pkt, 0x101, 0, NULL);
+			pkt[3] = 0x20 | ((cc[1] - 1) & 0x0f);
+			pkt[4] = 183;
+			pkt[5] = transport_adaptation_flag_pcr;
+			pcr_base = (tick * TS_MONITOR_CHECK_PCR_TICK) + pcr_offset;
+			if (tick == 90)		// 100us out
+				pcr_base += PCR_CLOCK_HZ / 10000;
+			pkt[6] = (pcr_base / 300) >> 25;
+			pkt[7] = (pcr_base / 300) >> 17;
+			pkt[8] = (pcr_base / 300) >> 9;
+			pkt[9] = (pcr_base / 300) >> 1;
+			pkt[10] = (((pcr_base / 300) & 1) << 7) | 0x7e | (((pcr_base % 300) >> 8) & 1);
+			pkt[11] = pcr_base % 300;
+		}
+
+		// PAT and PMT every 100ms, but not from 2.5 to 3.1s and 3.3 to 3.9s respectively
+		if (((tick % 10) == 0) && ((tick < 250) || (tick > 310))) {
+			pkt = batch + TRANSPORT_PACKET_LENGTH;
+			ts_monitor_check_section(pkt, TRANSPORT_PAT_PID, &pat_cc, pat, sizeof(pat));
+			if (tick == 140)	// a bad CRC
+				pkt[10] ^= 0x01;
+		}
+		if (((tick % 10) == 0) && ((tick < 330) || (tick > 390)))
+			ts_monitor_check_section(batch + (2 * TRANSPORT_PACKET_LENGTH), 0x100,
+						 &cc[0], pmt, sizeof(pmt));
+
+		// video and audio, with PTSs every 100ms; no audio from 4.5 to 4.9s, and no
+		// audio PTSs from 5.1 to 5.8s
+		pkt = batch + (3 * TRANSPORT_PACKET_LENGTH);
+		ts_monitor_check_packet(pkt, 0x101, (tick % 10) == 0, &cc[1]);
+		if ((tick % 10) == 0)
+			ts_monitor_check_pes(pkt, 1);
+		if ((tick < 450) || (tick >= 490)) {
+			pkt = batch + (4 * TRANSPORT_PACKET_LENGTH);
+			ts_monitor_check_packet(pkt, 0x102, (tick % 10) == 0, &cc[2]);
+			if ((tick % 10) == 0)
+				ts_monitor_check_pes(pkt, (tick < 510) || (tick > 580));
+			if (tick == 100)	// a continuity error
+				cc[2]++;
+			if (tick == 161)	// a scrambled packet, with no CAT
+				pkt[3] |= 0x80;
+		}
+
+		// a transport error, then a sync loss and a lone sync byte error
+		if (tick == 120)
+			ts_monitor_check_packet(batch + (5 * TRANSPORT_PACKET_LENGTH), 0x102, 0, NULL);
+		batch[(5 * TRANSPORT_PACKET_LENGTH) + 1] |= (tick == 120) ? 0x80 : 0;
+		if ((tick == 170) || (tick == 180))
+			batch[10 * TRANSPORT_PACKET_LENGTH] = 0x00;
+		if (tick == 170)
+			batch[11 * TRANSPORT_PACKET_LENGTH] = 0x00;
+
+		ts_monitor_add_packets(mon, batch, TS_MONITOR_CHECK_SLOTS,
+				       1000000000ULL + (tick * TS_MONITOR_CHECK_TICK));
+
+		// the PCR accuracy error is the only one before 1s
+		ts_monitor_get_stats(mon, &stats);
+		c = &stats.counters;
+		if ((tick == 89) && (c->pcr_accuracy_errors || c->pat_errors || c->pmt_errors ||
+				     c->pid_errors || c->pts_errors || c->cc_errors))
+			goto exit;
+		if ((tick == 99) && !c->pcr_accuracy_errors)
+			goto exit;
+	}
+
+	ts_monitor_get_stats(mon, &stats);
+	c = &stats.counters;
+	if (!stats.in_sync || (stats.programs != 1) ||
+	    (c->packets != (TS_MONITOR_CHECK_TICKS * TS_MONITOR_CHECK_SLOTS) - 3) ||
+	    (c->sync_losses != 1) || (c->sync_byte_errors != 3) || (c->pat_errors != 1) ||
+	    (c->cc_errors != 1) || (c->pmt_errors != 1) || (c->pid_errors != 1) ||
+	    (c->transport_errors != 1) || (c->crc_errors != 1) ||
+	    (c->pcr_repetition_errors != 1) || (c->pcr_discontinuity_errors != 1) ||
+	    (c->pts_errors != 1) || (c->cat_errors != 1) || (c->scrambled != 1))
+		goto exit;
+
+	// everything but the PAT, CRC, and CAT errors belong to the program
+	if ((ts_monitor_get_programs(mon, programs, 4) != 1) || (programs[0] != 1) ||
+	    ts_monitor_get_program_stats(mon, 1, &prog) ||
+	    (ts_monitor_get_program_stats(mon, 2, &prog) != -ENOENT))
+		goto exit;
+	ts_monitor_get_program_stats(mon, 1, &prog);
+	c = &prog.counters;
+	if ((prog.pmt_pid != 0x100) || (prog.pcr_pid != 0x101) || c->pat_errors ||
+	    (c->cc_errors != 1) || (c->pmt_errors != 1) || (c->pid_errors != 1) ||
+	    (c->transport_errors != 1) || c->crc_errors ||
+	    (c->pcr_repetition_errors != 1) || (c->pcr_discontinuity_errors != 1) ||
+	    !c->pcr_accuracy_errors || (c->pts_errors != 1) || c->cat_errors ||
+	    (c->scrambled != 1) || (c->packets < (uint64_t) (TS_MONITOR_CHECK_TICKS * 2)))
+		goto exit;
+
+	ts_monitor_get_pid_stats(mon, 0x102, &audio);
+	if ((audio.cc_errors != 1) || (audio.pid_errors != 1) || (audio.pts_errors != 1) ||
+	    (audio.transport_errors != 1) || audio.pcr_repetition_errors)
+		goto exit;
+	ts_monitor_destroy(mon);
+
+	// sync is acquired from batches of one packet, after a false start
+	if ((mon = ts_monitor_create(0, 300000000ULL)) == NULL)
+		return -1;
+	for(slot=0; slot < 10; slot++) {
+		ts_monitor_check_packet(batch, TRANSPORT_NULL_PID, 0, NULL);
+		if (slot == 2)
+			batch[0] = 0x00;
+		ts_monitor_add_packets(mon, batch, 1, 1000000000ULL);
+		ts_monitor_get_stats(mon, &stats);
+		if ((slot == 6) && stats.in_sync)
+			goto exit;
+	}
+	if (!stats.in_sync || (stats.counters.packets != 3) || stats.counters.sync_losses)
+		goto exit;
+	ret = 0;
+
+exit:
+	ts_monitor_destroy(mon);
+	return ret;
+}
+
 void ts_from_file(char *filename, int data_type) {
-	int fd = open(filename, O_RDONLY);
-	if (fd < 0) {
+	struct dvbtsinput *input = dvbtsinput_open_file(filename, DVBTSINPUT_TYPE_MMAP);
+	if (input == NULL) {
 		fprintf(stderr, "Unable to open file %s\n", filename);
 		exit(1);
 	}
-	receive_data(fd, 1000000000, data_type);
+	receive_data(input, 1000000000, data_type);
+	dvbtsinput_close(input);
 }
 
 int channels_cb(struct dvbcfg_zapchannel *channel, void *private)
@@ -183,109 +2223,142 @@ int channels_cb(struct dvbcfg_zapchannel *channel, void *private)
 			MAX_TUNE_TIME)) {
                 fprintf(stderr, "Failed to lock!\n");
         } else {
+                struct dvbtsinput *input = dvbtsinput_open_fd(dvrfd, DVBTSINPUT_TYPE_DVR);
+                if (input == NULL) {
+                        fprintf(stderr, "Unable to read dvr\n");
+                        exit(1);
+                }
                 printf("Tuned successfully!\n");
-                receive_data(dvrfd, MAX_DUMP_TIME, data_type);
+                receive_data(input, MAX_DUMP_TIME, data_type);
+                dvbtsinput_close(input);
         }
 
 	return 0;
 }
 
-void receive_data(int _dvrfd, int timeout, int data_type)
+void receive_data(struct dvbtsinput *input, int timeout, int data_type)
 {
-	unsigned char databuf[TRANSPORT_PACKET_LENGTH*20];
-	int sz;
-	int pid;
-	int i;
-	int used;
-	int section_status;
+	uint8_t *databuf;
+	int count;
 	time_t starttime;
-	unsigned char continuities[TRANSPORT_MAX_PIDS];
-	struct section_buf *section_bufs[TRANSPORT_MAX_PIDS];
-	struct transport_packet *tspkt;
-	struct transport_values tsvals;
+	struct transport_demux *tdemux;
+	struct transport_demux_stats tstats;
+	struct section_demux *sdemux;
+	struct section_demux_stats stats;
+	struct section_cache_stats cstats;
+	struct receive_state state;
+
+	// SI is repeated continuously, so only changed sections are decoded
+	state.data_type = data_type;
+	state.cache = section_cache_create(DUMP_CACHE_ENTRIES);
+	if (state.cache == NULL) {
+		fprintf(stderr, "Failed to create section cache\n");
+		exit(1);
+	}
+
+	// create the section reassembly context
+	sdemux = section_demux_create(DVB_MAX_SECTION_BYTES, receive_section, &state);
+	if (sdemux == NULL) {
+		fprintf(stderr, "Failed to create section demux\n");
+		exit(1);
+	}
+
+	// and the transport demux feeding it every packet
+	tdemux = transport_demux_create();
+	if ((tdemux == NULL) ||
+	    transport_demux_register(tdemux, TRANSPORT_DEMUX_ALL_PIDS, receive_packets, sdemux)) {
+		fprintf(stderr, "Failed to create transport demux\n");
+		exit(1);
+	}
 
 	// process the data
 	starttime = time(NULL);
-	memset(continuities, 0, sizeof(continuities));
-	memset(section_bufs, 0, sizeof(section_bufs));
 	while((time(NULL) - starttime) < timeout) {
 		// got some!
-		if ((sz = read(_dvrfd, databuf, sizeof(databuf))) < 0) {
-			if (errno == EOVERFLOW) {
+		if ((count = dvbtsinput_read(input, &databuf, 1000)) == 0) {
+			// end of the recording
+			break;
+		} else if (count < 0) {
+			if (count == -EOVERFLOW) {
 				fprintf(stderr, "data overflow!\n");
+				transport_demux_reset(tdemux);
 				continue;
-			} else if (errno == EAGAIN) {
-				usleep(100);
+			} else if (count == -ETIMEDOUT) {
 				continue;
 			} else {
-				perror("read error");
+				fprintf(stderr, "read error: %s\n", strerror(-count));
 				exit(1);
 			}
 		}
-		for(i=0; i < sz; i+=TRANSPORT_PACKET_LENGTH) {
-			// parse the transport packet
-			tspkt = transport_packet_init(databuf + i);
-			if (tspkt == NULL) {
-				fprintf(stderr, "XXXX Bad sync byte\n");
-				continue;
-			}
-			pid = transport_packet_pid(tspkt);
-
-			// extract all TS packet values even though we don't need them (to check for
-			// library segfaults etc)
-			if (transport_packet_values_extract(tspkt, &tsvals, 0xffff) < 0) {
-				fprintf(stderr, "XXXX Bad packet received (pid:%04x)\n", pid);
-				continue;
-			}
+		transport_demux_feed(tdemux, databuf, count * TRANSPORT_PACKET_LENGTH);
+	}
+
+	// report any sync losses
+	transport_demux_get_stats(tdemux, &tstats);
+	if (tstats.sync_losses)
+		fprintf(stderr, "XXXX Bad sync byte (%llu sync losses, %llu bytes skipped)\n",
+			(unsigned long long) tstats.sync_losses,
+			(unsigned long long) tstats.skipped_bytes);
+	transport_demux_destroy(tdemux);
+
+	// report how many sections could be parsed in place
+	section_demux_get_stats(sdemux, &stats);
+	fprintf(stderr, "Sections parsed in place:%llu copied:%llu pids:%u buffers:%u/%u/%u\n",
+		(unsigned long long) stats.direct, (unsigned long long) stats.copied, stats.pids,
+		stats.buffers[0], stats.buffers[1], stats.buffers[2]);
+	section_demux_destroy(sdemux);
+
+	// and how many repeats were skipped
+	section_cache_get_stats(state.cache, &cstats);
+	fprintf(stderr, "Sections unchanged:%llu decoded:%llu changed:%llu\n",
+		(unsigned long long) cstats.hits, (unsigned long long) cstats.misses,
+		(unsigned long long) cstats.changes);
+	section_cache_destroy(state.cache);
+}
 
-			// check continuity
-			if (transport_packet_continuity_check(tspkt,
-			    tsvals.flags & transport_adaptation_flag_discontinuity,
-			    continuities + pid)) {
-				fprintf(stderr, "XXXX Continuity error (pid:%04x)\n", pid);
-				continuities[pid] = 0;
-				if (section_bufs[pid] != NULL) {
-					section_buf_reset(section_bufs[pid]);
-				}
-				continue;
-			}
+void receive_packets(void *arg, int pid, struct transport_packet_info *pkts, int count)
+{
+	struct section_demux *sdemux = (struct section_demux *) arg;
+	struct transport_values tsvals;
+	int status;
+	int i;
 
-			// allocate section buf if we don't have one already
-			if (section_bufs[pid] == NULL) {
-				section_bufs[pid] = (struct section_buf*)
-					malloc(sizeof(struct section_buf) + DVB_MAX_SECTION_BYTES);
-				if (section_bufs[pid] == NULL) {
-					fprintf(stderr, "Failed to allocate section buf (pid:%04x)\n", pid);
-					exit(1);
-				}
-				section_buf_init(section_bufs[pid], DVB_MAX_SECTION_BYTES);
-			}
+	(void) pid;
+	for(i=0; i < count; i++) {
+		// extract all TS packet values even though we don't need them (to check for
+		// library segfaults etc)
+		if (transport_packet_values_extract(pkts[i].pkt, &tsvals, 0xffff) < 0) {
+			fprintf(stderr, "XXXX Bad packet received (pid:%04x)\n", pkts[i].pid);
+			continue;
+		}
 
-			// process the payload data as a section
-			while(tsvals.payload_length) {
-				used = section_buf_add_transport_payload(section_bufs[pid],
-									 tsvals.payload,
-									 tsvals.payload_length,
-									 tspkt->payload_unit_start_indicator,
-									 &section_status);
-				tspkt->payload_unit_start_indicator = 0;
-				tsvals.payload_length -= used;
-				tsvals.payload += used;
-
-				if (section_status == 1) {
-					parse_section(section_buf_data(section_bufs[pid]),
-						      section_bufs[pid]->len, pid, data_type);
-					section_buf_reset(section_bufs[pid]);
-				} else if (section_status < 0) {
-					// some kind of error - just discard
-					fprintf(stderr, "XXXX bad section %04x %i\n",pid, section_status);
-					section_buf_reset(section_bufs[pid]);
-				}
-			}
+		// check continuity and process the payload data as sections
+		status = section_demux_add_packet(sdemux, pkts[i].pkt);
+		if (status == -EPROTO) {
+			fprintf(stderr, "XXXX Continuity error (pid:%04x)\n", pkts[i].pid);
+		} else if (status < 0) {
+			// some kind of error - it has been discarded
+			fprintf(stderr, "XXXX bad section %04x %i\n", pkts[i].pid, status);
 		}
 	}
 }
 
+void receive_section(void *arg, int pid, uint8_t *section, int len)
+{
+	struct receive_state *state = (struct receive_state *) arg;
+
+	if (section_cache_check(state->cache, pid, section, len))
+		return;
+
+	// forget corrupt sections so the next good copy is decoded
+	if ((section[1] & 0x80) && crc32(CRC32_INIT, section, len)) {
+		section_cache_remove(state->cache, pid, section, len);
+		return;
+	}
+
+	parse_section(section, len, pid, state->data_type);
+}
+
 void parse_section(uint8_t *buf, int len, int pid, int data_type)
 {
 	struct section *section;
@@ -31,10 +31,11 @@
 #include <errno.h>
 
 #include <linux/dvb/dmx.h>
+#include <libucsi/pes_demux.h>
 
 #include "hex_dump.h"
 
-#define MAX_PES_SIZE (4*1024)
+#define TS_READ_PACKETS 64
 
 
 void usage(void)
@@ -47,10 +48,38 @@ void usage(void)
 	exit(1);
 }
 
-void process_pes(int fd, FILE *out)
+void pes_data(void *arg, int pid, struct pes_header *hdr,
+	      uint8_t *data, int len, int flags)
 {
-	uint8_t buf[MAX_PES_SIZE];
+	FILE *out = arg;
+
+	(void) pid;
+
+	if (out == stdout) {
+		if (flags & pes_demux_flag_start) {
+			printf("stream_id 0x%02x", hdr->stream_id);
+			if (hdr->flags & pes_header_flag_pts)
+				printf(" PTS %llu", (unsigned long long) hdr->pts);
+			if (hdr->flags & pes_header_flag_dts)
+				printf(" DTS %llu", (unsigned long long) hdr->dts);
+			printf("\n");
+		}
+		hex_dump(data, len);
+		printf("\n");
+	}
+	else {
+		printf("got %d bytes\n", len);
+		if (fwrite(data, 1, len, out) == 0)
+			perror("write output");
+	}
+}
+
+void process_pes(int fd, struct pes_demux *pdemux)
+{
+	uint8_t buf[TS_READ_PACKETS * TRANSPORT_PACKET_LENGTH];
+	struct transport_packet *pkt;
 	int bytes;
+	int i;
 
 	bytes = read(fd, buf, sizeof(buf));
 	if (bytes < 0) {
@@ -64,14 +93,15 @@ void process_pes(int fd, FILE *out)
 			exit(1);
 		}
 	}
-	if (out == stdout) {
-		hex_dump(buf, bytes);
-		printf("\n");
-	}
-	else {
-		printf("got %d bytes\n", bytes);
-		if (fwrite(buf, 1, bytes, out) == 0)
-			perror("write output");
+
+	/* the demux reads whole TS packets when asked for a multiple of them */
+	for (i = 0; i + TRANSPORT_PACKET_LENGTH <= bytes; i += TRANSPORT_PACKET_LENGTH) {
+		if ((pkt = transport_packet_init(buf + i)) == NULL) {
+			fprintf(stderr, "lost TS sync\n");
+			continue;
+		}
+		if (pes_demux_add_packet(pdemux, pkt) == -EPROTO)
+			fprintf(stderr, "continuity error\n");
 	}
 }
 
@@ -81,7 +111,7 @@ int set_filter(int fd, unsigned int pid)
 
 	f.pid = (uint16_t) pid;
 	f.input = DMX_IN_FRONTEND;
-	f.output = DMX_OUT_TAP;
+	f.output = DMX_OUT_TSDEMUX_TAP;
 	f.pes_type = DMX_PES_OTHER;
 	f.flags = DMX_IMMEDIATE_START;
 	if (ioctl(fd, DMX_SET_PES_FILTER, &f) == -1) {
@@ -98,6 +128,7 @@ int main(int argc, char *argv[])
 	unsigned long pid;
 	char *dmxdev = "/dev/dvb/adapter0/demux0";
 	FILE *out = stdout;
+	struct pes_demux *pdemux;
 
 	if (argc != 2 && argc != 3)
 		usage();
@@ -125,13 +156,20 @@ int main(int argc, char *argv[])
 		return 1;
 	}
 
+	pdemux = pes_demux_create(PES_DEMUX_MAX_PACKET_SIZE, pes_data, out);
+	if (pdemux == NULL) {
+		fprintf(stderr, "failed to create pes demux\n");
+		return 1;
+	}
+
 	if (set_filter(dmxfd, pid) != 0)
 		return 1;
 
 	for (;;) {
-		process_pes(dmxfd, out);
+		process_pes(dmxfd, pdemux);
 	}
 
+	pes_demux_destroy(pdemux);
 	close(dmxfd);
 	return 0;
 }
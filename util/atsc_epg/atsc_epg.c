@@ -34,6 +34,10 @@
 #include <stdarg.h>
 #include <libdvbapi/dvbfe.h>
 #include <libdvbapi/dvbdemux.h>
+#include <libdvbapi/dvbtsinput.h>
+#include <libucsi/crc32.h>
+#include <libucsi/section_demux.h>
+#include <libucsi/table_assembler.h>
 #include <libucsi/dvb/section.h>
 #include <libucsi/atsc/section.h>
 #include <libucsi/atsc/types.h>
@@ -47,7 +51,7 @@
 #define MAX_NUM_EVENTS_PER_CHANNEL	(4 * 24 * 7)
 
 static int atsc_scan_table(int dmxfd, uint16_t pid, enum atsc_section_tag tag,
-	void **table_section);
+	struct table_assembler *assembler, void **table_section);
 
 static const char *program;
 static int adapter = 0;
@@ -56,7 +60,9 @@ static int frequency;
 static int enable_ett = 0;
 static int ctrl_c = 0;
 static const char *modulation = NULL;
+static const char *recording_file = NULL;
 static char separator[80];
+static struct table_assembler *guide_tables;
 void (*old_handler)(int);
 
 struct atsc_string_buffer {
@@ -200,17 +206,18 @@ static uint32_t get_bits(const uint8_t *buf, int startbit, int bitlen)
 
 static void usage(void)
 {
-	fprintf(stderr, "usage: %s [-a <n>] -f <frequency> [-p <period>]"
-		" [-m <modulation>] [-t] [-h]\n", program);
+	fprintf(stderr, "usage: %s [-a <n>] -f <frequency>|-r <recording>"
+		" [-p <period>] [-m <modulation>] [-t] [-h]\n", program);
 }
 
 static void help(void)
 {
 	fprintf(stderr,
 	"\nhelp:\n"
-	"%s [-a <n>] -f <frequency> [-p <period>] [-m <modulation>] [-t] [-h]\n"
+	"%s [-a <n>] -f <frequency>|-r <recording> [-p <period>] [-m <modulation>] [-t] [-h]\n"
 	"  -a: adapter index to use, (default 0)\n"
 	"  -f: tuning frequency\n"
+	"  -r: read a recorded transport stream instead of tuning\n"
 	"  -p: period in hours, (default 12)\n"
 	"  -m: modulation ATSC vsb_8|vsb_16 (default vsb_8)\n"
 	"  -t: enable ETT to receive program details, if available\n"
@@ -271,7 +278,7 @@ static int parse_rrt(int dmxfd)
 	fprintf(stdout, "waiting for RRT: ");
 	fflush(stdout);
 	while(i < RRT_TIMEOUT) {
-		ret = atsc_scan_table(dmxfd, ATSC_BASE_PID, tag, (void **)&rrt);
+		ret = atsc_scan_table(dmxfd, ATSC_BASE_PID, tag, NULL, (void **)&rrt);
 		if(0 > ret) {
 			fprintf(stderr, "%s(): error calling atsc_scan_table()\n",
 				__FUNCTION__);
@@ -326,7 +333,7 @@ static int parse_stt(int dmxfd)
 	time_t sys_time;
 	int ret;
 
-	ret = atsc_scan_table(dmxfd, ATSC_BASE_PID, tag, (void **)&stt);
+	ret = atsc_scan_table(dmxfd, ATSC_BASE_PID, tag, NULL, (void **)&stt);
 	if(0 > ret) {
 		fprintf(stderr, "%s(): error calling atsc_scan_table()\n",
 			__FUNCTION__);
@@ -347,19 +354,15 @@ static int parse_stt(int dmxfd)
 
 static int parse_tvct(int dmxfd)
 {
-	int num_sections;
-	uint32_t section_pattern;
 	const enum atsc_section_tag tag = stag_atsc_terrestrial_virtual_channel;
 	struct atsc_tvct_section *tvct;
 	struct atsc_tvct_channel *ch;
 	struct atsc_channel_info *curr_info;
 	int i, k, ret;
 
-	section_pattern = 0;
-	num_sections = -1;
-
 	do {
-		ret = atsc_scan_table(dmxfd, ATSC_BASE_PID, tag, (void **)&tvct);
+		ret = atsc_scan_table(dmxfd, ATSC_BASE_PID, tag, guide_tables,
+			(void **)&tvct);
 		if(0 > ret) {
 			fprintf(stderr, "%s(): error calling atsc_scan_table()\n",
 			__FUNCTION__);
@@ -370,28 +373,6 @@ static int parse_tvct(int dmxfd)
 			return 0;
 		}
 
-		if(-1 == num_sections) {
-			num_sections = 1 + tvct->head.ext_head.last_section_number;
-			if(32 < num_sections) {
-				fprintf(stderr, "%s(): no support yet for "
-					"tables having more than 32 sections\n",
-					__FUNCTION__);
-				return -1;
-			}
-		} else {
-			if(num_sections !=
-				1 + tvct->head.ext_head.last_section_number) {
-				fprintf(stderr,
-					"%s(): last section number does not match\n",
-					__FUNCTION__);
-				return -1;
-			}
-		}
-		if(section_pattern & (1 << tvct->head.ext_head.section_number)) {
-			continue;
-		}
-		section_pattern |= 1 << tvct->head.ext_head.section_number;
-
 		if(MAX_NUM_CHANNELS < guide.num_channels +
 			tvct->num_channels_in_section) {
 			fprintf(stderr, "%s(): no support for more than %d "
@@ -452,7 +433,7 @@ static int parse_tvct(int dmxfd)
 		curr_info->src_id = ch->source_id;
 		curr_info++;
 		}
-	} while(section_pattern != (uint32_t)((1 << num_sections) - 1));
+	} while(TABLE_ASSEMBLER_COMPLETE != ret);
 
 	return 0;
 }
@@ -549,7 +530,7 @@ static int parse_ett(int dmxfd, int index, uint16_t pid)
 			if(ctrl_c) {
 				return 0;
 			}
-			ret = atsc_scan_table(dmxfd, pid, tag, (void **)&ett);
+			ret = atsc_scan_table(dmxfd, pid, tag, NULL, (void **)&ett);
 			fprintf(stdout, ".");
 			fflush(stdout);
 			if(0 > ret) {
@@ -604,8 +585,32 @@ static int parse_ett(int dmxfd, int index, uint16_t pid)
 	return 0;
 }
 
+/* take the slot of an event from the section being replaced, if any are
+ * left, otherwise a new one from the channel's event array
+ */
+static struct atsc_event_info *alloc_event_info(
+	struct atsc_channel_info *curr_info,
+	struct atsc_event_info **reuse, int *num_reuse)
+{
+	struct atsc_event_info *e_info = NULL;
+
+	while(*num_reuse && NULL == e_info) {
+		e_info = reuse[--*num_reuse];
+	}
+	if(NULL == e_info) {
+		if(curr_info->event_info_index >= MAX_NUM_EVENTS_PER_CHANNEL) {
+			return NULL;
+		}
+		e_info = &curr_info->e[curr_info->event_info_index++];
+	}
+	memset(e_info, 0, sizeof(struct atsc_event_info));
+
+	return e_info;
+}
+
 static int parse_events(struct atsc_channel_info *curr_info,
-	struct atsc_eit_section *eit, struct atsc_eit_section_info *section)
+	struct atsc_eit_section *eit, struct atsc_eit_section_info *section,
+	struct atsc_event_info **reuse, int num_reuse)
 {
 	int i, j, k;
 	struct atsc_eit_event *e;
@@ -619,8 +624,7 @@ static int parse_events(struct atsc_channel_info *curr_info,
 	atsc_eit_section_events_for_each(eit, e, i) {
 		struct atsc_text *title;
 		struct atsc_text_string *str;
-		struct atsc_event_info *e_info =
-			&curr_info->e[curr_info->event_info_index];
+		struct atsc_event_info *e_info;
 
 		if(0 == i && curr_info->last_event) {
 			if(e->event_id == curr_info->last_event->id) {
@@ -631,7 +635,14 @@ static int parse_events(struct atsc_channel_info *curr_info,
 				continue;
 			}
 		}
-		curr_info->event_info_index += 1;
+		if(NULL == (e_info = alloc_event_info(curr_info,
+			reuse, &num_reuse))) {
+			/* the channel's event array is full, so the rest
+			 * of the events are left out
+			 */
+			section->events[i] = NULL;
+			continue;
+		}
 		section->events[i] = e_info;
 		e_info->id = e->event_id;
 		start_time = atsctime_to_unixtime(e->start_time);
@@ -671,147 +682,123 @@ static int parse_events(struct atsc_channel_info *curr_info,
 
 static int parse_eit(int dmxfd, int index, uint16_t pid)
 {
-	int num_sections;
 	uint8_t section_num;
-	uint8_t curr_channel_index;
-	uint32_t section_pattern;
 	const enum atsc_section_tag tag = stag_atsc_event_information;
 	struct atsc_eit_section *eit;
 	struct atsc_channel_info *curr_info;
 	struct atsc_eit_info *eit_info;
 	struct atsc_eit_section_info *section;
+	struct atsc_event_info **old_events;
+	int old_num_events;
 	uint16_t source_id;
 	uint32_t eit_instance_pattern = 0;
 	int i, k, ret;
 
+	/* the sections of every channel's instance are taken in whatever
+	 * order they arrive, so all of them complete in about one cycle
+	 */
 	while(eit_instance_pattern !=
 		(uint32_t)((1 << guide.num_channels) - 1)) {
-		source_id = 0xFFFF;
-		section_pattern = 0;
-		num_sections = -1;
-
-		do {
-			ret = atsc_scan_table(dmxfd, pid, tag, (void **)&eit);
-			fprintf(stdout, ".");
-			fflush(stdout);
-			if(0 > ret) {
-				fprintf(stderr, "%s(): error calling "
-					"atsc_scan_table()\n", __FUNCTION__);
-				return -1;
-			}
-			if(0 == ret) {
-				fprintf(stdout, "no EIT %d in %d seconds\n",
-					index, TIMEOUT);
-				return 0;
-			}
+		ret = atsc_scan_table(dmxfd, pid, tag, guide_tables,
+			(void **)&eit);
+		fprintf(stdout, ".");
+		fflush(stdout);
+		if(0 > ret) {
+			fprintf(stderr, "%s(): error calling "
+				"atsc_scan_table()\n", __FUNCTION__);
+			return -1;
+		}
+		if(0 == ret) {
+			fprintf(stdout, "no EIT %d in %d seconds\n",
+				index, TIMEOUT);
+			return 0;
+		}
 
-			if(0xFFFF == source_id) {
-			source_id = atsc_eit_section_source_id(eit);
-			for(k = 0; k < guide.num_channels; k++) {
-				if(source_id == guide.ch[k].src_id) {
-					curr_info = &guide.ch[k];
-					curr_channel_index = k;
-					if(0 == index) {
-						curr_info->last_event = NULL;
-					}
-					break;
-				}
-			}
-			if(k == guide.num_channels) {
-				fprintf(stderr, "%s(): cannot find source_id "
-					"0x%04X in the EIT\n",
-					__FUNCTION__, source_id);
-				return -1;
-			}
-			} else {
-				if(source_id !=
-					atsc_eit_section_source_id(eit)) {
-					continue;
-				}
-			}
-			if(eit_instance_pattern & (1 << curr_channel_index)) {
-				/* we have received this instance,
-				 * so quit quick
-				 */
+		source_id = atsc_eit_section_source_id(eit);
+		for(k = 0; k < guide.num_channels; k++) {
+			if(source_id == guide.ch[k].src_id) {
 				break;
 			}
+		}
+		if(k == guide.num_channels) {
+			fprintf(stderr, "%s(): cannot find source_id "
+				"0x%04X in the EIT\n",
+				__FUNCTION__, source_id);
+			return -1;
+		}
+		curr_info = &guide.ch[k];
+		eit_info = &curr_info->eit[index];
+		if(0 == index && 0 == eit_info->num_eit_sections) {
+			curr_info->last_event = NULL;
+		}
 
-			if(-1 == num_sections) {
-				num_sections = 1 +
-					eit->head.ext_head.last_section_number;
-				if(32 < num_sections) {
-					fprintf(stderr,
-						"%s(): no support yet for "
-						"tables having more than "
-						"32 sections\n", __FUNCTION__);
-					return -1;
-				}
-			} else {
-				if(num_sections != 1 +
-					eit->head.ext_head.last_section_number) {
-					fprintf(stderr,
-						"%s(): last section number "
-						"does not match\n",
-						__FUNCTION__);
-					return -1;
-				}
-			}
-			if(section_pattern &
-				(1 << eit->head.ext_head.section_number)) {
-				continue;
-			}
-			section_pattern |= 1 << eit->head.ext_head.section_number;
-
-			eit_info = &curr_info->eit[index];
-			if(NULL == (eit_info->section =
-				realloc(eit_info->section,
-				(eit_info->num_eit_sections + 1) *
-				sizeof(struct atsc_eit_section_info)))) {
-				fprintf(stderr,
-					"%s(): error calling realloc()\n",
-					__FUNCTION__);
-				return -1;
+		section_num = eit->head.ext_head.section_number;
+		old_events = NULL;
+		old_num_events = 0;
+		for(i = 0; i < eit_info->num_eit_sections; i++) {
+			if(eit_info->section[i].section_num == section_num) {
+				break;
 			}
-			section_num = eit->head.ext_head.section_number;
-			if(0 == eit_info->num_eit_sections) {
-				eit_info->num_eit_sections = 1;
-				section = eit_info->section;
-			} else {
-				/* have to sort it into section order
-				 * (temporal order)
-				 */
-				for(i = 0; i < eit_info->num_eit_sections; i++) {
-					if(eit_info->section[i].section_num >
-						section_num) {
-						break;
-					}
+		}
+		if(i < eit_info->num_eit_sections) {
+			/* a new version of a section we already have
+			 * replaces it, reusing its events' slots
+			 */
+			section = &eit_info->section[i];
+			old_events = section->events;
+			old_num_events = section->num_events;
+		} else if(NULL == (eit_info->section =
+			realloc(eit_info->section,
+			(eit_info->num_eit_sections + 1) *
+			sizeof(struct atsc_eit_section_info)))) {
+			fprintf(stderr,
+				"%s(): error calling realloc()\n",
+				__FUNCTION__);
+			return -1;
+		} else if(0 == eit_info->num_eit_sections) {
+			eit_info->num_eit_sections = 1;
+			section = eit_info->section;
+		} else {
+			/* have to sort it into section order
+			 * (temporal order)
+			 */
+			for(i = 0; i < eit_info->num_eit_sections; i++) {
+				if(eit_info->section[i].section_num >
+					section_num) {
+					break;
 				}
-				memmove(&eit_info->section[i + 1],
-					&eit_info->section[i],
-					(eit_info->num_eit_sections - i) *
-					sizeof(struct atsc_eit_section_info));
-				section = &eit_info->section[i - 1];
-				section = &eit_info->section[i];
-				eit_info->num_eit_sections += 1;
 			}
+			memmove(&eit_info->section[i + 1],
+				&eit_info->section[i],
+				(eit_info->num_eit_sections - i) *
+				sizeof(struct atsc_eit_section_info));
+			section = &eit_info->section[i];
+			eit_info->num_eit_sections += 1;
+		}
 
-			section->section_num = section_num;
-			section->num_events = eit->num_events_in_section;
-			section->num_etms = 0;
-			section->num_received_etms = 0;
-			if(NULL == (section->events = calloc(section->num_events,
-				sizeof(struct atsc_event_info *)))) {
-				fprintf(stderr, "%s(): error calling calloc()\n",
-					__FUNCTION__);
-				return -1;
-			}
-			if(parse_events(curr_info, eit, section)) {
-				fprintf(stderr, "%s(): error calling "
-					"parse_events()\n", __FUNCTION__);
-				return -1;
-			}
-		} while(section_pattern != (uint32_t)((1 << num_sections) - 1));
-		eit_instance_pattern |= 1 << curr_channel_index;
+		section->section_num = section_num;
+		section->num_events = eit->num_events_in_section;
+		section->num_etms = 0;
+		section->num_received_etms = 0;
+		if(NULL == (section->events = calloc(section->num_events,
+			sizeof(struct atsc_event_info *)))) {
+			fprintf(stderr, "%s(): error calling calloc()\n",
+				__FUNCTION__);
+			free(old_events);
+			return -1;
+		}
+		if(parse_events(curr_info, eit, section,
+			old_events, old_num_events)) {
+			fprintf(stderr, "%s(): error calling "
+				"parse_events()\n", __FUNCTION__);
+			free(old_events);
+			return -1;
+		}
+		free(old_events);
+
+		if(TABLE_ASSEMBLER_COMPLETE == ret) {
+			eit_instance_pattern |= 1 << k;
+		}
 	}
 
 	for(i = 0; i < guide.num_channels; i++) {
@@ -842,7 +829,7 @@ static int parse_mgt(int dmxfd)
 	struct atsc_mgt_table *t;
 	int i, j, ret;
 
-	ret = atsc_scan_table(dmxfd, ATSC_BASE_PID, tag, (void **)&mgt);
+	ret = atsc_scan_table(dmxfd, ATSC_BASE_PID, tag, NULL, (void **)&mgt);
 	if(0 > ret) {
 		fprintf(stderr, "%s(): error calling atsc_scan_table()\n",
 			__FUNCTION__);
@@ -1016,50 +1003,219 @@ static int close_demux(int dmxfd)
 	return 0;
 }
 
-/* used other utilities as template and generalized here */
+/*
+ * the section atsc_scan_table() is waiting for in a recording. Matching
+ * sections which follow it in the same packet are queued for the next read;
+ * they can only be sections contained in that packet, so a packet's worth of
+ * queue is enough.
+ */
+struct recording_wait {
+	int pid;
+	uint8_t tag;
+	int size;
+	unsigned char *buf;
+	unsigned char queue[TRANSPORT_PACKET_LENGTH];
+	int queued;
+};
+
+static struct dvbtsinput *recording;
+static struct section_demux *recording_demux;
+static struct recording_wait recording_wait;
+static uint8_t *recording_packets;
+static int recording_count;
+
+static void recording_section(void *arg, int pid, uint8_t *section, int len)
+{
+	struct recording_wait *wait = arg;
+
+	if((pid != wait->pid) || (section[0] != wait->tag)) {
+		return;
+	}
+	/* the demux hardware would have checked this */
+	if(crc32(CRC32_INIT, section, len)) {
+		return;
+	}
+	if(0 == wait->size) {
+		memcpy(wait->buf, section, len);
+		wait->size = len;
+	} else if((wait->queued + len) <= (int) sizeof(wait->queue)) {
+		memcpy(wait->queue + wait->queued, section, len);
+		wait->queued += len;
+	} else {
+		fprintf(stderr, "%s(): section queue full, dropping a "
+			"section\n", __FUNCTION__);
+	}
+}
+
+static int open_recording(void)
+{
+	recording = dvbtsinput_open_file(recording_file, DVBTSINPUT_TYPE_MMAP);
+	if(NULL == recording) {
+		fprintf(stderr, "%s(): error opening %s\n", __FUNCTION__,
+			recording_file);
+		return -1;
+	}
+	recording_wait.pid = -1;
+	recording_demux = section_demux_create(4096, recording_section,
+		&recording_wait);
+	if(NULL == recording_demux) {
+		fprintf(stderr, "%s(): error calling section_demux_create()\n",
+			__FUNCTION__);
+		return -1;
+	}
+	return 0;
+}
+
+static void close_recording(void)
+{
+	section_demux_destroy(recording_demux);
+	dvbtsinput_close(recording);
+}
+
+/*
+ * Carry on through the recording from where we left off, until a matching
+ * section turns up, going back to the start at most once.
+ */
+static int recording_read_section(uint16_t pid, enum atsc_section_tag tag,
+	unsigned char *buf)
+{
+	struct transport_packet *tspkt;
+	int rewound = 0;
+	int size;
+
+	if(recording_wait.queued && (pid == recording_wait.pid) &&
+		(tag == recording_wait.tag)) {
+		size = 3 + (((recording_wait.queue[1] & 0x0f) << 8) |
+			recording_wait.queue[2]);
+		memcpy(buf, recording_wait.queue, size);
+		recording_wait.queued -= size;
+		memmove(recording_wait.queue, recording_wait.queue + size,
+			recording_wait.queued);
+		return size;
+	}
+	recording_wait.queued = 0;
+
+	/* packets of this PID were skipped while waiting on another one, so
+	 * its continuity counter and any partial section are stale */
+	if(pid != recording_wait.pid) {
+		section_demux_reset_pid(recording_demux, pid);
+	}
+
+	recording_wait.pid = pid;
+	recording_wait.tag = tag;
+	recording_wait.size = 0;
+	recording_wait.buf = buf;
+
+	for( ; ; ) {
+		if(0 == recording_count) {
+			recording_count = dvbtsinput_read(recording,
+				&recording_packets, 0);
+			if(recording_count < 0) {
+				recording_count = 0;
+				return -1;
+			}
+			if(0 == recording_count) {
+				if(rewound || dvbtsinput_rewind(recording)) {
+					return 0;
+				}
+				section_demux_reset_pid(recording_demux, pid);
+				rewound = 1;
+				continue;
+			}
+		}
+
+		tspkt = transport_packet_init(recording_packets);
+		recording_packets += TRANSPORT_PACKET_LENGTH;
+		recording_count--;
+		if((NULL != tspkt) && (transport_packet_pid(tspkt) == pid)) {
+			section_demux_add_packet(recording_demux, tspkt);
+			if(recording_wait.size) {
+				return recording_wait.size;
+			}
+		}
+	}
+}
+
+/* used other utilities as template and generalized here
+ *
+ * With an assembler, sections it has already received are skipped before
+ * being parsed, and TABLE_ASSEMBLER_COMPLETE is returned for the section
+ * which completes its table.
+ */
 static int atsc_scan_table(int dmxfd, uint16_t pid, enum atsc_section_tag tag,
-	void **table_section)
+	struct table_assembler *assembler, void **table_section)
 {
 	uint8_t filter[18];
 	uint8_t mask[18];
 	unsigned char sibuf[4096];
 	int size;
 	int ret;
+	int status = 1;
 	struct pollfd pollfd;
 	struct section *section;
 	struct section_ext *section_ext;
 	struct atsc_section_psip *psip;
 
 	/* create a section filter for the table */
-	memset(filter, 0, sizeof(filter));
-	memset(mask, 0, sizeof(mask));
-	filter[0] = tag;
-	mask[0] = 0xFF;
-	if(dvbdemux_set_section_filter(dmxfd, pid, filter, mask, 1, 1)) {
-		fprintf(stderr, "%s(): error calling atsc_scan_table()\n",
-			__FUNCTION__);
-		return -1;
-	}
-
-	/* poll for data */
-	pollfd.fd = dmxfd;
-	pollfd.events = POLLIN | POLLERR |POLLPRI;
-	if((ret = poll(&pollfd, 1, TIMEOUT * 1000)) < 0) {
-		if(ctrl_c) {
-			return 0;
+	if(!recording) {
+		memset(filter, 0, sizeof(filter));
+		memset(mask, 0, sizeof(mask));
+		filter[0] = tag;
+		mask[0] = 0xFF;
+		if(dvbdemux_set_section_filter(dmxfd, pid, filter, mask, 1, 1)) {
+			fprintf(stderr, "%s(): error calling atsc_scan_table()\n",
+				__FUNCTION__);
+			return -1;
 		}
-		fprintf(stderr, "%s(): error calling poll()\n", __FUNCTION__);
-		return -1;
 	}
 
-	if(0 == ret) {
-		return 0;
-	}
+	for( ; ; ) {
+		if(recording) {
+			if((size = recording_read_section(pid, tag, sibuf)) < 0) {
+				fprintf(stderr, "%s(): error reading recording\n",
+					__FUNCTION__);
+				return -1;
+			}
+			if(0 == size) {
+				return 0;
+			}
+		} else {
+			/* poll for data */
+			pollfd.fd = dmxfd;
+			pollfd.events = POLLIN | POLLERR |POLLPRI;
+			if((ret = poll(&pollfd, 1, TIMEOUT * 1000)) < 0) {
+				if(ctrl_c) {
+					return 0;
+				}
+				fprintf(stderr, "%s(): error calling poll()\n",
+					__FUNCTION__);
+				return -1;
+			}
 
-	/* read it */
-	if((size = read(dmxfd, sibuf, sizeof(sibuf))) < 0) {
-		fprintf(stderr, "%s(): error calling read()\n", __FUNCTION__);
-		return -1;
+			if(0 == ret) {
+				return 0;
+			}
+
+			/* read it */
+			if((size = read(dmxfd, sibuf, sizeof(sibuf))) < 0) {
+				fprintf(stderr, "%s(): error calling read()\n",
+					__FUNCTION__);
+				return -1;
+			}
+		}
+
+		if(NULL == assembler) {
+			break;
+		}
+		status = table_assembler_add(assembler, pid, sibuf, size);
+		if(0 > status) {
+			fprintf(stderr, "%s(): error calling "
+				"table_assembler_add()\n", __FUNCTION__);
+			return -1;
+		}
+		if(TABLE_ASSEMBLER_IGNORED != status) {
+			break;
+		}
 	}
 
 	/* parse section */
@@ -1092,7 +1248,7 @@ static int atsc_scan_table(int dmxfd, uint16_t pid, enum atsc_section_tag tag,
 		return -1;
 	}
 
-	return 1;
+	return status;
 }
 
 int main(int argc, char *argv[])
@@ -1110,7 +1266,7 @@ int main(int argc, char *argv[])
 	for( ; ; ) {
 		char c;
 
-		if(-1 == (c = getopt(argc, argv, "a:f:p:m:th"))) {
+		if(-1 == (c = getopt(argc, argv, "a:f:r:p:m:th"))) {
 			break;
 		}
 
@@ -1123,6 +1279,10 @@ int main(int argc, char *argv[])
 			frequency = strtol(optarg, NULL, 0);
 			break;
 
+		case 'r':
+			recording_file = optarg;
+			break;
+
 		case 'p':
 			period = strtol(optarg, NULL, 0);
 			/* each table covers 3 hours */
@@ -1156,16 +1316,32 @@ int main(int argc, char *argv[])
 	memset(guide.eit_pid, 0xFF, MAX_NUM_EVENT_TABLES * sizeof(uint16_t));
 	memset(guide.ett_pid, 0xFF, MAX_NUM_EVENT_TABLES * sizeof(uint16_t));
 
-	if(open_frontend(&fe)) {
-		fprintf(stderr, "%s(): error calling open_frontend()\n",
+	if(NULL == (guide_tables = table_assembler_create(NULL, NULL))) {
+		fprintf(stderr, "%s(): error calling table_assembler_create()\n",
 			__FUNCTION__);
 		return -1;
 	}
 
-	if(open_demux(&dmxfd)) {
-		fprintf(stderr, "%s(): error calling open_demux()\n",
-			__FUNCTION__);
-		return -1;
+	if(recording_file) {
+		fe = NULL;
+		dmxfd = -1;
+		if(open_recording()) {
+			fprintf(stderr, "%s(): error calling open_recording()\n",
+				__FUNCTION__);
+			return -1;
+		}
+	} else {
+		if(open_frontend(&fe)) {
+			fprintf(stderr, "%s(): error calling open_frontend()\n",
+				__FUNCTION__);
+			return -1;
+		}
+
+		if(open_demux(&dmxfd)) {
+			fprintf(stderr, "%s(): error calling open_demux()\n",
+				__FUNCTION__);
+			return -1;
+		}
 	}
 
 	if(parse_stt(dmxfd)) {
@@ -1235,6 +1411,13 @@ int main(int argc, char *argv[])
 		return -1;
 	}
 
+	table_assembler_destroy(guide_tables);
+
+	if(recording_file) {
+		close_recording();
+		return 0;
+	}
+
 	if(close_demux(dmxfd)) {
 		fprintf(stderr, "%s(): error calling close_demux()\n",
 			__FUNCTION__);
@@ -0,0 +1,427 @@
+/*
+ * dvbmpe.c - receive MPE or ULE encapsulated IP in userspace, and write it
+ * to a TUN interface
+ *
+ * Copyright (C) 2026 agent (agent@local)
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <libdvbapi/dvbdemux.h>
+#include <libdvbapi/dvbtsinput.h>
+#include <libdvbapi/dvbtun.h>
+#include <libucsi/mpe_demux.h>
+#include <libucsi/ule_demux.h>
+
+#define MAX_PIDS 64
+#define MAX_MACS 64
+
+struct output {
+	int tunfd;
+	struct dvbtun_packet *packets;
+	uint64_t written;
+	uint64_t dropped;
+};
+
+static int pids[MAX_PIDS];
+static int pid_count;
+static volatile sig_atomic_t quit;
+
+static void usage(FILE *output)
+{
+	fprintf(output,
+		"Usage: dvbmpe [OPTION]... -p PID [-p PID]...\n"
+		"Receive IP datagrams carried in MPE datagram sections, or in ULE\n"
+		"SNDUs, and write them to a TUN interface.\n"
+		"Options:\n"
+		"	-a N	use dvb adapter N\n"
+		"	-d N	use demux N\n"
+		"	-f FILE	read a recorded transport stream instead\n"
+		"	-p PID	receive the MPE stream on PID (up to %i times)\n"
+		"	-U	the streams use ULE (RFC 4326) instead; -m then gives\n"
+		"		destination NPA addresses\n"
+		"	-F ROWS	the streams use MPE-FEC, with frames of ROWS rows\n"
+		"		(256, 512, 768 or 1024); lost datagrams are rebuilt\n"
+		"	-m MAC	accept datagrams for MAC (xx:xx:xx:xx:xx:xx; may be repeated)\n"
+		"	-M	also accept multicast and broadcast MAC addresses\n"
+		"	-P	accept all MAC addresses (default if no -m is given)\n"
+		"	-i NAME	name of the TUN interface (default: chosen by the kernel)\n"
+		"	-q	open one queue of a multiqueue TUN interface, so several\n"
+		"		dvbmpe processes can feed it, e.g. one per core\n"
+		"	-n	do not write to a TUN interface; just count\n"
+		"	-b N	deliver datagrams in batches of up to N (default %i)\n"
+		"	-s N	print statistics every N seconds (default 0: only at exit)\n"
+		"	-h	display this help\n",
+		MAX_PIDS, MPE_DEMUX_DEFAULT_POOL);
+}
+
+static int parse_mac(const char *str, uint8_t *mac)
+{
+	unsigned int b[6];
+	int i;
+
+	if (sscanf(str, "%x:%x:%x:%x:%x:%x", &b[0], &b[1], &b[2], &b[3], &b[4], &b[5]) != 6)
+		return -1;
+	for(i=0; i < 6; i++) {
+		if (b[i] > 0xff)
+			return -1;
+		mac[i] = b[i];
+	}
+	return 0;
+}
+
+static void write_packets(struct output *out, int count)
+{
+	int written;
+
+	if (out->tunfd < 0) {
+		out->written += count;
+		return;
+	}
+
+	if ((written = dvbtun_write_batch(out->tunfd, out->packets, count)) < 0)
+		written = 0;
+	out->written += written;
+	out->dropped += count - written;
+}
+
+static void write_batch(void *arg, struct mpe_demux_packet *packets, int count)
+{
+	struct output *out = (struct output *) arg;
+	int i;
+
+	for(i=0; i < count; i++) {
+		out->packets[i].data = packets[i].data;
+		out->packets[i].len = packets[i].len;
+		out->packets[i].protocol = packets[i].protocol;
+	}
+	write_packets(out, count);
+}
+
+static void write_ule_batch(void *arg, struct ule_demux_packet *packets, int count)
+{
+	struct output *out = (struct output *) arg;
+	int i;
+
+	for(i=0; i < count; i++) {
+		out->packets[i].data = packets[i].data;
+		out->packets[i].len = packets[i].len;
+		out->packets[i].protocol = packets[i].protocol;
+	}
+	write_packets(out, count);
+}
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + (ts.tv_nsec / 1e9);
+}
+
+static void print_stats(struct mpe_demux *mdemux, struct output *out,
+			struct mpe_demux_pid_stats *last, double secs)
+{
+	struct mpe_demux_pid_stats s;
+	int i;
+
+	printf("-PID--DGRAM/S----KBIT/S--MACFILT-----CRC-SCRAMBL---UNSUP-INVALID-----CC---RECOV-FECLOST\n");
+	for(i=0; i < pid_count; i++) {
+		mpe_demux_get_pid_stats(mdemux, pids[i], &s);
+		printf("%04x %8.0f %9.0f %8llu %7llu %7llu %7llu %7llu %6llu %7llu %7llu\n",
+		       pids[i],
+		       (s.datagrams - last[i].datagrams) / secs,
+		       (s.bytes - last[i].bytes) * 8 / secs / 1000,
+		       (unsigned long long) (s.mac_filtered - last[i].mac_filtered),
+		       (unsigned long long) (s.crc_errors - last[i].crc_errors),
+		       (unsigned long long) (s.scrambled - last[i].scrambled),
+		       (unsigned long long) (s.unsupported - last[i].unsupported),
+		       (unsigned long long) (s.invalid - last[i].invalid),
+		       (unsigned long long) (s.continuity_errors - last[i].continuity_errors),
+		       (unsigned long long) (s.recovered - last[i].recovered),
+		       (unsigned long long) (s.fec_lost - last[i].fec_lost));
+		last[i] = s;
+	}
+	printf("tun: %llu written, %llu dropped\n",
+	       (unsigned long long) out->written, (unsigned long long) out->dropped);
+	fflush(stdout);
+}
+
+static void print_ule_stats(struct ule_demux *udemux, struct output *out,
+			    struct ule_demux_pid_stats *last, double secs)
+{
+	struct ule_demux_pid_stats s;
+	int i;
+
+	printf("-PID--SNDU/S----KBIT/S--NPAFILT-----CRC----TEST---UNSUP-INVALID----EXT-----PP-----CC-----TS\n");
+	for(i=0; i < pid_count; i++) {
+		ule_demux_get_pid_stats(udemux, pids[i], &s);
+		printf("%04x %7.0f %9.0f %8llu %7llu %7llu %7llu %7llu %6llu %6llu %6llu %6llu\n",
+		       pids[i],
+		       (s.sndus - last[i].sndus) / secs,
+		       (s.bytes - last[i].bytes) * 8 / secs / 1000,
+		       (unsigned long long) (s.npa_filtered - last[i].npa_filtered),
+		       (unsigned long long) (s.crc_errors - last[i].crc_errors),
+		       (unsigned long long) (s.test_sndus - last[i].test_sndus),
+		       (unsigned long long) (s.unsupported - last[i].unsupported),
+		       (unsigned long long) (s.invalid - last[i].invalid),
+		       (unsigned long long) (s.extensions - last[i].extensions),
+		       (unsigned long long) (s.pp_errors - last[i].pp_errors),
+		       (unsigned long long) (s.continuity_errors - last[i].continuity_errors),
+		       (unsigned long long) (s.ts_errors - last[i].ts_errors));
+		last[i] = s;
+	}
+	printf("tun: %llu written, %llu dropped\n",
+	       (unsigned long long) out->written, (unsigned long long) out->dropped);
+	fflush(stdout);
+}
+
+static void signal_handler(int sig)
+{
+	(void) sig;
+	quit = 1;
+}
+
+int main(int argc, char **argv)
+{
+	int adapter = 0, demux = 0;
+	char *filename = NULL;
+	char ifname[DVBTUN_NAME_LENGTH] = "";
+	uint8_t macs[MAX_MACS][6];
+	int mac_count = 0;
+	int promiscuous = 0, multicast = 0;
+	int flags = 0, tunflags = 0;
+	int notun = 0;
+	int pool = MPE_DEMUX_DEFAULT_POOL;
+	int interval = 0;
+	int fec_rows = 0;
+	int ule = 0;
+	int demuxfds[MAX_PIDS];
+	struct mpe_demux_pid_stats last[MAX_PIDS];
+	struct ule_demux_pid_stats ule_last[MAX_PIDS];
+	struct dvbtsinput *input;
+	struct mpe_demux *mdemux = NULL;
+	struct ule_demux *udemux = NULL;
+	struct output out;
+	double start, lastt;
+	int opt;
+	int i;
+
+	while ((opt = getopt(argc, argv, "a:b:d:f:F:hi:m:Mnp:Pqs:U")) != -1) {
+		switch (opt) {
+		case 'a':
+			adapter = atoi(optarg);
+			break;
+		case 'b':
+			pool = atoi(optarg);
+			break;
+		case 'd':
+			demux = atoi(optarg);
+			break;
+		case 'f':
+			filename = optarg;
+			break;
+		case 'F':
+			fec_rows = atoi(optarg);
+			break;
+		case 'h':
+			usage(stdout);
+			exit(0);
+		case 'i':
+			strncpy(ifname, optarg, DVBTUN_NAME_LENGTH - 1);
+			break;
+		case 'm':
+			if ((mac_count == MAX_MACS) || parse_mac(optarg, macs[mac_count])) {
+				fprintf(stderr, "dvbmpe: Invalid MAC address %s\n", optarg);
+				exit(1);
+			}
+			mac_count++;
+			break;
+		case 'M':
+			multicast = 1;
+			break;
+		case 'n':
+			notun = 1;
+			break;
+		case 'p':
+			if (pid_count == MAX_PIDS) {
+				fprintf(stderr, "dvbmpe: Too many PIDs\n");
+				exit(1);
+			}
+			pids[pid_count++] = strtol(optarg, NULL, 0);
+			break;
+		case 'P':
+			promiscuous = 1;
+			break;
+		case 'q':
+			tunflags |= DVBTUN_FLAG_MULTI_QUEUE;
+			break;
+		case 's':
+			interval = atoi(optarg);
+			break;
+		case 'U':
+			ule = 1;
+			break;
+		default:
+			usage(stderr);
+			exit(1);
+		}
+	}
+	if ((pid_count == 0) || (pool <= 0) || (ule && fec_rows)) {
+		usage(stderr);
+		exit(1);
+	}
+	if (mac_count == 0)
+		promiscuous = 1;
+	if (ule)
+		flags = (promiscuous ? ule_demux_flag_promiscuous : 0) |
+			(multicast ? ule_demux_flag_multicast : 0);
+	else
+		flags = (promiscuous ? mpe_demux_flag_promiscuous : 0) |
+			(multicast ? mpe_demux_flag_multicast : 0);
+
+	memset(&out, 0, sizeof(out));
+	out.tunfd = -1;
+	if (!notun) {
+		if ((out.tunfd = dvbtun_open(ifname, tunflags)) < 0) {
+			fprintf(stderr, "dvbmpe: Could not open TUN interface: %m\n");
+			exit(1);
+		}
+		fprintf(stderr, "dvbmpe: Writing to interface %s\n", ifname);
+	}
+	out.packets = (struct dvbtun_packet *) malloc(pool * sizeof(struct dvbtun_packet));
+
+	if (ule)
+		udemux = ule_demux_create(pool, flags, write_ule_batch, &out);
+	else
+		mdemux = mpe_demux_create(pool, flags, write_batch, &out);
+	if (((mdemux == NULL) && (udemux == NULL)) || (out.packets == NULL)) {
+		fprintf(stderr, "dvbmpe: Out of memory\n");
+		exit(1);
+	}
+	for(i=0; i < pid_count; i++) {
+		if (ule ? ule_demux_add_pid(udemux, pids[i]) : mpe_demux_add_pid(mdemux, pids[i])) {
+			fprintf(stderr, "dvbmpe: Invalid PID %i\n", pids[i]);
+			exit(1);
+		}
+		if (fec_rows && mpe_demux_set_fec(mdemux, pids[i], fec_rows)) {
+			fprintf(stderr, "dvbmpe: Invalid MPE-FEC frame size %i\n", fec_rows);
+			exit(1);
+		}
+	}
+	for(i=0; i < mac_count; i++) {
+		if (ule)
+			ule_demux_add_npa(udemux, macs[i]);
+		else
+			mpe_demux_add_mac(mdemux, macs[i]);
+	}
+
+	for(i=0; i < pid_count; i++)
+		demuxfds[i] = -1;
+	if (filename) {
+		input = dvbtsinput_open_file(filename, DVBTSINPUT_TYPE_MMAP);
+		if (input == NULL) {
+			fprintf(stderr, "dvbmpe: Could not open %s: %m\n", filename);
+			exit(1);
+		}
+	} else {
+		// route each PID to the DVR device, and read them all from there
+		for(i=0; i < pid_count; i++) {
+			demuxfds[i] = dvbdemux_open_demux(adapter, demux, 0);
+			if (demuxfds[i] < 0) {
+				fprintf(stderr, "dvbmpe: Could not open demux device: %m\n");
+				exit(1);
+			}
+			if (dvbdemux_set_pid_filter(demuxfds[i], pids[i], DVBDEMUX_INPUT_FRONTEND,
+						    DVBDEMUX_OUTPUT_DVR, 1)) {
+				fprintf(stderr, "dvbmpe: Could not set PID filter: %m\n");
+				exit(1);
+			}
+		}
+
+		input = dvbtsinput_open_dvr(adapter, demux, 4 * 1024 * 1024);
+		if (input == NULL) {
+			fprintf(stderr, "dvbmpe: Could not open dvr device: %m\n");
+			exit(1);
+		}
+	}
+
+	signal(SIGINT, signal_handler);
+	signal(SIGTERM, signal_handler);
+	memset(last, 0, sizeof(last));
+	memset(ule_last, 0, sizeof(ule_last));
+	start = lastt = now();
+
+	while (!quit) {
+		uint8_t *buffer;
+		int count;
+
+		count = dvbtsinput_read(input, &buffer, interval ? 1000 : -1);
+		if (count == 0)
+			break;
+		if ((count > 0) && ule) {
+			ule_demux_add_packets(udemux, buffer, count);
+			ule_demux_flush(udemux);
+		} else if (count > 0) {
+			mpe_demux_add_packets(mdemux, buffer, count);
+			mpe_demux_flush(mdemux);
+		} else if ((count != -ETIMEDOUT) && (count != -EOVERFLOW) && (count != -EINTR)) {
+			fprintf(stderr, "dvbmpe: read error: %s\n", strerror(-count));
+			break;
+		}
+
+		if (interval && (now() - lastt >= interval)) {
+			double t = now();
+
+			if (ule)
+				print_ule_stats(udemux, &out, ule_last, t - lastt);
+			else
+				print_stats(mdemux, &out, last, t - lastt);
+			lastt = t;
+		}
+	}
+
+	// summary over the whole run
+	if (ule) {
+		ule_demux_flush(udemux);
+		memset(ule_last, 0, sizeof(ule_last));
+		print_ule_stats(udemux, &out, ule_last, now() - start);
+	} else {
+		mpe_demux_flush(mdemux);
+		memset(last, 0, sizeof(last));
+		print_stats(mdemux, &out, last, now() - start);
+	}
+
+	for(i=0; i < pid_count; i++) {
+		if (demuxfds[i] >= 0)
+			close(demuxfds[i]);
+	}
+	dvbtsinput_close(input);
+	if (udemux)
+		ule_demux_destroy(udemux);
+	if (mdemux)
+		mpe_demux_destroy(mdemux);
+	if (out.tunfd >= 0)
+		close(out.tunfd);
+	free(out.packets);
+	return 0;
+}
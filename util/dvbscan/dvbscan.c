@@ -24,6 +24,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <time.h>
+#include <errno.h>
 #include <libdvbsec/dvbsec_cfg.h>
 #include <libdvbcfg/dvbcfg_scanfile.h>
 #include <libdvbapi/dvbdemux.h>
@@ -112,6 +113,32 @@ static int scan_load_callback(struct dvbcfg_scanfile *channel, void *private_dat
 	return 0;
 }
 
+static void print_tune_stats(struct dvbfe_handle *fe)
+{
+	struct dvbfe_tune_stats stats;
+	int i;
+
+	dvbfe_get_tune_stats(fe, &stats);
+	fprintf(stderr, "Tuned %u times: %u locked, %u timed out\n",
+		stats.tunes, stats.locks, stats.timeouts);
+	if (stats.locks == 0)
+		return;
+
+	fprintf(stderr, "Lock time: min %u ms, mean %u ms, max %u ms\n",
+		stats.min_ms, (uint32_t) (stats.total_ms / stats.locks), stats.max_ms);
+	for(i=0; i < DVBFE_TUNE_HISTOGRAM_BUCKETS; i++) {
+		if (stats.histogram[i] == 0)
+			continue;
+		if (i == 0)
+			fprintf(stderr, "      < 1 ms");
+		else if (i == (DVBFE_TUNE_HISTOGRAM_BUCKETS - 1))
+			fprintf(stderr, "  >= %5u ms", 1 << (i - 1));
+		else
+			fprintf(stderr, "   < %5u ms", 1 << i);
+		fprintf(stderr, ": %u\n", stats.histogram[i]);
+	}
+}
+
 int main(int argc, char *argv[])
 {
 	uint32_t i;
@@ -259,36 +286,25 @@ int main(int argc, char *argv[])
 		if (valid_sec)
 			psec = &sec;
 
-		// tune it
+		// tune it, waiting for the lock event
 		int tuned_ok = 0;
 		for(i=0; i < tmp->frequency_count; i++) {
 			tmp->params.frequency = tmp->frequencies[i];
-			if (dvbsec_set(fe,
+			int res = dvbsec_set(fe,
 					psec,
 					tmp->polarization,
 					(satpos & 0x01) ? DISEQC_SWITCH_B : DISEQC_SWITCH_A,
 					(satpos & 0x02) ? DISEQC_SWITCH_B : DISEQC_SWITCH_A,
 					&tmp->params,
-					0)) {
+					TIMEOUT_WAIT_LOCK * 1000);
+			if (res == 0) {
+				tuned_ok = 1;
+				break;
+			}
+			if (res != -ETIMEDOUT) {
 				fprintf(stderr, "Failed to set frontend\n");
 				exit(1);
 			}
-
-			// wait for lock
-			time_t starttime = time(NULL);
-			while((time(NULL) - starttime) < TIMEOUT_WAIT_LOCK) {
-				if (dvbfe_get_info(fe, DVBFE_INFO_LOCKSTATUS, &feinfo,
-				    			DVBFE_INFO_QUERYTYPE_IMMEDIATE, 0) !=
-					DVBFE_INFO_QUERYTYPE_IMMEDIATE) {
-					fprintf(stderr, "Unable to query frontend status\n");
-					exit(1);
-				}
-				if (feinfo.lock) {
-					tuned_ok = 1;
-					break;
-				}
-				usleep(100000);
-			}
 		}
 		if (!tuned_ok) {
 			free_transponder(tmp);
@@ -314,6 +330,7 @@ int main(int argc, char *argv[])
 
 	// FIXME: output the data
 
+	print_tune_stats(fe);
 	return 0;
 }
 
@@ -2,41 +2,360 @@
 
 #include <stdio.h>
 #include <stdlib.h>
-#include <sys/ioctl.h>
+#include <stdint.h>
 #include <unistd.h>
-#include <sys/types.h>
-#include <sys/stat.h>
-#include <fcntl.h>
-#include <time.h>
-#include <sys/poll.h>
-#include <sys/time.h>
 #include <string.h>
-#include <limits.h>
+#include <signal.h>
+#include <time.h>
+#include <errno.h>
 #include <libdvbapi/dvbdemux.h>
+#include <libdvbapi/dvbtsinput.h>
+#include <libucsi/transport_packet.h>
+#include <libucsi/pcr_clock.h>
+
+#define DVR_BUFFER_SIZE (4 * 1024 * 1024)
+#define READ_TIMEOUT 1000
+
+#define MAX_PATTERNS 32
+#define MAX_PATTERN_LENGTH (TRANSPORT_PACKET_LENGTH - 4)
+
+/* the machine readable output gives the totals as this PID */
+#define TOTAL_PID TRANSPORT_MAX_PIDS
+
+/* PCR steps larger than this are not used to advance the time */
+#define PCR_MAX_STEP (60 * PCR_CLOCK_HZ)
+
+struct pidstat {
+	uint32_t packets;
+	uint32_t scrambled;
+	uint32_t cc_errors;
+	uint32_t pusi;
+	uint32_t matches;
+	uint8_t continuity;
+};
+
+/* Aho-Corasick automaton, expanded into a DFA: one transition per byte */
+struct search {
+	int (*next)[256];
+	uint8_t *match;		/* nonzero if a pattern ends in the state */
+	int states;
+	int first;		/* the only byte leaving the root state, or -1 */
+};
 
-#define BSIZE 188
+struct timebase {
+	struct pcr_clock *clk;
+	double wall_start;
+	int pcr_valid;		/* PCRs are being used */
+	int pcr_reset;		/* the reference PCR was discontinuous */
+	int restart;		/* PCRs have just started being used */
+	uint64_t pcr;		/* last reference PCR value */
+	uint64_t ticks;		/* PCR ticks since PCRs started being used */
+	uint64_t packets;	/* packets counted */
+	uint64_t pcr_packets;	/* packets counted at pcr */
+	uint64_t timed_packets;	/* packets over which ticks were measured */
+	double origin;		/* the time at which they did */
+};
 
-static int pidt[0x2001];
+static struct pidstat pids[TRANSPORT_MAX_PIDS + 1];
+static uint32_t sync_errors;
+static volatile sig_atomic_t quit;
 
 static void usage(FILE *output)
 {
 	fprintf(output,
 		"Usage: dvbtraffic [OPTION]...\n"
+		"Show the bitrate of each PID in a transport stream. Time is measured\n"
+		"by the stream's PCRs once they have been seen, so the rates of a\n"
+		"recording are right however fast it is read.\n"
 		"Options:\n"
 		"	-a N	use dvb adapter N\n"
 		"	-d N	use demux N\n"
-		"	-h	display this help\n");
+		"	-f FILE	read a recorded transport stream instead\n"
+		"	-i N	print the rates every N seconds (default 1)\n"
+		"	-s STR	only count packets whose payload contains STR (may be\n"
+		"		repeated, up to %i patterns in all)\n"
+		"	-x HEX	only count packets whose payload contains the bytes HEX\n"
+		"	-m	machine readable output: a CSV line per PID per interval\n"
+		"		(time,pid,packets,scrambled,cc_errors,pusi,matches,bitrate);\n"
+		"		PID %i gives the totals\n"
+		"	-h	display this help\n",
+		MAX_PATTERNS, TOTAL_PID);
+}
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + (ts.tv_nsec / 1e9);
+}
+
+static void signal_handler(int sig)
+{
+	(void) sig;
+	quit = 1;
+}
+
+static int parse_hex(const char *str, uint8_t *buf, int max)
+{
+	unsigned int b;
+	int len = 0;
+
+	while(*str) {
+		if ((len == max) || (sscanf(str, "%2x", &b) != 1) || !str[1])
+			return -1;
+		buf[len++] = b;
+		str += 2;
+	}
+	return len;
+}
+
+static int search_build(struct search *s, uint8_t patterns[][MAX_PATTERN_LENGTH],
+			int *lens, int count)
+{
+	int *fail;
+	int *queue;
+	int head = 0, tail = 0;
+	int max = 1;
+	int state, f, u;
+	int i, j, c;
+
+	for(i=0; i < count; i++)
+		max += lens[i];
+	s->next = malloc(max * sizeof(*s->next));
+	s->match = calloc(max, 1);
+	fail = malloc(max * sizeof(int));
+	queue = malloc(max * sizeof(int));
+	if ((s->next == NULL) || (s->match == NULL) || (fail == NULL) || (queue == NULL))
+		return -1;
+
+	// build the trie, -1 meaning no child
+	memset(s->next, 0xff, max * sizeof(*s->next));
+	s->states = 1;
+	for(i=0; i < count; i++) {
+		state = 0;
+		for(j=0; j < lens[i]; j++) {
+			c = patterns[i][j];
+			if (s->next[state][c] < 0)
+				s->next[state][c] = s->states++;
+			state = s->next[state][c];
+		}
+		s->match[state] = 1;
+	}
+
+	// fill in the missing transitions breadth first, from the failure links
+	s->first = -1;
+	for(c=0; c < 256; c++) {
+		if (s->next[0][c] < 0) {
+			s->next[0][c] = 0;
+			continue;
+		}
+		s->first = (s->first == -1) ? c : -2;
+		fail[s->next[0][c]] = 0;
+		queue[tail++] = s->next[0][c];
+	}
+	if (s->first < 0)
+		s->first = -1;
+	while(head < tail) {
+		state = queue[head++];
+		f = fail[state];
+		for(c=0; c < 256; c++) {
+			u = s->next[state][c];
+			if (u < 0) {
+				s->next[state][c] = s->next[f][c];
+				continue;
+			}
+			fail[u] = s->next[f][c];
+			s->match[u] |= s->match[fail[u]];
+			queue[tail++] = u;
+		}
+	}
+
+	free(fail);
+	free(queue);
+	return 0;
+}
+
+static int search_payload(struct search *s, const uint8_t *buf, int len)
+{
+	const uint8_t *end = buf + len;
+	int state = 0;
+
+	while(buf < end) {
+		// with a single first byte, let memchr skip to the next candidate
+		if ((state == 0) && (s->first >= 0)) {
+			if ((buf = memchr(buf, s->first, end - buf)) == NULL)
+				return 0;
+		}
+		state = s->next[state][*buf++];
+		if (s->match[state])
+			return 1;
+	}
+	return 0;
+}
+
+static void count_packet(struct timebase *tb, struct search *search, uint8_t *buf)
+{
+	struct transport_packet *pkt = (struct transport_packet *) buf;
+	int pid = ((buf[1] & 0x1f) << 8) | buf[2];
+	struct pidstat *p = &pids[pid];
+	int discontinuity = 0;
+	int events;
+	int pos;
+
+	p->packets++;
+	tb->packets++;
+	if (buf[1] & 0x40)
+		p->pusi++;
+	if (buf[3] & 0xc0)
+		p->scrambled++;
+
+	if ((buf[3] & 0x20) && buf[4])
+		discontinuity = buf[5] & transport_adaptation_flag_discontinuity;
+	if (transport_packet_continuity_check(pkt, discontinuity, &p->continuity)) {
+		p->cc_errors++;
+		p->continuity = 0;
+	}
+
+	events = pcr_clock_add_packet(tb->clk, pkt);
+	if (events & pcr_clock_event_discontinuity) {
+		struct pcr_clock_stats stats;
+
+		pcr_clock_get_stats(tb->clk, &stats);
+		if (pid == stats.reference_pid)
+			tb->pcr_reset = 1;
+	}
+
+	if (search && (pid != TRANSPORT_NULL_PID) && (buf[3] & 0x10)) {
+		pos = 4;
+		if (buf[3] & 0x20)
+			pos += 1 + buf[4];
+		if ((pos < TRANSPORT_PACKET_LENGTH) &&
+		    search_payload(search, buf + pos, TRANSPORT_PACKET_LENGTH - pos))
+			p->matches++;
+	}
+}
+
+static void count_batch(struct timebase *tb, struct search *search, uint8_t *buf, int count)
+{
+	// dvbtsinput only hands back packets starting with a sync byte
+	while(count--) {
+		count_packet(tb, search, buf);
+		buf += TRANSPORT_PACKET_LENGTH;
+	}
+}
+
+static double timebase_now(struct timebase *tb)
+{
+	uint64_t pcr;
+	uint64_t delta;
+	uint64_t packets;
+
+	if (pcr_clock_now(tb->clk, &pcr)) {
+		if (!tb->pcr_valid)
+			return now() - tb->wall_start;
+		return tb->origin + ((double) tb->ticks / PCR_CLOCK_HZ);
+	}
+
+	packets = tb->packets - tb->pcr_packets;
+	if (!tb->pcr_valid) {
+		// switch from the wall clock to the PCRs; the packets so far
+		// can't be timed by them, so counting starts again
+		tb->origin = now() - tb->wall_start;
+		tb->pcr_valid = 1;
+		tb->restart = 1;
+	} else if (!tb->pcr_reset && ((delta = pcr_clock_delta(pcr, tb->pcr)) < PCR_MAX_STEP)) {
+		tb->ticks += delta;
+		tb->timed_packets += packets;
+	} else if (tb->timed_packets) {
+		// across a discontinuity, assume the bitrate stayed the same
+		tb->ticks += (packets * tb->ticks) / tb->timed_packets;
+		tb->timed_packets += packets;
+	}
+	tb->pcr = pcr;
+	tb->pcr_packets = tb->packets;
+	tb->pcr_reset = 0;
+
+	return tb->origin + ((double) tb->ticks / PCR_CLOCK_HZ);
+}
+
+static void reset(void)
+{
+	int pid;
+
+	for(pid=0; pid <= TOTAL_PID; pid++) {
+		pids[pid].packets = 0;
+		pids[pid].scrambled = 0;
+		pids[pid].cc_errors = 0;
+		pids[pid].pusi = 0;
+		pids[pid].matches = 0;
+	}
+	sync_errors = 0;
+}
+
+static void report(double t, double secs, int machine, int searching)
+{
+	struct pidstat *total = &pids[TOTAL_PID];
+	struct pidstat *p;
+	unsigned long pps;
+	uint32_t count;
+	int pid;
+
+	memset(total, 0, sizeof(struct pidstat));
+	for(pid=0; pid < TRANSPORT_MAX_PIDS; pid++) {
+		p = &pids[pid];
+		total->packets += p->packets;
+		total->scrambled += p->scrambled;
+		total->cc_errors += p->cc_errors;
+		total->pusi += p->pusi;
+		total->matches += p->matches;
+	}
+
+	for(pid=0; pid <= TOTAL_PID; pid++) {
+		p = &pids[pid];
+		count = searching ? p->matches : p->packets;
+		if (count == 0)
+			continue;
+
+		if (machine) {
+			printf("%.3f,%i,%u,%u,%u,%u,%u,%.0f\n", t, pid, p->packets, p->scrambled,
+			       p->cc_errors, p->pusi, p->matches,
+			       p->packets * TRANSPORT_PACKET_LENGTH * 8 / secs);
+		} else {
+			pps = count / secs;
+			printf("%04x %5lu p/s %5lu kb/s %5lu kbit\n",
+			       pid, pps, pps * TRANSPORT_PACKET_LENGTH / 1024,
+			       pps * 8 * TRANSPORT_PACKET_LENGTH / 1000);
+		}
+	}
+
+	if (!machine) {
+		if (sync_errors)
+			printf("%u sync errors\n", sync_errors);
+		printf("-PID--FREQ-----BANDWIDTH-BANDWIDTH-\n");
+	}
+	fflush(stdout);
+	reset();
 }
 
 int main(int argc, char **argv)
 {
-	struct timeval startt;
 	int adapter = 0, demux = 0;
-	char *search = NULL;
-	int fd, ffd, packets = 0;
+	char *filename = NULL;
+	struct dvbtsinput *input;
+	struct timebase tb;
+	struct search search;
+	static uint8_t patterns[MAX_PATTERNS][MAX_PATTERN_LENGTH];
+	int lens[MAX_PATTERNS];
+	int pattern_count = 0;
+	int machine = 0;
+	int interval = 1;
+	double t, lastt;
+	uint32_t sync_losses = 0;
+	int ffd = -1;
 	int opt;
 
-	while ((opt = getopt(argc, argv, "a:d:hs:")) != -1) {
+	while ((opt = getopt(argc, argv, "a:d:f:hi:ms:x:")) != -1) {
 		switch (opt) {
 		case 'a':
 			adapter = atoi(optarg);
@@ -44,107 +363,133 @@ int main(int argc, char **argv)
 		case 'd':
 			demux = atoi(optarg);
 			break;
+		case 'f':
+			filename = optarg;
+			break;
 		case 'h':
 			usage(stdout);
 			exit(0);
-		case 's':
-			search = strdup(optarg);
+		case 'i':
+			interval = atoi(optarg);
+			break;
+		case 'm':
+			machine = 1;
+			break;
+		case 's': {
+			size_t len = strlen(optarg);
+
+			if ((pattern_count == MAX_PATTERNS) || (len == 0) ||
+			    (len > MAX_PATTERN_LENGTH)) {
+				fprintf(stderr, "dvbtraffic: Invalid search pattern %s\n", optarg);
+				exit(1);
+			}
+			memcpy(patterns[pattern_count], optarg, len);
+			lens[pattern_count] = len;
+			pattern_count++;
+			break;
+		}
+		case 'x':
+			if ((pattern_count == MAX_PATTERNS) ||
+			    ((lens[pattern_count] = parse_hex(optarg, patterns[pattern_count],
+							      MAX_PATTERN_LENGTH)) <= 0)) {
+				fprintf(stderr, "dvbtraffic: Invalid search pattern %s\n", optarg);
+				exit(1);
+			}
+			pattern_count++;
 			break;
 		default:
 			usage(stderr);
 			exit(1);
 		}
 	}
+	if (interval <= 0) {
+		usage(stderr);
+		exit(1);
+	}
 
-	// open the DVR device
-	fd = dvbdemux_open_dvr(adapter, demux, 1, 0);
-	if (fd < 0) {
- 		fprintf(stderr, "dvbtraffic: Could not open dvr device: %m\n");
+	if (pattern_count && search_build(&search, patterns, lens, pattern_count)) {
+		fprintf(stderr, "dvbtraffic: Out of memory\n");
 		exit(1);
 	}
-	dvbdemux_set_buffer(fd, 1024 * 1024);
 
-	ffd = dvbdemux_open_demux(adapter, demux, 0);
-	if (ffd < 0) {
-		fprintf(stderr, "dvbtraffic: Could not open demux device: %m\n");
+	memset(&tb, 0, sizeof(tb));
+	if ((tb.clk = pcr_clock_create()) == NULL) {
+		fprintf(stderr, "dvbtraffic: Out of memory\n");
 		exit(1);
 	}
 
-	if (dvbdemux_set_pid_filter(ffd, -1, DVBDEMUX_INPUT_FRONTEND, DVBDEMUX_OUTPUT_DVR, 1)) {
-		perror("dvbdemux_set_pid_filter");
-		return -1;
+	if (filename) {
+		// read the recording as fast as we can
+		input = dvbtsinput_open_file(filename, DVBTSINPUT_TYPE_STREAM);
+		if (input == NULL) {
+			fprintf(stderr, "dvbtraffic: Could not open %s: %m\n", filename);
+			exit(1);
+		}
+	} else {
+		// open the DVR device, with room for a good fraction of a second
+		// of a full rate transponder
+		input = dvbtsinput_open_dvr(adapter, demux, DVR_BUFFER_SIZE);
+		if (input == NULL) {
+			fprintf(stderr, "dvbtraffic: Could not open dvr device: %m\n");
+			exit(1);
+		}
+
+		ffd = dvbdemux_open_demux(adapter, demux, 0);
+		if (ffd < 0) {
+			fprintf(stderr, "dvbtraffic: Could not open demux device: %m\n");
+			exit(1);
+		}
+
+		if (dvbdemux_set_pid_filter(ffd, -1, DVBDEMUX_INPUT_FRONTEND, DVBDEMUX_OUTPUT_DVR, 1)) {
+			perror("dvbdemux_set_pid_filter");
+			return -1;
+		}
 	}
 
-	gettimeofday(&startt, 0);
+	signal(SIGINT, signal_handler);
+	signal(SIGTERM, signal_handler);
 
-	while (1) {
-		unsigned char buffer[BSIZE];
-		int pid, ok;
-		ssize_t r;
+	if (machine)
+		printf("time,pid,packets,scrambled,cc_errors,pusi,matches,bitrate\n");
 
-		if ((r = read(fd, buffer, BSIZE)) <= 0) {
-			perror("read");
+	tb.wall_start = now();
+	lastt = 0;
+	while (!quit) {
+		uint8_t *buffer;
+		int count;
+
+		if ((count = dvbtsinput_read(input, &buffer, READ_TIMEOUT)) == 0)
 			break;
-		}
-		if (r != BSIZE) {
-			fprintf(stderr, "dvbtraffic: only read %zd bytes\n", r);
+		if (count < 0) {
+			if ((count == -EOVERFLOW) || (count == -ETIMEDOUT) || (count == -EINTR))
+				continue;
+			fprintf(stderr, "dvbtraffic: read error: %s\n", strerror(-count));
 			break;
 		}
-		if (buffer[0] != 0x47) {
-			continue;
-			printf("desync (%x)\n", buffer[0]);
-			while (buffer[0] != 0x47)
-				read(fd, buffer, 1);
-			continue;
-		}
-		ok = 1;
-		pid = ((((unsigned) buffer[1]) << 8) |
-		       ((unsigned) buffer[2])) & 0x1FFF;
-
-		if (search) {
-			int i, sl = strlen(search);
-			ok = 0;
-			if (pid != 0x1fff) {
-				for (i = 0; i < (188 - sl); ++i) {
-					if (!memcmp(buffer + i, search, sl))
-						ok = 1;
-				}
-			}
-		}
 
-		if (ok) {
-			pidt[pid]++;
-			pidt[0x2000]++;
-		}
+		count_batch(&tb, pattern_count ? &search : NULL, buffer, count);
+		sync_errors += dvbtsinput_sync_losses(input) - sync_losses;
+		sync_losses = dvbtsinput_sync_losses(input);
 
-		packets++;
-
-		if (!(packets & 0xFF)) {
-			struct timeval now;
-			int diff;
-			gettimeofday(&now, 0);
-			diff =
-			    (now.tv_sec - startt.tv_sec) * 1000 +
-			    (now.tv_usec - startt.tv_usec) / 1000;
-			if (diff > 1000) {
-				int _pid = 0;
-				for (_pid = 0; _pid < 0x2001; _pid++) {
-					if (pidt[_pid]) {
-						printf("%04x %5d p/s %5d kb/s %5d kbit\n",
-						     _pid,
-						     pidt[_pid] * 1000 / diff,
-						     pidt[_pid] * 1000 / diff * 188 / 1024,
-						     pidt[_pid] * 8 * 1000 / diff * 188 / 1000);
-					}
-					pidt[_pid] = 0;
-				}
-				printf("-PID--FREQ-----BANDWIDTH-BANDWIDTH-\n");
-				startt = now;
-			}
+		t = timebase_now(&tb);
+		if (tb.restart) {
+			reset();
+			lastt = t;
+			tb.restart = 0;
+		} else if ((t - lastt) >= interval) {
+			report(t, t - lastt, machine, pattern_count);
+			lastt = t;
 		}
 	}
 
-	close(ffd);
-	close(fd);
+	// whatever is left over
+	t = timebase_now(&tb);
+	if (t > lastt)
+		report(t, t - lastt, machine, pattern_count);
+
+	if (ffd >= 0)
+		close(ffd);
+	dvbtsinput_close(input);
+	pcr_clock_destroy(tb.clk);
 	return 0;
 }
@@ -42,6 +42,7 @@
 static char *usage_str =
     "\nusage: femon [options]\n"
     "     -H        : human readable output\n"
+    "     -5        : show the DVBv5 statistics (signal dBm, C/N dB, BER, UCB)\n"
     "     -A        : Acoustical mode. A sound indicates the signal quality.\n"
     "     -r        : If 'Acoustical mode' is active it tells the application\n"
     "                 is called remotely via ssh. The sound is heard on the 'real'\n"
@@ -53,6 +54,7 @@ static char *usage_str =
 int sleep_time=1000000;
 int acoustical_mode=0;
 int remote=0;
+int v5_stats=0;
 
 static void usage(void)
 {
@@ -61,12 +63,54 @@ static void usage(void)
 }
 
 
+static void print_v5_stat(const char *name, const char *unit, struct dvbfe_stat *stat)
+{
+	switch(stat->scale) {
+	case DVBFE_STAT_SCALE_DECIBEL:
+		printf("%s %.2f%s | ", name, stat->value / 1000.0, unit);
+		break;
+	case DVBFE_STAT_SCALE_RELATIVE:
+		printf("%s %3u%% | ", name, (unsigned int) ((stat->value * 100) / 0xffff));
+		break;
+	default:
+		printf("%s ---- | ", name);
+		break;
+	}
+}
+
+/*
+ * The DVBv5 counters run continuously, so the error rates are worked out
+ * from the difference to the previous sample.
+ */
+static void print_v5_stats(struct dvbfe_stats *stats, struct dvbfe_stats *last)
+{
+	int64_t bits;
+
+	print_v5_stat("signal", "dBm", &stats->signal_strength);
+	print_v5_stat("c/n", "dB", &stats->cnr);
+
+	bits = stats->post_total_bits.value - last->post_total_bits.value;
+	if ((stats->post_error_bits.scale == DVBFE_STAT_SCALE_COUNTER) && (bits > 0))
+		printf("ber %.2e | ",
+		       (double) (stats->post_error_bits.value - last->post_error_bits.value) / bits);
+	else
+		printf("ber ---- | ");
+
+	if (stats->error_blocks.scale == DVBFE_STAT_SCALE_COUNTER)
+		printf("unc %lld | ", (long long) (stats->error_blocks.value - last->error_blocks.value));
+	else
+		printf("unc ---- | ");
+}
+
 static
 int check_frontend (struct dvbfe_handle *fe, int human_readable, unsigned int count)
 {
 	struct dvbfe_info fe_info;
+	struct dvbfe_stats stats;
+	struct dvbfe_stats last;
 	unsigned int samples = 0;
 	FILE *ttyFile=NULL;
+	int res;
 	
 	// We dont write the "beep"-codes to stdout but to /dev/tty1.
 	// This is neccessary for Thin-Client-Systems or Streaming-Boxes
@@ -88,14 +132,44 @@ int check_frontend (struct dvbfe_handle *fe, int human_readable, unsigned int co
 	    }
 	}
 
+	if (v5_stats) {
+		if ((res = dvbfe_get_stats(fe, &last)) != 0) {
+			fprintf(stderr, "Problem retrieving frontend statistics: %s\n", strerror(-res));
+			exit(1);
+		}
+	}
+
 	do {
-		if (dvbfe_get_info(fe, FE_STATUS_PARAMS, &fe_info, DVBFE_INFO_QUERYTYPE_IMMEDIATE, 0) != FE_STATUS_PARAMS) {
+		if (v5_stats) {
+			// the status is all that is left to read the old way
+			if (dvbfe_get_info(fe, DVBFE_INFO_LOCKSTATUS, &fe_info, DVBFE_INFO_QUERYTYPE_IMMEDIATE, 0) != DVBFE_INFO_LOCKSTATUS)
+				fprintf(stderr, "Problem retrieving frontend information: %m\n");
+			if ((res = dvbfe_get_stats(fe, &stats)) != 0) {
+				// nothing to print, and last must stay valid for the next delta
+				fprintf(stderr, "Problem retrieving frontend statistics: %s\n", strerror(-res));
+				usleep(sleep_time);
+				samples++;
+				continue;
+			}
+			fe_info.signal_strength = 0;
+			if (stats.signal_strength.scale == DVBFE_STAT_SCALE_RELATIVE)
+				fe_info.signal_strength = stats.signal_strength.value;
+		} else if (dvbfe_get_info(fe, FE_STATUS_PARAMS, &fe_info, DVBFE_INFO_QUERYTYPE_IMMEDIATE, 0) != FE_STATUS_PARAMS) {
 			fprintf(stderr, "Problem retrieving frontend information: %m\n");
 		}
 
 
 
-		if (human_readable) {
+		if (v5_stats) {
+			printf("status %c%c%c%c%c | ",
+				fe_info.signal ? 'S' : ' ',
+				fe_info.carrier ? 'C' : ' ',
+				fe_info.viterbi ? 'V' : ' ',
+				fe_info.sync ? 'Y' : ' ',
+				fe_info.lock ? 'L' : ' ');
+			print_v5_stats(&stats, &last);
+			memcpy(&last, &stats, sizeof(struct dvbfe_stats));
+		} else if (human_readable) {
                        printf ("status %c%c%c%c%c | signal %3u%% | snr %3u%% | ber %d | unc %d | ",
 				fe_info.signal ? 'S' : ' ',
 				fe_info.carrier ? 'C' : ' ',
@@ -188,7 +262,7 @@ int main(int argc, char *argv[])
 	int human_readable = 0;
 	int opt;
 
-       while ((opt = getopt(argc, argv, "rAHa:f:c:")) != -1) {
+       while ((opt = getopt(argc, argv, "rAH5a:f:c:")) != -1) {
 		switch (opt)
 		{
 		default:
@@ -206,6 +280,9 @@ int main(int argc, char *argv[])
 		case 'H':
 			human_readable = 1;
 			break;
+		case '5':
+			v5_stats = 1;
+			break;
 		case 'A':
 			// Acoustical mode: we have to reduce the delay between
 			// checks in order to hear nice sound
@@ -327,10 +327,10 @@ int main(int argc, char *argv[])
 		gnutv_dvb_params.frontend_id = frontend_id;
 		gnutv_dvb_params.demux_id = demux_id;
 		gnutv_dvb_params.output_type = output_type;
-		gnutv_dvb_start(&gnutv_dvb_params);
-
-		// start the data stuff
+		// start the data stuff first: the DVB thread feeds it new PATs and PMTs
 		gnutv_data_start(output_type, ffaudiofd, adapter_id, demux_id, buffer_size, outfile, outif, outaddrs, usertp);
+
+		gnutv_dvb_start(&gnutv_dvb_params);
 	}
 
 	// the UI
@@ -351,13 +351,13 @@ int main(int argc, char *argv[])
 			usleep(1);
 	}
 
-	// stop data handling
-	gnutv_data_stop();
-
 	// shutdown DVB stuff
 	if (channel_name != NULL)
 		gnutv_dvb_stop();
 
+	// stop data handling
+	gnutv_data_stop();
+
 	// shutdown CA stuff
 	gnutv_ca_stop();
 
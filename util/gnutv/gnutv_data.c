@@ -32,13 +32,18 @@
 #include <signal.h>
 #include <pthread.h>
 #include <errno.h>
+#include <time.h>
 #include <sys/poll.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <libdvbapi/dvbdemux.h>
+#include <libdvbapi/dvbfilter.h>
 #include <libdvbapi/dvbaudio.h>
 #include <libucsi/mpeg/section.h>
+#include <libucsi/transport_packet.h>
+#include <libucsi/section_carousel.h>
+#include <libucsi/crc32.h>
 #include "gnutv.h"
 #include "gnutv_dvb.h"
 #include "gnutv_ca.h"
@@ -47,34 +52,53 @@
 static void *fileoutputthread_func(void* arg);
 static void *udpoutputthread_func(void* arg);
 
-static int gnutv_data_create_decoder_filter(int adapter, int demux, uint16_t pid, int pestype);
-static int gnutv_data_create_dvr_filter(int adapter, int demux, uint16_t pid);
-
 static void gnutv_data_decoder_pmt(struct mpeg_pmt_section *pmt);
 static void gnutv_data_dvr_pmt(struct mpeg_pmt_section *pmt);
 
-static void gnutv_data_append_pid_fd(int pid, int fd);
-static void gnutv_data_free_pid_fds(void);
+static void gnutv_data_open_rec(int buffer_size);
+static int gnutv_data_add_output_pid(int pid);
+static void gnutv_data_use_dvr(void);
+
+static void gnutv_data_append_pid_filter(int pid, int filter);
+static void gnutv_data_free_pid_filters(void);
+
+static int gnutv_data_pat_packets(uint8_t *buf, int max);
+static void gnutv_data_write(uint8_t *buf, int size);
+
+// repetition interval of the rewritten PAT, in ms
+#define PAT_INTERVAL 100
+
+// demux buffer size for recording, unless one is given; the DVR device's default
+#define REC_BUFFER_SIZE (10 * 188 * 1024)
 
 static pthread_t outputthread;
 static int outfd = -1;
 static int dvrfd = -1;
-static int pat_fd_dvrout = -1;
-static int pmt_fd_dvrout = -1;
+static int recfd = -1;
+static int rec_dvr = 0;
+static struct dvbfilter_pool *filter_pool = NULL;
+static int pat_filter_dvrout = -1;
+static int pmt_filter_dvrout = -1;
+static int pmt_pid = -1;
 static int outputthread_shutdown = 0;
 
+// the PAT sent in a single program output, listing only our program
+static struct section_carousel *pat_carousel = NULL;
+static pthread_mutex_t pat_carousel_lock = PTHREAD_MUTEX_INITIALIZER;
+static int pat_table = -1;
+
 static int usertp = 0;
 static int adapter_id = -1;
 static int demux_id = -1;
 static int output_type = 0;
 static struct addrinfo *outaddrs = NULL;
 
-struct pid_fd {
+struct pid_filter {
 	int pid;
-	int fd;
+	int filter;
 };
-static struct pid_fd *pid_fds = NULL;
-static int pid_fds_count = 0;
+static struct pid_filter *pid_filters = NULL;
+static int pid_filters_count = 0;
 
 void gnutv_data_start(int _output_type,
 		    int ffaudiofd, int _adapter_id, int _demux_id, int buffer_size,
@@ -86,6 +110,27 @@ void gnutv_data_start(int _output_type,
 	adapter_id = _adapter_id;
 	output_type = _output_type;
 
+	// the demux fds are kept in a pool, so they are reused on each PMT change
+	filter_pool = dvbfilter_pool_create(adapter_id, demux_id);
+	if (filter_pool == NULL) {
+		fprintf(stderr, "Failed to create demux filter pool\n");
+		exit(1);
+	}
+
+	// we output a single program to files and sockets, so we send our own
+	// PAT; the output threads use it as soon as they start
+	switch(output_type) {
+	case OUTPUT_TYPE_FILE:
+	case OUTPUT_TYPE_STDOUT:
+	case OUTPUT_TYPE_UDP:
+		pat_carousel = section_carousel_create();
+		if (pat_carousel == NULL) {
+			fprintf(stderr, "Failed to create PAT carousel\n");
+			exit(1);
+		}
+		break;
+	}
+
 	// setup output
 	switch(output_type) {
 	case OUTPUT_TYPE_DECODER:
@@ -122,6 +167,7 @@ void gnutv_data_start(int _output_type,
 			}
 		}
 
+		gnutv_data_open_rec(buffer_size);
 		pthread_create(&outputthread, NULL, fileoutputthread_func, NULL);
 		break;
 
@@ -158,18 +204,15 @@ void gnutv_data_start(int _output_type,
 			}
 		}
 
+		gnutv_data_open_rec(buffer_size);
 		pthread_create(&outputthread, NULL, udpoutputthread_func, NULL);
 		break;
 	}
 
-	// output PAT to DVR if requested
-	switch(output_type) {
-	case OUTPUT_TYPE_DVR:
-	case OUTPUT_TYPE_FILE:
-	case OUTPUT_TYPE_STDOUT:
-	case OUTPUT_TYPE_UDP:
-		pat_fd_dvrout = gnutv_data_create_dvr_filter(adapter_id, demux_id, TRANSPORT_PAT_PID);
-	}
+	// output PAT to DVR if requested; other readers of the DVR device
+	// might want the other programs, so it is passed through unchanged
+	if (output_type == OUTPUT_TYPE_DVR)
+		pat_filter_dvrout = dvbfilter_add_pid(filter_pool, TRANSPORT_PAT_PID, DVBDEMUX_OUTPUT_DVR, NULL, NULL);
 }
 
 void gnutv_data_stop()
@@ -179,33 +222,74 @@ void gnutv_data_stop()
 		outputthread_shutdown = 1;
 		pthread_join(outputthread, NULL);
 	}
-	gnutv_data_free_pid_fds();
-	if (pat_fd_dvrout != -1)
-		close(pat_fd_dvrout);
-	if (pmt_fd_dvrout != -1)
-		close(pmt_fd_dvrout);
+	if (pat_carousel)
+		section_carousel_destroy(pat_carousel);
+	if (filter_pool) {
+		gnutv_data_free_pid_filters();
+		dvbfilter_pool_destroy(filter_pool);
+	}
 	if (outaddrs)
 		freeaddrinfo(outaddrs);
 }
 
-void gnutv_data_new_pat(int pmt_pid)
+void gnutv_data_new_pat(struct mpeg_pat_section *pat, struct mpeg_pat_program *program)
 {
-	// output PMT to DVR if requested
+	// output PMT if requested
 	switch(output_type) {
 	case OUTPUT_TYPE_DVR:
 	case OUTPUT_TYPE_FILE:
 	case OUTPUT_TYPE_STDOUT:
 	case OUTPUT_TYPE_UDP:
-		if (pmt_fd_dvrout != -1)
-			close(pmt_fd_dvrout);
-		pmt_fd_dvrout = gnutv_data_create_dvr_filter(adapter_id, demux_id, pmt_pid);
+		if (pmt_filter_dvrout >= 0)
+			dvbfilter_remove(filter_pool, pmt_filter_dvrout);
+		pmt_pid = program->pid;
+		pmt_filter_dvrout = gnutv_data_add_output_pid(pmt_pid);
+	}
+
+	if (pat_carousel == NULL)
+		return;
+
+	// rewrite the PAT with just our program, keeping its version
+	uint8_t sibuf[16];
+	uint16_t tsid = mpeg_pat_section_transport_stream_id(pat);
+	uint32_t crc;
+	sibuf[0] = stag_mpeg_program_association;
+	sibuf[1] = 0xb0;
+	sibuf[2] = sizeof(sibuf) - 3;
+	sibuf[3] = tsid >> 8;
+	sibuf[4] = tsid;
+	sibuf[5] = 0xc1 | (pat->head.version_number << 1);
+	sibuf[6] = 0;
+	sibuf[7] = 0;
+	sibuf[8] = program->program_number >> 8;
+	sibuf[9] = program->program_number;
+	sibuf[10] = 0xe0 | (program->pid >> 8);
+	sibuf[11] = program->pid;
+	crc = crc32(CRC32_INIT, sibuf, 12);
+	sibuf[12] = crc >> 24;
+	sibuf[13] = crc >> 16;
+	sibuf[14] = crc >> 8;
+	sibuf[15] = crc;
+
+	pthread_mutex_lock(&pat_carousel_lock);
+	if (pat_table < 0) {
+		struct timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		pat_table = section_carousel_add_table(pat_carousel, TRANSPORT_PAT_PID,
+						       sibuf, sizeof(sibuf), PAT_INTERVAL,
+						       ts.tv_sec * 1000ULL + ts.tv_nsec / 1000000);
+		if (pat_table < 0)
+			fprintf(stderr, "Failed to add PAT to carousel\n");
+	} else {
+		section_carousel_update_table(pat_carousel, pat_table, sibuf, sizeof(sibuf));
 	}
+	pthread_mutex_unlock(&pat_carousel_lock);
 }
 
 int gnutv_data_new_pmt(struct mpeg_pmt_section *pmt)
 {
-	// close all old PID FDs
-	gnutv_data_free_pid_fds();
+	// remove all old PID filters
+	gnutv_data_free_pid_filters();
 
 	// deal with the PMT appropriately
 	switch(output_type) {
@@ -228,49 +312,54 @@ int gnutv_data_new_pmt(struct mpeg_pmt_section *pmt)
 static void *fileoutputthread_func(void* arg)
 {
 	(void)arg;
-	uint8_t buf[4096];
-	struct pollfd pollfd;
-	int written;
-
-	pollfd.fd = dvrfd;
-	pollfd.events = POLLIN|POLLPRI|POLLERR;
+	// whole packets, so the two fds' data can be interleaved
+	uint8_t buf[TRANSPORT_PACKET_LENGTH * 21];
+	uint8_t patbuf[TRANSPORT_PACKET_LENGTH];
+	struct pollfd pollfds[2];
+	int offset[2] = { 0, 0 };
+	int i;
+
+	// the program comes from the shared demux fd, or the DVR device if
+	// the kernel could not share it
+	pollfds[0].fd = recfd;
+	pollfds[1].fd = dvrfd;
+	for(i=0; i < 2; i++)
+		pollfds[i].events = POLLIN|POLLPRI|POLLERR;
 
 	while(!outputthread_shutdown) {
-		if (poll(&pollfd, 1, 1000) == -1) {
+		if (poll(pollfds, 2, 1000) == -1) {
 			if (errno == EINTR)
 				continue;
 			fprintf(stderr, "DVR device poll failure\n");
 			return 0;
 		}
 
-		if (pollfd.revents == 0)
-			continue;
-
-		int size = read(dvrfd, buf, sizeof(buf));
-		if (size < 0) {
-			if (errno == EINTR)
+		for(i=0; i < 2; i++) {
+			if (pollfds[i].revents == 0)
 				continue;
 
-			if (errno == EOVERFLOW) {
-				// The error flag has been cleared, next read should succeed.
-				fprintf(stderr, "DVR overflow\n");
-				continue;
+			int size = read(pollfds[i].fd, buf, sizeof(buf));
+			if (size < 0) {
+				if ((errno == EINTR) || (errno == EAGAIN))
+					continue;
+
+				if (errno == EOVERFLOW) {
+					// The error flag has been cleared, next read should succeed.
+					fprintf(stderr, "DVR overflow\n");
+					continue;
+				}
+
+				fprintf(stderr, "DVR device read failure\n");
+				return 0;
 			}
 
-			fprintf(stderr, "DVR device read failure\n");
-			return 0;
-		}
+			gnutv_data_write(buf, size);
 
-		written = 0;
-		while(written < size) {
-			int tmp = write(outfd, buf + written, size - written);
-			if (tmp == -1) {
-				if (errno != EINTR) {
-					fprintf(stderr, "Write error: %m\n");
-					break;
-				}
-			} else {
-				written += tmp;
+			// insert the PAT between the packets when it is due
+			offset[i] = (offset[i] + size) % TRANSPORT_PACKET_LENGTH;
+			if ((offset[0] == 0) && (offset[1] == 0)) {
+				while((size = gnutv_data_pat_packets(patbuf, 1)) > 0)
+					gnutv_data_write(patbuf, size);
 			}
 		}
 	}
@@ -278,20 +367,59 @@ static void *fileoutputthread_func(void* arg)
 	return 0;
 }
 
+static void gnutv_data_write(uint8_t *buf, int size)
+{
+	int written = 0;
+
+	while(written < size) {
+		int tmp = write(outfd, buf + written, size - written);
+		if (tmp == -1) {
+			if (errno != EINTR) {
+				fprintf(stderr, "Write error: %m\n");
+				break;
+			}
+		} else {
+			written += tmp;
+		}
+	}
+}
+
+static int gnutv_data_pat_packets(uint8_t *buf, int max)
+{
+	struct timespec ts;
+	uint64_t now;
+	int count = 0;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	now = ts.tv_sec * 1000ULL + ts.tv_nsec / 1000000;
+
+	pthread_mutex_lock(&pat_carousel_lock);
+	while((count < max) &&
+	      section_carousel_next_packet(pat_carousel, now, buf + (count * TRANSPORT_PACKET_LENGTH)))
+		count++;
+	pthread_mutex_unlock(&pat_carousel_lock);
+
+	return count * TRANSPORT_PACKET_LENGTH;
+}
+
 #define TS_PAYLOAD_SIZE (188*7)
 
 static void *udpoutputthread_func(void* arg)
 {
 	(void)arg;
 	uint8_t buf[12 + TS_PAYLOAD_SIZE];
-	struct pollfd pollfd;
+	struct pollfd pollfds[2];
+	int cur = 0;
 	int bufsize = 0;
 	int bufbase = 0;
 	int readsize;
 	uint16_t rtpseq = 0;
 
-	pollfd.fd = dvrfd;
-	pollfd.events = POLLIN|POLLPRI|POLLERR;
+	// the program comes from the shared demux fd, or the DVR device if
+	// the kernel could not share it
+	pollfds[0].fd = recfd;
+	pollfds[1].fd = dvrfd;
+	pollfds[0].events = pollfds[1].events = POLLIN|POLLPRI|POLLERR;
 
 	if (usertp) {
 		srandom(time(NULL));
@@ -311,19 +439,30 @@ static void *udpoutputthread_func(void* arg)
 	}
 
 	while(!outputthread_shutdown) {
-		if (poll(&pollfd, 1, 1000) != 1)
+		if (poll(pollfds, 2, 1000) < 1)
 			continue;
-		if (pollfd.revents & POLLERR) {
+
+		// a partial packet is finished from the same fd
+		if ((bufsize % TRANSPORT_PACKET_LENGTH) == 0)
+			cur = pollfds[0].revents ? 0 : 1;
+		if (pollfds[cur].revents == 0)
+			continue;
+		if (pollfds[cur].revents & POLLERR) {
 			if (errno == EINTR)
 				continue;
 			fprintf(stderr, "DVR device read failure\n");
 			return 0;
 		}
 
+		// insert the PAT between the DVR's packets when it is due
+		if ((bufsize % TRANSPORT_PACKET_LENGTH) == 0)
+			bufsize += gnutv_data_pat_packets(buf + bufbase + bufsize,
+							  (TS_PAYLOAD_SIZE - bufsize) / TRANSPORT_PACKET_LENGTH);
+
 		readsize = TS_PAYLOAD_SIZE - bufsize;
-		readsize = read(dvrfd, buf + bufbase + bufsize, readsize);
+		readsize = read(pollfds[cur].fd, buf + bufbase + bufsize, readsize);
 		if (readsize < 0) {
-			if (errno == EINTR)
+			if ((errno == EINTR) || (errno == EAGAIN))
 				continue;
 			fprintf(stderr, "DVR device read failure\n");
 			return 0;
@@ -360,44 +499,6 @@ static void *udpoutputthread_func(void* arg)
 	return 0;
 }
 
-static int gnutv_data_create_decoder_filter(int adapter, int demux, uint16_t pid, int pestype)
-{
-	int demux_fd = -1;
-
-	// open the demuxer
-	if ((demux_fd = dvbdemux_open_demux(adapter, demux, 0)) < 0) {
-		return -1;
-	}
-
-	// create a section filter
-	if (dvbdemux_set_pes_filter(demux_fd, pid, DVBDEMUX_INPUT_FRONTEND, DVBDEMUX_OUTPUT_DECODER, pestype, 1)) {
-		close(demux_fd);
-		return -1;
-	}
-
-	// done
-	return demux_fd;
-}
-
-static int gnutv_data_create_dvr_filter(int adapter, int demux, uint16_t pid)
-{
-	int demux_fd = -1;
-
-	// open the demuxer
-	if ((demux_fd = dvbdemux_open_demux(adapter, demux, 0)) < 0) {
-		return -1;
-	}
-
-	// create a section filter
-	if (dvbdemux_set_pid_filter(demux_fd, pid, DVBDEMUX_INPUT_FRONTEND, DVBDEMUX_OUTPUT_DVR, 1)) {
-		close(demux_fd);
-		return -1;
-	}
-
-	// done
-	return demux_fd;
-}
-
 static void gnutv_data_decoder_pmt(struct mpeg_pmt_section *pmt)
 {
 	int audio_pid = -1;
@@ -418,26 +519,26 @@ static void gnutv_data_decoder_pmt(struct mpeg_pmt_section *pmt)
 	}
 
 	if (audio_pid != -1) {
-		int fd = gnutv_data_create_decoder_filter(adapter_id, demux_id, audio_pid, DVBDEMUX_PESTYPE_AUDIO);
-		if (fd < 0) {
+		int filter = dvbfilter_add_decoder(filter_pool, audio_pid, DVBDEMUX_PESTYPE_AUDIO);
+		if (filter < 0) {
 			fprintf(stderr, "Unable to create dvr filter for PID %i\n", audio_pid);
 		} else {
-			gnutv_data_append_pid_fd(audio_pid, fd);
+			gnutv_data_append_pid_filter(audio_pid, filter);
 		}
 	}
 	if (video_pid != -1) {
-		int fd = gnutv_data_create_decoder_filter(adapter_id, demux_id, video_pid, DVBDEMUX_PESTYPE_VIDEO);
-		if (fd < 0) {
+		int filter = dvbfilter_add_decoder(filter_pool, video_pid, DVBDEMUX_PESTYPE_VIDEO);
+		if (filter < 0) {
 			fprintf(stderr, "Unable to create dvr filter for PID %i\n", video_pid);
 		} else {
-			gnutv_data_append_pid_fd(video_pid, fd);
+			gnutv_data_append_pid_filter(video_pid, filter);
 		}
 	}
-	int fd = gnutv_data_create_decoder_filter(adapter_id, demux_id, pmt->pcr_pid, DVBDEMUX_PESTYPE_PCR);
-	if (fd < 0) {
+	int filter = dvbfilter_add_decoder(filter_pool, pmt->pcr_pid, DVBDEMUX_PESTYPE_PCR);
+	if (filter < 0) {
 		fprintf(stderr, "Unable to create dvr filter for PID %i\n", pmt->pcr_pid);
 	} else {
-		gnutv_data_append_pid_fd(pmt->pcr_pid, fd);
+		gnutv_data_append_pid_filter(pmt->pcr_pid, filter);
 	}
 }
 
@@ -445,39 +546,88 @@ static void gnutv_data_dvr_pmt(struct mpeg_pmt_section *pmt)
 {
 	struct mpeg_pmt_stream *cur_stream;
 	mpeg_pmt_section_streams_for_each(pmt, cur_stream) {
-		int fd = gnutv_data_create_dvr_filter(adapter_id, demux_id, cur_stream->pid);
-		if (fd < 0) {
+		int filter = gnutv_data_add_output_pid(cur_stream->pid);
+		if (filter < 0) {
 			fprintf(stderr, "Unable to create dvr filter for PID %i\n", cur_stream->pid);
 		} else {
-			gnutv_data_append_pid_fd(cur_stream->pid, fd);
+			gnutv_data_append_pid_filter(cur_stream->pid, filter);
 		}
 	}
 }
 
-static void gnutv_data_append_pid_fd(int pid, int fd)
+static void gnutv_data_open_rec(int buffer_size)
+{
+	// a recorded program's PIDs all go on the filter pool's shared fd
+	recfd = dvbfilter_pool_get_shared_fd(filter_pool);
+	if (recfd < 0) {
+		fprintf(stderr, "Failed to open demux device\n");
+		exit(1);
+	}
+
+	if (dvbdemux_set_buffer(recfd, (buffer_size > 0) ? buffer_size : REC_BUFFER_SIZE) != 0) {
+		fprintf(stderr, "Failed to set demux buffer size\n");
+		exit(1);
+	}
+}
+
+static int gnutv_data_add_output_pid(int pid)
+{
+	int filter;
+
+	if ((output_type == OUTPUT_TYPE_DVR) || rec_dvr)
+		return dvbfilter_add_pid(filter_pool, pid, DVBDEMUX_OUTPUT_DVR, NULL, NULL);
+
+	filter = dvbfilter_add_pid(filter_pool, pid, DVBDEMUX_OUTPUT_TS_DEMUX, NULL, NULL);
+	if ((filter < 0) || (dvbfilter_get_fd(filter_pool, filter) == recfd))
+		return filter;
+
+	// the kernel cannot add PIDs to the shared fd, so record from the DVR device
+	dvbfilter_remove(filter_pool, filter);
+	gnutv_data_use_dvr();
+	return dvbfilter_add_pid(filter_pool, pid, DVBDEMUX_OUTPUT_DVR, NULL, NULL);
+}
+
+static void gnutv_data_use_dvr(void)
+{
+	int i;
+
+	rec_dvr = 1;
+
+	if (pmt_filter_dvrout >= 0) {
+		dvbfilter_remove(filter_pool, pmt_filter_dvrout);
+		pmt_filter_dvrout = dvbfilter_add_pid(filter_pool, pmt_pid, DVBDEMUX_OUTPUT_DVR, NULL, NULL);
+	}
+	for(i=0; i < pid_filters_count; i++) {
+		dvbfilter_remove(filter_pool, pid_filters[i].filter);
+		pid_filters[i].filter = dvbfilter_add_pid(filter_pool, pid_filters[i].pid,
+							  DVBDEMUX_OUTPUT_DVR, NULL, NULL);
+	}
+}
+
+static void gnutv_data_append_pid_filter(int pid, int filter)
 {
-	struct pid_fd *tmp;
-	if ((tmp = realloc(pid_fds, (pid_fds_count +1) * sizeof(struct pid_fd))) == NULL) {
-		fprintf(stderr, "Out of memory when adding a new pid_fd\n");
+	struct pid_filter *tmp;
+	if ((tmp = realloc(pid_filters, (pid_filters_count +1) * sizeof(struct pid_filter))) == NULL) {
+		fprintf(stderr, "Out of memory when adding a new pid_filter\n");
 		exit(1);
 	}
-	tmp[pid_fds_count].pid = pid;
-	tmp[pid_fds_count].fd = fd;
-	pid_fds_count++;
-	pid_fds = tmp;
+	tmp[pid_filters_count].pid = pid;
+	tmp[pid_filters_count].filter = filter;
+	pid_filters_count++;
+	pid_filters = tmp;
 }
 
-static void gnutv_data_free_pid_fds()
+static void gnutv_data_free_pid_filters()
 {
-	if (pid_fds_count) {
+	if (pid_filters_count) {
 		int i;
-		for(i=0; i< pid_fds_count; i++) {
-			close(pid_fds[i].fd);
+		for(i=0; i< pid_filters_count; i++) {
+			dvbfilter_remove(filter_pool, pid_filters[i].filter);
 		}
 	}
-	if (pid_fds)
-		free(pid_fds);
+	if (pid_filters)
+		free(pid_filters);
 
-	pid_fds_count = 0;
-	pid_fds = NULL;
+	pid_filters_count = 0;
+	pid_filters = NULL;
 }
@@ -31,7 +31,7 @@ extern void gnutv_data_start(int output_type,
 			   char* outif, struct addrinfo *outaddrs, int usertp);
 extern void gnutv_data_stop(void);
 
-extern void gnutv_data_new_pat(int pmt_pid);
+extern void gnutv_data_new_pat(struct mpeg_pat_section *pat, struct mpeg_pat_program *program);
 extern int gnutv_data_new_pmt(struct mpeg_pmt_section *pmt);
 
 
@@ -77,7 +77,7 @@ static void *dvbthread_func(void* arg)
 	int pat_fd = -1;
 	int pmt_fd = -1;
 	int tdt_fd = -1;
-	struct pollfd pollfds[3];
+	struct pollfd pollfds[4];
 
 	struct gnutv_dvb_params *params = (struct gnutv_dvb_params *) arg;
 
@@ -104,6 +104,10 @@ static void *dvbthread_func(void* arg)
 	pollfds[2].fd = 0;
 	pollfds[2].events = 0;
 
+	// the frontend, only while waiting for the lock
+	pollfds[3].fd = -1;
+	pollfds[3].events = POLLIN;
+
 	// the DVB loop
 	while(!dvbthread_shutdown) {
 		// tune frontend + monitor lock status
@@ -136,20 +140,32 @@ static void *dvbthread_func(void* arg)
 			if (params->valid_sec)
 				sec = &params->sec;
 
-			// tune!
-			if (dvbsec_set(params->fe,
-			    		  sec,
-					  params->channel.polarization,
-					  (params->channel.diseqc_switch & 0x01) ? DISEQC_SWITCH_B : DISEQC_SWITCH_A,
-					  (params->channel.diseqc_switch & 0x02) ? DISEQC_SWITCH_B : DISEQC_SWITCH_A,
-					  &params->channel.fe_params,
-					  0)) {
+			// tune! the lock is waited for alongside the SI data
+			if (dvbsec_set_async(params->fe,
+					     sec,
+					     params->channel.polarization,
+					     (params->channel.diseqc_switch & 0x01) ? DISEQC_SWITCH_B : DISEQC_SWITCH_A,
+					     (params->channel.diseqc_switch & 0x02) ? DISEQC_SWITCH_B : DISEQC_SWITCH_A,
+					     &params->channel.fe_params,
+					     -1, NULL, NULL)) {
 				fprintf(stderr, "Failed to set frontend\n");
 				exit(1);
 			}
+			pollfds[3].fd = dvbfe_get_pollfd(params->fe);
 
 			tune_state++;
-		} else if (tune_state == 1) {
+		}
+
+		// is there SI data, or a frontend event?
+		int count = poll(pollfds, 4, 100);
+		if (count < 0) {
+			if (errno != EINTR)
+				fprintf(stderr, "Poll error: %m\n");
+			break;
+		}
+
+		// print the status on each frontend event until it locks
+		if ((tune_state == 1) && (pollfds[3].revents & POLLIN)) {
 			struct dvbfe_info result;
 			memset(&result, 0, sizeof(result));
 			dvbfe_get_info(params->fe,
@@ -171,22 +187,13 @@ static void *dvbthread_func(void* arg)
 				result.lock ? "FE_HAS_LOCK" : "");
 			fflush(stderr);
 
-			if (result.lock) {
+			if (dvbfe_tune_check(params->fe) == DVBFE_TUNE_LOCKED) {
 				tune_state++;
+				pollfds[3].fd = -1;
 				fprintf(stderr, "\n");
 				fflush(stderr);
-			} else {
-				usleep(500000);
 			}
 		}
-
-		// is there SI data?
-		int count = poll(pollfds, 3, 100);
-		if (count < 0) {
-			if (errno != EINTR)
-				fprintf(stderr, "Poll error: %m\n");
-			break;
-		}
 		if (count == 0) {
 			continue;
 		}
@@ -265,7 +272,7 @@ static void process_pat(int pat_fd, struct gnutv_dvb_params *params, int *pmt_fd
 			pollfd->fd = *pmt_fd;
 			pollfd->events = POLLIN|POLLPRI|POLLERR;
 
-			gnutv_data_new_pat(cur_program->pid);
+			gnutv_data_new_pat(pat, cur_program);
 
 			// we have a new PMT pid
 			data_pmt_version = -1;